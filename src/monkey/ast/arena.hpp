@@ -0,0 +1,101 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace YOXS_AST {
+
+// Arena is a bump allocator for AST nodes. Memory is carved out of large
+// blocks and never freed piecemeal: destroying the Arena releases every
+// block at once. Only trivially destructible types may live here, because
+// their destructors are never run.
+class Arena {
+public:
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    template <typename T, typename... Args>
+    T* New(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        void* mem = allocate(sizeof(T), alignof(T));
+        objects++;
+        return new (mem) T(std::forward<Args>(args)...);
+    }
+
+    // Copies items into the arena and returns the copy.
+    template <typename T>
+    T* CopyArray(const std::vector<T>& items) {
+        static_assert(std::is_trivially_copyable<T>::value, "arena arrays are copied bytewise");
+        if (items.empty()) return nullptr;
+        void* mem = allocate(sizeof(T) * items.size(), alignof(T));
+        std::memcpy(mem, items.data(), sizeof(T) * items.size());
+        return static_cast<T*>(mem);
+    }
+
+    size_t ObjectCount() const { return objects; }
+    size_t BytesUsed() const { return used; }          // bytes handed out, including alignment padding
+    size_t BytesReserved() const { return reserved; }  // bytes held in blocks
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t objects = 0;
+    size_t used = 0;
+    size_t reserved = 0;
+
+    void* allocate(size_t size, size_t align) {
+        size_t padding = (align - reinterpret_cast<uintptr_t>(cursor) % align) % align;
+        if (!cursor || padding + size > static_cast<size_t>(limit - cursor)) {
+            grow(size + align);
+            padding = (align - reinterpret_cast<uintptr_t>(cursor) % align) % align;
+        }
+        char* p = cursor + padding;
+        cursor = p + size;
+        used += padding + size;
+        return p;
+    }
+
+    void grow(size_t minimum) {
+        size_t size = minimum > BlockSize ? minimum : BlockSize;
+        blocks.emplace_back(new char[size]);
+        cursor = blocks.back().get();
+        limit = cursor + size;
+        reserved += size;
+    }
+};
+
+// NodeList is a fixed-size, non-owning array of AST children whose storage
+// lives in the Program's Arena.
+template <typename T>
+class NodeList {
+public:
+    NodeList() : items(nullptr), count(0) {}
+    NodeList(T* items, size_t count) : items(items), count(count) {}
+    NodeList(Arena& arena, const std::vector<T>& v) : items(arena.CopyArray(v)), count(v.size()) {}
+
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t i) const { return items[i]; }
+    T& back() const { return items[count - 1]; }
+
+private:
+    T* items;
+    size_t count;
+};
+
+} // namespace YOXS_AST
+
+#endif // ARENA_H
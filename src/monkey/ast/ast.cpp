@@ -2,6 +2,15 @@
 
 namespace YOXS_AST {
 
+uint32_t Scope::Find(SymbolId name) const {
+    auto it = slots.find(name);
+    return it == slots.end() ? NotFound : it->second;
+}
+
+uint32_t Scope::Declare(SymbolId name) {
+    return slots.emplace(name, static_cast<uint32_t>(slots.size())).first->second;
+}
+
 std::string Program::TokenLiteral() const {
         if(!Statements.empty()){
             return Statements[0]->TokenLiteral();
@@ -20,15 +29,15 @@ std::string Program::String() const {
 }
 
 std::string LetStatement::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string LetStatement::String() const {
-    return token.Literal + " " + Name->String() + " = " + (Value ? Value->String() : "") + ";";
+    return std::string(token.Literal) + " " + Name->String() + " = " + (Value ? Value->String() : "") + ";";
 }
 
 std::string ReturnStatement::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string ReturnStatement::String() const {
@@ -42,16 +51,24 @@ std::string ReturnStatement::String() const {
 }
 
 std::string ExpressionStatement::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string ExpressionStatement::String() const {
     return (expr ? expr->String() : "");
 }
-BlockStatement::BlockStatement(const Token& t) : token(t) {}
+std::string AssignStatement::TokenLiteral() const {
+    return std::string(token.Literal);
+}
+
+std::string AssignStatement::String() const {
+    return Name->String() + " = " + (Value ? Value->String() : "") + ";";
+}
+
+BlockStatement::BlockStatement(const Token& t) : Statement(NodeKind::BlockStatement), token(t) {}
 
 std::string BlockStatement::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string BlockStatement::String() const {
@@ -62,64 +79,75 @@ std::string BlockStatement::String() const {
     return out.str();
 }
 
-Identifier::Identifier(const Token& t, const std::string& v) : token(t) {
+std::string WhileStatement::TokenLiteral() const {
+    return std::string(token.Literal);
+}
+
+std::string WhileStatement::String() const {
+    return "while" + Condition->String() + " " + Body->String();
+}
+
+// The lexer has interned the name already, unless the token was made by
+// hand.
+Identifier::Identifier(const Token& t, std::string_view v) : Expression(NodeKind::Identifier), token(t) {
     token.Literal = v;
+    Symbol = t.Symbol != Interner::None && t.Literal == v ? t.Symbol : Interner::Current().Intern(v);
 }
 
-std::string Identifier::Value() const {
+std::string_view Identifier::Value() const {
     return token.Literal;
 }
 
 std::string Identifier::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string Identifier::String() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
-Boolean::Boolean(const Token& t, const bool& v) : token(t), Value(v) {}
+Boolean::Boolean(const Token& t, const bool& v) : Expression(NodeKind::Boolean), token(t), Value(v) {}
 
 std::string Boolean::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string Boolean::String() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string IntegerLiteral::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string IntegerLiteral::String() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
-PrefixExpression::PrefixExpression(const Token& t, const std::string& v) : token(t), Operator(v) {}
+PrefixExpression::PrefixExpression(const Token& t, std::string_view v) : Expression(NodeKind::PrefixExpression), token(t), Operator(v) {}
 
 std::string PrefixExpression::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string PrefixExpression::String() const {
-    return "(" + Operator + Right->String() + ")";
+    return "(" + std::string(Operator) + Right->String() + ")";
 }
 
-InfixExpression::InfixExpression(const Token& tok, const std::string& op, std::shared_ptr<Expression> leftExp) : token(tok), Left(leftExp), Operator(op) {}
+InfixExpression::InfixExpression(const Token& tok, std::string_view op, Expression* leftExp) : Expression(NodeKind::InfixExpression), token(tok), Left(leftExp), Operator(op) {}
 
 std::string InfixExpression::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string InfixExpression::String() const {
-    return "(" + Left->String() + " " + Operator + " " + Right->String() + ")";
+    return "(" + Left->String() + " " + std::string(Operator) + " " + Right->String() + ")";
 }
 
-IfExpression::IfExpression(const Token& t) : token(t) {}
+IfExpression::IfExpression(const Token& t) : Expression(NodeKind::IfExpression), token(t) {}
 
 std::string IfExpression::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string IfExpression::String() const {
@@ -130,14 +158,14 @@ std::string IfExpression::String() const {
     return result;
 }
 
-FunctionLiteral::FunctionLiteral(const Token& t) : token(t) {}
+FunctionLiteral::FunctionLiteral(const Token& t) : Expression(NodeKind::FunctionLiteral), token(t) {}
 
 std::string FunctionLiteral::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string FunctionLiteral::String() const {
-    std::string result = token.Literal + "(";
+    std::string result = std::string(token.Literal) + "(";
     std::vector<std::string> params;
     for (const auto& param : Parameters) {
         params.push_back(param->String());
@@ -147,10 +175,10 @@ std::string FunctionLiteral::String() const {
     return result;
 }
 
-CallExpression::CallExpression (const Token& t, std::shared_ptr<Expression> f) : token(t), Function(f){}
+CallExpression::CallExpression (const Token& t, Expression* f) : Expression(NodeKind::CallExpression), token(t), Function(f){}
 
 std::string CallExpression::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string CallExpression::String() const {
@@ -163,20 +191,20 @@ std::string CallExpression::String() const {
     return result;
 }
 
-StringLiteral::StringLiteral (const Token& t) : token(t) {}
+StringLiteral::StringLiteral (const Token& t) : Expression(NodeKind::StringLiteral), token(t) {}
 
 std::string StringLiteral::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string StringLiteral::String () const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
-ArrayLiteral::ArrayLiteral(const Token& t) : token(t) {}
+ArrayLiteral::ArrayLiteral(const Token& t) : Expression(NodeKind::ArrayLiteral), token(t) {}
 
 std::string ArrayLiteral::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string ArrayLiteral::String() const {
@@ -189,10 +217,10 @@ std::string ArrayLiteral::String() const {
     return out;
 }
 
-IndexExpression::IndexExpression (const Token& t, std::shared_ptr<Expression> l) : token(t), Left(l) {}
+IndexExpression::IndexExpression (const Token& t, Expression* l) : Expression(NodeKind::IndexExpression), token(t), Left(l) {}
 
 std::string IndexExpression::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 
 std::string IndexExpression::String() const {
@@ -200,15 +228,15 @@ std::string IndexExpression::String() const {
     return out;
 }
 
-HashLiteral::HashLiteral(const Token& t) : token(t) {}
+HashLiteral::HashLiteral(const Token& t) : Expression(NodeKind::HashLiteral), token(t) {}
 std::string HashLiteral::TokenLiteral() const {
-    return token.Literal;
+    return std::string(token.Literal);
 }
 std::string HashLiteral::String() const {
 
     std::vector<std::string> pairs;
-    for(const auto& key: Pairs){
-        pairs.push_back(key.first->String() + ":" + key.second->String());
+    for(const auto& pair: Pairs){
+        pairs.push_back(pair.Key->String() + ":" + pair.Value->String());
     }
 
     std::string result = "{" + join(pairs, ", ") + "}";
@@ -1,13 +1,17 @@
 #ifndef AST_H
 #define AST_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include <memory>
 #include <iterator>
 #include <map>
+#include <unordered_map>
 #include "../token/token.hpp"
+#include "arena.hpp"
 
 namespace YOXS_AST {
 // Forward declarations of all the classes we're going to use.
@@ -15,30 +19,95 @@ class Statement;
 class Expression;
 class Identifier;
 
-// Node represents every node in the abstract syntax tree
+// NodeKind identifies the concrete class of a Node. It is set once at
+// construction so consumers can dispatch with a switch and a static_cast
+// instead of probing the node with dynamic casts.
+enum class NodeKind : uint8_t {
+    Program,
+    LetStatement,
+    ReturnStatement,
+    ExpressionStatement,
+    BlockStatement,
+    Identifier,
+    Boolean,
+    IntegerLiteral,
+    PrefixExpression,
+    InfixExpression,
+    IfExpression,
+    FunctionLiteral,
+    CallExpression,
+    StringLiteral,
+    ArrayLiteral,
+    IndexExpression,
+    HashLiteral,
+    AssignStatement,
+    WhileStatement
+};
+
+// Node represents every node in the abstract syntax tree. Nodes are
+// allocated in their Program's Arena and never destroyed one by one, so the
+// destructor is trivial and protected: nothing may delete a node through a
+// base pointer.
 class Node {
 public:
-    virtual ~Node() = default; 
+    explicit Node(NodeKind kind) : Kind(kind) {}
     virtual std::string TokenLiteral() const = 0;
     virtual std::string String() const = 0;
+
+    const NodeKind Kind;
+
+protected:
+    ~Node() = default;
 };
 
 // All nodes that can be used as statements implement this interface
 class Statement : public Node {
 public: 
+    explicit Statement(NodeKind kind) : Node(kind) {}
     virtual void statementNode() = 0;
 };
 
 // All nodes that can be used as expressions implement this interface
 class Expression : public Node {
 public: 
+    explicit Expression(NodeKind kind) : Node(kind) {}
     virtual void expressionNode() = 0;
 };
 
-// The root node of every AST our parser produces
-class Program : public Node {
+// Scope lists the variables of one function body, or of the top level, and
+// the slot each one is stored in. The Resolver fills scopes in; at run time
+// an Environment keeps its values in a flat array indexed by these slots.
+class Scope {
 public:
-    std::vector<std::shared_ptr<Statement>> Statements;
+    static constexpr uint32_t NotFound = UINT32_MAX;
+
+    uint32_t Find(SymbolId name) const;
+    uint32_t Declare(SymbolId name); // returns the existing slot if name is already declared
+    size_t Size() const { return slots.size(); }
+    void Clear() { slots.clear(); }
+
+private:
+    std::unordered_map<SymbolId, uint32_t> slots;
+};
+
+// The root node of every AST our parser produces. It owns the arena the
+// rest of the tree lives in and the source text the tokens point into, so
+// the whole tree is freed at once when the Program goes away.
+class Program final : public Node, public std::enable_shared_from_this<Program> {
+public:
+    Program() : Node(NodeKind::Program) {}
+    ~Program() = default;
+    NodeList<Statement*> Statements;
+    std::shared_ptr<const std::string> Source; // the text every token in the tree points into
+    Arena NodeArena;
+    std::vector<std::unique_ptr<Scope>> Scopes; // the Locals of every FunctionLiteral in the tree
+
+    template <typename T, typename... Args>
+    T* New(Args&&... args) { return NodeArena.New<T>(std::forward<Args>(args)...); }
+
+    template <typename T>
+    NodeList<T> List(const std::vector<T>& items) { return NodeList<T>(NodeArena, items); }
+
     std::string TokenLiteral() const override;
     std::string String() const override;
 };
@@ -46,9 +115,10 @@ public:
 // AST node for let statements
 class LetStatement : public Statement {
 public:
+    LetStatement() : Statement(NodeKind::LetStatement) {}
     Token token; // The 'let' token
-    std::shared_ptr<Identifier> Name;
-    std::shared_ptr<Expression> Value;
+    Identifier* Name = nullptr;
+    Expression* Value = nullptr;
 
     std::string TokenLiteral() const override;
     std::string String() const override;
@@ -58,8 +128,9 @@ public:
 
 class ReturnStatement : public Statement {
 public:
+    ReturnStatement() : Statement(NodeKind::ReturnStatement) {}
     Token token; // the 'return' token
-    std::shared_ptr<Expression> ReturnValue;
+    Expression* ReturnValue = nullptr;
 
     std::string TokenLiteral() const override;
     std::string String() const override;
@@ -68,8 +139,23 @@ public:
 
 class ExpressionStatement : public Statement {
 public:
+    ExpressionStatement() : Statement(NodeKind::ExpressionStatement) {}
     Token token; // the first token of the expression
-    std::shared_ptr<Expression> expr;
+    Expression* expr = nullptr;
+
+    std::string TokenLiteral() const override;
+    std::string String() const override;
+    void statementNode() override {}
+};
+
+// AST node for `x = value;`, which rebinds a variable some enclosing let
+// or parameter already introduced instead of declaring a new one.
+class AssignStatement : public Statement {
+public:
+    AssignStatement() : Statement(NodeKind::AssignStatement) {}
+    Token token; // the '=' token
+    Identifier* Name = nullptr;
+    Expression* Value = nullptr;
 
     std::string TokenLiteral() const override;
     std::string String() const override;
@@ -80,7 +166,21 @@ class BlockStatement : public Statement {
 public:
     BlockStatement(const Token& t);
     Token token; // the '{' token
-    std::vector<std::shared_ptr<Statement>> Statements;
+    NodeList<Statement*> Statements;
+
+    std::string TokenLiteral() const override;
+    std::string String() const override;
+    void statementNode() override {}
+};
+
+// Runs Body for as long as Condition is truthy. The body runs in the
+// enclosing scope, like an if block, so a loop allocates no environments.
+class WhileStatement : public Statement {
+public:
+    WhileStatement(const Token& t) : Statement(NodeKind::WhileStatement), token(t) {}
+    Token token; // the 'while' token
+    Expression* Condition = nullptr;
+    BlockStatement* Body = nullptr;
 
     std::string TokenLiteral() const override;
     std::string String() const override;
@@ -89,11 +189,20 @@ public:
 
 class Identifier : public Expression {
 public:
-    Identifier() = default;
-    Identifier(const Token& t, const std::string& v);
+    Identifier() : Expression(NodeKind::Identifier) {}
+    Identifier(const Token& t, std::string_view v);
 
     Token token; // The IDENT token
-    std::string Value() const;
+    SymbolId Symbol = Interner::None; // the interned name, what scopes and environments key on
+    std::string_view Value() const;
+
+    // Set by the Resolver: the variable is in slot Slot of the environment
+    // Depth levels out. Names it could not place, such as builtins, keep
+    // Depth == Unresolved and are looked up by name.
+    static constexpr uint32_t Unresolved = UINT32_MAX;
+    uint32_t Depth = Unresolved;
+    uint32_t Slot = 0;
+
     std::string TokenLiteral() const override;
     std::string String() const override;
     void expressionNode() override {}
@@ -114,9 +223,9 @@ public:
 class IntegerLiteral : public Expression {
 public: 
     Token token;
-    int64_t Value;
-    IntegerLiteral(const Token& t) : token(t) {}
-    IntegerLiteral(const Token& t, int64_t value) : token(t), Value(value) {}
+    int64_t Value = 0;
+    IntegerLiteral(const Token& t) : Expression(NodeKind::IntegerLiteral), token(t) {}
+    IntegerLiteral(const Token& t, int64_t value) : Expression(NodeKind::IntegerLiteral), token(t), Value(value) {}
     std::string TokenLiteral() const override;
     std::string String() const override;
     void expressionNode() override {}
@@ -124,11 +233,11 @@ public:
 
 class PrefixExpression : public Expression {
 public:
-    PrefixExpression(const Token& t, const std::string& v);
+    PrefixExpression(const Token& t, std::string_view v);
 
     Token token; // The prefix token, e.g. !
-    std::string Operator;
-    std::shared_ptr<Expression> Right;
+    std::string_view Operator;
+    Expression* Right = nullptr;
 
     std::string TokenLiteral() const override;
     std::string String() const override;
@@ -138,11 +247,11 @@ public:
 class InfixExpression : public Expression {
 public:
 
-    InfixExpression(const Token& tok, const std::string& op, std::shared_ptr<Expression> leftExp);
+    InfixExpression(const Token& tok, std::string_view op, Expression* leftExp);
     Token token; // The operator token, e.g. +
-    std::shared_ptr<Expression> Left;
-    std::string Operator;
-    std::shared_ptr<Expression> Right;
+    Expression* Left = nullptr;
+    std::string_view Operator;
+    Expression* Right = nullptr;
 
     std::string TokenLiteral() const override;
     std::string String() const override;
@@ -153,9 +262,9 @@ class IfExpression : public Expression {
 public:
     IfExpression(const Token& t);
     Token token; // The 'if' token
-    std::shared_ptr<Expression> Condition;
-    std::shared_ptr<BlockStatement> Consequence;
-    std::shared_ptr<BlockStatement> Alternative;
+    Expression* Condition = nullptr;
+    BlockStatement* Consequence = nullptr;
+    BlockStatement* Alternative = nullptr;
 
     std::string TokenLiteral() const override;
     std::string String() const override;
@@ -166,8 +275,11 @@ class FunctionLiteral : public Expression {
 public:
     FunctionLiteral(const Token& t);
     Token token; // The 'fn' token
-    std::vector<std::shared_ptr<Identifier>> Parameters;
-    std::shared_ptr<BlockStatement> Body;
+    NodeList<Identifier*> Parameters;
+    BlockStatement* Body = nullptr;
+    std::string_view Name; // set when the literal is bound by a let statement
+    Program* Owner = nullptr; // every Function created from this literal keeps it alive
+    Scope* Locals = nullptr; // parameters and lets of the body, set by the Resolver
 
     std::string TokenLiteral() const override;
     std::string String() const override;
@@ -176,10 +288,11 @@ public:
 
 class CallExpression : public Expression {
 public:
-    CallExpression(const Token& t, std::shared_ptr<Expression> f);
+    CallExpression(const Token& t, Expression* f);
     Token token; // The '(' token
-    std::shared_ptr<Expression> Function; // Identifier or FunctionLiteral
-    std::vector<std::shared_ptr<Expression>> Arguments;
+    Expression* Function = nullptr; // Identifier or FunctionLiteral
+    NodeList<Expression*> Arguments;
+    bool Tail = false; // set by the Resolver when the call is the last thing its function does
 
     std::string TokenLiteral() const override;
     std::string String() const override;
@@ -189,9 +302,9 @@ public:
 class StringLiteral : public Expression {
 public: 
     StringLiteral(const Token& t);
-    StringLiteral(const Token& t, const std::string& s) : token(t), Value(s) {}
+    StringLiteral(const Token& t, std::string_view s) : Expression(NodeKind::StringLiteral), token(t), Value(s) {}
     Token token;
-    std::string Value;
+    std::string_view Value;
     void expressionNode() override {}
     std::string TokenLiteral() const override;
     std::string String() const override;
@@ -201,7 +314,7 @@ class ArrayLiteral : public Expression {
 public:
     Token token;
     ArrayLiteral(const Token& t);
-    std::vector<std::shared_ptr<Expression>> Elements;
+    NodeList<Expression*> Elements;
 
     void expressionNode() override {}
     std::string TokenLiteral() const override;
@@ -210,20 +323,25 @@ public:
 
 class IndexExpression : public Expression {
 public:
-    IndexExpression(const Token& t, std::shared_ptr<Expression> l);
+    IndexExpression(const Token& t, Expression* l);
     Token token; //the [ token
-    std::shared_ptr<Expression> Left;
-    std::shared_ptr<Expression> Index;
+    Expression* Left = nullptr;
+    Expression* Index = nullptr;
 
     void expressionNode() override {}
     std::string TokenLiteral() const override;
     std::string String() const override;
 };
 
+struct HashLiteralPair {
+    Expression* Key = nullptr;
+    Expression* Value = nullptr;
+};
+
 class HashLiteral : public Expression {
 public:
     Token token;
-    std::map<std::shared_ptr<Expression>, std::shared_ptr<Expression>> Pairs;
+    NodeList<HashLiteralPair> Pairs; // in source order
     
     void expressionNode() override {}
 
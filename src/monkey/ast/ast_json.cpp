@@ -0,0 +1,246 @@
+// ast_json.cpp
+#include "ast_json.hpp"
+
+namespace YOXS_AST {
+
+void AppendJsonString(std::string& out, std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += "\\u00";
+                out += hex[(c >> 4) & 0xF];
+                out += hex[c & 0xF];
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+namespace {
+
+// Appends `"key":` to out, after a comma since every member follows "type".
+void key(std::string& out, const char* name) {
+    out += ",\"";
+    out += name;
+    out += "\":";
+}
+
+template <class T>
+void writeList(const NodeList<T>& items, std::string& out) {
+    out += '[';
+    for (size_t i = 0; i < items.size(); i++) {
+        if (i > 0) out += ',';
+        WriteJson(items[i], out);
+    }
+    out += ']';
+}
+
+} // namespace
+
+void WriteJson(const Node* node, std::string& out) {
+    if (!node) {
+        out += "null";
+        return;
+    }
+    out += "{\"type\":";
+    switch (node->Kind) {
+    case NodeKind::Program: {
+        auto n = static_cast<const Program*>(node);
+        out += "\"Program\"";
+        key(out, "statements");
+        writeList(n->Statements, out);
+        break;
+    }
+    case NodeKind::LetStatement: {
+        auto n = static_cast<const LetStatement*>(node);
+        out += "\"LetStatement\"";
+        key(out, "name");
+        AppendJsonString(out, n->Name->Value());
+        key(out, "value");
+        WriteJson(n->Value, out);
+        break;
+    }
+    case NodeKind::ReturnStatement: {
+        auto n = static_cast<const ReturnStatement*>(node);
+        out += "\"ReturnStatement\"";
+        key(out, "value");
+        WriteJson(n->ReturnValue, out);
+        break;
+    }
+    case NodeKind::ExpressionStatement: {
+        auto n = static_cast<const ExpressionStatement*>(node);
+        out += "\"ExpressionStatement\"";
+        key(out, "expression");
+        WriteJson(n->expr, out);
+        break;
+    }
+    case NodeKind::AssignStatement: {
+        auto n = static_cast<const AssignStatement*>(node);
+        out += "\"AssignStatement\"";
+        key(out, "name");
+        AppendJsonString(out, n->Name->Value());
+        key(out, "value");
+        WriteJson(n->Value, out);
+        break;
+    }
+    case NodeKind::BlockStatement: {
+        auto n = static_cast<const BlockStatement*>(node);
+        out += "\"BlockStatement\"";
+        key(out, "statements");
+        writeList(n->Statements, out);
+        break;
+    }
+    case NodeKind::WhileStatement: {
+        auto n = static_cast<const WhileStatement*>(node);
+        out += "\"WhileStatement\"";
+        key(out, "condition");
+        WriteJson(n->Condition, out);
+        key(out, "body");
+        WriteJson(n->Body, out);
+        break;
+    }
+    case NodeKind::Identifier: {
+        auto n = static_cast<const Identifier*>(node);
+        out += "\"Identifier\"";
+        key(out, "name");
+        AppendJsonString(out, n->Value());
+        break;
+    }
+    case NodeKind::Boolean: {
+        auto n = static_cast<const Boolean*>(node);
+        out += "\"Boolean\"";
+        key(out, "value");
+        out += n->Value ? "true" : "false";
+        break;
+    }
+    case NodeKind::IntegerLiteral: {
+        auto n = static_cast<const IntegerLiteral*>(node);
+        out += "\"IntegerLiteral\"";
+        key(out, "value");
+        out += std::to_string(n->Value);
+        break;
+    }
+    case NodeKind::PrefixExpression: {
+        auto n = static_cast<const PrefixExpression*>(node);
+        out += "\"PrefixExpression\"";
+        key(out, "operator");
+        AppendJsonString(out, n->Operator);
+        key(out, "right");
+        WriteJson(n->Right, out);
+        break;
+    }
+    case NodeKind::InfixExpression: {
+        auto n = static_cast<const InfixExpression*>(node);
+        out += "\"InfixExpression\"";
+        key(out, "operator");
+        AppendJsonString(out, n->Operator);
+        key(out, "left");
+        WriteJson(n->Left, out);
+        key(out, "right");
+        WriteJson(n->Right, out);
+        break;
+    }
+    case NodeKind::IfExpression: {
+        auto n = static_cast<const IfExpression*>(node);
+        out += "\"IfExpression\"";
+        key(out, "condition");
+        WriteJson(n->Condition, out);
+        key(out, "consequence");
+        WriteJson(n->Consequence, out);
+        key(out, "alternative");
+        WriteJson(n->Alternative, out);
+        break;
+    }
+    case NodeKind::FunctionLiteral: {
+        auto n = static_cast<const FunctionLiteral*>(node);
+        out += "\"FunctionLiteral\"";
+        key(out, "parameters");
+        out += '[';
+        for (size_t i = 0; i < n->Parameters.size(); i++) {
+            if (i > 0) out += ',';
+            AppendJsonString(out, n->Parameters[i]->Value());
+        }
+        out += ']';
+        key(out, "body");
+        WriteJson(n->Body, out);
+        break;
+    }
+    case NodeKind::CallExpression: {
+        auto n = static_cast<const CallExpression*>(node);
+        out += "\"CallExpression\"";
+        key(out, "function");
+        WriteJson(n->Function, out);
+        key(out, "arguments");
+        writeList(n->Arguments, out);
+        break;
+    }
+    case NodeKind::StringLiteral: {
+        auto n = static_cast<const StringLiteral*>(node);
+        out += "\"StringLiteral\"";
+        key(out, "value");
+        AppendJsonString(out, n->Value);
+        break;
+    }
+    case NodeKind::ArrayLiteral: {
+        auto n = static_cast<const ArrayLiteral*>(node);
+        out += "\"ArrayLiteral\"";
+        key(out, "elements");
+        writeList(n->Elements, out);
+        break;
+    }
+    case NodeKind::IndexExpression: {
+        auto n = static_cast<const IndexExpression*>(node);
+        out += "\"IndexExpression\"";
+        key(out, "left");
+        WriteJson(n->Left, out);
+        key(out, "index");
+        WriteJson(n->Index, out);
+        break;
+    }
+    case NodeKind::HashLiteral: {
+        auto n = static_cast<const HashLiteral*>(node);
+        out += "\"HashLiteral\"";
+        key(out, "pairs");
+        out += '[';
+        for (size_t i = 0; i < n->Pairs.size(); i++) {
+            if (i > 0) out += ',';
+            out += "{\"key\":";
+            WriteJson(n->Pairs[i].Key, out);
+            out += ",\"value\":";
+            WriteJson(n->Pairs[i].Value, out);
+            out += '}';
+        }
+        out += ']';
+        break;
+    }
+    }
+    out += '}';
+}
+
+std::string ToJson(const Node* node) {
+    std::string out;
+    WriteJson(node, out);
+    return out;
+}
+
+void WriteTokenJson(const Token& tok, size_t offset, std::string& out) {
+    out += "{\"type\":";
+    AppendJsonString(out, TokenTypeToString(tok.Type));
+    out += ",\"literal\":";
+    AppendJsonString(out, tok.Literal);
+    out += ",\"offset\":";
+    out += std::to_string(offset);
+    out += '}';
+}
+
+} // namespace YOXS_AST
@@ -0,0 +1,32 @@
+// ast_json.hpp
+#ifndef AST_JSON_H
+#define AST_JSON_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "ast.hpp"
+
+namespace YOXS_AST {
+
+// Appends s to out as a quoted JSON string.
+void AppendJsonString(std::string& out, std::string_view s);
+
+// Appends node and everything under it to out as JSON. Every node is an
+// object whose "type" is its class name, with one member per child:
+//   let x = 1 + 2;
+// becomes
+//   {"type":"LetStatement","name":"x","value":{"type":"InfixExpression",
+//    "operator":"+","left":{"type":"IntegerLiteral","value":1},
+//    "right":{"type":"IntegerLiteral","value":2}}}
+// A missing child, such as an if without an else, is null.
+void WriteJson(const Node* node, std::string& out);
+std::string ToJson(const Node* node);
+
+// Appends tok to out as {"type":"LET","literal":"let","offset":0}, where
+// offset is where the token starts in the source.
+void WriteTokenJson(const Token& tok, size_t offset, std::string& out);
+
+} // namespace YOXS_AST
+
+#endif // AST_JSON_H
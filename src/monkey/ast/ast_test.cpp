@@ -1,4 +1,5 @@
 #include "ast.hpp"
+#include "ast_json.hpp"
 #include <iostream>
 
 //AST Test: This tests the construction of an Abstract Syntax Tree (AST) and its string representation.
@@ -8,20 +9,20 @@ void TestString() {
     Program program;
 
     // Setting up the LetStatement
-    auto letStatement = std::make_shared<LetStatement>();
+    auto letStatement = program.New<LetStatement>();
     letStatement->token = Token{TokenType::LET, "let"};
 
     // Setting up the Name Identifier
-    auto name = std::make_shared<Identifier>();
+    auto name = program.New<Identifier>();
     name->token = Token{TokenType::IDENT, "myVar"};
-    letStatement->Name = std::move(name);
+    letStatement->Name = name;
 
     // Setting up the Value Identifier
-    auto value = std::make_shared<Identifier>();
+    auto value = program.New<Identifier>();
     value->token = Token{TokenType::IDENT, "anotherVar"};
-    letStatement->Value = std::move(value);
+    letStatement->Value = value;
 
-    program.Statements.push_back(std::move(letStatement));
+    program.Statements = program.List<Statement*>({letStatement});
 
     if (program.String() != "let myVar = anotherVar;") {
         std::cerr << "program.String() is wrong. got: " << program.String() << std::endl;
@@ -42,9 +43,12 @@ void TestStringLiteral() {
 }
 
 void TestArrayLiteral() {
+    Program program;
     ArrayLiteral arrLiteral(Token{TokenType::LBRACKET, "["});
-    arrLiteral.Elements.push_back(std::make_shared<IntegerLiteral>(Token{TokenType::INT, "1"}, 1));
-    arrLiteral.Elements.push_back(std::make_shared<IntegerLiteral>(Token{TokenType::INT, "2"}, 2));
+    arrLiteral.Elements = program.List<Expression*>({
+        program.New<IntegerLiteral>(Token{TokenType::INT, "1"}, 1),
+        program.New<IntegerLiteral>(Token{TokenType::INT, "2"}, 2),
+    });
 
     if (arrLiteral.String() != "[1, 2]") {
         std::cerr << "ArrayLiteral.String() is wrong. got: " << arrLiteral.String() << std::endl;
@@ -55,8 +59,9 @@ void TestArrayLiteral() {
 }
 
 void TestIndexExpression() {
-    auto leftExp = std::make_shared<Identifier>(Token{TokenType::IDENT, "myArray"}, "myArray");
-    auto indexExp = std::make_shared<IntegerLiteral>(Token{TokenType::INT, "0"});
+    Program program;
+    auto leftExp = program.New<Identifier>(Token{TokenType::IDENT, "myArray"}, "myArray");
+    auto indexExp = program.New<IntegerLiteral>(Token{TokenType::INT, "0"});
     indexExp->Value = 0;
     IndexExpression indexExpression(Token{TokenType::LBRACKET, "["}, leftExp);
     indexExpression.Index = indexExp;
@@ -70,10 +75,11 @@ void TestIndexExpression() {
 }
 
 void TestHashLiteral() {
+    Program program;
     HashLiteral hashLiteral(Token{TokenType::LBRACE, "{"});
-    auto key = std::make_shared<StringLiteral>(Token{TokenType::STRING, "\"key\""});
-    auto value = std::make_shared<StringLiteral>(Token{TokenType::STRING, "\"value\""});
-    hashLiteral.Pairs[key] = value;
+    auto key = program.New<StringLiteral>(Token{TokenType::STRING, "\"key\""});
+    auto value = program.New<StringLiteral>(Token{TokenType::STRING, "\"value\""});
+    hashLiteral.Pairs = program.List<HashLiteralPair>({{key, value}});
 
     if (hashLiteral.String() != "{\"key\":\"value\"}") {
         std::cerr << "HashLiteral.String() is wrong. got: " << hashLiteral.String() << std::endl;
@@ -83,12 +89,89 @@ void TestHashLiteral() {
     }
 }
 
+void TestNodeKind() {
+    Program program;
+    Token tok{TokenType::INT, "5"};
+    auto left = program.New<IntegerLiteral>(tok, 5);
+    auto index = program.New<IndexExpression>(Token{TokenType::LBRACKET, "["}, left);
+    Node* nodes[] = {&program, program.New<LetStatement>(), program.New<Identifier>(), left, index};
+    NodeKind expected[] = {NodeKind::Program, NodeKind::LetStatement, NodeKind::Identifier, NodeKind::IntegerLiteral, NodeKind::IndexExpression};
+
+    for (size_t i = 0; i < 5; i++) {
+        if (nodes[i]->Kind != expected[i]) {
+            std::cerr << "node " << i << " has the wrong Kind. got: " << static_cast<int>(nodes[i]->Kind) << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << "TestNodeKind passed!" << std::endl;
+}
+
+void TestArena() {
+    Program program;
+    std::vector<Expression*> elements;
+    for (int i = 0; i < 10000; i++) {
+        elements.push_back(program.New<IntegerLiteral>(Token{TokenType::INT, "7"}, i));
+    }
+    auto array = program.New<ArrayLiteral>(Token{TokenType::LBRACKET, "["});
+    array->Elements = program.List(elements);
+
+    if (program.NodeArena.ObjectCount() != 10001 || array->Elements.size() != 10000) {
+        std::cerr << "arena holds " << program.NodeArena.ObjectCount() << " objects, want 10001" << std::endl;
+        exit(1);
+    }
+    if (static_cast<IntegerLiteral*>(array->Elements[9999])->Value != 9999) {
+        std::cerr << "arena node was overwritten" << std::endl;
+        exit(1);
+    }
+    if (program.NodeArena.BytesReserved() < program.NodeArena.BytesUsed() || program.NodeArena.BytesUsed() < 10000 * sizeof(IntegerLiteral)) {
+        std::cerr << "arena byte accounting is wrong" << std::endl;
+        exit(1);
+    }
+    std::cout << "TestArena passed!" << std::endl;
+}
+
+void TestJson() {
+    Program program;
+    auto let = program.New<LetStatement>();
+    let->token = Token{TokenType::LET, "let"};
+    let->Name = program.New<Identifier>(Token{TokenType::IDENT, "s"}, "s");
+    auto call = program.New<CallExpression>(Token{TokenType::LPAREN, "("}, program.New<Identifier>(Token{TokenType::IDENT, "len"}, "len"));
+    auto str = program.New<StringLiteral>(Token{TokenType::STRING, "a\"b"}, "a\"b");
+    auto neg = program.New<PrefixExpression>(Token{TokenType::MINUS, "-"}, "-");
+    neg->Right = program.New<IntegerLiteral>(Token{TokenType::INT, "5"}, 5);
+    call->Arguments = program.List<Expression*>({str, neg});
+    let->Value = call;
+    auto ret = program.New<ReturnStatement>();
+    ret->token = Token{TokenType::RETURN, "return"};
+    program.Statements = program.List<Statement*>({let, ret});
+
+    std::string want = R"({"type":"Program","statements":[{"type":"LetStatement","name":"s","value":)"
+                       R"({"type":"CallExpression","function":{"type":"Identifier","name":"len"},"arguments":[)"
+                       R"({"type":"StringLiteral","value":"a\"b"},{"type":"PrefixExpression","operator":"-",)"
+                       R"("right":{"type":"IntegerLiteral","value":5}}]}},{"type":"ReturnStatement","value":null}]})";
+    if (ToJson(&program) != want) {
+        std::cerr << "ToJson is wrong. got: " << ToJson(&program) << std::endl;
+        exit(1);
+    }
+
+    std::string tok;
+    WriteTokenJson(Token{TokenType::STRING, "\n\t"}, 3, tok);
+    if (tok != R"({"type":"STRING","literal":"\n\t","offset":3})") {
+        std::cerr << "WriteTokenJson is wrong. got: " << tok << std::endl;
+        exit(1);
+    }
+    std::cout << "TestJson passed!" << std::endl;
+}
+
 int main() {
     TestString();
     TestStringLiteral();
     TestArrayLiteral();
     TestIndexExpression();
     TestHashLiteral();
+    TestNodeKind();
+    TestArena();
+    TestJson();
     std::cout << "all ast_test.cpp tests passed" << std::endl;
     return 0;
 }
@@ -0,0 +1,83 @@
+#include "../lexer/lexer.hpp"
+#include "../parser/parser.hpp"
+#include "../evaluator/evaluator.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+//Array Bench: Builds arrays one push at a time, comparing the copy-on-push that `push` used to do
+//with PersistentVector, and times a Monkey reducer that builds a 100k element array with push and
+//folds it back up with first and rest.
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// What `push` did before: copy every element into a new vector.
+double copyPush(size_t n) {
+    auto start = Clock::now();
+    auto arr = std::make_shared<ArrayObject>(std::vector<std::shared_ptr<Object>>{});
+    std::vector<std::shared_ptr<Object>> elements;
+    for (size_t i = 0; i < n; i++) {
+        elements.push_back(std::make_shared<Integer>(i));
+        arr = std::make_shared<ArrayObject>(elements);
+    }
+    return msSince(start);
+}
+
+double persistentPush(size_t n) {
+    auto start = Clock::now();
+    auto arr = std::make_shared<ArrayObject>(std::vector<std::shared_ptr<Object>>{});
+    for (size_t i = 0; i < n; i++) {
+        arr = std::make_shared<ArrayObject>(arr->Elements.PushBack(std::make_shared<Integer>(i)));
+    }
+    return msSince(start);
+}
+
+// Each level recurses at most 100 deep, which keeps the tree-walking
+// evaluator well inside the C++ stack.
+const std::string reducer = R"(
+let fill = fn(arr, i, n) { if (i == n) { arr } else { fill(push(arr, i), i + 1, n) } };
+let hundreds = fn(arr, i, n) { if (i == n) { arr } else { hundreds(fill(arr, i, i + 100), i + 100, n) } };
+let build = fn(arr, i, n) { if (i == n) { arr } else { build(hundreds(arr, i, i + 10000), i + 10000, n) } };
+
+let sumChunk = fn(arr, acc, k) { if (k == 0) { [arr, acc] } else { sumChunk(rest(arr), acc + first(arr), k - 1) } };
+let sumHundreds = fn(state, c) { if (c == 0) { state } else { sumHundreds(sumChunk(state[0], state[1], 100), c - 1) } };
+let sum = fn(state, c) { if (c == 0) { state[1] } else { sum(sumHundreds(state, 100), c - 1) } };
+
+let arr = build([], 0, 100000);
+let total = sum([arr, 0], 10);
+[len(arr), arr[0], arr[50000], arr[99999], total];
+)";
+
+int main() {
+    std::cout << std::left << std::setw(10) << "n" << std::right
+              << std::setw(14) << "copy ms" << std::setw(16) << "persistent ms" << std::endl;
+    for (size_t n : {1000, 10000, 30000, 100000}) {
+        std::cout << std::left << std::setw(10) << n << std::right << std::fixed << std::setprecision(2);
+        // Copying 100k times is quadratic and takes far too long to be worth waiting for.
+        if (n <= 30000) {
+            std::cout << std::setw(14) << copyPush(n);
+        } else {
+            std::cout << std::setw(14) << "-";
+        }
+        std::cout << std::setw(16) << persistentPush(n) << std::endl;
+    }
+
+    Lexer l(reducer);
+    Parser p(l);
+    auto program = p.ParseProgram();
+    if (!p.Errors().empty()) {
+        std::cerr << "parser error: " << p.Errors()[0] << std::endl;
+        return 1;
+    }
+    auto start = Clock::now();
+    auto result = Evaluator::Eval(program, std::make_shared<Environment>());
+    double ms = msSince(start);
+    std::cout << "\nmonkey reducer, 100k pushes then 100k first/rest: " << ms << " ms -> " << result->Inspect() << std::endl;
+    return 0;
+}
@@ -0,0 +1,342 @@
+#include "../lexer/lexer.hpp"
+#include "../parser/parser.hpp"
+#include "../evaluator/evaluator.hpp"
+#include "../evaluator/stack_evaluator.hpp"
+#include "../object/builtins.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+//Bench: Times lexing, parsing and evaluation of a fixed set of Monkey workloads separately, with
+//warmup runs, and reports the median and p99 of each phase. Results go to stdout as a table and to
+//a JSON file so runs from different commits can be compared.
+//
+//  bench.out [--reps N] [--warmup N] [--filter SUBSTRING] [--samples PATH] [--out PATH] [--commit ID] [--engine eval|stack]
+
+using Clock = std::chrono::steady_clock;
+
+struct Workload {
+    std::string name;
+    std::string source;
+};
+
+struct Phase {
+    std::vector<double> ns;
+
+    double percentile(double p) const {
+        std::vector<double> sorted = ns;
+        std::sort(sorted.begin(), sorted.end());
+        size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+        return sorted[rank > 0 ? rank - 1 : 0];
+    }
+    double median() const { return percentile(0.5); }
+};
+
+struct Result {
+    std::string name;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    std::string value;
+    std::vector<std::string> errors;
+    Phase lex, parse, eval;
+};
+
+double since(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// Monkey identifiers cannot contain digits, so generated names spell i in letters.
+std::string letters(int i) {
+    std::string out;
+    do {
+        out += char('a' + i % 26);
+        i /= 26;
+    } while (i > 0);
+    return out;
+}
+
+// About 1MB of top level functions, arithmetic and collections, all of which evaluate.
+std::string generatedSource() {
+    std::string out;
+    for (int i = 0; out.size() < (1 << 20); i++) {
+        std::string n = std::to_string(i), name = letters(i);
+        out += "let f_" + name + " = fn(a, b) { if (a > b) { return a * " + n + " + b; } else { return [a, b, \"s" + n + "\"][0]; } };\n";
+        out += "let x_" + name + " = (1 + 2 * " + n + " - -3) / (4 + " + n + ") == " + n + " != !true;\n";
+        out += "let h_" + name + " = {\"k\": [1, 2, " + n + "], \"v\": len(\"abc\"), " + n + ": {true: push([], " + n + ")}};\n";
+        out += "f_" + name + "(" + n + ", 7);\n";
+    }
+    return out;
+}
+
+std::string hashSource() {
+    std::string out = "let h = {";
+    for (int i = 0; i < 2000; i++) {
+        out += (i ? ", \"word" : "\"word") + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    out += "};\n";
+    out += "let lookups = fn(i, acc) { if (i == 0) { acc } else { lookups(i - 1, acc + h[\"word5\"] + h[\"word500\"] + h[\"word1999\"] + h[\"word77\"]) } };\n";
+    out += "let many = fn(j, acc) { if (j == 0) { acc } else { many(j - 1, lookups(100, acc)) } };\n";
+    out += "let build = fn(i) { if (i == 0) { 0 } else { let m = {";
+    for (int i = 0; i < 200; i++) {
+        out += (i ? ", " : "") + std::to_string(i * 7) + ": " + std::to_string(i);
+    }
+    out += "}; m[700] + build(i - 1) } };\n";
+    out += "[many(100, 0), build(300)];\n";
+    return out;
+}
+
+// Each recursion level stays at most 100 calls deep, well inside the evaluator's C++ stack.
+const std::string arraySource = R"(
+let fill = fn(arr, i, n) { if (i == n) { arr } else { fill(push(arr, i), i + 1, n) } };
+let hundreds = fn(arr, i, n) { if (i == n) { arr } else { hundreds(fill(arr, i, i + 100), i + 100, n) } };
+let build = fn(arr, i, n) { if (i == n) { arr } else { build(hundreds(arr, i, i + 10000), i + 10000, n) } };
+let sumChunk = fn(arr, acc, k) { if (k == 0) { [arr, acc] } else { sumChunk(rest(arr), acc + first(arr), k - 1) } };
+let sumHundreds = fn(state, c) { if (c == 0) { state } else { sumHundreds(sumChunk(state[0], state[1], 100), c - 1) } };
+let sum = fn(state, c) { if (c == 0) { state[1] } else { sum(sumHundreds(state, 100), c - 1) } };
+let arr = build([], 0, 100000);
+[len(arr), sum([arr, 0], 10)];
+)";
+
+const std::string stringSource = R"(
+let cat = fn(s, i) { if (i == 0) { s } else { cat(s + "abcdefghij", i - 1) } };
+let many = fn(s, j) { if (j == 0) { s } else { many(cat(s, 100), j - 1) } };
+len(many("", 100));
+)";
+
+// Reads the "name" and "code" strings of every object in the sample file, which is
+// a flat array of {"name": ..., "code": ...} objects.
+std::vector<Workload> readSamples(const std::string& path) {
+    std::vector<Workload> samples;
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "bench: cannot read " << path << ", skipping the sample programs" << std::endl;
+        return samples;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string json = buffer.str();
+
+    auto stringAfter = [&](const std::string& key, size_t& pos) -> std::string {
+        pos = json.find("\"" + key + "\"", pos);
+        if (pos == std::string::npos) return "";
+        pos = json.find('"', json.find(':', pos) + 1) + 1;
+        std::string out;
+        for (; pos < json.size() && json[pos] != '"'; pos++) {
+            char c = json[pos];
+            if (c == '\\' && pos + 1 < json.size()) {
+                c = json[++pos];
+                if (c == 'n') c = '\n';
+                else if (c == 't') c = '\t';
+            }
+            out += c;
+        }
+        return out;
+    };
+
+    size_t pos = 0;
+    while (true) {
+        std::string name = stringAfter("name", pos);
+        if (pos == std::string::npos) break;
+        std::string code = stringAfter("code", pos);
+        if (pos == std::string::npos) break;
+        std::string id = "sample/";
+        for (char c : name) {
+            if (std::isalnum(static_cast<unsigned char>(c))) id += char(std::tolower(c));
+            else if (id.back() != '_') id += '_';
+        }
+        samples.push_back({id, code});
+    }
+    return samples;
+}
+
+Result run(const Workload& w, int warmup, int reps, bool stack) {
+    Result r;
+    r.name = w.name;
+    r.bytes = w.source.size();
+    auto source = std::make_shared<const std::string>(w.source);
+
+    for (int i = 0; i < warmup + reps; i++) {
+        bool measured = i >= warmup;
+
+        auto start = Clock::now();
+        Lexer lexer(source);
+        auto buffer = lexer.TokenizeAll();
+        size_t tokens = buffer.Size() - 1;
+        double lexNs = since(start);
+
+        // The parser reads the tokens lexed above, so this is parsing alone.
+        start = Clock::now();
+        Parser p(buffer);
+        auto program = p.ParseProgram();
+        double parseNs = since(start);
+
+        if (!p.Errors().empty()) {
+            r.errors = p.Errors();
+            return r;
+        }
+
+        start = Clock::now();
+        auto result = stack ? StackEvaluator().Eval(program, std::make_shared<Environment>())
+                            : Evaluator::Eval(program, std::make_shared<Environment>());
+        double evalNs = since(start);
+
+        if (measured) {
+            r.tokens = tokens;
+            r.value = result ? result->Inspect() : "";
+            r.lex.ns.push_back(lexNs);
+            r.parse.ns.push_back(parseNs);
+            r.eval.ns.push_back(evalNs);
+        }
+
+        // Free this run's values now and let malloc coalesce them, rather
+        // than charging that to whichever phase of the next run allocates
+        // something large first.
+        result.reset();
+        program.reset();
+        YOXS_OBJECT::Heap::Collect();
+#ifdef __GLIBC__
+        malloc_trim(0);
+#endif
+    }
+    return r;
+}
+
+std::string escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+void writePhase(std::ostream& out, const char* name, const Phase& phase) {
+    out << "\"" << name << "\": {";
+    if (!phase.ns.empty()) {
+        double total = 0;
+        for (double ns : phase.ns) total += ns;
+        out << "\"median\": " << phase.median() << ", \"p99\": " << phase.percentile(0.99)
+            << ", \"min\": " << phase.percentile(0) << ", \"mean\": " << total / phase.ns.size();
+    }
+    out << "}";
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results, const std::string& commit, const std::string& engine, int warmup, int reps) {
+    out << std::fixed << std::setprecision(0);
+    out << "{\n  \"commit\": \"" << escape(commit) << "\",\n"
+        << "  \"engine\": \"" << engine << "\",\n"
+        << "  \"timestamp\": " << std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() << ",\n"
+        << "  \"compiler\": \"" << escape(__VERSION__) << "\",\n"
+        << "  \"warmup\": " << warmup << ",\n  \"reps\": " << reps << ",\n  \"unit\": \"ns\",\n  \"workloads\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << escape(r.name) << "\", \"bytes\": " << r.bytes << ", \"tokens\": " << r.tokens
+            << ", \"result\": \"" << escape(r.value.substr(0, 80)) << "\", \"errors\": [";
+        for (size_t e = 0; e < r.errors.size(); e++) out << (e ? ", " : "") << "\"" << escape(r.errors[e]) << "\"";
+        out << "], ";
+        writePhase(out, "lex", r.lex);
+        out << ", ";
+        writePhase(out, "parse", r.parse);
+        out << ", ";
+        writePhase(out, "eval", r.eval);
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    int reps = 10, warmup = 2;
+    std::string filter, samplesPath = "../python_interface/data/sample_files.json", outPath = "bench_results.json", commit, engine = "eval";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "bench: " << arg << " needs a value" << std::endl;
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--reps") reps = std::max(1, std::stoi(value));
+        else if (arg == "--warmup") warmup = std::max(0, std::stoi(value));
+        else if (arg == "--filter") filter = value;
+        else if (arg == "--samples") samplesPath = value;
+        else if (arg == "--out") outPath = value;
+        else if (arg == "--commit") commit = value;
+        else if (arg == "--engine") {
+            if (value != "eval" && value != "stack") {
+                std::cerr << "bench: unknown engine " << value << std::endl;
+                return 2;
+            }
+            engine = value;
+        }
+        else {
+            std::cerr << "bench: unknown option " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<Workload> workloads = {
+        {"fib/25", "let fib = fn(x) { if (x < 2) { x } else { fib(x - 1) + fib(x - 2) } }; fib(25);"},
+        {"fib/30", "let fib = fn(x) { if (x < 2) { x } else { fib(x - 1) + fib(x - 2) } }; fib(30);"},
+        {"array/push_rest_100k", arraySource},
+        {"hash/literals_and_lookups", hashSource()},
+        {"string/concat_10k", stringSource},
+        {"generated/1mb", generatedSource()},
+    };
+    for (auto& s : readSamples(samplesPath)) workloads.push_back(s);
+
+    // Sample programs call puts; keep that out of the terminal and the timings.
+    std::ostream discard(nullptr);
+    std::ostream& previous = YOXS_OBJECT::SetOutput(discard);
+
+    std::cout << std::left << std::setw(40) << "workload" << std::right
+              << std::setw(12) << "lex med" << std::setw(12) << "lex p99"
+              << std::setw(12) << "parse med" << std::setw(12) << "parse p99"
+              << std::setw(12) << "eval med" << std::setw(12) << "eval p99" << "   (ms)" << std::endl;
+
+    std::vector<Result> results;
+    for (const auto& w : workloads) {
+        if (!filter.empty() && w.name.find(filter) == std::string::npos) continue;
+        Result r = run(w, warmup, reps, engine == "stack");
+        std::cout << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(3);
+        if (!r.errors.empty()) {
+            std::cout << "  parser error: " << r.errors[0] << std::endl;
+        } else {
+            for (const Phase* phase : {&r.lex, &r.parse, &r.eval}) {
+                std::cout << std::setw(12) << phase->median() / 1e6 << std::setw(12) << phase->percentile(0.99) / 1e6;
+            }
+            std::cout << std::endl;
+        }
+        results.push_back(std::move(r));
+    }
+    YOXS_OBJECT::SetOutput(previous);
+
+    std::ofstream out(outPath);
+    if (!out) {
+        std::cerr << "bench: cannot write " << outPath << std::endl;
+        return 1;
+    }
+    writeJson(out, results, commit, engine, warmup, reps);
+    std::cout << "\nwrote " << outPath << std::endl;
+    return 0;
+}
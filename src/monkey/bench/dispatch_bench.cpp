@@ -0,0 +1,206 @@
+#include "../lexer/lexer.hpp"
+#include "../parser/parser.hpp"
+#include "../evaluator/evaluator.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+//Dispatch Bench: Measures the per-node cost of picking a handler for an AST node, comparing the
+//old dynamic cast ladder from Evaluator::Eval against the NodeKind switch, on the sample programs.
+
+using Clock = std::chrono::steady_clock;
+
+struct Sample {
+    std::string name;
+    std::string code;
+};
+
+// The programs from python_interface/data/sample_files.json, with puts dropped so the
+// evaluation timings do not include terminal output.
+const std::vector<Sample> samples = {
+    {"Factorial Program", "let factorial = fn(n) { if (n == 0) { return 1; } else { return n * factorial(n - 1); } }; factorial(20);"},
+    {"Working with Arrays & Recursion", "let array = [1, 2, 3, 4, 5]; let sum = fn(arr, i) { if (i == len(arr)) { return 0; } else { return arr[i] + sum(arr, i + 1); } }; sum(array, 0);"},
+    {"Calculate the Power of a Number", "let power = fn(base, exp) { if (exp == 0) { return 1; } else { return base * power(base, exp - 1); } }; power(2, 30);"},
+    {"Simple Calculator", "let add = fn(a, b) { return a + b; }; let subtract = fn(a, b) { return a - b; }; let multiply = fn(a, b) { return a * b; }; let divide = fn(a, b) { return a / b; }; \"Add: \" + add(10, 5); \"Subtract: \" + subtract(10, 5); \"Multiply: \" + multiply(10, 5); \"Divide: \" + divide(10, 5);"},
+    {"Recursive String Reverse", "let reverse = fn(s) { let helper = fn(s, i) { if (i < 0) { return \"\"; } else { return s[i] + helper(s, i - 1); } }; return helper(s, len(s) - 1); }; reverse(\"Monkey\");"},
+    {"Hashes and Indexing", "let people = [{\"name\": \"Alice\", \"age\": 24}, {\"name\": \"Anna\", \"age\": 28}]; let getAge = fn(p) { p[\"age\"] }; getAge(people[0]) + getAge(people[1]);"},
+};
+
+// Flattens the tree so both dispatchers see exactly the same node sequence.
+void collect(Node* node, std::vector<Node*>& out) {
+    if (!node) return;
+    out.push_back(node);
+
+    switch (node->Kind) {
+    case NodeKind::Program:
+        for (auto& s : static_cast<Program*>(node)->Statements) collect(s, out);
+        break;
+    case NodeKind::BlockStatement:
+        for (auto& s : static_cast<BlockStatement*>(node)->Statements) collect(s, out);
+        break;
+    case NodeKind::LetStatement:
+        collect(static_cast<LetStatement*>(node)->Value, out);
+        break;
+    case NodeKind::ReturnStatement:
+        collect(static_cast<ReturnStatement*>(node)->ReturnValue, out);
+        break;
+    case NodeKind::ExpressionStatement:
+        collect(static_cast<ExpressionStatement*>(node)->expr, out);
+        break;
+    case NodeKind::PrefixExpression:
+        collect(static_cast<PrefixExpression*>(node)->Right, out);
+        break;
+    case NodeKind::InfixExpression: {
+        auto n = static_cast<InfixExpression*>(node);
+        collect(n->Left, out);
+        collect(n->Right, out);
+        break;
+    }
+    case NodeKind::IfExpression: {
+        auto n = static_cast<IfExpression*>(node);
+        collect(n->Condition, out);
+        collect(n->Consequence, out);
+        collect(n->Alternative, out);
+        break;
+    }
+    case NodeKind::FunctionLiteral: {
+        auto n = static_cast<FunctionLiteral*>(node);
+        for (auto& p : n->Parameters) collect(p, out);
+        collect(n->Body, out);
+        break;
+    }
+    case NodeKind::CallExpression: {
+        auto n = static_cast<CallExpression*>(node);
+        collect(n->Function, out);
+        for (auto& a : n->Arguments) collect(a, out);
+        break;
+    }
+    case NodeKind::ArrayLiteral:
+        for (auto& e : static_cast<ArrayLiteral*>(node)->Elements) collect(e, out);
+        break;
+    case NodeKind::IndexExpression: {
+        auto n = static_cast<IndexExpression*>(node);
+        collect(n->Left, out);
+        collect(n->Index, out);
+        break;
+    }
+    case NodeKind::HashLiteral:
+        for (auto& pair : static_cast<HashLiteral*>(node)->Pairs) {
+            collect(pair.Key, out);
+            collect(pair.Value, out);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// The dispatch Evaluator::Eval used before NodeKind, in the same order. Nodes are
+// raw arena pointers now, so this leaves out the refcount traffic the old
+// dynamic_pointer_cast ladder also paid.
+__attribute__((noinline)) int ladderDispatch(Node* node) {
+    if (dynamic_cast<Program*>(node)) return 0;
+    else if (dynamic_cast<BlockStatement*>(node)) return 1;
+    else if (dynamic_cast<ExpressionStatement*>(node)) return 2;
+    else if (dynamic_cast<ReturnStatement*>(node)) return 3;
+    else if (dynamic_cast<LetStatement*>(node)) return 4;
+    else if (dynamic_cast<IntegerLiteral*>(node)) return 5;
+    else if (dynamic_cast<StringLiteral*>(node)) return 6;
+    else if (dynamic_cast<Boolean*>(node)) return 7;
+    else if (dynamic_cast<PrefixExpression*>(node)) return 8;
+    else if (dynamic_cast<InfixExpression*>(node)) return 9;
+    else if (dynamic_cast<IfExpression*>(node)) return 10;
+    else if (dynamic_cast<Identifier*>(node)) return 11;
+    else if (dynamic_cast<FunctionLiteral*>(node)) return 12;
+    else if (dynamic_cast<CallExpression*>(node)) return 13;
+    else if (dynamic_cast<ArrayLiteral*>(node)) return 14;
+    else if (dynamic_cast<IndexExpression*>(node)) return 15;
+    else if (dynamic_cast<HashLiteral*>(node)) return 16;
+    else if (dynamic_cast<AssignStatement*>(node)) return 17;
+    else if (dynamic_cast<WhileStatement*>(node)) return 18;
+    return -1;
+}
+
+// The dispatch Evaluator::Eval uses now.
+__attribute__((noinline)) int tagDispatch(Node* node) {
+    switch (node->Kind) {
+    case NodeKind::Program: return 0;
+    case NodeKind::BlockStatement: return 1;
+    case NodeKind::ExpressionStatement: return 2;
+    case NodeKind::ReturnStatement: return 3;
+    case NodeKind::LetStatement: return 4;
+    case NodeKind::IntegerLiteral: return 5;
+    case NodeKind::StringLiteral: return 6;
+    case NodeKind::Boolean: return 7;
+    case NodeKind::PrefixExpression: return 8;
+    case NodeKind::InfixExpression: return 9;
+    case NodeKind::IfExpression: return 10;
+    case NodeKind::Identifier: return 11;
+    case NodeKind::FunctionLiteral: return 12;
+    case NodeKind::CallExpression: return 13;
+    case NodeKind::ArrayLiteral: return 14;
+    case NodeKind::IndexExpression: return 15;
+    case NodeKind::HashLiteral: return 16;
+    case NodeKind::AssignStatement: return 17;
+    case NodeKind::WhileStatement: return 18;
+    }
+    return -1;
+}
+
+template <typename F>
+double nsPerNode(const std::vector<Node*>& nodes, int iterations, F dispatch, long& checksum) {
+    checksum = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (const auto& n : nodes) {
+            checksum += dispatch(n);
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+    return elapsed.count() / (double(nodes.size()) * iterations);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::stoi(argv[1]) : 20000;
+
+    std::cout << std::left << std::setw(34) << "program" << std::right
+              << std::setw(8) << "nodes" << std::setw(14) << "ladder ns" << std::setw(14) << "kind ns"
+              << std::setw(10) << "speedup" << std::setw(14) << "eval us" << std::endl;
+
+    for (const auto& sample : samples) {
+        Lexer l(sample.code);
+        Parser p(l);
+        auto program = p.ParseProgram();
+        if (!p.Errors().empty()) {
+            std::cerr << sample.name << ": parser error: " << p.Errors()[0] << std::endl;
+            return 1;
+        }
+
+        std::vector<Node*> nodes;
+        collect(program.get(), nodes);
+
+        long ladderSum = 0, tagSum = 0;
+        nsPerNode(nodes, iterations / 10 + 1, ladderDispatch, ladderSum); // warmup
+        double ladder = nsPerNode(nodes, iterations, ladderDispatch, ladderSum);
+        nsPerNode(nodes, iterations / 10 + 1, tagDispatch, tagSum); // warmup
+        double tag = nsPerNode(nodes, iterations, tagDispatch, tagSum);
+        if (ladderSum != tagSum) {
+            std::cerr << sample.name << ": dispatchers disagree" << std::endl;
+            return 1;
+        }
+
+        int evalRuns = 200;
+        auto start = Clock::now();
+        for (int i = 0; i < evalRuns; i++) {
+            Evaluator::Eval(program, std::make_shared<Environment>());
+        }
+        std::chrono::duration<double, std::micro> evalTime = Clock::now() - start;
+
+        std::cout << std::left << std::setw(34) << sample.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(8) << nodes.size() << std::setw(14) << ladder << std::setw(14) << tag
+                  << std::setw(9) << ladder / tag << "x" << std::setw(14) << evalTime.count() / evalRuns << std::endl;
+    }
+    return 0;
+}
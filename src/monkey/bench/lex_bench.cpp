@@ -0,0 +1,94 @@
+#include "../lexer/lexer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+//Lex Bench: Tokenizes generated ~8MB Monkey sources with every scanner this CPU runs
+//(see lexer/scan.hpp) and reports lexer throughput and tokens per second.
+
+using Clock = std::chrono::steady_clock;
+
+struct Workload {
+    std::string name;
+    std::string (*chunk)(int i);
+};
+
+// Monkey identifiers cannot contain digits, so generated names spell i in letters.
+std::string letters(int i) {
+    std::string out;
+    do {
+        out += char('a' + i % 26);
+        i /= 26;
+    } while (i > 0);
+    return out;
+}
+
+// Ordinary code: short identifiers, numbers and single spaces.
+std::string codeChunk(int i) {
+    std::string n = std::to_string(i);
+    return "let f_" + letters(i) + " = fn(a, b) { if (a > b) { return a * " + n + " + b; } else { return [a, b, \"s" + n + "\"][0]; } };\n";
+}
+
+// Deeply indented code with blank lines between statements.
+std::string indentedChunk(int i) {
+    std::string indent(4 * (1 + i % 8), ' ');
+    return indent + "let value_" + letters(i) + " = compute_" + letters(i + 1) + "(value, other);\n\n" + indent + "\t\n";
+}
+
+// Long string literals, long names and long numbers.
+std::string literalsChunk(int i) {
+    return "let a_rather_long_descriptive_name_" + letters(i) + " = \"a string literal of a good length, as a message or a template would be\";\n"
+           "let another_long_variable_name_" + letters(i) + " = 12345678901234567 + 98765432109876543;\n";
+}
+
+std::string generate(std::string (*chunk)(int), size_t targetBytes) {
+    std::string out;
+    for (int i = 0; out.size() < targetBytes; i++) {
+        out += chunk(i);
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    const size_t targetBytes = 8 << 20;
+    int runs = argc > 1 ? std::stoi(argv[1]) : 7;
+
+    std::vector<Workload> workloads = {
+        {"code", codeChunk},
+        {"indented", indentedChunk},
+        {"literals", literalsChunk},
+    };
+
+    std::cout << std::left << std::setw(12) << "workload" << std::setw(10) << "scanner" << std::right
+              << std::setw(10) << "MB" << std::setw(10) << "ms" << std::setw(10) << "MB/s"
+              << std::setw(12) << "Mtokens/s" << std::endl;
+
+    for (const auto& w : workloads) {
+        auto source = std::make_shared<const std::string>(generate(w.chunk, targetBytes));
+        for (const Scanner* scanner : Scanner::Available()) {
+            std::vector<double> lexMs;
+            size_t tokens = 0;
+
+            for (int r = 0; r < runs; r++) {
+                auto start = Clock::now();
+                Lexer l(source, *scanner);
+                tokens = l.TokenizeAll().Size();
+                std::chrono::duration<double, std::milli> lexed = Clock::now() - start;
+                lexMs.push_back(lexed.count());
+            }
+
+            std::sort(lexMs.begin(), lexMs.end());
+            double ms = lexMs[lexMs.size() / 2];
+            double mb = source->size() / 1048576.0;
+
+            std::cout << std::left << std::setw(12) << w.name << std::setw(10) << scanner->Name << std::right
+                      << std::fixed << std::setprecision(2)
+                      << std::setw(10) << mb << std::setw(10) << ms << std::setw(10) << mb / (ms / 1000.0)
+                      << std::setw(12) << tokens / (ms * 1000.0) << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "../lexer/lexer.hpp"
+#include "../parser/parser.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <string>
+#include <vector>
+
+//Parse Bench: Lexes and parses generated ~1MB Monkey sources and reports throughput, AST nodes,
+//arena bytes per node, heap allocations made while parsing and the time it takes to free the Program.
+
+using Clock = std::chrono::steady_clock;
+
+static size_t heapAllocations = 0;
+static size_t heapBytes = 0;
+
+void* operator new(size_t size) {
+    heapAllocations++;
+    heapBytes += size;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+struct Workload {
+    std::string name;
+    std::string (*chunk)(int i);
+};
+
+// Monkey identifiers cannot contain digits, so generated names spell i in letters.
+std::string letters(int i) {
+    std::string out;
+    do {
+        out += char('a' + i % 26);
+        i /= 26;
+    } while (i > 0);
+    return out;
+}
+
+std::string functionsChunk(int i) {
+    std::string n = std::to_string(i);
+    return "let f_" + letters(i) + " = fn(a, b) { if (a > b) { return a * " + n + " + b; } else { return [a, b, \"s" + n + "\"][0]; } };\n";
+}
+
+std::string expressionsChunk(int i) {
+    std::string n = std::to_string(i);
+    return "let x_" + letters(i) + " = (1 + 2 * " + n + " - -3) / (4 + " + n + ") == " + n + " != !true;\n";
+}
+
+std::string collectionsChunk(int i) {
+    std::string n = std::to_string(i);
+    return "let h_" + letters(i) + " = {\"k\": [1, 2, " + n + "], \"v\": len(\"abc\"), " + n + ": {true: push([], " + n + ")}};\n";
+}
+
+std::string generate(std::string (*chunk)(int), size_t targetBytes) {
+    std::string out;
+    for (int i = 0; out.size() < targetBytes; i++) {
+        out += chunk(i);
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    const size_t targetBytes = 1 << 20;
+    int runs = argc > 1 ? std::stoi(argv[1]) : 7;
+
+    std::vector<Workload> workloads = {
+        {"functions", functionsChunk},
+        {"expressions", expressionsChunk},
+        {"collections", collectionsChunk},
+    };
+
+    std::cout << std::left << std::setw(14) << "workload" << std::right
+              << std::setw(10) << "MB" << std::setw(10) << "ms" << std::setw(10) << "MB/s"
+              << std::setw(10) << "nodes" << std::setw(12) << "bytes/node" << std::setw(14) << "allocs/node"
+              << std::setw(10) << "free us" << std::endl;
+
+    for (const auto& w : workloads) {
+        std::string source = generate(w.chunk, targetBytes);
+        std::vector<double> parseMs, freeUs;
+        size_t nodes = 0, arenaBytes = 0, allocations = 0;
+
+        for (int r = 0; r < runs; r++) {
+            size_t allocsBefore = heapAllocations;
+            auto start = Clock::now();
+            Lexer l(source);
+            Parser p(l);
+            auto program = p.ParseProgram();
+            std::chrono::duration<double, std::milli> parsed = Clock::now() - start;
+            if (!p.Errors().empty()) {
+                std::cerr << w.name << ": parser error: " << p.Errors()[0] << std::endl;
+                return 1;
+            }
+            allocations = heapAllocations - allocsBefore;
+            nodes = program->NodeArena.ObjectCount();
+            arenaBytes = program->NodeArena.BytesUsed();
+            parseMs.push_back(parsed.count());
+
+            start = Clock::now();
+            program.reset();
+            std::chrono::duration<double, std::micro> freed = Clock::now() - start;
+            freeUs.push_back(freed.count());
+        }
+
+        std::sort(parseMs.begin(), parseMs.end());
+        std::sort(freeUs.begin(), freeUs.end());
+        double ms = parseMs[parseMs.size() / 2];
+        double mb = source.size() / 1048576.0;
+
+        std::cout << std::left << std::setw(14) << w.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << mb << std::setw(10) << ms << std::setw(10) << mb / (ms / 1000.0)
+                  << std::setw(10) << nodes << std::setw(12) << double(arenaBytes) / nodes
+                  << std::setw(14) << double(allocations) / nodes
+                  << std::setw(10) << freeUs[freeUs.size() / 2] << std::endl;
+    }
+    return 0;
+}
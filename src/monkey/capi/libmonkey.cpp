@@ -0,0 +1,229 @@
+// libmonkey.cpp
+#include "libmonkey.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "../ast/ast_json.hpp"
+#include "../repl/repl.hpp"
+
+struct monkey_interp {
+    Session session;
+    std::thread::id owner = std::this_thread::get_id();
+
+    explicit monkey_interp(Engine engine) : session(engine) {}
+};
+
+namespace {
+
+// Copies s into memory monkey_string_free releases.
+char* release(const std::string& s) {
+    char* out = static_cast<char*>(std::malloc(s.size() + 1));
+    if (out) {
+        std::memcpy(out, s.c_str(), s.size() + 1);
+    }
+    return out;
+}
+
+// Points puts at out for as long as it lives, even if the run throws.
+class OutputTo {
+public:
+    explicit OutputTo(std::ostream& out) : previous(SetOutput(out)) {}
+    ~OutputTo() { SetOutput(previous); }
+
+private:
+    std::ostream& previous;
+};
+
+std::string failure(const std::string& message) {
+    std::string out = "{\"ok\":false,\"errors\":[";
+    YOXS_AST::AppendJsonString(out, message);
+    return out + "]}";
+}
+
+void appendErrors(std::string& out, const std::vector<std::string>& errors) {
+    out += ",\"errors\":[";
+    for (size_t i = 0; i < errors.size(); i++) {
+        if (i > 0) out += ',';
+        YOXS_AST::AppendJsonString(out, errors[i]);
+    }
+    out += ']';
+}
+
+// The members every run reports after its own: errors, limit, timings and
+// counters.
+void appendReport(std::string& out, const RunReport& report, int64_t totalNs) {
+    appendErrors(out, report.Errors);
+    if (!report.Limit.empty()) {
+        out += ",\"limit\":\"" + report.Limit + "\"";
+    }
+    out += ",\"timings_ns\":{\"lex\":" + std::to_string(report.LexNs);
+    out += ",\"parse\":" + std::to_string(report.ParseNs);
+    out += ",\"compile\":" + std::to_string(report.CompileNs);
+    out += ",\"eval\":" + std::to_string(report.EvalNs);
+    out += ",\"total\":" + std::to_string(totalNs) + "}";
+    AppendCountersJson(out, report);
+    out += '}';
+}
+
+// Runs source in interp with run, which fills in the report and writes the
+// output. Anything thrown becomes an error, since nothing may cross the C ABI.
+template <class F>
+char* guarded(monkey_interp* interp, const char* source, F run) {
+    try {
+        if (!interp || !source) {
+            return release(failure("no interpreter or no source"));
+        }
+        if (interp->owner != std::this_thread::get_id()) {
+            return release(failure("interpreter used from a thread other than the one that created it"));
+        }
+        return release(run());
+    } catch (const std::exception& e) {
+        return release(failure(std::string("internal error: ") + e.what()));
+    } catch (...) {
+        return release(failure("internal error"));
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+int monkey_abi_version(void) {
+    return MONKEY_ABI_VERSION;
+}
+
+monkey_interp* monkey_new(const char* engine) {
+    Engine e = Engine::EVAL;
+    if (engine && std::strcmp(engine, "stack") == 0) {
+        e = Engine::STACK;
+    } else if (engine && std::strcmp(engine, "vm") == 0) {
+        e = Engine::VM;
+    } else if (engine && std::strcmp(engine, "eval") != 0) {
+        return nullptr;
+    }
+    try {
+        return new monkey_interp(e);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void monkey_free(monkey_interp* interp) {
+    // Its values are linked into the owning thread's heap; freeing them from
+    // another thread would corrupt that heap, so such an interpreter leaks.
+    if (interp && interp->owner == std::this_thread::get_id()) {
+        delete interp;
+    }
+}
+
+void monkey_set_limits(monkey_interp* interp, uint64_t max_steps, uint64_t max_heap_bytes, uint64_t timeout_ms) {
+    if (!interp) {
+        return;
+    }
+    ExecutionLimits limits;
+    limits.MaxSteps = max_steps;
+    limits.MaxHeapBytes = max_heap_bytes;
+    // As in the server, anything near the range of nanoseconds is no limit.
+    limits.Timeout = std::chrono::milliseconds(std::min<uint64_t>(timeout_ms, uint64_t(1) << 40));
+    interp->session.Limits = limits;
+}
+
+char* monkey_eval(monkey_interp* interp, const char* source) {
+    return guarded(interp, source, [&] {
+        auto start = std::chrono::steady_clock::now();
+        RunReport report;
+        std::ostringstream output;
+        {
+            OutputTo capture(output);
+            REPL::Run(source, interp->session, report);
+        }
+        auto total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        bool ok = report.Errors.empty();
+        std::string out = ok ? "{\"ok\":true,\"result\":" : "{\"ok\":false,\"result\":";
+        if (ok) {
+            YOXS_AST::AppendJsonString(out, report.Result);
+            out += ",\"type\":";
+            YOXS_AST::AppendJsonString(out, report.ResultType);
+        } else {
+            out += "null,\"type\":null";
+        }
+        out += ",\"output\":";
+        YOXS_AST::AppendJsonString(out, output.str());
+        appendReport(out, report, total.count());
+        return out;
+    });
+}
+
+char* monkey_run(monkey_interp* interp, const char* source) {
+    return guarded(interp, source, [&] {
+        auto start = std::chrono::steady_clock::now();
+        RunReport report;
+        std::ostringstream output;
+        {
+            OutputTo capture(output);
+            REPL::RunSingle(source, output, interp->session, &report);
+        }
+        auto total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        std::string out = report.Errors.empty() ? "{\"ok\":true,\"output\":" : "{\"ok\":false,\"output\":";
+        YOXS_AST::AppendJsonString(out, output.str());
+        appendReport(out, report, total.count());
+        return out;
+    });
+}
+
+char* monkey_pipeline(monkey_interp* interp, const char* source) {
+    return guarded(interp, source, [&] { return REPL::RunJson(source, interp->session); });
+}
+
+char* monkey_tokens(const char* source) {
+    try {
+        std::string out = "[";
+        if (source) {
+            Interner names;
+            Interner::Use use(names);
+            Lexer l(source);
+            TokenBuffer tokens = l.TokenizeAll();
+            for (size_t i = 0; i + 1 < tokens.Size(); i++) {
+                if (i > 0) out += ',';
+                YOXS_AST::WriteTokenJson(tokens.At(i), tokens.Offsets[i], out);
+            }
+        }
+        return release(out + "]");
+    } catch (...) {
+        return release("[]");
+    }
+}
+
+char* monkey_ast(const char* source) {
+    try {
+        Interner names;
+        Interner::Use use(names);
+        Lexer l(source ? source : "");
+        Parser p(l);
+        auto program = p.ParseProgram();
+        bool ok = p.Errors().empty();
+        std::string out = ok ? "{\"ok\":true,\"ast\":" : "{\"ok\":false,\"ast\":null";
+        if (ok) {
+            YOXS_AST::WriteJson(program.get(), out);
+        }
+        appendErrors(out, p.Errors());
+        return release(out + "}");
+    } catch (const std::exception& e) {
+        return release(failure(std::string("internal error: ") + e.what()));
+    } catch (...) {
+        return release(failure("internal error"));
+    }
+}
+
+void monkey_string_free(char* s) {
+    std::free(s);
+}
+
+} // extern "C"
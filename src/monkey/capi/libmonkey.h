@@ -0,0 +1,97 @@
+/* libmonkey.h */
+#ifndef LIBMONKEY_H
+#define LIBMONKEY_H
+
+#include <stdint.h>
+
+/*
+ * libmonkey is the interpreter as a shared library with a C ABI, so a host
+ * such as Python's ctypes can run programs in its own process instead of
+ * talking to monkey_repl over a pipe.
+ *
+ * Every function that returns char* returns a JSON document allocated by
+ * the library, which the caller releases with monkey_string_free. They
+ * only return NULL when out of memory, and none of them throws.
+ *
+ * An interpreter keeps its values in the heap of the thread that created
+ * it, so it must only be used and freed on that thread. Calls from any
+ * other thread fail with an error instead of touching it. Different
+ * threads can each run interpreters of their own at the same time.
+ */
+
+#if defined(__GNUC__)
+#define MONKEY_API __attribute__((visibility("default")))
+#else
+#define MONKEY_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a function changes its signature or meaning. */
+#define MONKEY_ABI_VERSION 1
+
+typedef struct monkey_interp monkey_interp;
+
+MONKEY_API int monkey_abi_version(void);
+
+/*
+ * Creates an interpreter running on engine, "eval", "stack" or "vm", or
+ * "eval" if engine is NULL. Returns NULL for an unknown engine. Everything
+ * one monkey_eval defines is visible to the next, as in a REPL session.
+ */
+MONKEY_API monkey_interp* monkey_new(const char* engine);
+MONKEY_API void monkey_free(monkey_interp* interp);
+
+/* Sets the limits every later run is held to; 0 means no limit. */
+MONKEY_API void monkey_set_limits(monkey_interp* interp, uint64_t max_steps, uint64_t max_heap_bytes, uint64_t timeout_ms);
+
+/*
+ * Runs source and returns
+ *   {"ok":true,"result":"3","type":"INTEGER","output":"","errors":[],
+ *    "timings_ns":{"lex":..,"parse":..,"compile":..,"eval":..,"total":..},
+ *    "counters":{"tokens":..,"ast_nodes":..,"steps":..,"calls":..,
+ *                "environments":..,"max_env_depth":..,"allocated":{..}}}
+ * where output is what puts printed and allocated counts the objects
+ * created by type. A run that fails has "ok":false,
+ * null result and type, and the messages in errors; one stopped by a
+ * limit also has "limit":"steps", "heap", "timeout" or "stack".
+ */
+MONKEY_API char* monkey_eval(monkey_interp* interp, const char* source);
+
+/*
+ * Runs source like monkey_eval, but answers as monkey_repl --server does:
+ * output is the whole trace StartSingle prints, tokens and AST included,
+ * and there is no result or type.
+ */
+MONKEY_API char* monkey_run(monkey_interp* interp, const char* source);
+
+/*
+ * Runs source and returns what REPL::RunJson does: one document with the
+ * tokens, the AST, the result, what puts printed, the time each stage
+ * took and the counters, from a single pass over the source.
+ */
+MONKEY_API char* monkey_pipeline(monkey_interp* interp, const char* source);
+
+/*
+ * The tokens of source, as
+ *   [{"type":"LET","literal":"let","offset":0}, ...]
+ * without the final EOF.
+ */
+MONKEY_API char* monkey_tokens(const char* source);
+
+/*
+ * Parses source and returns {"ok":true,"ast":{...},"errors":[]}, with the
+ * tree in the shape ast/ast_json.hpp describes, or "ok":false and a null
+ * ast if it does not parse.
+ */
+MONKEY_API char* monkey_ast(const char* source);
+
+MONKEY_API void monkey_string_free(char* s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBMONKEY_H */
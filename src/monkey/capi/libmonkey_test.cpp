@@ -0,0 +1,128 @@
+#include "libmonkey.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//libmonkey Test: This tests the C API of libmonkey.so through the library
+//itself, as a host would load it.
+
+bool contains(const std::string& haystack, const std::string& needle) {
+    return haystack.find(needle) != std::string::npos;
+}
+
+// Takes a string the library returned and frees it.
+std::string take(char* s) {
+    if (!s) {
+        std::cerr << "libmonkey returned NULL" << std::endl;
+        exit(1);
+    }
+    std::string out(s);
+    monkey_string_free(s);
+    return out;
+}
+
+void expect(const std::string& got, const std::vector<std::string>& wants, const std::string& what) {
+    for (const auto& want : wants) {
+        if (!contains(got, want)) {
+            std::cerr << what << ": want " << want << " in " << got << std::endl;
+            exit(1);
+        }
+    }
+}
+
+void TestEval() {
+    if (monkey_abi_version() != MONKEY_ABI_VERSION) {
+        std::cerr << "monkey_abi_version() = " << monkey_abi_version() << std::endl;
+        exit(1);
+    }
+    if (monkey_new("jit") != nullptr) {
+        std::cerr << "monkey_new accepted an unknown engine" << std::endl;
+        exit(1);
+    }
+
+    for (const char* engine : {"eval", "stack", "vm"}) {
+        monkey_interp* interp = monkey_new(engine);
+        std::string what = std::string("monkey_eval on ") + engine;
+        expect(take(monkey_eval(interp, "let add = fn(a, b) { a + b }; puts(\"hi\"); add(1, 2)")),
+               {R"({"ok":true,"result":"3","type":"INTEGER","output":"hi\n","errors":[])", R"("timings_ns":{)"}, what);
+        // Later runs see what earlier ones defined.
+        expect(take(monkey_eval(interp, "[add(2, 3), \"x\"]")), {R"("result":"[5, x]","type":"ARRAY")"}, what);
+        expect(take(monkey_eval(interp, "add(1, true)")), {R"({"ok":false,"result":null,"type":null)", "type mismatch"}, what);
+        expect(take(monkey_eval(interp, "let = 1")), {R"("ok":false)", "expected next token to be IDENT"}, what);
+        expect(take(monkey_pipeline(interp, "add(4, 5)")),
+               {R"({"ok":true,"tokens":[{"type":"IDENT","literal":"add","offset":0},)",
+                R"("ast":{"type":"Program","statements":[{"type":"ExpressionStatement","expression":{"type":"CallExpression",)",
+                R"("result":"9","type":"INTEGER","output":"","errors":[],"timings_ns":{"lex":)"}, what);
+        expect(take(monkey_run(interp, "add(4, 5)")), {R"({"ok":true,"output":"Input: add(4, 5)\n)", "Evaluated Result: 9"}, what);
+        // Neither an empty program nor a division by zero may take the host down.
+        expect(take(monkey_eval(interp, "")), {R"({"ok":true,"result":"","type":"")"}, what);
+        expect(take(monkey_eval(interp, "let y = 1;")), {R"({"ok":true,"result":"","type":"")"}, what);
+        expect(take(monkey_run(interp, "")), {R"("ok":true)", "No output from evaluation."}, what);
+        expect(take(monkey_pipeline(interp, "")), {R"({"ok":true,"tokens":[],)"}, what);
+        expect(take(monkey_eval(interp, "1/0")), {R"({"ok":false,"result":null,"type":null)", R"("errors":["division by zero"])"}, what);
+        expect(take(monkey_run(interp, "add(1, 1) / 0")), {R"("ok":false)", "division by zero"}, what);
+
+        monkey_set_limits(interp, 1000, 0, 0);
+        expect(take(monkey_eval(interp, "while (true) { }")), {R"("ok":false)", R"("limit":"steps")"}, what);
+        monkey_set_limits(interp, 0, 0, 0);
+        expect(take(monkey_eval(interp, "let i = 0; while (i < 2000) { i = i + 1; }; i")), {R"("result":"2000")"}, what);
+        monkey_free(interp);
+    }
+    monkey_free(nullptr);
+    std::cout << "TestEval passed!" << std::endl;
+}
+
+void TestTokensAndAst() {
+    expect(take(monkey_tokens("let x = \"a b\";")),
+           {R"([{"type":"LET","literal":"let","offset":0},{"type":"IDENT","literal":"x","offset":4},)",
+            R"({"type":"STRING","literal":"a b","offset":9},{"type":";","literal":";","offset":13}])"},
+           "monkey_tokens");
+    expect(take(monkey_tokens("")), {"[]"}, "monkey_tokens");
+
+    expect(take(monkey_ast("if (x < 1) { x }")),
+           {R"({"ok":true,"ast":{"type":"Program","statements":[{"type":"ExpressionStatement","expression":)"
+            R"({"type":"IfExpression","condition":{"type":"InfixExpression","operator":"<",)",
+            R"("alternative":null}}]},"errors":[]})"},
+           "monkey_ast");
+    expect(take(monkey_ast("let 5;")), {R"({"ok":false,"ast":null,"errors":[")"}, "monkey_ast");
+    std::cout << "TestTokensAndAst passed!" << std::endl;
+}
+
+void TestThreads() {
+    monkey_interp* interp = monkey_new(nullptr);
+    take(monkey_eval(interp, "let x = 1;"));
+    std::string fromOther;
+    std::vector<std::string> results(4);
+    std::vector<std::thread> threads;
+    threads.emplace_back([&] { fromOther = take(monkey_eval(interp, "x")); });
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&results, t] {
+            // Each thread runs an interpreter of its own, in parallel.
+            monkey_interp* own = monkey_new("vm");
+            for (int i = 0; i < 50; i++) {
+                results[t] = take(monkey_eval(own, ("let v = [" + std::to_string(t) + "]; len(v) + v[0]").c_str()));
+            }
+            monkey_free(own);
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    expect(fromOther, {R"("ok":false)", "other than the one that created it"}, "cross-thread monkey_eval");
+    for (int t = 0; t < 4; t++) {
+        expect(results[t], {R"("result":")" + std::to_string(t + 1) + "\""}, "thread " + std::to_string(t));
+    }
+    expect(take(monkey_eval(interp, "x")), {R"("result":"1")"}, "monkey_eval after other threads");
+    monkey_free(interp);
+    std::cout << "TestThreads passed!" << std::endl;
+}
+
+int main() {
+    TestEval();
+    TestTokensAndAst();
+    TestThreads();
+    std::cout << "All libmonkey_test.cpp tests passed!" << std::endl;
+    return 0;
+}
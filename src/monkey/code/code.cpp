@@ -0,0 +1,146 @@
+#include "code.hpp"
+#include <sstream>
+#include <iomanip>
+
+namespace YOXS_CODE {
+
+static const Definition definitions[] = {
+    {"OpConstant", {2}},
+
+    {"OpAdd", {}},
+    {"OpSub", {}},
+    {"OpMul", {}},
+    {"OpDiv", {}},
+
+    {"OpPop", {}},
+
+    {"OpTrue", {}},
+    {"OpFalse", {}},
+    {"OpNull", {}},
+
+    {"OpEqual", {}},
+    {"OpNotEqual", {}},
+    {"OpGreaterThan", {}},
+    {"OpLessThan", {}},
+
+    {"OpMinus", {}},
+    {"OpBang", {}},
+
+    {"OpJumpNotTruthy", {2}},
+    {"OpJump", {2}},
+
+    {"OpGetGlobal", {2}},
+    {"OpSetGlobal", {2}},
+    {"OpGetLocal", {1}},
+    {"OpSetLocal", {1}},
+    {"OpGetBuiltin", {1}},
+    {"OpGetFree", {1}},
+    {"OpCurrentClosure", {}},
+
+    {"OpArray", {2}},
+    {"OpHash", {2}},
+    {"OpIndex", {}},
+
+    {"OpCall", {1}},
+    {"OpReturnValue", {}},
+    {"OpReturn", {}},
+    {"OpClosure", {2, 1}}, // constant index of the function, number of free variables
+};
+
+const Definition* Lookup(uint8_t op) {
+    if (op >= sizeof(definitions) / sizeof(definitions[0])) {
+        return nullptr;
+    }
+    return &definitions[op];
+}
+
+Instructions Make(Opcode op, const std::vector<int>& operands) {
+    const Definition* def = Lookup(op);
+    if (!def) {
+        return {};
+    }
+
+    size_t instructionLen = 1;
+    for (int w : def->OperandWidths) {
+        instructionLen += w;
+    }
+
+    Instructions instruction;
+    instruction.reserve(instructionLen);
+    instruction.push_back(op);
+
+    for (size_t i = 0; i < operands.size() && i < def->OperandWidths.size(); i++) {
+        int o = operands[i];
+        switch (def->OperandWidths[i]) {
+            case 2:
+                instruction.push_back(static_cast<uint8_t>((o >> 8) & 0xFF));
+                instruction.push_back(static_cast<uint8_t>(o & 0xFF));
+                break;
+            case 1:
+                instruction.push_back(static_cast<uint8_t>(o & 0xFF));
+                break;
+        }
+    }
+
+    return instruction;
+}
+
+std::pair<std::vector<int>, int> ReadOperands(const Definition& def, const Instructions& ins, size_t offset) {
+    std::vector<int> operands(def.OperandWidths.size());
+    int read = 0;
+
+    for (size_t i = 0; i < def.OperandWidths.size(); i++) {
+        switch (def.OperandWidths[i]) {
+            case 2:
+                operands[i] = ReadUint16(ins, offset + read);
+                break;
+            case 1:
+                operands[i] = ReadUint8(ins, offset + read);
+                break;
+        }
+        read += def.OperandWidths[i];
+    }
+
+    return {operands, read};
+}
+
+static std::string fmtInstruction(const Definition& def, const std::vector<int>& operands) {
+    size_t operandCount = def.OperandWidths.size();
+    if (operands.size() != operandCount) {
+        return "ERROR: operand len " + std::to_string(operands.size()) + " does not match defined " + std::to_string(operandCount) + "\n";
+    }
+
+    switch (operandCount) {
+        case 0:
+            return def.Name;
+        case 1:
+            return def.Name + " " + std::to_string(operands[0]);
+        case 2:
+            return def.Name + " " + std::to_string(operands[0]) + " " + std::to_string(operands[1]);
+    }
+
+    return "ERROR: unhandled operandCount for " + def.Name + "\n";
+}
+
+std::string InstructionsToString(const Instructions& ins) {
+    std::ostringstream out;
+
+    size_t i = 0;
+    while (i < ins.size()) {
+        const Definition* def = Lookup(ins[i]);
+        if (!def) {
+            out << "ERROR: opcode " << static_cast<int>(ins[i]) << " undefined\n";
+            i++;
+            continue;
+        }
+
+        auto [operands, read] = ReadOperands(*def, ins, i + 1);
+        out << std::setw(4) << std::setfill('0') << i << " " << fmtInstruction(*def, operands) << "\n";
+
+        i += 1 + read;
+    }
+
+    return out.str();
+}
+
+} // namespace YOXS_CODE
@@ -0,0 +1,86 @@
+#ifndef CODE_H
+#define CODE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace YOXS_CODE {
+
+// Instructions is a flat stream of bytes: an opcode followed by its
+// big-endian operands, one instruction after another.
+using Instructions = std::vector<uint8_t>;
+
+enum Opcode : uint8_t {
+    OpConstant,
+
+    OpAdd,
+    OpSub,
+    OpMul,
+    OpDiv,
+
+    OpPop,
+
+    OpTrue,
+    OpFalse,
+    OpNull,
+
+    OpEqual,
+    OpNotEqual,
+    OpGreaterThan,
+    OpLessThan,
+
+    OpMinus,
+    OpBang,
+
+    OpJumpNotTruthy,
+    OpJump,
+
+    OpGetGlobal,
+    OpSetGlobal,
+    OpGetLocal,
+    OpSetLocal,
+    OpGetBuiltin,
+    OpGetFree,
+    OpCurrentClosure,
+
+    OpArray,
+    OpHash,
+    OpIndex,
+
+    OpCall,
+    OpReturnValue,
+    OpReturn,
+    OpClosure
+};
+
+// Definition describes an opcode: a readable name and the width in bytes
+// of each of its operands.
+struct Definition {
+    std::string Name;
+    std::vector<int> OperandWidths;
+};
+
+// Returns the definition for op, or nullptr if op is not defined.
+const Definition* Lookup(uint8_t op);
+
+Instructions Make(Opcode op, const std::vector<int>& operands = {});
+
+// Decodes the operands of one instruction starting at offset; returns the
+// operands and the number of bytes read.
+std::pair<std::vector<int>, int> ReadOperands(const Definition& def, const Instructions& ins, size_t offset);
+
+inline uint16_t ReadUint16(const Instructions& ins, size_t offset) {
+    return static_cast<uint16_t>((ins[offset] << 8) | ins[offset + 1]);
+}
+
+inline uint8_t ReadUint8(const Instructions& ins, size_t offset) {
+    return ins[offset];
+}
+
+std::string InstructionsToString(const Instructions& ins);
+
+} // namespace YOXS_CODE
+
+#endif // CODE_H
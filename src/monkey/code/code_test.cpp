@@ -0,0 +1,101 @@
+#include "code.hpp"
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+//Code Test: This tests the encoding and decoding of bytecode instructions.
+using namespace YOXS_CODE;
+
+void TestMake() {
+    struct TestCase {
+        Opcode op;
+        std::vector<int> operands;
+        Instructions expected;
+    };
+
+    std::vector<TestCase> tests = {
+        {OpConstant, {65534}, {OpConstant, 255, 254}},
+        {OpAdd, {}, {OpAdd}},
+        {OpGetLocal, {255}, {OpGetLocal, 255}},
+        {OpClosure, {65534, 255}, {OpClosure, 255, 254, 255}},
+    };
+
+    for (const auto& tt : tests) {
+        Instructions instruction = Make(tt.op, tt.operands);
+        if (instruction != tt.expected) {
+            std::cerr << "instruction has wrong encoding for " << Lookup(tt.op)->Name << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << "TestMake passed!" << std::endl;
+}
+
+void TestInstructionsString() {
+    std::vector<Instructions> instructions = {
+        Make(OpAdd),
+        Make(OpGetLocal, {1}),
+        Make(OpConstant, {2}),
+        Make(OpConstant, {65535}),
+        Make(OpClosure, {65535, 255}),
+    };
+
+    std::string expected =
+        "0000 OpAdd\n"
+        "0001 OpGetLocal 1\n"
+        "0003 OpConstant 2\n"
+        "0006 OpConstant 65535\n"
+        "0009 OpClosure 65535 255\n";
+
+    Instructions concatted;
+    for (const auto& ins : instructions) {
+        concatted.insert(concatted.end(), ins.begin(), ins.end());
+    }
+
+    if (InstructionsToString(concatted) != expected) {
+        std::cerr << "instructions wrongly formatted.\nwant=" << expected << "\ngot=" << InstructionsToString(concatted) << std::endl;
+        exit(1);
+    }
+    std::cout << "TestInstructionsString passed!" << std::endl;
+}
+
+void TestReadOperands() {
+    struct TestCase {
+        Opcode op;
+        std::vector<int> operands;
+        int bytesRead;
+    };
+
+    std::vector<TestCase> tests = {
+        {OpConstant, {65535}, 2},
+        {OpGetLocal, {255}, 1},
+        {OpClosure, {65535, 255}, 3},
+    };
+
+    for (const auto& tt : tests) {
+        Instructions instruction = Make(tt.op, tt.operands);
+        const Definition* def = Lookup(tt.op);
+        if (!def) {
+            std::cerr << "definition not found" << std::endl;
+            exit(1);
+        }
+
+        auto [operandsRead, n] = ReadOperands(*def, instruction, 1);
+        if (n != tt.bytesRead) {
+            std::cerr << "n wrong. want=" << tt.bytesRead << ", got=" << n << std::endl;
+            exit(1);
+        }
+        if (operandsRead != tt.operands) {
+            std::cerr << "operands wrong for " << def->Name << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << "TestReadOperands passed!" << std::endl;
+}
+
+int main() {
+    TestMake();
+    TestInstructionsString();
+    TestReadOperands();
+    std::cout << "All code_test.cpp tests passed!" << std::endl;
+    return 0;
+}
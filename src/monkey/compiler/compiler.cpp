@@ -0,0 +1,348 @@
+#include "compiler.hpp"
+#include "../object/builtins.hpp"
+
+using namespace YOXS_OBJECT;
+
+Compiler::Compiler() : symbolTable(std::make_shared<SymbolTable>()), scopes(1), scopeIndex(0) {
+    for (size_t i = 0; i < Builtins.size(); i++) {
+        symbolTable->DefineBuiltin(static_cast<int>(i), Builtins[i].Name);
+    }
+}
+
+Compiler::Compiler(std::shared_ptr<SymbolTable> s, const std::vector<std::shared_ptr<Object>>& constants)
+    : symbolTable(s), constants(constants), scopes(1), scopeIndex(0) {}
+
+bool Compiler::fail(const std::string& msg) {
+    errors.push_back(msg);
+    return false;
+}
+
+bool Compiler::Compile(Node* node) {
+    if (!node) {
+        return fail("cannot compile an empty node");
+    }
+
+    switch (node->Kind) {
+    case NodeKind::Program: {
+        auto n = static_cast<Program*>(node);
+        for (const auto& s : n->Statements) {
+            if (!Compile(s)) return false;
+        }
+        break;
+    }
+    case NodeKind::ExpressionStatement: {
+        auto n = static_cast<ExpressionStatement*>(node);
+        if (!n->expr) return true;
+        if (!Compile(n->expr)) return false;
+        emit(OpPop);
+        break;
+    }
+    case NodeKind::BlockStatement: {
+        auto n = static_cast<BlockStatement*>(node);
+        for (const auto& s : n->Statements) {
+            if (!Compile(s)) return false;
+        }
+        break;
+    }
+    case NodeKind::LetStatement: {
+        auto n = static_cast<LetStatement*>(node);
+        // Defined after the value is compiled, so the value sees any earlier
+        // binding of the name; a function refers to itself through
+        // DefineFunctionName instead.
+        if (!Compile(n->Value)) return false;
+        Symbol symbol = symbolTable->Define(std::string(n->Name->Value()));
+
+        if (symbol.Scope == SymbolScope::GLOBAL) {
+            emit(OpSetGlobal, {symbol.Index});
+        } else {
+            emit(OpSetLocal, {symbol.Index});
+        }
+        break;
+    }
+    case NodeKind::ReturnStatement: {
+        auto n = static_cast<ReturnStatement*>(node);
+        if (!Compile(n->ReturnValue)) return false;
+        emit(OpReturnValue);
+        break;
+    }
+    case NodeKind::AssignStatement: {
+        auto n = static_cast<AssignStatement*>(node);
+        std::string name(n->Name->Value());
+        auto symbol = symbolTable->Resolve(name);
+        if (!symbol) {
+            return fail("identifier not found: " + name);
+        }
+        // Closures hold copies of their free variables, so only the
+        // function's own locals and the globals can be assigned.
+        if (symbol->Scope != SymbolScope::GLOBAL && symbol->Scope != SymbolScope::LOCAL) {
+            return fail("cannot assign to " + name + " here");
+        }
+        if (!Compile(n->Value)) return false;
+        emit(symbol->Scope == SymbolScope::GLOBAL ? OpSetGlobal : OpSetLocal, {symbol->Index});
+        break;
+    }
+    case NodeKind::WhileStatement: {
+        auto n = static_cast<WhileStatement*>(node);
+        int loopStart = static_cast<int>(currentInstructions().size());
+        if (!Compile(n->Condition)) return false;
+
+        // Patched to point past the loop once the body is compiled.
+        int exitPos = emit(OpJumpNotTruthy, {9999});
+        if (!Compile(n->Body)) return false;
+        emit(OpJump, {loopStart});
+
+        changeOperand(exitPos, static_cast<int>(currentInstructions().size()));
+        break;
+    }
+    case NodeKind::InfixExpression: {
+        auto n = static_cast<InfixExpression*>(node);
+        if (!Compile(n->Left)) return false;
+        if (!Compile(n->Right)) return false;
+
+        if (n->Operator == "+") emit(OpAdd);
+        else if (n->Operator == "-") emit(OpSub);
+        else if (n->Operator == "*") emit(OpMul);
+        else if (n->Operator == "/") emit(OpDiv);
+        else if (n->Operator == ">") emit(OpGreaterThan);
+        else if (n->Operator == "<") emit(OpLessThan);
+        else if (n->Operator == "==") emit(OpEqual);
+        else if (n->Operator == "!=") emit(OpNotEqual);
+        else return fail("unknown operator " + std::string(n->Operator));
+        break;
+    }
+    case NodeKind::PrefixExpression: {
+        auto n = static_cast<PrefixExpression*>(node);
+        if (!Compile(n->Right)) return false;
+
+        if (n->Operator == "!") emit(OpBang);
+        else if (n->Operator == "-") emit(OpMinus);
+        else return fail("unknown operator " + std::string(n->Operator));
+        break;
+    }
+    case NodeKind::IfExpression: {
+        auto n = static_cast<IfExpression*>(node);
+        if (!Compile(n->Condition)) return false;
+
+        // Emit with a bogus offset; patched once the consequence is compiled.
+        int jumpNotTruthyPos = emit(OpJumpNotTruthy, {9999});
+
+        if (!compileBlockValue(n->Consequence)) return false;
+
+        int jumpPos = emit(OpJump, {9999});
+        changeOperand(jumpNotTruthyPos, static_cast<int>(currentInstructions().size()));
+
+        if (!n->Alternative) {
+            emit(OpNull);
+        } else if (!compileBlockValue(n->Alternative)) {
+            return false;
+        }
+
+        changeOperand(jumpPos, static_cast<int>(currentInstructions().size()));
+        break;
+    }
+    case NodeKind::Identifier: {
+        auto n = static_cast<Identifier*>(node);
+        std::string name(n->Value());
+        auto symbol = symbolTable->Resolve(name);
+        if (!symbol) {
+            return fail("identifier not found: " + name);
+        }
+        loadSymbol(*symbol);
+        break;
+    }
+    case NodeKind::IntegerLiteral: {
+        auto n = static_cast<IntegerLiteral*>(node);
+        emit(OpConstant, {addConstant(std::make_shared<Integer>(n->Value))});
+        break;
+    }
+    case NodeKind::StringLiteral: {
+        auto n = static_cast<StringLiteral*>(node);
+        emit(OpConstant, {addConstant(std::make_shared<String>(std::string(n->Value)))});
+        break;
+    }
+    case NodeKind::Boolean: {
+        auto n = static_cast<YOXS_AST::Boolean*>(node);
+        emit(n->Value ? OpTrue : OpFalse);
+        break;
+    }
+    case NodeKind::ArrayLiteral: {
+        auto n = static_cast<ArrayLiteral*>(node);
+        for (const auto& el : n->Elements) {
+            if (!Compile(el)) return false;
+        }
+        emit(OpArray, {static_cast<int>(n->Elements.size())});
+        break;
+    }
+    case NodeKind::HashLiteral: {
+        auto n = static_cast<HashLiteral*>(node);
+        for (const auto& pair : n->Pairs) {
+            if (!Compile(pair.Key)) return false;
+            if (!Compile(pair.Value)) return false;
+        }
+        emit(OpHash, {static_cast<int>(n->Pairs.size() * 2)});
+        break;
+    }
+    case NodeKind::IndexExpression: {
+        auto n = static_cast<IndexExpression*>(node);
+        if (!Compile(n->Left)) return false;
+        if (!Compile(n->Index)) return false;
+        emit(OpIndex);
+        break;
+    }
+    case NodeKind::FunctionLiteral: {
+        auto n = static_cast<FunctionLiteral*>(node);
+        enterScope();
+
+        if (!n->Name.empty()) {
+            symbolTable->DefineFunctionName(std::string(n->Name));
+        }
+        for (const auto& p : n->Parameters) {
+            symbolTable->Define(std::string(p->Value()));
+        }
+
+        if (!Compile(n->Body)) return false;
+
+        if (lastInstructionIs(OpPop)) {
+            replaceLastPopWithReturn();
+        }
+        if (!lastInstructionIs(OpReturnValue)) {
+            emit(OpReturn);
+        }
+
+        std::vector<Symbol> freeSymbols = symbolTable->FreeSymbols;
+        int numLocals = symbolTable->numDefinitions;
+        YOXS_CODE::Instructions instructions = leaveScope();
+
+        for (const auto& s : freeSymbols) {
+            loadSymbol(s);
+        }
+
+        auto compiledFn = std::make_shared<CompiledFunction>(instructions, numLocals, static_cast<int>(n->Parameters.size()));
+        emit(OpClosure, {addConstant(compiledFn), static_cast<int>(freeSymbols.size())});
+        break;
+    }
+    case NodeKind::CallExpression: {
+        auto n = static_cast<CallExpression*>(node);
+        if (!Compile(n->Function)) return false;
+        for (const auto& a : n->Arguments) {
+            if (!Compile(a)) return false;
+        }
+        emit(OpCall, {static_cast<int>(n->Arguments.size())});
+        break;
+    }
+    }
+
+    return true;
+}
+
+// Compiles an if/else branch so that it leaves exactly one value on the stack.
+bool Compiler::compileBlockValue(BlockStatement* block) {
+    if (!Compile(block)) return false;
+
+    if (lastInstructionIs(OpPop)) {
+        removeLastPop();
+    } else if (!lastInstructionIs(OpReturnValue)) {
+        emit(OpNull);
+    }
+    return true;
+}
+
+Bytecode Compiler::GetBytecode() const {
+    return Bytecode{scopes[scopeIndex].Instructions, constants};
+}
+
+std::vector<std::string> Compiler::Errors() const {
+    return errors;
+}
+
+int Compiler::addConstant(std::shared_ptr<Object> obj) {
+    constants.push_back(obj);
+    return static_cast<int>(constants.size()) - 1;
+}
+
+int Compiler::emit(Opcode op, const std::vector<int>& operands) {
+    int pos = addInstruction(Make(op, operands));
+    setLastInstruction(op, pos);
+    return pos;
+}
+
+int Compiler::addInstruction(const YOXS_CODE::Instructions& ins) {
+    auto& current = currentInstructions();
+    int posNewInstruction = static_cast<int>(current.size());
+    current.insert(current.end(), ins.begin(), ins.end());
+    return posNewInstruction;
+}
+
+void Compiler::setLastInstruction(Opcode op, int pos) {
+    scopes[scopeIndex].PreviousInstruction = scopes[scopeIndex].LastInstruction;
+    scopes[scopeIndex].LastInstruction = EmittedInstruction{op, pos};
+}
+
+bool Compiler::lastInstructionIs(Opcode op) const {
+    if (scopes[scopeIndex].Instructions.empty()) {
+        return false;
+    }
+    return scopes[scopeIndex].LastInstruction.Op == op;
+}
+
+void Compiler::removeLastPop() {
+    auto& scope = scopes[scopeIndex];
+    scope.Instructions.resize(scope.LastInstruction.Position);
+    scope.LastInstruction = scope.PreviousInstruction;
+}
+
+void Compiler::replaceInstruction(int pos, const YOXS_CODE::Instructions& newInstruction) {
+    auto& ins = currentInstructions();
+    for (size_t i = 0; i < newInstruction.size(); i++) {
+        ins[pos + i] = newInstruction[i];
+    }
+}
+
+void Compiler::changeOperand(int opPos, int operand) {
+    Opcode op = static_cast<Opcode>(currentInstructions()[opPos]);
+    replaceInstruction(opPos, Make(op, {operand}));
+}
+
+void Compiler::replaceLastPopWithReturn() {
+    int lastPos = scopes[scopeIndex].LastInstruction.Position;
+    replaceInstruction(lastPos, Make(OpReturnValue));
+    scopes[scopeIndex].LastInstruction.Op = OpReturnValue;
+}
+
+YOXS_CODE::Instructions& Compiler::currentInstructions() {
+    return scopes[scopeIndex].Instructions;
+}
+
+void Compiler::enterScope() {
+    scopes.push_back(CompilationScope{});
+    scopeIndex++;
+    symbolTable = std::make_shared<SymbolTable>(symbolTable);
+}
+
+YOXS_CODE::Instructions Compiler::leaveScope() {
+    YOXS_CODE::Instructions instructions = currentInstructions();
+    scopes.pop_back();
+    scopeIndex--;
+    symbolTable = symbolTable->Outer;
+    return instructions;
+}
+
+void Compiler::loadSymbol(const Symbol& s) {
+    switch (s.Scope) {
+        case SymbolScope::GLOBAL:
+            emit(OpGetGlobal, {s.Index});
+            break;
+        case SymbolScope::LOCAL:
+            emit(OpGetLocal, {s.Index});
+            break;
+        case SymbolScope::BUILTIN:
+            emit(OpGetBuiltin, {s.Index});
+            break;
+        case SymbolScope::FREE:
+            emit(OpGetFree, {s.Index});
+            break;
+        case SymbolScope::FUNCTION:
+            emit(OpCurrentClosure);
+            break;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "../ast/ast.hpp"
+#include "../code/code.hpp"
+#include "../object/object.hpp"
+#include "symbol_table.hpp"
+
+using namespace YOXS_AST;
+using namespace YOXS_CODE;
+
+// Bytecode is what the Compiler hands to the VM: the instructions of the
+// main program and the constant pool they index into.
+struct Bytecode {
+    YOXS_CODE::Instructions Instructions;
+    std::vector<std::shared_ptr<YOXS_OBJECT::Object>> Constants;
+};
+
+struct EmittedInstruction {
+    Opcode Op;
+    int Position;
+};
+
+// Every function literal is compiled in its own scope so its instructions
+// don't get mixed into the enclosing function's.
+struct CompilationScope {
+    YOXS_CODE::Instructions Instructions;
+    EmittedInstruction LastInstruction;
+    EmittedInstruction PreviousInstruction;
+};
+
+class Compiler {
+public:
+    Compiler();
+    Compiler(std::shared_ptr<SymbolTable> symbolTable, const std::vector<std::shared_ptr<YOXS_OBJECT::Object>>& constants);
+
+    // Compiles node into the current scope. On failure the reasons are
+    // available through Errors().
+    bool Compile(std::shared_ptr<Program> program) { return Compile(program.get()); }
+    bool Compile(Node* node);
+    Bytecode GetBytecode() const;
+    std::vector<std::string> Errors() const;
+
+    std::shared_ptr<SymbolTable> symbolTable;
+
+private:
+    std::vector<std::shared_ptr<YOXS_OBJECT::Object>> constants;
+    std::vector<CompilationScope> scopes;
+    size_t scopeIndex;
+    std::vector<std::string> errors;
+
+    int addConstant(std::shared_ptr<YOXS_OBJECT::Object> obj);
+    int emit(Opcode op, const std::vector<int>& operands = {});
+    int addInstruction(const YOXS_CODE::Instructions& ins);
+    void setLastInstruction(Opcode op, int pos);
+    bool lastInstructionIs(Opcode op) const;
+    void removeLastPop();
+    void replaceInstruction(int pos, const YOXS_CODE::Instructions& newInstruction);
+    void changeOperand(int opPos, int operand);
+    void replaceLastPopWithReturn();
+    YOXS_CODE::Instructions& currentInstructions();
+    void enterScope();
+    YOXS_CODE::Instructions leaveScope();
+    void loadSymbol(const Symbol& s);
+    bool compileBlockValue(BlockStatement* block);
+    bool fail(const std::string& msg);
+};
+
+#endif // COMPILER_H
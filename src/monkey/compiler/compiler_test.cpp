@@ -0,0 +1,285 @@
+#include "compiler.hpp"
+#include "../lexer/lexer.hpp"
+#include "../parser/parser.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <variant>
+#include <cstdlib>
+
+//Compiler Test: This tests that the compiler emits the expected bytecode and constant pool, and that the symbol table resolves every kind of scope.
+using namespace YOXS_OBJECT;
+
+using Constant = std::variant<int64_t, std::string, std::vector<Instructions>>;
+
+struct CompilerTestCase {
+    std::string input;
+    std::vector<Constant> expectedConstants;
+    std::vector<Instructions> expectedInstructions;
+};
+
+std::shared_ptr<Program> parse(const std::string& input) {
+    Lexer l(input);
+    Parser p(l);
+    return p.ParseProgram();
+}
+
+Instructions concatInstructions(const std::vector<Instructions>& s) {
+    Instructions out;
+    for (const auto& ins : s) {
+        out.insert(out.end(), ins.begin(), ins.end());
+    }
+    return out;
+}
+
+bool testInstructions(const std::vector<Instructions>& expected, const Instructions& actual) {
+    Instructions concatted = concatInstructions(expected);
+    if (concatted != actual) {
+        std::cerr << "wrong instructions.\nwant=\n" << InstructionsToString(concatted) << "got=\n" << InstructionsToString(actual) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool testConstants(const std::vector<Constant>& expected, const std::vector<std::shared_ptr<Object>>& actual) {
+    if (expected.size() != actual.size()) {
+        std::cerr << "wrong number of constants. got=" << actual.size() << ", want=" << expected.size() << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (auto v = std::get_if<int64_t>(&expected[i])) {
+            auto integer = std::dynamic_pointer_cast<Integer>(actual[i]);
+            if (!integer || integer->Value != *v) {
+                std::cerr << "constant " << i << " - wrong integer. want=" << *v << std::endl;
+                return false;
+            }
+        } else if (auto v = std::get_if<std::string>(&expected[i])) {
+            auto str = std::dynamic_pointer_cast<String>(actual[i]);
+            if (!str || str->Value != *v) {
+                std::cerr << "constant " << i << " - wrong string. want=" << *v << std::endl;
+                return false;
+            }
+        } else if (auto v = std::get_if<std::vector<Instructions>>(&expected[i])) {
+            auto fn = std::dynamic_pointer_cast<CompiledFunction>(actual[i]);
+            if (!fn) {
+                std::cerr << "constant " << i << " - not a function" << std::endl;
+                return false;
+            }
+            if (!testInstructions(*v, fn->Instructions)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void runCompilerTests(const std::string& name, const std::vector<CompilerTestCase>& tests) {
+    for (const auto& tt : tests) {
+        auto program = parse(tt.input);
+
+        Compiler compiler;
+        if (!compiler.Compile(program)) {
+            std::cerr << name << ": compiler error: " << compiler.Errors()[0] << std::endl;
+            exit(1);
+        }
+
+        Bytecode bytecode = compiler.GetBytecode();
+        if (!testInstructions(tt.expectedInstructions, bytecode.Instructions) ||
+            !testConstants(tt.expectedConstants, bytecode.Constants)) {
+            std::cerr << name << " failed for input: " << tt.input << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << name << " passed!" << std::endl;
+}
+
+void TestIntegerArithmetic() {
+    runCompilerTests("TestIntegerArithmetic", {
+        {"1 + 2", {int64_t(1), int64_t(2)}, {Make(OpConstant, {0}), Make(OpConstant, {1}), Make(OpAdd), Make(OpPop)}},
+        {"1; 2", {int64_t(1), int64_t(2)}, {Make(OpConstant, {0}), Make(OpPop), Make(OpConstant, {1}), Make(OpPop)}},
+        {"2 / 1", {int64_t(2), int64_t(1)}, {Make(OpConstant, {0}), Make(OpConstant, {1}), Make(OpDiv), Make(OpPop)}},
+        {"-1", {int64_t(1)}, {Make(OpConstant, {0}), Make(OpMinus), Make(OpPop)}},
+    });
+}
+
+void TestBooleanExpressions() {
+    runCompilerTests("TestBooleanExpressions", {
+        {"true", {}, {Make(OpTrue), Make(OpPop)}},
+        {"1 < 2", {int64_t(1), int64_t(2)}, {Make(OpConstant, {0}), Make(OpConstant, {1}), Make(OpLessThan), Make(OpPop)}},
+        {"true != false", {}, {Make(OpTrue), Make(OpFalse), Make(OpNotEqual), Make(OpPop)}},
+        {"!true", {}, {Make(OpTrue), Make(OpBang), Make(OpPop)}},
+    });
+}
+
+void TestConditionals() {
+    runCompilerTests("TestConditionals", {
+        {"if (true) { 10 }; 3333;", {int64_t(10), int64_t(3333)}, {
+            Make(OpTrue),                 // 0000
+            Make(OpJumpNotTruthy, {10}),  // 0001
+            Make(OpConstant, {0}),        // 0004
+            Make(OpJump, {11}),           // 0007
+            Make(OpNull),                 // 0010
+            Make(OpPop),                  // 0011
+            Make(OpConstant, {1}),        // 0012
+            Make(OpPop),                  // 0015
+        }},
+        {"if (true) { 10 } else { 20 }; 3333;", {int64_t(10), int64_t(20), int64_t(3333)}, {
+            Make(OpTrue),                 // 0000
+            Make(OpJumpNotTruthy, {10}),  // 0001
+            Make(OpConstant, {0}),        // 0004
+            Make(OpJump, {13}),           // 0007
+            Make(OpConstant, {1}),        // 0010
+            Make(OpPop),                  // 0013
+            Make(OpConstant, {2}),        // 0014
+            Make(OpPop),                  // 0017
+        }},
+    });
+}
+
+void TestWhileLoops() {
+    runCompilerTests("TestWhileLoops", {
+        {"let i = 0; while (i < 3) { i = i + 1; }", {int64_t(0), int64_t(3), int64_t(1)}, {
+            Make(OpConstant, {0}),        // 0000
+            Make(OpSetGlobal, {0}),       // 0003
+            Make(OpGetGlobal, {0}),       // 0006
+            Make(OpConstant, {1}),        // 0009
+            Make(OpLessThan),             // 0012
+            Make(OpJumpNotTruthy, {29}),  // 0013
+            Make(OpGetGlobal, {0}),       // 0016
+            Make(OpConstant, {2}),        // 0019
+            Make(OpAdd),                  // 0022
+            Make(OpSetGlobal, {0}),       // 0023
+            Make(OpJump, {6}),            // 0026
+        }},
+    });
+}
+
+void TestGlobalLetStatements() {
+    runCompilerTests("TestGlobalLetStatements", {
+        {"let one = 1; let two = one; two;", {int64_t(1)}, {
+            Make(OpConstant, {0}),
+            Make(OpSetGlobal, {0}),
+            Make(OpGetGlobal, {0}),
+            Make(OpSetGlobal, {1}),
+            Make(OpGetGlobal, {1}),
+            Make(OpPop),
+        }},
+    });
+}
+
+void TestCollections() {
+    runCompilerTests("TestCollections", {
+        {"\"mon\" + \"key\"", {std::string("mon"), std::string("key")}, {Make(OpConstant, {0}), Make(OpConstant, {1}), Make(OpAdd), Make(OpPop)}},
+        {"[1, 2][0]", {int64_t(1), int64_t(2), int64_t(0)}, {
+            Make(OpConstant, {0}), Make(OpConstant, {1}), Make(OpArray, {2}), Make(OpConstant, {2}), Make(OpIndex), Make(OpPop),
+        }},
+        {"{}", {}, {Make(OpHash, {0}), Make(OpPop)}},
+    });
+}
+
+void TestFunctions() {
+    runCompilerTests("TestFunctions", {
+        {"fn() { return 5 + 10 }", {int64_t(5), int64_t(10), std::vector<Instructions>{
+            Make(OpConstant, {0}), Make(OpConstant, {1}), Make(OpAdd), Make(OpReturnValue),
+        }}, {Make(OpClosure, {2, 0}), Make(OpPop)}},
+        {"fn() { }", {std::vector<Instructions>{Make(OpReturn)}}, {Make(OpClosure, {0, 0}), Make(OpPop)}},
+        {"let oneArg = fn(a) { a }; oneArg(24);", {std::vector<Instructions>{
+            Make(OpGetLocal, {0}), Make(OpReturnValue),
+        }, int64_t(24)}, {
+            Make(OpClosure, {0, 0}), Make(OpSetGlobal, {0}), Make(OpGetGlobal, {0}), Make(OpConstant, {1}), Make(OpCall, {1}), Make(OpPop),
+        }},
+        {"len([]);", {}, {Make(OpGetBuiltin, {0}), Make(OpArray, {0}), Make(OpCall, {1}), Make(OpPop)}},
+    });
+}
+
+void TestClosures() {
+    runCompilerTests("TestClosures", {
+        {"fn(a) { fn(b) { a + b } }", {
+            std::vector<Instructions>{Make(OpGetFree, {0}), Make(OpGetLocal, {0}), Make(OpAdd), Make(OpReturnValue)},
+            std::vector<Instructions>{Make(OpGetLocal, {0}), Make(OpClosure, {0, 1}), Make(OpReturnValue)},
+        }, {Make(OpClosure, {1, 0}), Make(OpPop)}},
+        {"let countDown = fn(x) { countDown(x - 1); };", {
+            int64_t(1),
+            std::vector<Instructions>{Make(OpCurrentClosure), Make(OpGetLocal, {0}), Make(OpConstant, {0}), Make(OpSub), Make(OpCall, {1}), Make(OpReturnValue)},
+        }, {Make(OpClosure, {1, 0}), Make(OpSetGlobal, {0})}},
+    });
+}
+
+void TestSymbolTable() {
+    auto global = std::make_shared<SymbolTable>();
+    global->DefineBuiltin(0, "len");
+    Symbol a = global->Define("a");
+
+    auto firstLocal = std::make_shared<SymbolTable>(global);
+    Symbol c = firstLocal->Define("c");
+
+    auto secondLocal = std::make_shared<SymbolTable>(firstLocal);
+    Symbol e = secondLocal->Define("e");
+
+    struct TestCase {
+        std::string name;
+        Symbol expected;
+    };
+    std::vector<TestCase> tests = {
+        {"a", {"a", SymbolScope::GLOBAL, 0}},
+        {"len", {"len", SymbolScope::BUILTIN, 0}},
+        {"c", {"c", SymbolScope::FREE, 0}},
+        {"e", {"e", SymbolScope::LOCAL, 0}},
+    };
+
+    for (const auto& tt : tests) {
+        auto result = secondLocal->Resolve(tt.name);
+        if (!result || !(*result == tt.expected)) {
+            std::cerr << "symbol " << tt.name << " resolved wrong" << std::endl;
+            exit(1);
+        }
+    }
+
+    if (a.Index != 0 || c.Scope != SymbolScope::LOCAL || e.Index != 0) {
+        std::cerr << "Define returned unexpected symbols" << std::endl;
+        exit(1);
+    }
+    if (secondLocal->FreeSymbols.size() != 1 || !(secondLocal->FreeSymbols[0] == c)) {
+        std::cerr << "free symbol for c not recorded" << std::endl;
+        exit(1);
+    }
+    if (secondLocal->Resolve("undefined")) {
+        std::cerr << "undefined name resolved" << std::endl;
+        exit(1);
+    }
+    std::cout << "TestSymbolTable passed!" << std::endl;
+}
+
+void TestCompilerErrors() {
+    Compiler compiler;
+    if (compiler.Compile(parse("foobar;")) || compiler.Errors().empty() || compiler.Errors()[0] != "identifier not found: foobar") {
+        std::cerr << "expected an identifier not found error" << std::endl;
+        exit(1);
+    }
+
+    // Closures copy their free variables, so assigning one could not be
+    // seen by the function it came from.
+    Compiler captured;
+    if (captured.Compile(parse("let f = fn() { let n = 0; fn() { n = n + 1 } };")) ||
+        captured.Errors().empty() || captured.Errors()[0] != "cannot assign to n here") {
+        std::cerr << "expected assigning a free variable to fail" << std::endl;
+        exit(1);
+    }
+    std::cout << "TestCompilerErrors passed!" << std::endl;
+}
+
+int main() {
+    TestIntegerArithmetic();
+    TestBooleanExpressions();
+    TestConditionals();
+    TestWhileLoops();
+    TestGlobalLetStatements();
+    TestCollections();
+    TestFunctions();
+    TestClosures();
+    TestSymbolTable();
+    TestCompilerErrors();
+    std::cout << "All compiler_test.cpp tests passed!" << std::endl;
+    return 0;
+}
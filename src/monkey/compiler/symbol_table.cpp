@@ -0,0 +1,60 @@
+#include "symbol_table.hpp"
+
+std::string SymbolScopeToString(SymbolScope scope) {
+    switch (scope) {
+        case SymbolScope::GLOBAL:   return "GLOBAL";
+        case SymbolScope::LOCAL:    return "LOCAL";
+        case SymbolScope::BUILTIN:  return "BUILTIN";
+        case SymbolScope::FREE:     return "FREE";
+        case SymbolScope::FUNCTION: return "FUNCTION";
+        default:                    return "UNKNOWN";
+    }
+}
+
+Symbol SymbolTable::Define(const std::string& name) {
+    Symbol symbol{name, Outer ? SymbolScope::LOCAL : SymbolScope::GLOBAL, numDefinitions};
+    store[name] = symbol;
+    numDefinitions++;
+    return symbol;
+}
+
+Symbol SymbolTable::DefineBuiltin(int index, const std::string& name) {
+    Symbol symbol{name, SymbolScope::BUILTIN, index};
+    store[name] = symbol;
+    return symbol;
+}
+
+Symbol SymbolTable::DefineFunctionName(const std::string& name) {
+    Symbol symbol{name, SymbolScope::FUNCTION, 0};
+    store[name] = symbol;
+    return symbol;
+}
+
+Symbol SymbolTable::defineFree(const Symbol& original) {
+    FreeSymbols.push_back(original);
+    Symbol symbol{original.Name, SymbolScope::FREE, static_cast<int>(FreeSymbols.size()) - 1};
+    store[original.Name] = symbol;
+    return symbol;
+}
+
+std::optional<Symbol> SymbolTable::Resolve(const std::string& name) {
+    auto it = store.find(name);
+    if (it != store.end()) {
+        return it->second;
+    }
+    if (!Outer) {
+        return std::nullopt;
+    }
+
+    auto obj = Outer->Resolve(name);
+    if (!obj) {
+        return obj;
+    }
+
+    if (obj->Scope == SymbolScope::GLOBAL || obj->Scope == SymbolScope::BUILTIN) {
+        return obj;
+    }
+
+    // A local of an enclosing function: capture it as a free variable.
+    return defineFree(*obj);
+}
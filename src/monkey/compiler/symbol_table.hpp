@@ -0,0 +1,51 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+enum class SymbolScope {
+    GLOBAL,
+    LOCAL,
+    BUILTIN,
+    FREE,
+    FUNCTION
+};
+
+std::string SymbolScopeToString(SymbolScope scope);
+
+struct Symbol {
+    std::string Name;
+    SymbolScope Scope;
+    int Index;
+
+    bool operator==(const Symbol& rhs) const {
+        return Name == rhs.Name && Scope == rhs.Scope && Index == rhs.Index;
+    }
+};
+
+// SymbolTable maps identifiers to the slot the VM keeps them in. Every
+// function literal gets its own table enclosing the one it was defined in.
+class SymbolTable {
+public:
+    SymbolTable(std::shared_ptr<SymbolTable> outer = nullptr) : Outer(outer) {}
+
+    std::shared_ptr<SymbolTable> Outer;
+    std::vector<Symbol> FreeSymbols;
+    int numDefinitions = 0;
+
+    Symbol Define(const std::string& name);
+    Symbol DefineBuiltin(int index, const std::string& name);
+    Symbol DefineFunctionName(const std::string& name);
+    std::optional<Symbol> Resolve(const std::string& name);
+
+private:
+    std::unordered_map<std::string, Symbol> store;
+
+    Symbol defineFree(const Symbol& original);
+};
+
+#endif // SYMBOL_TABLE_H
@@ -2,124 +2,113 @@
 
 //evaluator.cpp
 
-std::shared_ptr<NullObject> ObjectConstants::NULL_OBJ = std::make_shared<NullObject>();
-std::shared_ptr<BooleanObject> ObjectConstants::TRUE = std::make_shared<BooleanObject>(true);
-std::shared_ptr<BooleanObject> ObjectConstants::FALSE = std::make_shared<BooleanObject>(false);
-
-std::map<std::string, std::shared_ptr<Builtin>> builtins = {
-    {"len", std::make_shared<Builtin>([](const std::vector<std::shared_ptr<Object>>& args) -> std::shared_ptr<Object> {
-        if (args.size() != 1) {
-            return Evaluator::newError("wrong number of arguments. got=%zu, want=1", args.size());
-        }
+// A call in tail position does not run where it is evaluated. The call is
+// left in pendingCall and the body unwinds as if it had returned tailCall,
+// which applyFunction recognises and runs the call in its own loop instead,
+// so tail recursion takes no C++ stack. tailCall travels as a ReturnValue
+// because unwinding is exactly what a return does; its Value is unused.
+namespace {
+
+struct PendingCall {
+    Value Function;
+    std::vector<Value> Args;
+};
 
-        auto argType = args[0]->Type();
-        if (argType == ARRAY_OBJ) {
-            auto arrayObj = std::dynamic_pointer_cast<ArrayObject>(args[0]);
-            return std::make_shared<Integer>(arrayObj->Elements.size());
-        } else if (argType == STRING_OBJ) {
-            auto stringObj = std::dynamic_pointer_cast<String>(args[0]);
-            return std::make_shared<Integer>(stringObj->Value.size());
-        } else {
-            return Evaluator::newError("argument to `len` not supported, got %s", ObjectTypeToString(argType).c_str());
-        }
-    })},
-    {"puts", std::make_shared<Builtin>([](const std::vector<std::shared_ptr<Object>>& args) -> std::shared_ptr<Object> {
-        for (auto& arg : args) {
-            std::cout << arg->Inspect() << std::endl;
-        }
-        return ObjectConstants::NULL_OBJ;
-    })},
+thread_local PendingCall pendingCall;
+// The limits of the program being run on this thread, if it has any.
+thread_local LimitGuard* limitGuard = nullptr;
+const Value tailCall = std::make_shared<ReturnValue>(Value());
 
-    {"first", std::make_shared<Builtin>([](const std::vector<std::shared_ptr<Object>>& args) -> std::shared_ptr<Object> {
-        if (args.size() != 1) {
-            return Evaluator::newError("wrong number of arguments. got=" + std::to_string(args.size()) + ", want=1");
-        }
-        if (args[0]->Type() != ARRAY_OBJ) {
-            return Evaluator::newError("argument to `first` must be ARRAY, got " + ObjectTypeToString(args[0]->Type()));
-        }
-        auto arr = std::dynamic_pointer_cast<ArrayObject>(args[0]);
-        if (!arr->Elements.empty()) {
-            return arr->Elements.front();
-        }
-        return ObjectConstants::NULL_OBJ;
-    })},
+bool isTailCall(const Value& v) {
+    return v.get() == tailCall.get();
+}
 
-    {"last", std::make_shared<Builtin>([](const std::vector<std::shared_ptr<Object>>& args) -> std::shared_ptr<Object> {
-        if (args.size() != 1) {
-            return Evaluator::newError("wrong number of arguments. got=" + std::to_string(args.size()) + ", want=1");
-        }
-        if (args[0]->Type() != ARRAY_OBJ) {
-            return Evaluator::newError("argument to `last` must be ARRAY, got " + ObjectTypeToString(args[0]->Type()));
-        }
-        auto arr = std::dynamic_pointer_cast<ArrayObject>(args[0]);
-        if (!arr->Elements.empty()) {
-            return arr->Elements.back();
-        }
-        return ObjectConstants::NULL_OBJ;
-    })},
+// Evaluates the arguments of call and leaves it in pendingCall. The last
+// tail call's arguments are spent by now, so their vector is reused rather
+// than allocating one per call.
+Value deferTailCall(Value function, CallExpression* call, std::shared_ptr<Environment> env) {
+    std::vector<Value> args = std::move(pendingCall.Args);
+    Evaluator::evalExpressions(call->Arguments, env, args);
+    if (args.size() == 1 && Evaluator::isError(args[0])) {
+        return args[0];
+    }
+    pendingCall.Function = std::move(function);
+    pendingCall.Args = std::move(args);
+    return tailCall;
+}
 
-    {"rest", std::make_shared<Builtin>([](const std::vector<std::shared_ptr<Object>>& args) -> std::shared_ptr<Object> {
-        if (args.size() != 1) {
-            return Evaluator::newError("wrong number of arguments. got=" + std::to_string(args.size()) + ", want=1");
-        }
-        if (args[0]->Type() != ARRAY_OBJ) {
-            return Evaluator::newError("argument to `rest` must be ARRAY, got " + ObjectTypeToString(args[0]->Type()));
-        }
-        auto arr = std::dynamic_pointer_cast<ArrayObject>(args[0]);
-        if (arr->Elements.size() > 1) {
-            std::vector<std::shared_ptr<Object>> newElements(arr->Elements.begin() + 1, arr->Elements.end());
-            return std::make_shared<ArrayObject>(newElements);
-        }
-        return ObjectConstants::NULL_OBJ;
-    })},
+} // namespace
 
-    {"push", std::make_shared<Builtin>([](const std::vector<std::shared_ptr<Object>>& args) -> std::shared_ptr<Object> {
-        if (args.size() != 2) {
-            return Evaluator::newError("wrong number of arguments. got=" + std::to_string(args.size()) + ", want=2");
-        }
-        if (args[0]->Type() != ARRAY_OBJ) {
-            return Evaluator::newError("argument to `push` must be ARRAY, got " + ObjectTypeToString(args[0]->Type()));
-        }
-        auto arr = std::dynamic_pointer_cast<ArrayObject>(args[0]);
-        auto newElements = arr->Elements;
-        newElements.push_back(args[1]);
-        return std::make_shared<ArrayObject>(newElements);
-    })}
-};
+std::shared_ptr<Object> Evaluator::Eval(std::shared_ptr<Program> program, std::shared_ptr<Environment> env, const ExecutionLimits& limits) {
+    Resolver(env->Names()).Resolve(program.get());
+    Heap::MaybeCollect();
+    if (limits.Unlimited()) {
+        return Eval(program.get(), env).ToObject();
+    }
+    LimitGuard guard(limits);
+    LimitGuard* outer = std::exchange(limitGuard, &guard);
+    auto result = Eval(program.get(), env).ToObject();
+    limitGuard = outer;
+    return result;
+}
 
-std::shared_ptr<Object> Evaluator::Eval(std::shared_ptr<Node> node, std::shared_ptr<Environment> env) {
-    // The dynamic_cast will check the actual type of Node and return nullptr if the cast is not valid.
-    if (auto n = std::dynamic_pointer_cast<Program>(node)) {
-        return evalProgram(n, env);
-    } else if (auto n = std::dynamic_pointer_cast<BlockStatement>(node)) {
-        return evalBlockStatement(n, env);
-    } else if (auto n = std::dynamic_pointer_cast<ExpressionStatement>(node)) {
-        return Eval(n->expr, env);
-    } else if (auto n = std::dynamic_pointer_cast<ReturnStatement>(node)) {
+Value Evaluator::Eval(Node* node, std::shared_ptr<Environment> env) {
+    Counters::Current().Steps++;
+    if (limitGuard) {
+        if (auto err = limitGuard->Step()) {
+            return err;
+        }
+    }
+    // Every node records its concrete class in Kind, so a single switch picks the
+    // handler and the static cast below is always valid.
+    switch (node->Kind) {
+    case NodeKind::Program:
+        return evalProgram(static_cast<Program*>(node), env);
+    case NodeKind::BlockStatement:
+        return evalBlockStatement(static_cast<BlockStatement*>(node), env);
+    case NodeKind::ExpressionStatement:
+        return Eval(static_cast<ExpressionStatement*>(node)->expr, env);
+    case NodeKind::ReturnStatement: {
+        auto n = static_cast<ReturnStatement*>(node);
         auto val = Eval(n->ReturnValue, env);
-        if (isError(val)) {
+        if (isError(val) || isTailCall(val)) {
             return val;
         }
         return std::make_shared<ReturnValue>(val);
-    } else if (auto n = std::dynamic_pointer_cast<LetStatement>(node)){
+    }
+    case NodeKind::LetStatement: {
+        auto n = static_cast<LetStatement*>(node);
         auto val = Eval(n->Value, env);
         if(Evaluator::isError(val)) {
             return val;
         }
-        env->Set(n->Name->Value(), val);
-    } else if (auto n = std::dynamic_pointer_cast<IntegerLiteral>(node)){
-        return std::make_shared<Integer>(n->Value);
-    } else if (auto n = std::dynamic_pointer_cast<StringLiteral>(node)){
-        return std::make_shared<String>(n->Value);
-    } else if (auto n = std::dynamic_pointer_cast<Boolean>(node)){
-        return nativeBoolToBooleanObject(n->Value);
-    } else if (auto n = std::dynamic_pointer_cast<PrefixExpression>(node)){
+        if (n->Name->Depth == 0) {
+            env->SetAt(n->Name->Slot, val);
+        } else {
+            env->Set(n->Name->Symbol, val);
+        }
+        return Value();
+    }
+    case NodeKind::AssignStatement:
+        return evalAssignStatement(static_cast<AssignStatement*>(node), env);
+    case NodeKind::WhileStatement:
+        return evalWhileStatement(static_cast<WhileStatement*>(node), env);
+    case NodeKind::IntegerLiteral:
+        return Value::Int(static_cast<IntegerLiteral*>(node)->Value);
+    case NodeKind::StringLiteral:
+        return std::make_shared<String>(std::string(static_cast<StringLiteral*>(node)->Value));
+    case NodeKind::Boolean:
+        return Value::Bool(static_cast<Boolean*>(node)->Value);
+    case NodeKind::PrefixExpression: {
+        auto n = static_cast<PrefixExpression*>(node);
         auto right = Eval(n->Right, env);
         if(isError(right)) {
             return right;
         }
         return evalPrefixExpression(n->Operator, right);
-    } else if (auto n = std::dynamic_pointer_cast<InfixExpression>(node)){
+    }
+    case NodeKind::InfixExpression: {
+        auto n = static_cast<InfixExpression*>(node);
         auto left = Eval(n->Left, env);
         if(isError(left)){
             return left;
@@ -130,65 +119,87 @@ std::shared_ptr<Object> Evaluator::Eval(std::shared_ptr<Node> node, std::shared_
             return right;
         }
         return evalInfixExpression(n->Operator, left, right);
-    } else if (auto n = std::dynamic_pointer_cast<IfExpression>(node)){
-        return evalIfExpression(n, env);
-    } else if (auto n = std::dynamic_pointer_cast<Identifier>(node)){
-        return evalIdentifier(n, env);
-    } else if (auto n = std::dynamic_pointer_cast<FunctionLiteral>(node)){
+    }
+    case NodeKind::IfExpression:
+        return evalIfExpression(static_cast<IfExpression*>(node), env);
+    case NodeKind::Identifier:
+        return evalIdentifier(static_cast<Identifier*>(node), env);
+    case NodeKind::FunctionLiteral: {
+        auto n = static_cast<FunctionLiteral*>(node);
         auto params = n->Parameters;
         auto body = n->Body;
-        return std::make_shared<Function>(params, env, body);
-    } else if (auto n = std::dynamic_pointer_cast<CallExpression>(node)){
+        auto fn = std::make_shared<Function>(params, env, body);
+        fn->Locals = n->Locals;
+        if (n->Owner) {
+            fn->Owner = n->Owner->weak_from_this().lock();
+        }
+        return fn;
+    }
+    case NodeKind::CallExpression: {
+        auto n = static_cast<CallExpression*>(node);
         auto function = Eval(n->Function, env);
         
         if(isError(function)){
             return function;
         }
 
+        if (n->Tail) {
+            return deferTailCall(std::move(function), n, env);
+        }
+
         auto args = evalExpressions(n->Arguments, env);
         if(args.size() == 1 && isError(args[0])){
             return args[0];
         }
         return applyFunction(function, args);
-    } else if (auto n = std::dynamic_pointer_cast<ArrayLiteral>(node)){
+    }
+    case NodeKind::ArrayLiteral: {
+        auto n = static_cast<ArrayLiteral*>(node);
         auto elements = evalExpressions(n->Elements, env);
         if(elements.size() == 1 && isError(elements[0])) return elements[0];
         return std::make_shared<ArrayObject>(elements);
-    } else if (auto n = std::dynamic_pointer_cast<IndexExpression>(node)) {
+    }
+    case NodeKind::IndexExpression: {
+        auto n = static_cast<IndexExpression*>(node);
         auto left = Eval(n->Left, env);
         if(isError(left)) return left;
         auto index = Eval(n->Index, env);
+        if(isError(index)) return index;
         return evalIndexExpression(left, index);
-    } else if (auto n = std::dynamic_pointer_cast<HashLiteral>(node)){
-        return evalHashLiteral(n, env);
+    }
+    case NodeKind::HashLiteral:
+        return evalHashLiteral(static_cast<HashLiteral*>(node), env);
     }
 
-    return nullptr;
+    return Value();
 }
 
-std::shared_ptr<Object> Evaluator::evalProgram(std::shared_ptr<Program> program, std::shared_ptr<Environment> env){
-    std::shared_ptr<Object> result;
+Value Evaluator::evalProgram(Program* program, std::shared_ptr<Environment> env){
+    Value result;
 
     for(auto& stmt : program->Statements){
         result = Eval(stmt, env);
-        if(auto returnValue = std::dynamic_pointer_cast<ReturnValue>(result)){
-            return returnValue->Value;
+        if(!result.IsObject()){
+            continue;
+        }
+        if(result.Type() == RETURN_VALUE_OBJ){
+            return result.As<ReturnValue>()->Value;
         }
-        else if(auto errorValue = std::dynamic_pointer_cast<Error>(result)){
-            return errorValue;
+        else if(result.Type() == ERROR_OBJ){
+            return result;
         }
     }
 
     return result;
 }
 
-std::shared_ptr<Object> Evaluator::evalBlockStatement(std::shared_ptr<BlockStatement> block, std::shared_ptr<Environment> env){
-    std::shared_ptr<Object> result;
+Value Evaluator::evalBlockStatement(BlockStatement* block, std::shared_ptr<Environment> env){
+    Value result;
 
     for(auto& stmt: block->Statements) {
         result = Eval(stmt, env);
-        if(result){
-            auto rt = result->Type();
+        if(result.IsObject()){
+            auto rt = result.Type();
             if(rt == RETURN_VALUE_OBJ or rt == ERROR_OBJ){
                 return result;
             }
@@ -198,11 +209,7 @@ std::shared_ptr<Object> Evaluator::evalBlockStatement(std::shared_ptr<BlockState
     return result;
 }
 
-std::shared_ptr<BooleanObject> Evaluator::nativeBoolToBooleanObject(bool input){
-    return input ? ObjectConstants::TRUE : ObjectConstants::FALSE;
-}
-
-std::shared_ptr<Object> Evaluator::evalPrefixExpression(const std::string& op, std::shared_ptr<Object> right){
+Value Evaluator::evalPrefixExpression(std::string_view op, const Value& right){
     if(op == "!"){
         return evalBangOperatorExpression(right);
     }
@@ -210,77 +217,83 @@ std::shared_ptr<Object> Evaluator::evalPrefixExpression(const std::string& op, s
         return evalMinusPrefixOperatorExpression(right);
     }
     else{
-        return newError("unknown operator: %s%s", op.c_str(), ObjectTypeToString(right->Type()).c_str());
+        return newError("unknown operator: %s%s", std::string(op).c_str(), ObjectTypeToString(right.Type()).c_str());
     }
 }
 
-std::shared_ptr<Object> Evaluator::evalInfixExpression(const std::string& op, std::shared_ptr<Object> left, std::shared_ptr<Object> right){
-    if (left->Type() != right->Type()) {
-        return newError("type mismatch: %s %s %s", ObjectTypeToString(left->Type()).c_str(), op.c_str(), ObjectTypeToString(right->Type()).c_str());
-    } else if (left->Type() == INTEGER_OBJ && right->Type() == INTEGER_OBJ) {
+Value Evaluator::evalInfixExpression(std::string_view op, const Value& left, const Value& right){
+    if (left.IsInt() && right.IsInt()) {
         return evalIntegerInfixExpression(op, left, right);
-    } else if(left->Type() == STRING_OBJ && right->Type() == STRING_OBJ) {
+    } else if (left.Type() != right.Type()) {
+        return newError("type mismatch: %s %s %s", ObjectTypeToString(left.Type()).c_str(), std::string(op).c_str(), ObjectTypeToString(right.Type()).c_str());
+    } else if(left.Type() == STRING_OBJ && right.Type() == STRING_OBJ) {
         return evalStringInfixExpression(op, left, right);
     } else if (op == "==") {
-        return nativeBoolToBooleanObject(left == right);
+        return Value::Bool(left == right);
     } else if (op == "!=") {
-        return nativeBoolToBooleanObject(left != right);
+        return Value::Bool(left != right);
     } else {
-        return newError("unknown operator: %s %s %s", ObjectTypeToString(left->Type()).c_str(), op.c_str(), ObjectTypeToString(right->Type()).c_str());
+        return newError("unknown operator: %s %s %s", ObjectTypeToString(left.Type()).c_str(), std::string(op).c_str(), ObjectTypeToString(right.Type()).c_str());
     }
 }
 
-std::shared_ptr<Object> Evaluator::evalBangOperatorExpression(std::shared_ptr<Object> right){
-    if(right == ObjectConstants::TRUE){
-        return ObjectConstants::FALSE;
-    }
-    else if(right == ObjectConstants::FALSE){
-        return ObjectConstants::TRUE;
+Value Evaluator::evalBangOperatorExpression(const Value& right){
+    if(right.IsBool()){
+        return Value::Bool(!right.AsBool());
     }
-    else if(right == ObjectConstants::NULL_OBJ){
-        return ObjectConstants::TRUE;
+    else if(right.IsNull()){
+        return Value::Bool(true);
     }
     else{
-        return ObjectConstants::FALSE;
+        return Value::Bool(false);
     }
 }
 
-std::shared_ptr<Object> Evaluator::evalMinusPrefixOperatorExpression(std::shared_ptr<Object> right){
-    if(right->Type() != INTEGER_OBJ){
-        return newError("unknown operator: -%s", ObjectTypeToString(right->Type()).c_str());
+Value Evaluator::evalMinusPrefixOperatorExpression(const Value& right){
+    if(!right.IsInt()){
+        return newError("unknown operator: -%s", ObjectTypeToString(right.Type()).c_str());
     }
 
-    int value = std::static_pointer_cast<Integer>(right)->Value;
-    return std::make_shared<Integer>(-value);
+    // Through uint64_t, so negating INT64_MIN wraps instead of overflowing.
+    return Value::Int(static_cast<int64_t>(0 - static_cast<uint64_t>(right.AsInt())));
 }
 
-std::shared_ptr<Object> Evaluator::evalIntegerInfixExpression(const std::string& op, std::shared_ptr<Object> left, std::shared_ptr<Object> right){
-    int leftVal = std::static_pointer_cast<Integer>(left)->Value;
-    int rightVal = std::static_pointer_cast<Integer>(right)->Value;
-
-    if(op == "+") { return std::make_shared<Integer>(leftVal + rightVal);}
-    else if (op == "-") { return std::make_shared<Integer>(leftVal - rightVal); }
-    else if (op == "*") { return std::make_shared<Integer>(leftVal * rightVal); }
-    else if (op == "/") { return std::make_shared<Integer>(leftVal / rightVal); }
-    else if (op == "<") { return nativeBoolToBooleanObject(leftVal < rightVal); }
-    else if (op == ">") { return nativeBoolToBooleanObject(leftVal > rightVal); }
-    else if (op == "==") { return nativeBoolToBooleanObject(leftVal == rightVal); }
-    else if (op == "!=") { return nativeBoolToBooleanObject(leftVal != rightVal); }
-    else {return newError("unknown operator: %s %s %s", ObjectTypeToString(left->Type()).c_str(), op.c_str(), ObjectTypeToString(right->Type()).c_str()); }
-    //else {return newError("unknown operator: %s %s %s", left->Inspect().c_str(), op.c_str(), right->Inspect().c_str()); }
+Value Evaluator::evalIntegerInfixExpression(std::string_view op, const Value& left, const Value& right){
+    int64_t leftVal = left.AsInt();
+    int64_t rightVal = right.AsInt();
+
+    // + - and * go through uint64_t, where overflow wraps; on int64_t it
+    // would be undefined.
+    uint64_t l = static_cast<uint64_t>(leftVal), r = static_cast<uint64_t>(rightVal);
+    if(op == "+") { return Value::Int(static_cast<int64_t>(l + r));}
+    else if (op == "-") { return Value::Int(static_cast<int64_t>(l - r)); }
+    else if (op == "*") { return Value::Int(static_cast<int64_t>(l * r)); }
+    else if (op == "/") {
+        // Both would trap the whole process with SIGFPE. The quotient that
+        // does not fit wraps, as + - and * do.
+        if (rightVal == 0) { return newError("division by zero"); }
+        if (rightVal == -1) { return Value::Int(static_cast<int64_t>(0 - l)); }
+        return Value::Int(leftVal / rightVal);
+    }
+    else if (op == "<") { return Value::Bool(leftVal < rightVal); }
+    else if (op == ">") { return Value::Bool(leftVal > rightVal); }
+    else if (op == "==") { return Value::Bool(leftVal == rightVal); }
+    else if (op == "!=") { return Value::Bool(leftVal != rightVal); }
+    else {return newError("unknown operator: %s %s %s", ObjectTypeToString(left.Type()).c_str(), std::string(op).c_str(), ObjectTypeToString(right.Type()).c_str()); }
+    //else {return newError("unknown operator: %s %s %s", left->Inspect().c_str(), std::string(op).c_str(), right->Inspect().c_str()); }
 }
 
-std::shared_ptr<Object> Evaluator::evalStringInfixExpression(const std::string& op, std::shared_ptr<Object> left, std::shared_ptr<Object> right){
+Value Evaluator::evalStringInfixExpression(std::string_view op, const Value& left, const Value& right){
     if(op != "+"){
-       return newError("unknown operator: %s %s %s", ObjectTypeToString(left->Type()).c_str(), op.c_str(), ObjectTypeToString(right->Type()).c_str());
+       return newError("unknown operator: %s %s %s", ObjectTypeToString(left.Type()).c_str(), std::string(op).c_str(), ObjectTypeToString(right.Type()).c_str());
     }
-    std::string leftVal = std::static_pointer_cast<String>(left)->Value;
-    std::string rightVal = std::static_pointer_cast<String>(right)->Value;
+    const std::string& leftVal = left.As<String>()->Value;
+    const std::string& rightVal = right.As<String>()->Value;
 
     return std::make_shared<String>(leftVal + rightVal);
 }
 
-std::shared_ptr<Object> Evaluator::evalIfExpression(std::shared_ptr<IfExpression> ie, std::shared_ptr<Environment> env){
+Value Evaluator::evalIfExpression(IfExpression* ie, std::shared_ptr<Environment> env){
     auto condition = Eval(ie->Condition, env);
     if(isError(condition)) return condition;
     if(isTruthy(condition)){
@@ -290,30 +303,75 @@ std::shared_ptr<Object> Evaluator::evalIfExpression(std::shared_ptr<IfExpression
         return Eval(ie->Alternative, env);
     }
     else{
-        return ObjectConstants::NULL_OBJ;
+        return Value::Null();
+    }
+}
+
+Value Evaluator::evalAssignStatement(AssignStatement* as, std::shared_ptr<Environment> env){
+    auto val = Eval(as->Value, env);
+    if(isError(val)) return val;
+    return assignVariable(as->Name, std::move(val), env);
+}
+
+// Rebinds an existing variable, returning an error if there is none.
+Value Evaluator::assignVariable(Identifier* ident, Value val, std::shared_ptr<Environment> env){
+    if (ident->Depth != Identifier::Unresolved && env->AssignAt(ident->Depth, ident->Slot, val)) {
+        return Value();
+    }
+    // Like evalIdentifier, fall back to the name for slots that are not set.
+    if (env->Assign(ident->Symbol, val)) {
+        return Value();
     }
+    return newError("identifier not found: " + std::string(ident->Value()));
 }
 
-std::shared_ptr<Object> Evaluator::evalIdentifier(std::shared_ptr<Identifier> node, std::shared_ptr<Environment> env){
-    auto val = env->Get(node->Value());
+// The loop runs in env itself and in this one C++ frame, so the number of
+// iterations costs neither environments nor stack.
+Value Evaluator::evalWhileStatement(WhileStatement* ws, std::shared_ptr<Environment> env){
+    while (true) {
+        auto condition = Eval(ws->Condition, env);
+        if(isError(condition)) return condition;
+        if(!isTruthy(condition)) return Value();
+
+        auto result = evalBlockStatement(ws->Body, env);
+        if(result.IsObject()){
+            auto rt = result.Type();
+            if(rt == RETURN_VALUE_OBJ or rt == ERROR_OBJ){
+                return result;
+            }
+        }
+        // Nothing but env and the callers' values is in use between
+        // iterations, so a long loop can collect like a call does.
+        Heap::MaybeCollect();
+    }
+}
+
+Value Evaluator::evalIdentifier(Identifier* node, std::shared_ptr<Environment> env){
+    if (node->Depth != Identifier::Unresolved) {
+        if (auto val = env->GetAt(node->Depth, node->Slot)) {
+            return val;
+        }
+    }
+
+    // Unresolved names, and resolved ones whose slot is still empty because
+    // their let has not run yet, fall back to a lookup by name.
+    auto val = env->Get(node->Symbol);
     if (val) {
         return val;
     }
 
     // If not found in the environment, check if it's a built-in function
-    auto it = builtins.find(node->Value());
-    if (it != builtins.end()) {
-        return it->second;  // Return the built-in function
+    if (auto builtin = GetBuiltinBySymbol(node->Symbol)) {
+        return builtin;  // Return the built-in function
     }
 
     // If neither in environment nor a built-in, return an error
-    return newError("identifier not found: " + node->Value());
+    return newError("identifier not found: " + std::string(node->Value()));
 }
 
-bool Evaluator::isTruthy(std::shared_ptr<Object> obj){
-    if(obj == ObjectConstants::NULL_OBJ) return false;
-    else if(obj == ObjectConstants::TRUE) return true;
-    else if(obj == ObjectConstants::FALSE) return false;
+bool Evaluator::isTruthy(const Value& obj){
+    if(obj.IsNull()) return false;
+    else if(obj.IsBool()) return obj.AsBool();
     else return true;
 }
 
@@ -331,96 +389,153 @@ std::shared_ptr<Error> Evaluator::newError(const std::string format, ...) {
 }
 
 
-bool Evaluator::isError(std::shared_ptr<Object> obj){
-    if(obj) return obj->Type() == ERROR_OBJ;
-    return false;
+bool Evaluator::isError(const Value& obj){
+    return obj.IsObject() && obj.Type() == ERROR_OBJ;
+}
+
+std::vector<Value> Evaluator::evalExpressions(const NodeList<Expression*>& exps, std::shared_ptr<Environment> env){
+    std::vector<Value> result;
+    evalExpressions(exps, env, result);
+    return result;
 }
 
-std::vector<std::shared_ptr<Object>> Evaluator::evalExpressions(std::vector<std::shared_ptr<Expression>> exps, std::shared_ptr<Environment> env){
-    std::vector<std::shared_ptr<Object>> result;
+void Evaluator::evalExpressions(const NodeList<Expression*>& exps, std::shared_ptr<Environment> env, std::vector<Value>& result){
+    result.clear();
+    result.reserve(exps.size());
     for (auto& exp : exps) {
         auto evaluated = Eval(exp, env);
         if (isError(evaluated)) {
             // If an error occurs, return a vector with just that error.
-            return {evaluated};
+            result.clear();
+            result.push_back(std::move(evaluated));
+            return;
         }
-        result.push_back(evaluated);
+        result.push_back(std::move(evaluated));
     }
-    return result;
 }
 
-std::shared_ptr<Object> Evaluator::applyFunction(std::shared_ptr<Object> fn, std::vector<std::shared_ptr<Object>> args){
-    if(auto fnCast = std::dynamic_pointer_cast<Function>(fn)){
-        auto extendedEnv = extendFunctionEnv(fnCast, args);
-        auto evaluated = Eval(fnCast->Body, extendedEnv);
-        return unwrapReturnValue(evaluated);
-    } else if (auto fnCast = std::dynamic_pointer_cast<Builtin>(fn)){
-        return fnCast->function(args);
+Value Evaluator::applyFunction(const Value& fn, const std::vector<Value>& args){
+    RunCounters& counters = Counters::Current();
+    counters.Calls++;
+    if(fn.Type() == BUILTIN_OBJ){
+        return fn.As<Builtin>()->function(args);
+    } else if (fn.Type() != FUNCTION_OBJ){
+        return newError("not a function: %s", fn.Inspect().c_str());
+    }
+
+    // The trampoline: each tail call the body ends with runs here, in the
+    // next round of the loop, instead of one C++ frame deeper.
+    Function* fnCast = fn.As<Function>();
+    Value callee; // holds the function of the latest tail call
+    std::vector<Value> tailArgs;
+    const std::vector<Value>* calleeArgs = &args;
+    std::shared_ptr<Environment> env;
+    while (true) {
+        // Calls are where cycles pile up, and everything the evaluator is
+        // working on is held by a shared_ptr here, so it is safe to collect.
+        Heap::MaybeCollect();
+        // Checked on every round, since a tail call brings its own arguments.
+        if (calleeArgs->size() != fnCast->Parameters.size()) {
+            return newError("wrong number of arguments: want=%zu, got=%zu", fnCast->Parameters.size(), calleeArgs->size());
+        }
+        if (env && env.use_count() == 1 && fnCast->Locals) {
+            // Nothing kept the finished call's environment, so the next
+            // call reuses its storage instead of allocating another.
+            env->Reset(fnCast->Env, fnCast->Locals);
+            for (size_t i = 0; i < fnCast->Parameters.size(); ++i) {
+                env->SetAt(fnCast->Parameters[i]->Slot, (*calleeArgs)[i]);
+            }
+        } else {
+            env = extendFunctionEnv(fnCast, *calleeArgs);
+        }
+
+        auto evaluated = Eval(fnCast->Body, env);
+        if (!isTailCall(evaluated)) {
+            return unwrapReturnValue(std::move(evaluated));
+        }
+
+        // Swapping hands the spent arguments' vector back for the next call.
+        callee = std::move(pendingCall.Function);
+        tailArgs.swap(pendingCall.Args);
+        pendingCall.Args.clear();
+        calleeArgs = &tailArgs;
+        counters.Calls++;
+        if (callee.Type() == BUILTIN_OBJ) {
+            return callee.As<Builtin>()->function(tailArgs);
+        } else if (callee.Type() != FUNCTION_OBJ) {
+            return newError("not a function: %s", callee.Inspect().c_str());
+        }
+        fnCast = callee.As<Function>();
     }
-    //else
-    return newError("not a function: %s", fn->Inspect().c_str());
 }
 
-std::shared_ptr<Environment> Evaluator::extendFunctionEnv(std::shared_ptr<Function> fn, std::vector<std::shared_ptr<Object>> args){
-    auto env = std::make_shared<Environment>(fn->Env);
+std::shared_ptr<Environment> Evaluator::extendFunctionEnv(Function* fn, const std::vector<Value>& args){
+    if (!fn->Locals) {
+        auto env = std::make_shared<Environment>(fn->Env);
+        for (size_t i = 0; i < fn->Parameters.size(); ++i) {
+            env->Set(fn->Parameters[i]->Symbol, args[i]);
+        }
+        return env;
+    }
+
+    auto env = std::make_shared<Environment>(fn->Env, fn->Locals);
     for (size_t i = 0; i < fn->Parameters.size(); ++i) {
-        env->Set(fn->Parameters[i]->Value(), args[i]);
+        env->SetAt(fn->Parameters[i]->Slot, args[i]);
     }
     return env;
 }
 
-std::shared_ptr<Object> Evaluator::unwrapReturnValue(std::shared_ptr<Object> obj){
-    auto returnValue = std::dynamic_pointer_cast<ReturnValue>(obj);
-    if (returnValue) {
-        return returnValue->Value;
+Value Evaluator::unwrapReturnValue(Value obj){
+    if (obj.IsObject() && obj.Type() == RETURN_VALUE_OBJ) {
+        return obj.As<ReturnValue>()->Value;
     }
     return obj;
 }
 
-std::shared_ptr<Object> Evaluator::evalIndexExpression(std::shared_ptr<Object> left, std::shared_ptr<Object> index){
-    if(left->Type() == ARRAY_OBJ && index->Type() == INTEGER_OBJ) return evalArrayIndexExpression(left, index);
-    else if(left->Type() == HASH_OBJ) return evalHashIndexExpression(left, index);
-    else {return newError("index operator not supported: %s", ObjectTypeToString(left->Type()).c_str()); }
+Value Evaluator::evalIndexExpression(const Value& left, const Value& index){
+    if(left.Type() == ARRAY_OBJ && index.IsInt()) return evalArrayIndexExpression(left, index);
+    else if(left.Type() == HASH_OBJ) return evalHashIndexExpression(left, index);
+    else {return newError("index operator not supported: %s", ObjectTypeToString(left.Type()).c_str()); }
 }
 
-std::shared_ptr<Object> Evaluator::evalArrayIndexExpression(std::shared_ptr<Object> array, std::shared_ptr<Object> index){
-    auto arrayObject = std::dynamic_pointer_cast<ArrayObject>(array);
-    int idx = std::dynamic_pointer_cast<Integer>(index)->Value;
-    int max = arrayObject->Elements.size() - 1;
+Value Evaluator::evalArrayIndexExpression(const Value& array, const Value& index){
+    auto arrayObject = array.As<ArrayObject>();
+    int64_t idx = index.AsInt();
+    int64_t max = static_cast<int64_t>(arrayObject->Elements.size()) - 1;
 
-    if(idx < 0 or idx > max) return ObjectConstants::NULL_OBJ;
+    if(idx < 0 or idx > max) return Value::Null();
 
     return arrayObject->Elements[idx];
 }
 
-std::shared_ptr<Object> Evaluator::evalHashLiteral(std::shared_ptr<HashLiteral> node, std::shared_ptr<Environment> env){
-    std::map<HashKey, HashPair> pairs;
+Value Evaluator::evalHashLiteral(HashLiteral* node, std::shared_ptr<Environment> env){
+    HashTable pairs;
+    pairs.Reserve(node->Pairs.size());
     for(const auto& nodePair : node->Pairs) {
-        auto key = Eval(nodePair.first, env);
+        auto key = Eval(nodePair.Key, env);
         if(isError(key)) return key;
 
-        auto hashKey = std::dynamic_pointer_cast<Hashable>(key);
-        if(!hashKey) return newError("unusable as hash key: %s", ObjectTypeToString(key->Type()).c_str());
+        auto hashKey = HashKeyOf(key);
+        if(!hashKey) return newError("unusable as hash key: %s", ObjectTypeToString(key.Type()).c_str());
 
-        auto value = Eval(nodePair.second, env);
-        if(isError(key)) return value;
+        auto value = Eval(nodePair.Value, env);
+        if(isError(value)) return value;
 
-        auto hashed = hashKey->keyHash();
-        pairs[hashed] = HashPair{key, value};
+        pairs.Set(*hashKey, HashPair{key, value});
     }
 
-    return std::make_shared<Hash>(pairs);
+    return std::make_shared<Hash>(std::move(pairs));
 }
 
-std::shared_ptr<Object> Evaluator::evalHashIndexExpression(std::shared_ptr<Object> hash, std::shared_ptr<Object> index){
-    auto hashObject = std::dynamic_pointer_cast<Hash>(hash);
+Value Evaluator::evalHashIndexExpression(const Value& hash, const Value& index){
+    auto hashObject = hash.As<Hash>();
 
-    auto key = std::dynamic_pointer_cast<Hashable>(index);
-    if(!key) return newError("unusable as hash key: %s", ObjectTypeToString(index->Type()).c_str());
-    auto pair = hashObject->Pairs.find(key->keyHash());
-    if(pair == hashObject->Pairs.end()) return ObjectConstants::NULL_OBJ;
+    auto key = HashKeyOf(index);
+    if(!key) return newError("unusable as hash key: %s", ObjectTypeToString(index.Type()).c_str());
+    auto pair = hashObject->Pairs.Find(*key, index);
+    if(!pair) return Value::Null();
 
-    return pair->second.Value;
+    return pair->Value;
 }
 
 //g++ -std=c++17 -Isrc -c src/monkey/evaluator/evaluator.cpp -o evaluator.o
\ No newline at end of file
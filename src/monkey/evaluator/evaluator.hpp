@@ -5,6 +5,9 @@
 #include "../ast/ast.hpp"
 #include "../object/object.hpp"
 #include "../object/environment.hpp"
+#include "../object/builtins.hpp"
+#include "../object/limits.hpp"
+#include "resolver.hpp"
 #include <map>
 #include <cstdarg>
 #include <cstdio>
@@ -16,37 +19,39 @@ using namespace YOXS_AST;
 class Evaluator {
 public:
 
-    static std::shared_ptr<Object> Eval(std::shared_ptr<Node> node, std::shared_ptr<Environment> env);
-    static std::shared_ptr<Object> evalProgram(std::shared_ptr<Program> program, std::shared_ptr<Environment> env);
-    static std::shared_ptr<Object> evalBlockStatement(std::shared_ptr<BlockStatement> block, std::shared_ptr<Environment> env);
-    static std::shared_ptr<BooleanObject> nativeBoolToBooleanObject(bool input);
-    static std::shared_ptr<Object> evalPrefixExpression(const std::string& op, std::shared_ptr<Object> right);
-    static std::shared_ptr<Object> evalInfixExpression(const std::string& op, std::shared_ptr<Object> left, std::shared_ptr<Object> right);
-    static std::shared_ptr<Object> evalBangOperatorExpression(std::shared_ptr<Object> right);
-    static std::shared_ptr<Object> evalMinusPrefixOperatorExpression(std::shared_ptr<Object> right);
-    static std::shared_ptr<Object> evalIntegerInfixExpression(const std::string& op, std::shared_ptr<Object> left, std::shared_ptr<Object> right);
-    static std::shared_ptr<Object> evalStringInfixExpression(const std::string& op, std::shared_ptr<Object> left, std::shared_ptr<Object> right);
-    static std::shared_ptr<Object> evalIfExpression(std::shared_ptr<IfExpression> ie, std::shared_ptr<Environment> env);
-    static std::shared_ptr<Object> evalIdentifier(std::shared_ptr<Identifier> node, std::shared_ptr<Environment> env);
+    // Resolves and evaluates a whole program. Functions created while
+    // evaluating it keep the program, and with it every AST node, alive.
+    // The result is boxed into an Object for the host. A run that hits one
+    // of limits ends with an Error of the matching ErrorKind.
+    static std::shared_ptr<Object> Eval(std::shared_ptr<Program> program, std::shared_ptr<Environment> env, const ExecutionLimits& limits = {});
+    static Value Eval(Node* node, std::shared_ptr<Environment> env);
+    static Value evalProgram(Program* program, std::shared_ptr<Environment> env);
+    static Value evalBlockStatement(BlockStatement* block, std::shared_ptr<Environment> env);
+    static Value evalPrefixExpression(std::string_view op, const Value& right);
+    static Value evalInfixExpression(std::string_view op, const Value& left, const Value& right);
+    static Value evalBangOperatorExpression(const Value& right);
+    static Value evalMinusPrefixOperatorExpression(const Value& right);
+    static Value evalIntegerInfixExpression(std::string_view op, const Value& left, const Value& right);
+    static Value evalStringInfixExpression(std::string_view op, const Value& left, const Value& right);
+    static Value evalIfExpression(IfExpression* ie, std::shared_ptr<Environment> env);
+    static Value evalAssignStatement(AssignStatement* as, std::shared_ptr<Environment> env);
+    static Value assignVariable(Identifier* name, Value val, std::shared_ptr<Environment> env);
+    static Value evalWhileStatement(WhileStatement* ws, std::shared_ptr<Environment> env);
+    static Value evalIdentifier(Identifier* node, std::shared_ptr<Environment> env);
     
-    static bool isTruthy(std::shared_ptr<Object> obj);
+    static bool isTruthy(const Value& obj);
     static std::shared_ptr<Error> newError(const std::string format, ...);
-    static bool isError(std::shared_ptr<Object> obj);
-    static std::vector<std::shared_ptr<Object>> evalExpressions(std::vector<std::shared_ptr<Expression>> exps, std::shared_ptr<Environment> env);
-    static std::shared_ptr<Object> applyFunction(std::shared_ptr<Object> fn, std::vector<std::shared_ptr<Object>> args);
-    static std::shared_ptr<Environment> extendFunctionEnv(std::shared_ptr<Function> fn, std::vector<std::shared_ptr<Object>> args);
-    static std::shared_ptr<Object> unwrapReturnValue(std::shared_ptr<Object> obj);
-    static std::shared_ptr<Object> evalIndexExpression(std::shared_ptr<Object> left, std::shared_ptr<Object> index);
-    static std::shared_ptr<Object> evalArrayIndexExpression(std::shared_ptr<Object> array, std::shared_ptr<Object> index);
-    static std::shared_ptr<Object> evalHashLiteral(std::shared_ptr<HashLiteral> node, std::shared_ptr<Environment> env);
-    static std::shared_ptr<Object> evalHashIndexExpression(std::shared_ptr<Object> hash, std::shared_ptr<Object> index);
-};
-
-class ObjectConstants {
-public:
-    static std::shared_ptr<NullObject> NULL_OBJ;
-    static std::shared_ptr<BooleanObject> TRUE;
-    static std::shared_ptr<BooleanObject> FALSE;
+    static bool isError(const Value& obj);
+    static std::vector<Value> evalExpressions(const NodeList<Expression*>& exps, std::shared_ptr<Environment> env);
+    static void evalExpressions(const NodeList<Expression*>& exps, std::shared_ptr<Environment> env, std::vector<Value>& result);
+    static Value applyFunction(const Value& fn, const std::vector<Value>& args);
+    // args must hold one value per parameter; applyFunction checks that.
+    static std::shared_ptr<Environment> extendFunctionEnv(Function* fn, const std::vector<Value>& args);
+    static Value unwrapReturnValue(Value obj);
+    static Value evalIndexExpression(const Value& left, const Value& index);
+    static Value evalArrayIndexExpression(const Value& array, const Value& index);
+    static Value evalHashLiteral(HashLiteral* node, std::shared_ptr<Environment> env);
+    static Value evalHashIndexExpression(const Value& hash, const Value& index);
 };
 
 #endif // EVALUATOR_H
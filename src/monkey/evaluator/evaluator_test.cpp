@@ -1,5 +1,8 @@
 #include <iostream>
 #include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
 #include <variant>
 #include <string>
 #include "evaluator.hpp"
@@ -24,6 +27,18 @@ bool testIntegerObject(const std::shared_ptr<Object>& obj, int64_t expected);
 bool testBooleanObject(const std::shared_ptr<Object>& obj, bool expected);
 bool testNullObject(const std::shared_ptr<Object> obj);
 
+// Counts every allocation, so tests can check that a path allocates nothing.
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
 void TestEvalIntegerExpression(){
     struct TestCase {
         std::string input;
@@ -237,6 +252,10 @@ void TestErrorHandling(){
 		{
 			"999[1]",
 			"index operator not supported: INTEGER",
+		},
+		{
+			"[1][true + 1]",
+			"type mismatch: BOOLEAN + INTEGER",
 		}
     };
 
@@ -343,6 +362,208 @@ void TestClosures() {
     testIntegerObject(testEval(input), 4);
 }
 
+// Tokens view the source text, so a Function must keep it alive after the
+// program and the string it was parsed from are gone.
+void TestFunctionOutlivesSource() {
+    auto env = std::make_shared<Environment>();
+    {
+        std::string input = "let greet = fn(name) { let hello = \"hello \"; hello + name };";
+        Lexer l(input);
+        Parser p(l);
+        Evaluator::Eval(p.ParseProgram(), env);
+    }
+
+    std::string input = "greet(\"monkey\")";
+    Lexer l(input);
+    Parser p(l);
+    auto str = std::dynamic_pointer_cast<String>(Evaluator::Eval(p.ParseProgram(), env));
+    if (!str || str->Value != "hello monkey") {
+        std::cerr << "function body did not survive its source. got=" << (str ? str->Value : "nullptr") << std::endl;
+        exit(1);
+    }
+}
+
+// The Resolver places parameters first and lets after them, and counts
+// depth in function scopes, not blocks.
+void TestResolver() {
+    std::string input = "let a = 1; let f = fn(x, y) { if (x) { let z = a; } z + y + len };";
+    Lexer l(input);
+    Parser p(l);
+    auto program = p.ParseProgram();
+    Scope globals;
+    Resolver(globals).Resolve(program.get());
+
+    auto fn = static_cast<FunctionLiteral*>(static_cast<LetStatement*>(program->Statements[1])->Value);
+    auto ifStmt = static_cast<ExpressionStatement*>(fn->Body->Statements[0]);
+    auto let = static_cast<LetStatement*>(static_cast<IfExpression*>(ifStmt->expr)->Consequence->Statements[0]);
+    auto sum = static_cast<InfixExpression*>(static_cast<ExpressionStatement*>(fn->Body->Statements[1])->expr);
+    auto zPlusY = static_cast<InfixExpression*>(sum->Left);
+
+    struct TestCase {
+        Identifier* ident;
+        uint32_t depth;
+        uint32_t slot;
+    };
+    std::vector<TestCase> tests = {
+        {static_cast<LetStatement*>(program->Statements[0])->Name, 0, 0},
+        {static_cast<LetStatement*>(program->Statements[1])->Name, 0, 1},
+        {fn->Parameters[1], 0, 1},
+        {let->Name, 0, 2},
+        {static_cast<Identifier*>(let->Value), 1, 0},
+        {static_cast<Identifier*>(zPlusY->Left), 0, 2},
+        {static_cast<Identifier*>(sum->Right), Identifier::Unresolved, 0},
+    };
+    for (const auto& tt : tests) {
+        if (tt.ident->Depth != tt.depth || (tt.depth != Identifier::Unresolved && tt.ident->Slot != tt.slot)) {
+            std::cerr << "identifier " << tt.ident->Value() << " resolved to (" << tt.ident->Depth << ", " << tt.ident->Slot
+                      << "), want (" << tt.depth << ", " << tt.slot << ")" << std::endl;
+            exit(1);
+        }
+    }
+    if (globals.Size() != 2 || fn->Locals->Size() != 3) {
+        std::cerr << "wrong scope sizes: globals=" << globals.Size() << ", locals=" << fn->Locals->Size() << std::endl;
+        exit(1);
+    }
+}
+
+// Slots must not change what a name means: reads before a let still see the
+// outer binding, functions see globals defined after them, and rebinding
+// reuses the slot.
+void TestResolvedScoping() {
+    struct TestCase {
+        std::string input;
+        int64_t expected;
+    };
+    std::vector<TestCase> tests = {
+        {"let x = 1; let f = fn() { let y = x; let x = 2; y * 10 + x }; f();", 12},
+        {"let f = fn() { g() }; let g = fn() { 7 }; f();", 7},
+        {"let x = 1; let x = x + 1; x;", 2},
+        {"let f = fn(n) { if (n > 0) { let r = n; } r }; f(3);", 3},
+        {"let f = fn(a, a) { a }; f(1, 2);", 2},
+        {"let make = fn(x) { fn(y) { fn(z) { x * 100 + y * 10 + z } } }; make(1)(2)(3);", 123},
+        {"let fact = fn(n) { if (n == 0) { 1 } else { n * fact(n - 1) } }; fact(10);", 3628800},
+    };
+    for (const auto& tt : tests) {
+        auto evaluated = testEval(tt.input);
+        auto integer = std::dynamic_pointer_cast<Integer>(evaluated);
+        if (!integer || integer->Value != tt.expected) {
+            std::cerr << "wrong result for " << tt.input << ". got=" << (evaluated ? evaluated->Inspect() : "nullptr")
+                      << ", want=" << tt.expected << std::endl;
+            exit(1);
+        }
+    }
+
+    // Later programs in the same environment keep seeing earlier globals.
+    auto env = std::make_shared<Environment>();
+    for (std::string input : {"let a = 5; let get = fn() { a };", "let b = 6; let a = 7;", "get() * 10 + b"}) {
+        Lexer l(input);
+        Parser p(l);
+        auto result = Evaluator::Eval(p.ParseProgram(), env);
+        if (input == "get() * 10 + b") {
+            auto integer = std::dynamic_pointer_cast<Integer>(result);
+            if (!integer || integer->Value != 76) {
+                std::cerr << "globals not shared between programs. got=" << (result ? result->Inspect() : "nullptr") << std::endl;
+                exit(1);
+            }
+        }
+    }
+}
+
+std::shared_ptr<Object> evalIn(const std::string& input, std::shared_ptr<Environment> env) {
+    Lexer l(input);
+    Parser p(l);
+    return Evaluator::Eval(p.ParseProgram(), env);
+}
+
+// A recursive function and the environment it is bound in keep each other
+// alive, so only the collector can free them, and it must never free
+// anything that is still reachable.
+void TestCycleCollection() {
+    Heap::SetThreshold(0);
+    Heap::Collect();
+    size_t baseline = Heap::Stats().Live;
+
+    std::string recursive = "let f = fn(n) { if (n == 0) { 0 } else { f(n - 1) } }; let xs = [f, {1: f}]; f(10);";
+    for (int i = 0; i < 100; i++) {
+        evalIn(recursive, std::make_shared<Environment>());
+    }
+    if (Heap::Stats().Live <= baseline) {
+        std::cerr << "expected the cycles to outlive their environments" << std::endl;
+        exit(1);
+    }
+    size_t freed = Heap::Collect();
+    if (Heap::Stats().Live != baseline || freed == 0) {
+        std::cerr << "cycles not collected: live=" << Heap::Stats().Live << ", baseline=" << baseline << std::endl;
+        exit(1);
+    }
+
+    // Reachable from an environment the host still holds.
+    auto env = std::make_shared<Environment>();
+    evalIn("let counter = fn(n) { if (n == 0) { 0 } else { counter(n - 1) + 1 } }; let fns = [counter];", env);
+    // Reachable only from a value the host holds.
+    auto g = evalIn("let make = fn() { let g = fn() { g }; g }; make();", std::make_shared<Environment>());
+    Heap::Collect();
+    if (!testIntegerObject(evalIn("fns[0](3)", env), 3) || Evaluator::applyFunction(g, {}) != g) {
+        std::cerr << "collector freed values that were still reachable" << std::endl;
+        exit(1);
+    }
+
+    // With a threshold, collections happen during evaluation and the heap
+    // stays flat however many programs run.
+    env.reset();
+    g.reset();
+    Heap::SetThreshold(500);
+    size_t collections = Heap::Stats().Collections;
+    size_t peak = 0;
+    for (int i = 0; i < 2000; i++) {
+        evalIn(recursive, std::make_shared<Environment>());
+        peak = std::max(peak, Heap::Stats().Live);
+    }
+    if (Heap::Stats().Collections == collections || peak > baseline + 2000) {
+        std::cerr << "automatic collection did not bound the heap: peak=" << peak << std::endl;
+        exit(1);
+    }
+    Heap::SetThreshold(10000);
+}
+
+// push and rest share storage with their argument, which must stay as it was.
+void TestPersistentArrays() {
+    struct TestCase {
+        std::string input;
+        int64_t expected;
+    };
+    // grow recurses once per 100 elements so the tests stay clear of the C++ stack limit.
+    std::string fill = "let fill = fn(arr, i, n) { if (i == n) { arr } else { fill(push(arr, i), i + 1, n) } };"
+                       "let grow = fn(arr, i, n) { if (i == n) { arr } else { grow(fill(arr, i, i + 100), i + 100, n) } };";
+    std::vector<TestCase> tests = {
+        {"let a = [1, 2, 3]; let b = push(a, 4); len(a) * 10 + len(b)", 34},
+        {"let a = [1, 2, 3]; let b = rest(a); let c = push(b, 9); a[0] * 100 + b[0] * 10 + c[2]", 129},
+        {fill + "let big = grow([], 0, 2000); let r = rest(rest(big)); big[1999] + r[0] + len(r)", 1999 + 2 + 1998},
+        {fill + "let big = grow([], 0, 1100); let a = push(big, 7); let b = push(big, 8); a[1100] * 10 + b[1100] + big[1056]", 78 + 1056},
+    };
+    for (const auto& tt : tests) {
+        auto evaluated = testEval(tt.input);
+        if (!testIntegerObject(evaluated, tt.expected)) {
+            std::cerr << "wrong result for " << tt.input << std::endl;
+            exit(1);
+        }
+    }
+
+    // Functions in shared trie nodes are counted once by the collector.
+    Heap::SetThreshold(0);
+    auto env = std::make_shared<Environment>();
+    evalIn(fill + "let f = fn() { f }; let a = fill([f, f], 0, 100); let b = push(a, f); let c = rest(a);", env);
+    Heap::Collect();
+    auto result = evalIn("len(a) + len(b) + len(c) + (if (b[0]() == f) { 1000 } else { 0 })", env);
+    env.reset();
+    Heap::Collect();
+    Heap::SetThreshold(10000);
+    if (!testIntegerObject(result, 102 + 103 + 101 + 1000)) {
+        std::cerr << "collector freed array elements that were still reachable" << std::endl;
+        exit(1);
+    }
+}
+
 void TestStringLiteral(){
     std::string input = R"("Hello World!")";
     auto evaluated = testEval(input);
@@ -415,7 +636,7 @@ void TestBuiltinFunctions() {
                     std::cerr << "wrong num of elements. want=" << expectedVector.size() << " got=" << array->Elements.size() << "\n";
                 }
                 for (size_t i = 0; i < expectedVector.size(); ++i) {
-                    testIntegerObject(array->Elements[i], expectedVector[i]);
+                    testIntegerObject(array->Elements[i].ToObject(), expectedVector[i]);
                 }
             }
         }, tt.expected);
@@ -428,9 +649,9 @@ void TestArrayLiteral() {
     auto result = std::dynamic_pointer_cast<ArrayObject>(evaluated);
     if(!result) std::cerr << "object is not Array. got=" << evaluated << std::endl;
     if(result->Elements.size() != 3) std::cerr << "array has wrong num of elements. got=" << result->Elements.size() << "\n";
-    testIntegerObject(result->Elements[0], 1);
-	testIntegerObject(result->Elements[1], 4);
-	testIntegerObject(result->Elements[2], 6);
+    testIntegerObject(result->Elements[0].ToObject(), 1);
+	testIntegerObject(result->Elements[1].ToObject(), 4);
+	testIntegerObject(result->Elements[2].ToObject(), 6);
 }
 
 void TestArrayIndexExpressions() {
@@ -509,13 +730,13 @@ void TestHashLiterals() {
     auto result = std::dynamic_pointer_cast<Hash>(evaluated);
     if(!result) std::cerr << "Eval didn't return Hash. got=" << evaluated << std::endl;
 
-    auto expected = std::map<HashKey, int64_t>{
-        { std::make_shared<String>("one")->keyHash(), 1 },
-        { std::make_shared<String>("two")->keyHash(), 2 },
-        { std::make_shared<String>("three")->keyHash(), 3 },
-        { std::make_shared<Integer>(4)->keyHash(), 4 },
-        { ObjectConstants::TRUE->keyHash(), 5 },
-        { ObjectConstants::FALSE->keyHash(), 6 },
+    auto expected = std::vector<std::pair<std::shared_ptr<Object>, int64_t>>{
+        { std::make_shared<String>("one"), 1 },
+        { std::make_shared<String>("two"), 2 },
+        { std::make_shared<String>("three"), 3 },
+        { std::make_shared<Integer>(4), 4 },
+        { ObjectConstants::TRUE, 5 },
+        { ObjectConstants::FALSE, 6 },
     };
 
     if (result->Pairs.size() != expected.size()) {
@@ -523,11 +744,11 @@ void TestHashLiterals() {
     }
 
     for (const auto& [expectedKey, expectedValue] : expected) {
-        auto iter = result->Pairs.find(expectedKey);
-        if (iter == result->Pairs.end()) {
+        auto pair = result->Pairs.Find(*HashKeyOf(expectedKey), expectedKey);
+        if (!pair) {
             std::cerr << "No pair for given key in Pairs" << std::endl;
         } else {
-            testIntegerObject(iter->second.Value, expectedValue);
+            testIntegerObject(pair->Value.ToObject(), expectedValue);
         }
     }
 }
@@ -624,6 +845,272 @@ bool testNullObject(const std::shared_ptr<Object> obj) {
     return true;
 }
 
+// Integers, booleans and null are inline Values: arithmetic and comparisons
+// allocate nothing, and integers use all 64 bits.
+void TestInlineValues() {
+    std::string input = "(1 + 2) * 30 - 4 / 2 == 88 != !(-7 < 3)";
+    Lexer l(input);
+    Parser p(l);
+    auto program = p.ParseProgram();
+    auto expr = static_cast<ExpressionStatement*>(program->Statements[0])->expr;
+    auto env = std::make_shared<Environment>();
+
+    size_t before = allocations;
+    Value result = Evaluator::Eval(expr, env);
+    size_t allocated = allocations - before;
+    if (allocated != 0 || !result.IsBool() || result.AsBool() != true) {
+        std::cerr << "arithmetic allocated " << allocated << " times, result=" << result.Inspect() << std::endl;
+        exit(1);
+    }
+
+    struct TestCase {
+        std::string input;
+        int64_t expected;
+    };
+    std::vector<TestCase> tests = {
+        {"3000000000 * 3", 9000000000},
+        {"let big = 4294967296; big + big", 8589934592},
+        {"-9000000000 / 3", -3000000000},
+    };
+    for (const auto& tt : tests) {
+        if (!testIntegerObject(testEval(tt.input), tt.expected)) {
+            std::cerr << "wrong 64-bit result for " << tt.input << std::endl;
+            exit(1);
+        }
+    }
+
+    // Boxed integers from the host unbox, so they compare equal to inline ones.
+    Value boxed(std::make_shared<Integer>(5));
+    if (!boxed.IsInt() || boxed != Value::Int(5) || Value(ObjectConstants::TRUE) != Value::Bool(true) ||
+        !Value(ObjectConstants::NULL_OBJ).IsNull() || Value::Int(5).ToObject()->Inspect() != "5") {
+        std::cerr << "boxed values do not match inline ones" << std::endl;
+        exit(1);
+    }
+}
+
+void TestWhileLoops() {
+    struct TestCase {
+        std::string input;
+        int64_t expected;
+    };
+    std::vector<TestCase> tests = {
+        {"let i = 0; let sum = 0; while (i < 10) { sum = sum + i; i = i + 1; } sum", 45},
+        {"let i = 0; let n = 0; while (i < 5) { let j = 0; while (j < 4) { n = n + 1; j = j + 1; } i = i + 1; } n", 20},
+        {"let x = 5; while (false) { x = 6; } x", 5},
+        {"let find = fn(limit) { let i = 0; while (true) { if (i * i > limit) { return i; } i = i + 1; } }; find(50)", 8},
+        {"let f = fn(x) { x = x * 2; x }; f(21)", 42},
+        {"let count = 0; let inc = fn() { count = count + 1; }; inc(); inc(); count", 2},
+        {"let make = fn() { let n = 0; fn() { n = n + 1; n } }; let c = make(); c(); c(); c()", 3},
+    };
+    for (const auto& tt : tests) {
+        if (!testIntegerObject(testEval(tt.input), tt.expected)) {
+            std::cerr << "wrong result for " << tt.input << std::endl;
+            exit(1);
+        }
+    }
+
+    struct ErrorCase {
+        std::string input;
+        std::string expectedMessage;
+    };
+    std::vector<ErrorCase> errors = {
+        {"y = 1", "identifier not found: y"},
+        {"let f = fn() { z = 1; }; f()", "identifier not found: z"},
+        {"let i = 0; while (i < 3) { i = i + true; }", "type mismatch: INTEGER + BOOLEAN"},
+        {"while (1 + true) { 1 }", "type mismatch: INTEGER + BOOLEAN"},
+    };
+    for (const auto& tt : errors) {
+        auto evaluated = testEval(tt.input);
+        auto err = std::dynamic_pointer_cast<Error>(evaluated);
+        if (!err || err->Message != tt.expectedMessage) {
+            std::cerr << "expected error " << tt.expectedMessage << " for " << tt.input << ", got "
+                      << (evaluated ? evaluated->Inspect() : "nothing") << std::endl;
+            exit(1);
+        }
+    }
+
+    // The body runs in the enclosing environment, so iterations allocate
+    // nothing no matter how many there are.
+    auto loopAllocations = [](int n) {
+        Lexer l("let i = 0; while (i < " + std::to_string(n) + ") { let j = i * 2; i = i + 1; }");
+        Parser p(l);
+        auto program = p.ParseProgram();
+        auto env = std::make_shared<Environment>();
+        Resolver(env->Names()).Resolve(program.get());
+        Evaluator::Eval(program->Statements[0], env);
+        size_t before = allocations;
+        Evaluator::Eval(program->Statements[1], env);
+        return allocations - before;
+    };
+    size_t few = loopAllocations(10), many = loopAllocations(100000);
+    if (few != many || many != 0) {
+        std::cerr << "loop allocated " << few << " times for 10 iterations and " << many << " for 100000" << std::endl;
+        exit(1);
+    }
+}
+
+// Division that would trap the process with SIGFPE gives an error or a
+// wrapped quotient instead.
+void TestIntegerLimits() {
+    const char* errors[] = {"1 / 0", "let f = fn(x) { x / (x - x) }; f(7)", "0 / 0"};
+    for (const char* input : errors) {
+        auto err = std::dynamic_pointer_cast<Error>(testEval(input));
+        if (!err || err->Message != "division by zero") {
+            std::cerr << "no division by zero error for " << input << std::endl;
+            exit(1);
+        }
+    }
+    if (!testIntegerObject(testEval("(-9223372036854775807 - 1) / -1"), INT64_MIN) ||
+        !testIntegerObject(testEval("-7 / -1"), 7) || !testIntegerObject(testEval("-7 / 2"), -3)) {
+        std::cerr << "wrong quotient" << std::endl;
+        exit(1);
+    }
+    // Overflow wraps around.
+    if (!testIntegerObject(testEval("9223372036854775807 + 1"), INT64_MIN) ||
+        !testIntegerObject(testEval("-9223372036854775807 - 2"), INT64_MAX) ||
+        !testIntegerObject(testEval("4611686018427387904 * 2"), INT64_MIN) ||
+        !testIntegerObject(testEval("-(-9223372036854775807 - 1)"), INT64_MIN)) {
+        std::cerr << "overflow does not wrap" << std::endl;
+        exit(1);
+    }
+    std::cout << "TestIntegerLimits passed!" << std::endl;
+}
+
+void TestTailCalls() {
+    struct TestCase {
+        std::string input;
+        int64_t expected;
+    };
+    // Each of these recurses far deeper than the C++ stack would allow if
+    // every call took a frame.
+    std::vector<TestCase> tests = {
+        {"let count = fn(n, acc) { if (n == 0) { acc } else { count(n - 1, acc + 1) } }; count(1000000, 0)", 1000000},
+        {"let count = fn(n) { if (n == 0) { return 0; } return count(n - 1); }; count(200000)", 0},
+        {"let even = fn(n) { if (n == 0) { true } else { odd(n - 1) } }; let odd = fn(n) { if (n == 0) { false } else { even(n - 1) } }; if (even(100001)) { 1 } else { 2 }", 2},
+        {"let a = []; let i = 0; while (i < 100000) { a = push(a, i); i = i + 1; } "
+         "let sum = fn(arr, i, acc) { if (i == len(arr)) { acc } else { sum(arr, i + 1, acc + arr[i]) } }; sum(a, 0, 0)", 4999950000},
+        {"let find = fn(n) { while (true) { if (n > 10) { return find(n - 20); } return n; } }; find(500001)", 1},
+        // A tail call to a builtin, and one whose callee captures the
+        // environment, so it cannot be reused.
+        {"let size = fn(a) { len(a) }; size([1, 2, 3])", 3},
+        {"let keep = fn(n, fs) { if (n == 0) { fs } else { keep(n - 1, push(fs, fn() { n })) } }; keep(3, [])[0]()", 3},
+        // A return inside a let's value is not a tail call, so the call
+        // runs before another call can replace the pending one.
+        {"let f = fn(a) { a }; let h = fn(b) { f(b) }; "
+         "let g = fn(c) { let x = if (c) { return f(1) }; let y = h(2); x }; g(true)", 1},
+    };
+    for (const auto& tt : tests) {
+        if (!testIntegerObject(testEval(tt.input), tt.expected)) {
+            std::cerr << "wrong result for " << tt.input << std::endl;
+            exit(1);
+        }
+    }
+
+    // Arity is checked on the first call and on each tail call.
+    const char* arity[][2] = {
+        {"let g = fn(x, y) { x }; g(5)", "wrong number of arguments: want=2, got=1"},
+        {"let g = fn(x) { x }; g(5, 6)", "wrong number of arguments: want=1, got=2"},
+        {"let g = fn(x, y) { y }; let h = fn(n) { g(n) }; h(5)", "wrong number of arguments: want=2, got=1"},
+        {"let g = fn() { 1 }; let h = fn(n) { g(n, n) }; h(5)", "wrong number of arguments: want=0, got=2"},
+    };
+    for (const auto& tt : arity) {
+        auto wrong = std::dynamic_pointer_cast<Error>(testEval(tt[0]));
+        if (!wrong || wrong->Message != tt[1]) {
+            std::cerr << "wrong arity error for " << tt[0] << ". got=" << (wrong ? wrong->Message : "no error") << std::endl;
+            exit(1);
+        }
+    }
+
+    auto err = std::dynamic_pointer_cast<Error>(testEval("let f = fn() { 5() }; f()"));
+    if (!err || err->Message != "not a function: 5") {
+        std::cerr << "tail call to a non-function did not fail" << std::endl;
+        exit(1);
+    }
+
+    // A self tail call reuses the environment, so the allocations do not
+    // grow with the number of calls.
+    auto callAllocations = [](int n) {
+        Lexer l("let count = fn(n, acc) { if (n == 0) { acc } else { count(n - 1, acc + 1) } }; count(" + std::to_string(n) + ", 0)");
+        Parser p(l);
+        auto program = p.ParseProgram();
+        auto env = std::make_shared<Environment>();
+        Resolver(env->Names()).Resolve(program.get());
+        Evaluator::Eval(program->Statements[0], env);
+        size_t before = allocations;
+        Evaluator::Eval(program->Statements[1], env);
+        return allocations - before;
+    };
+    callAllocations(10); // leaves the reused argument vector allocated
+    size_t few = callAllocations(10), many = callAllocations(10000);
+    if (few != many) {
+        std::cerr << "tail calls allocated " << few << " times for 10 calls and " << many << " for 10000" << std::endl;
+        exit(1);
+    }
+}
+
+std::shared_ptr<Object> evalLimited(const std::string& input, const ExecutionLimits& limits) {
+    Lexer l(input);
+    Parser p(l);
+    return Evaluator::Eval(p.ParseProgram(), std::make_shared<Environment>(), limits);
+}
+
+void TestExecutionLimits() {
+    ExecutionLimits steps;
+    steps.MaxSteps = 1000;
+    ExecutionLimits heap;
+    heap.MaxHeapBytes = 1 << 20;
+    ExecutionLimits time;
+    time.Timeout = std::chrono::milliseconds(20);
+
+    struct TestCase {
+        std::string input;
+        ExecutionLimits limits;
+        ErrorKind kind;
+        std::string message;
+    };
+    std::vector<TestCase> tests = {
+        {"while (true) { }", steps, ErrorKind::StepLimit, "step limit of 1000 exceeded"},
+        {"let f = fn(n) { f(n + 1) }; f(0)", steps, ErrorKind::StepLimit, "step limit of 1000 exceeded"},
+        {"let f = fn(n) { 1 + f(n + 1) }; f(0)", steps, ErrorKind::StepLimit, "step limit of 1000 exceeded"},
+        {"let s = \"ab\"; while (true) { s = s + s; }", heap, ErrorKind::HeapLimit, "heap limit of 1048576 bytes exceeded"},
+        {"let a = []; while (true) { a = push(a, a); }", heap, ErrorKind::HeapLimit, "heap limit of 1048576 bytes exceeded"},
+        {"let h = {}; let i = 0; while (true) { h = {i: h}; i = i + 1; }", heap, ErrorKind::HeapLimit, "heap limit of 1048576 bytes exceeded"},
+        {"let i = 0; while (true) { i = i + 1; }", time, ErrorKind::Timeout, "time limit of 20ms exceeded"},
+    };
+    for (const auto& tt : tests) {
+        auto err = std::dynamic_pointer_cast<Error>(evalLimited(tt.input, tt.limits));
+        if (!err || err->Kind != tt.kind || err->Message != tt.message) {
+            std::cerr << "wrong limit error for " << tt.input << ": " << (err ? err->Inspect() : "no error") << std::endl;
+            exit(1);
+        }
+    }
+
+    // Within its limits a program runs as usual, and garbage, cycles
+    // included, does not count against the heap limit.
+    ExecutionLimits all;
+    all.MaxSteps = 10000000;
+    all.MaxHeapBytes = 1 << 20;
+    all.Timeout = std::chrono::seconds(60);
+    std::string churn = "let mk = fn() { let g = fn() { g }; [g, \"some text\", {1: 2}] }; "
+                        "let i = 0; while (i < 20000) { mk(); i = i + 1; } i";
+    if (!testIntegerObject(evalLimited(churn, all), 20000)) {
+        std::cerr << "churn failed under limits" << std::endl;
+        exit(1);
+    }
+
+    // Errors a program makes itself are runtime errors, and a run after a
+    // limited one is not limited.
+    auto err = std::dynamic_pointer_cast<Error>(testEval("5 + true"));
+    if (!err || err->Kind != ErrorKind::Runtime) {
+        std::cerr << "a type mismatch is not a runtime error" << std::endl;
+        exit(1);
+    }
+    if (!testIntegerObject(testEval("let i = 0; while (i < 5000) { i = i + 1; } i"), 5000)) {
+        std::cerr << "limits leaked into an unlimited run" << std::endl;
+        exit(1);
+    }
+}
+
 int main() {
     TestEvalIntegerExpression();
     TestEvalBooleanExpression();
@@ -636,6 +1123,11 @@ int main() {
     TestFunctionApplication();
     TestEnclosingEnvironments();
     TestClosures();
+    TestFunctionOutlivesSource();
+    TestResolver();
+    TestResolvedScoping();
+    TestCycleCollection();
+    TestPersistentArrays();
     TestStringLiteral();
     TestStringConcatenation();
     TestBuiltinFunctions();
@@ -643,6 +1135,11 @@ int main() {
     TestArrayIndexExpressions();
     TestHashLiterals();
     TestHashIndexExpressions();
+    TestInlineValues();
+    TestWhileLoops();
+    TestIntegerLimits();
+    TestTailCalls();
+    TestExecutionLimits();
     std::cout << "All evaluator_test.cpp tests passed!" << std::endl;
     return 0;
 }
@@ -0,0 +1,256 @@
+#include "resolver.hpp"
+
+Resolver::Resolver(Scope& globals) : scopes{&globals} {}
+
+void Resolver::Resolve(Program* program) {
+    this->program = program;
+    for (auto& s : program->Statements) declare(s, *scopes.back());
+    for (auto& s : program->Statements) resolve(s);
+}
+
+// declare gives every name bound by a let under node a slot in scope. It
+// does not descend into function literals, which get scopes of their own.
+void Resolver::declare(Node* node, Scope& scope) {
+    if (!node) return;
+
+    switch (node->Kind) {
+    case NodeKind::LetStatement: {
+        auto n = static_cast<LetStatement*>(node);
+        scope.Declare(n->Name->Symbol);
+        declare(n->Value, scope);
+        break;
+    }
+    case NodeKind::ReturnStatement:
+        declare(static_cast<ReturnStatement*>(node)->ReturnValue, scope);
+        break;
+    case NodeKind::AssignStatement:
+        declare(static_cast<AssignStatement*>(node)->Value, scope);
+        break;
+    case NodeKind::WhileStatement: {
+        auto n = static_cast<WhileStatement*>(node);
+        declare(n->Condition, scope);
+        declare(n->Body, scope);
+        break;
+    }
+    case NodeKind::ExpressionStatement:
+        declare(static_cast<ExpressionStatement*>(node)->expr, scope);
+        break;
+    case NodeKind::BlockStatement:
+        for (auto& s : static_cast<BlockStatement*>(node)->Statements) declare(s, scope);
+        break;
+    case NodeKind::PrefixExpression:
+        declare(static_cast<PrefixExpression*>(node)->Right, scope);
+        break;
+    case NodeKind::InfixExpression: {
+        auto n = static_cast<InfixExpression*>(node);
+        declare(n->Left, scope);
+        declare(n->Right, scope);
+        break;
+    }
+    case NodeKind::IfExpression: {
+        auto n = static_cast<IfExpression*>(node);
+        declare(n->Condition, scope);
+        declare(n->Consequence, scope);
+        declare(n->Alternative, scope);
+        break;
+    }
+    case NodeKind::CallExpression: {
+        auto n = static_cast<CallExpression*>(node);
+        declare(n->Function, scope);
+        for (auto& a : n->Arguments) declare(a, scope);
+        break;
+    }
+    case NodeKind::ArrayLiteral:
+        for (auto& e : static_cast<ArrayLiteral*>(node)->Elements) declare(e, scope);
+        break;
+    case NodeKind::IndexExpression: {
+        auto n = static_cast<IndexExpression*>(node);
+        declare(n->Left, scope);
+        declare(n->Index, scope);
+        break;
+    }
+    case NodeKind::HashLiteral:
+        for (auto& pair : static_cast<HashLiteral*>(node)->Pairs) {
+            declare(pair.Key, scope);
+            declare(pair.Value, scope);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void Resolver::resolve(Node* node) {
+    if (!node) return;
+
+    switch (node->Kind) {
+    case NodeKind::LetStatement: {
+        auto n = static_cast<LetStatement*>(node);
+        resolve(n->Value);
+        resolveIdentifier(n->Name);
+        break;
+    }
+    case NodeKind::ReturnStatement:
+        resolve(static_cast<ReturnStatement*>(node)->ReturnValue);
+        break;
+    case NodeKind::AssignStatement: {
+        // Assignment never declares, so the name resolves to whichever
+        // let or parameter it would be read from.
+        auto n = static_cast<AssignStatement*>(node);
+        resolve(n->Value);
+        resolveIdentifier(n->Name);
+        break;
+    }
+    case NodeKind::WhileStatement: {
+        auto n = static_cast<WhileStatement*>(node);
+        resolve(n->Condition);
+        resolve(n->Body);
+        break;
+    }
+    case NodeKind::ExpressionStatement:
+        resolve(static_cast<ExpressionStatement*>(node)->expr);
+        break;
+    case NodeKind::BlockStatement:
+        for (auto& s : static_cast<BlockStatement*>(node)->Statements) resolve(s);
+        break;
+    case NodeKind::Identifier:
+        resolveIdentifier(static_cast<Identifier*>(node));
+        break;
+    case NodeKind::PrefixExpression:
+        resolve(static_cast<PrefixExpression*>(node)->Right);
+        break;
+    case NodeKind::InfixExpression: {
+        auto n = static_cast<InfixExpression*>(node);
+        resolve(n->Left);
+        resolve(n->Right);
+        break;
+    }
+    case NodeKind::IfExpression: {
+        auto n = static_cast<IfExpression*>(node);
+        resolve(n->Condition);
+        resolve(n->Consequence);
+        resolve(n->Alternative);
+        break;
+    }
+    case NodeKind::FunctionLiteral:
+        resolveFunction(static_cast<FunctionLiteral*>(node));
+        break;
+    case NodeKind::CallExpression: {
+        auto n = static_cast<CallExpression*>(node);
+        resolve(n->Function);
+        for (auto& a : n->Arguments) resolve(a);
+        break;
+    }
+    case NodeKind::ArrayLiteral:
+        for (auto& e : static_cast<ArrayLiteral*>(node)->Elements) resolve(e);
+        break;
+    case NodeKind::IndexExpression: {
+        auto n = static_cast<IndexExpression*>(node);
+        resolve(n->Left);
+        resolve(n->Index);
+        break;
+    }
+    case NodeKind::HashLiteral:
+        for (auto& pair : static_cast<HashLiteral*>(node)->Pairs) {
+            resolve(pair.Key);
+            resolve(pair.Value);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void Resolver::resolveFunction(FunctionLiteral* fn) {
+    // A program that is resolved again reuses the scopes it already owns.
+    if (!fn->Locals) {
+        program->Scopes.push_back(std::make_unique<Scope>());
+        fn->Locals = program->Scopes.back().get();
+    }
+    Scope& locals = *fn->Locals;
+    locals.Clear();
+
+    for (auto& p : fn->Parameters) locals.Declare(p->Symbol);
+    declare(fn->Body, locals);
+
+    scopes.push_back(&locals);
+    for (auto& p : fn->Parameters) resolveIdentifier(p);
+    resolve(fn->Body);
+    markTail(fn->Body);
+    markReturns(fn->Body);
+    scopes.pop_back();
+}
+
+// markReturns marks the calls the returns under node return, where node is
+// a statement whose ReturnValue ends the function. A return inside an
+// expression, such as a let's value or an operand, only makes a value for
+// that expression, so its call is not in tail position.
+void Resolver::markReturns(Node* node) {
+    if (!node) return;
+
+    switch (node->Kind) {
+    case NodeKind::BlockStatement:
+        for (auto s : static_cast<BlockStatement*>(node)->Statements) markReturns(s);
+        break;
+    case NodeKind::ExpressionStatement:
+        markReturns(static_cast<ExpressionStatement*>(node)->expr);
+        break;
+    case NodeKind::ReturnStatement:
+        markTail(static_cast<ReturnStatement*>(node)->ReturnValue);
+        break;
+    case NodeKind::IfExpression: {
+        auto n = static_cast<IfExpression*>(node);
+        markReturns(n->Consequence);
+        markReturns(n->Alternative);
+        break;
+    }
+    case NodeKind::WhileStatement:
+        markReturns(static_cast<WhileStatement*>(node)->Body);
+        break;
+    default:
+        break;
+    }
+}
+
+// markTail marks the calls whose value node evaluates to, where node is
+// what a function body ends with.
+void Resolver::markTail(Node* node) {
+    if (!node) return;
+
+    switch (node->Kind) {
+    case NodeKind::BlockStatement: {
+        auto n = static_cast<BlockStatement*>(node);
+        if (!n->Statements.empty()) markTail(n->Statements.back());
+        break;
+    }
+    case NodeKind::ExpressionStatement:
+        markTail(static_cast<ExpressionStatement*>(node)->expr);
+        break;
+    case NodeKind::ReturnStatement:
+        markTail(static_cast<ReturnStatement*>(node)->ReturnValue);
+        break;
+    case NodeKind::IfExpression: {
+        auto n = static_cast<IfExpression*>(node);
+        markTail(n->Consequence);
+        markTail(n->Alternative);
+        break;
+    }
+    case NodeKind::CallExpression:
+        static_cast<CallExpression*>(node)->Tail = true;
+        break;
+    default:
+        break;
+    }
+}
+
+void Resolver::resolveIdentifier(Identifier* ident) {
+    for (size_t depth = 0; depth < scopes.size(); depth++) {
+        uint32_t slot = scopes[scopes.size() - 1 - depth]->Find(ident->Symbol);
+        if (slot != Scope::NotFound) {
+            ident->Depth = static_cast<uint32_t>(depth);
+            ident->Slot = slot;
+            return;
+        }
+    }
+    ident->Depth = Identifier::Unresolved;
+}
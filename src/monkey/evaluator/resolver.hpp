@@ -0,0 +1,38 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <vector>
+#include "../ast/ast.hpp"
+
+using namespace YOXS_AST;
+
+// Resolver works out where every variable of a program lives before it is
+// evaluated, so the Evaluator can read it with a couple of pointer hops
+// instead of hashing its name in every enclosing environment.
+//
+// Each function body gets a Scope holding its parameters followed by every
+// name a let in the body binds (blocks do not open scopes in Monkey). The
+// top level uses the globals Scope of the environment the program will run
+// in, so programs evaluated one after another in the same environment agree
+// on global slots. Each Identifier is then annotated with how many scopes
+// out its name was found and its slot there, and each call whose result a
+// function returns unchanged is marked Tail.
+class Resolver {
+public:
+    explicit Resolver(Scope& globals);
+
+    void Resolve(Program* program);
+
+private:
+    std::vector<Scope*> scopes; // innermost last
+    Program* program = nullptr;
+
+    void declare(Node* node, Scope& scope);
+    void resolve(Node* node);
+    void resolveFunction(FunctionLiteral* fn);
+    void resolveIdentifier(Identifier* ident);
+    void markTail(Node* node);
+    void markReturns(Node* node);
+};
+
+#endif // RESOLVER_H
@@ -0,0 +1,521 @@
+#include "stack_evaluator.hpp"
+#include <iterator>
+
+//stack_evaluator.cpp
+
+// Every task leaves exactly one value on the values stack when it finishes.
+// An error always ends the whole program in Evaluator, since nothing in
+// Monkey catches one, so here it simply stops the loop. A return leaves a
+// ReturnValue that ends each block and loop it is the statement of, up to
+// the call, just as Evaluator's does, so one nested in an expression only
+// gives that expression its value. A tail call replaces the call it is in.
+
+namespace {
+
+bool isReturn(const Value& v) {
+    return v.IsObject() && v.Type() == RETURN_VALUE_OBJ;
+}
+
+} // namespace
+
+std::shared_ptr<Object> StackEvaluator::Eval(std::shared_ptr<Program> program, std::shared_ptr<Environment> env, const ExecutionLimits& limits) {
+    Resolver(env->Names()).Resolve(program.get());
+    Heap::MaybeCollect();
+    return Run(program.get(), env, limits).ToObject();
+}
+
+Value StackEvaluator::Run(Node* node, std::shared_ptr<Environment> env, const ExecutionLimits& limits) {
+    LimitGuard guard(limits);
+    const bool limited = !limits.Unlimited();
+    tasks.clear();
+    values.clear();
+    frames.clear();
+    frames.push_back(Frame{std::move(env), 0, 0});
+    push(node);
+
+    Value result;
+    bool finished = true;
+    uint64_t steps = 0;
+    while (!tasks.empty()) {
+        steps++;
+        if (limited) {
+            if (auto err = guard.Step()) {
+                result = err;
+                finished = false;
+                break;
+            }
+        }
+        if (!step(result)) {
+            finished = false;
+            break;
+        }
+    }
+    if (finished) {
+        result = Evaluator::unwrapReturnValue(pop());
+    }
+    Counters::Current().Steps += steps;
+    // Drop what an unfinished program left behind now rather than holding
+    // it until the next run.
+    tasks.clear();
+    values.clear();
+    frames.clear();
+    return result;
+}
+
+// Advances the top task by one step. Returns false when the program has
+// ended early with an error, leaving it in result.
+bool StackEvaluator::step(Value& result) {
+    Task& task = tasks.back();
+    Node* node = task.node;
+    const auto& env = frames.back().env;
+
+    switch (node->Kind) {
+    case NodeKind::Program:
+    case NodeKind::BlockStatement: {
+        const auto& stmts = node->Kind == NodeKind::Program ? static_cast<Program*>(node)->Statements
+                                                            : static_cast<BlockStatement*>(node)->Statements;
+        if (stmts.empty()) {
+            finish(Value());
+            return true;
+        }
+        if (task.step > 0) {
+            if (isReturn(values.back())) {
+                tasks.pop_back(); // the block's value is already in place
+                return true;
+            }
+            values.pop_back(); // only the last statement's value is kept
+        }
+        if (task.step + 1 < stmts.size()) {
+            Node* next = stmts[task.step++];
+            push(next);
+        } else {
+            // The block's value is its last statement's, so that statement
+            // takes the block's place.
+            task = Task{stmts[stmts.size() - 1], 0};
+        }
+        return true;
+    }
+    case NodeKind::ExpressionStatement: {
+        auto expr = static_cast<ExpressionStatement*>(node)->expr;
+        if (expr) {
+            task = Task{expr, 0};
+        } else {
+            finish(Value());
+        }
+        return true;
+    }
+    case NodeKind::ReturnStatement: {
+        if (task.step == 0) {
+            task.step = 1;
+            if (!eval(static_cast<ReturnStatement*>(node)->ReturnValue)) {
+                return true;
+            }
+        }
+        auto val = pop();
+        if (Evaluator::isError(val)) {
+            result = std::move(val);
+            return false;
+        }
+        finish(std::make_shared<ReturnValue>(std::move(val)));
+        return true;
+    }
+    case NodeKind::LetStatement: {
+        auto n = static_cast<LetStatement*>(node);
+        if (task.step == 0) {
+            task.step = 1;
+            if (!eval(n->Value)) {
+                return true;
+            }
+        }
+        auto val = pop();
+        if (Evaluator::isError(val)) {
+            result = std::move(val);
+            return false;
+        }
+        if (n->Name->Depth == 0) {
+            env->SetAt(n->Name->Slot, std::move(val));
+        } else {
+            env->Set(n->Name->Symbol, std::move(val));
+        }
+        finish(Value());
+        return true;
+    }
+    case NodeKind::AssignStatement: {
+        auto n = static_cast<AssignStatement*>(node);
+        if (task.step == 0) {
+            task.step = 1;
+            if (!eval(n->Value)) {
+                return true;
+            }
+        }
+        auto val = pop();
+        if (!Evaluator::isError(val)) {
+            val = Evaluator::assignVariable(n->Name, std::move(val), env);
+        }
+        if (Evaluator::isError(val)) {
+            result = std::move(val);
+            return false;
+        }
+        finish(Value());
+        return true;
+    }
+    case NodeKind::WhileStatement: {
+        auto n = static_cast<WhileStatement*>(node);
+        if (task.step == 2) {
+            if (isReturn(values.back())) {
+                tasks.pop_back();
+                return true;
+            }
+            values.pop_back(); // the body's
+            Heap::MaybeCollect();
+            task.step = 0;
+        }
+        if (task.step == 0) {
+            task.step = 1;
+            if (!eval(n->Condition)) {
+                return true;
+            }
+        }
+        auto condition = pop();
+        if (Evaluator::isError(condition)) {
+            result = std::move(condition);
+            return false;
+        }
+        if (!Evaluator::isTruthy(condition)) {
+            finish(Value());
+            return true;
+        }
+        task.step = 2;
+        push(n->Body);
+        return true;
+    }
+    case NodeKind::IntegerLiteral:
+        finish(Value::Int(static_cast<IntegerLiteral*>(node)->Value));
+        return true;
+    case NodeKind::Boolean:
+        finish(Value::Bool(static_cast<Boolean*>(node)->Value));
+        return true;
+    case NodeKind::Identifier: {
+        auto n = static_cast<Identifier*>(node);
+        Value val;
+        if (n->Depth != Identifier::Unresolved) {
+            val = env->GetAt(n->Depth, n->Slot);
+        }
+        if (!val) {
+            val = Evaluator::evalIdentifier(n, env);
+            if (Evaluator::isError(val)) {
+                result = std::move(val);
+                return false;
+            }
+        }
+        finish(std::move(val));
+        return true;
+    }
+    case NodeKind::StringLiteral:
+    case NodeKind::FunctionLiteral:
+        // Neither evaluates anything below it.
+        finish(Evaluator::Eval(node, env));
+        return true;
+    case NodeKind::PrefixExpression: {
+        auto n = static_cast<PrefixExpression*>(node);
+        if (task.step == 0) {
+            task.step = 1;
+            if (!eval(n->Right)) {
+                return true;
+            }
+        }
+        auto right = pop();
+        auto val = Evaluator::isError(right) ? right : Evaluator::evalPrefixExpression(n->Operator, right);
+        if (Evaluator::isError(val)) {
+            result = std::move(val);
+            return false;
+        }
+        finish(std::move(val));
+        return true;
+    }
+    case NodeKind::InfixExpression: {
+        auto n = static_cast<InfixExpression*>(node);
+        if (task.step == 0) {
+            task.step = 1;
+            if (!eval(n->Left)) {
+                return true;
+            }
+        }
+        if (task.step == 1) {
+            if (Evaluator::isError(values.back())) {
+                result = pop();
+                return false;
+            }
+            task.step = 2;
+            if (!eval(n->Right)) {
+                return true;
+            }
+        }
+        auto right = pop();
+        auto left = pop();
+        auto val = Evaluator::isError(right) ? right : Evaluator::evalInfixExpression(n->Operator, left, right);
+        if (Evaluator::isError(val)) {
+            result = std::move(val);
+            return false;
+        }
+        finish(std::move(val));
+        return true;
+    }
+    case NodeKind::IfExpression: {
+        auto n = static_cast<IfExpression*>(node);
+        if (task.step == 0) {
+            task.step = 1;
+            if (!eval(n->Condition)) {
+                return true;
+            }
+        }
+        auto condition = pop();
+        if (Evaluator::isError(condition)) {
+            result = std::move(condition);
+            return false;
+        }
+        // The branch taken takes the if's place.
+        if (Evaluator::isTruthy(condition)) {
+            task = Task{n->Consequence, 0};
+        } else if (n->Alternative) {
+            task = Task{n->Alternative, 0};
+        } else {
+            finish(Value::Null());
+        }
+        return true;
+    }
+    case NodeKind::CallExpression: {
+        auto n = static_cast<CallExpression*>(node);
+        if (task.step == Returning) {
+            // The body has left the call's value.
+            values.back() = Evaluator::unwrapReturnValue(std::move(values.back()));
+            frames.pop_back();
+            tasks.pop_back();
+            return true;
+        }
+        // Step 0 evaluates the function, and step i the argument before it.
+        while (true) {
+            if (task.step > 0 && Evaluator::isError(values.back())) {
+                result = pop();
+                return false;
+            }
+            if (task.step > n->Arguments.size()) {
+                break;
+            }
+            Node* next = task.step == 0 ? n->Function : n->Arguments[task.step - 1];
+            task.step++;
+            if (!eval(next)) {
+                return true;
+            }
+        }
+        return call(n, values.size() - n->Arguments.size() - 1, result);
+    }
+    case NodeKind::ArrayLiteral: {
+        auto n = static_cast<ArrayLiteral*>(node);
+        while (true) {
+            if (task.step > 0 && Evaluator::isError(values.back())) {
+                result = pop();
+                return false;
+            }
+            if (task.step == n->Elements.size()) {
+                break;
+            }
+            Node* next = n->Elements[task.step++];
+            if (!eval(next)) {
+                return true;
+            }
+        }
+        auto first = values.end() - n->Elements.size();
+        std::vector<Value> elements(std::make_move_iterator(first), std::make_move_iterator(values.end()));
+        values.erase(first, values.end());
+        finish(std::make_shared<ArrayObject>(elements));
+        return true;
+    }
+    case NodeKind::IndexExpression: {
+        auto n = static_cast<IndexExpression*>(node);
+        if (task.step == 0) {
+            task.step = 1;
+            if (!eval(n->Left)) {
+                return true;
+            }
+        }
+        if (task.step == 1) {
+            if (Evaluator::isError(values.back())) {
+                result = pop();
+                return false;
+            }
+            task.step = 2;
+            if (!eval(n->Index)) {
+                return true;
+            }
+        }
+        auto index = pop();
+        auto left = pop();
+        auto val = Evaluator::isError(index) ? index : Evaluator::evalIndexExpression(left, index);
+        if (Evaluator::isError(val)) {
+            result = std::move(val);
+            return false;
+        }
+        finish(std::move(val));
+        return true;
+    }
+    case NodeKind::HashLiteral:
+        return hashLiteral(task, static_cast<HashLiteral*>(node), result);
+    }
+
+    finish(Value());
+    return true;
+}
+
+// Steps a hash literal, whose pairs are added to the hash as they are evaluated.
+bool StackEvaluator::hashLiteral(Task& task, HashLiteral* n, Value& result) {
+    // The hash is filled in on the values stack, under the key or value
+    // being evaluated. Keys are evaluated at odd steps and values at even
+    // ones, so a key is checked before its value is evaluated.
+    if (task.step == 0) {
+        HashTable pairs;
+        pairs.Reserve(n->Pairs.size());
+        values.push_back(std::make_shared<Hash>(std::move(pairs)));
+    }
+    while (true) {
+        if (task.step > 0) {
+            const Value& last = values.back();
+            if (Evaluator::isError(last)) {
+                result = pop();
+                return false;
+            }
+            if (task.step % 2 == 1) {
+                if (!HashKeyOf(last)) {
+                    result = Evaluator::newError("unusable as hash key: %s", ObjectTypeToString(last.Type()).c_str());
+                    return false;
+                }
+            } else {
+                auto value = pop();
+                auto key = pop();
+                auto hashKey = HashKeyOf(key);
+                values.back().As<Hash>()->Pairs.Set(*hashKey, HashPair{std::move(key), std::move(value)});
+            }
+        }
+        if (task.step == 2 * n->Pairs.size()) {
+            break;
+        }
+        const auto& pair = n->Pairs[task.step / 2];
+        Node* next = task.step % 2 == 0 ? pair.Key : pair.Value;
+        task.step++;
+        if (!eval(next)) {
+            return true;
+        }
+    }
+    tasks.pop_back(); // the hash is already in place
+    return true;
+}
+
+// Starts evaluating node. Literals and variables, which make up most
+// operands, are evaluated on the spot instead of as a task of their own,
+// and then eval returns true with the value already on the values stack.
+// A variable that is not found leaves its error as the value, so every
+// caller checks the value for an error before using it.
+bool StackEvaluator::eval(Node* node) {
+    switch (node->Kind) {
+    case NodeKind::IntegerLiteral:
+        values.push_back(Value::Int(static_cast<IntegerLiteral*>(node)->Value));
+        return true;
+    case NodeKind::Boolean:
+        values.push_back(Value::Bool(static_cast<Boolean*>(node)->Value));
+        return true;
+    case NodeKind::StringLiteral:
+        values.push_back(std::make_shared<String>(std::string(static_cast<StringLiteral*>(node)->Value)));
+        return true;
+    case NodeKind::Identifier: {
+        auto n = static_cast<Identifier*>(node);
+        const auto& env = frames.back().env;
+        Value val;
+        if (n->Depth != Identifier::Unresolved) {
+            val = env->GetAt(n->Depth, n->Slot);
+        }
+        if (!val) {
+            val = Evaluator::evalIdentifier(n, env);
+        }
+        values.push_back(std::move(val));
+        return true;
+    }
+    default:
+        push(node);
+        return false;
+    }
+}
+
+// Calls the function at values[base] with the values above it as its
+// arguments.
+bool StackEvaluator::call(CallExpression* node, size_t base, Value& result) {
+    Value fn = values[base];
+    size_t count = values.size() - base - 1;
+    Counters::Current().Calls++;
+    if (fn.Type() == BUILTIN_OBJ) {
+        args.assign(std::make_move_iterator(values.begin() + base + 1), std::make_move_iterator(values.end()));
+        values.resize(base);
+        auto val = fn.As<Builtin>()->function(args);
+        args.clear();
+        if (Evaluator::isError(val)) {
+            result = std::move(val);
+            return false;
+        }
+        finish(std::move(val));
+        return true;
+    } else if (fn.Type() != FUNCTION_OBJ) {
+        result = Evaluator::newError("not a function: %s", fn.Inspect().c_str());
+        return false;
+    }
+
+    Function* function = fn.As<Function>();
+    // Like the VM, take exactly as many arguments as there are parameters.
+    if (count != function->Parameters.size()) {
+        result = Evaluator::newError("wrong number of arguments: want=%zu, got=%zu", function->Parameters.size(), count);
+        return false;
+    }
+    // A call in tail position replaces the call it is in, so it never
+    // makes the stack deeper. The program itself is frames[0].
+    bool tail = node->Tail && frames.size() > 1;
+    if (!tail && frames.size() - 1 >= maxDepth) {
+        auto err = Evaluator::newError("stack overflow at depth %zu", frames.size() - 1);
+        err->Kind = ErrorKind::StackOverflow;
+        result = err;
+        return false;
+    }
+    // Every value in use is on the stacks here, so it is safe to collect.
+    Heap::MaybeCollect();
+
+    std::shared_ptr<Environment> env;
+    if (tail && frames.back().env.use_count() == 1 && function->Locals) {
+        // Nothing kept the environment of the call being replaced, so the
+        // new call reuses its storage.
+        env = std::move(frames.back().env);
+        env->Reset(function->Env, function->Locals);
+    } else if (function->Locals) {
+        env = std::make_shared<Environment>(function->Env, function->Locals);
+    } else {
+        env = std::make_shared<Environment>(function->Env);
+    }
+    for (size_t i = 0; i < function->Parameters.size(); ++i) {
+        auto param = function->Parameters[i];
+        if (function->Locals) {
+            env->SetAt(param->Slot, std::move(values[base + 1 + i]));
+        } else {
+            env->Set(param->Symbol, std::move(values[base + 1 + i]));
+        }
+    }
+    values.resize(base);
+
+    if (tail) {
+        Frame& frame = frames.back();
+        frame.env = std::move(env);
+        tasks.resize(frame.tasksBase);
+        values.resize(frame.valuesBase);
+    } else {
+        tasks.back().step = Returning;
+        frames.push_back(Frame{std::move(env), tasks.size(), values.size()});
+    }
+    push(function->Body);
+    return true;
+}
+
@@ -0,0 +1,76 @@
+// stack_evaluator.hpp
+#ifndef STACK_EVALUATOR_H
+#define STACK_EVALUATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "evaluator.hpp"
+
+// StackEvaluator evaluates programs with the same semantics as Evaluator,
+// but keeps the work still to be done on vectors on the heap instead of on
+// the C++ stack. Evaluator takes several C++ frames per Monkey call, so deep
+// non-tail recursion overflows the stack and kills the process; here it only
+// grows the vectors, up to MaxDepth nested calls, after which the program
+// fails with a "stack overflow at depth N" error.
+//
+// The operator, index and lookup rules are Evaluator's own, so only the
+// order in which nodes are evaluated lives here.
+class StackEvaluator {
+public:
+    static constexpr size_t DefaultMaxDepth = 100000;
+
+    explicit StackEvaluator(size_t maxDepth = DefaultMaxDepth) : maxDepth(maxDepth) {}
+
+    // Resolves and evaluates a whole program, like Evaluator::Eval. Each
+    // step of the loop counts as one step against limits.
+    std::shared_ptr<Object> Eval(std::shared_ptr<Program> program, std::shared_ptr<Environment> env, const ExecutionLimits& limits = {});
+    Value Run(Node* node, std::shared_ptr<Environment> env, const ExecutionLimits& limits = {});
+
+    size_t MaxDepth() const { return maxDepth; }
+
+private:
+    // A node being evaluated and how far it has got; what step means
+    // depends on the kind of node.
+    struct Task {
+        Node* node;
+        uint32_t step;
+    };
+
+    // A Monkey call in progress. Every task above tasksBase runs in env, and
+    // the call's result replaces every value above valuesBase.
+    struct Frame {
+        std::shared_ptr<Environment> env;
+        size_t tasksBase;
+        size_t valuesBase;
+    };
+
+    // The step of a CallExpression whose function body is running.
+    static constexpr uint32_t Returning = UINT32_MAX;
+
+    size_t maxDepth;
+    std::vector<Task> tasks;
+    std::vector<Value> values; // the results of finished tasks their parents have not used yet
+    std::vector<Frame> frames; // the program itself at the bottom
+    std::vector<Value> args;   // the arguments of a builtin call
+
+    void push(Node* node) { tasks.push_back(Task{node, 0}); }
+    bool eval(Node* node);
+    // Pops the top task, leaving result for its parent.
+    void finish(Value result) {
+        tasks.pop_back();
+        values.push_back(std::move(result));
+    }
+    Value pop() {
+        Value v = std::move(values.back());
+        values.pop_back();
+        return v;
+    }
+
+    bool step(Value& result);
+    bool hashLiteral(Task& task, HashLiteral* node, Value& result);
+    bool call(CallExpression* node, size_t base, Value& result);
+};
+
+#endif // STACK_EVALUATOR_H
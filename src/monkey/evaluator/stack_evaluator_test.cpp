@@ -0,0 +1,213 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "stack_evaluator.hpp"
+#include "../lexer/lexer.hpp"
+#include "../parser/parser.hpp"
+
+//Stack Evaluator Test: This tests that the StackEvaluator gives the same results as the Evaluator,
+//and that recursion deeper than the C++ stack ends in an error instead of a crash.
+
+std::shared_ptr<Object> evalWith(StackEvaluator& evaluator, const std::string& input) {
+    Lexer l(input);
+    Parser p(l);
+    auto program = p.ParseProgram();
+    if (!p.Errors().empty()) {
+        std::cerr << "parser error: " << p.Errors()[0] << " in " << input << std::endl;
+        exit(1);
+    }
+    return evaluator.Eval(program, std::make_shared<Environment>());
+}
+
+std::shared_ptr<Object> stackEval(const std::string& input) {
+    StackEvaluator evaluator;
+    return evalWith(evaluator, input);
+}
+
+std::shared_ptr<Object> recursiveEval(const std::string& input) {
+    Lexer l(input);
+    Parser p(l);
+    return Evaluator::Eval(p.ParseProgram(), std::make_shared<Environment>());
+}
+
+std::string inspect(const std::shared_ptr<Object>& obj) {
+    return obj ? obj->Inspect() : "nullptr";
+}
+
+void expectResult(const std::string& input, const std::string& expected, const std::shared_ptr<Object>& got) {
+    if (inspect(got) != expected) {
+        std::cerr << "wrong result for " << input << ". want=" << expected << ", got=" << inspect(got) << std::endl;
+        exit(1);
+    }
+}
+
+// Every program here is shallow enough for the Evaluator, which is the
+// reference for what each one should give.
+void TestSameResultsAsEvaluator() {
+    std::vector<std::string> tests = {
+        "5 + 5 * 2 - -3",
+        "!true == !!false",
+        "\"Hello\" + \" \" + \"World!\"",
+        "if (1 < 2) { 10 } else { 20 }",
+        "if (1 > 2) { 10 }",
+        "if (10 > 1) { if (10 > 1) { return 10; } return 1; }",
+        "9; return 2 * 5; 9;",
+        "let a = 5; let b = a; let c = a + b + 5; c;",
+        "let f = fn(x) { x; }; f(5);",
+        "let add = fn(a, b) { a + b }; add(5 + 5, add(5, 5));",
+        "fn(x) { x; }(5)",
+        "let newAdder = fn(x) { fn(y) { x + y } }; let addTwo = newAdder(2); addTwo(2);",
+        "let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } }; fib(15);",
+        "[1, 2 * 2, 3 + 3]",
+        "[1, 2, 3][1 + 1]",
+        "[1, 2, 3][3]",
+        "let two = \"two\"; {\"one\": 10 - 9, two: 1 + 1, \"thr\" + \"ee\": 6 / 2, 4: 4, true: 5}",
+        "{\"foo\": 5}[\"foo\"]",
+        "{\"foo\": 5}[\"bar\"]",
+        "let map = fn(arr, f) { if (len(arr) == 0) { [] } else { [f(first(arr))] } }; map([1, 2], fn(x) { x * 2 })",
+        "len(\"four\") + len([1, 2])",
+        "rest(push([1, 2], 3))",
+        "let i = 0; let sum = 0; while (i < 100) { sum = sum + i; i = i + 1; } sum",
+        "let f = fn() { let i = 0; while (true) { if (i == 5) { return i * 10; } i = i + 1; } }; f()",
+        "let counter = fn() { let n = 0; fn() { n = n + 1; n } }; let c = counter(); c(); c(); c()",
+        "let count = fn(n) { if (n == 0) { 0 } else { count(n - 1) } }; count(1000)",
+        "let even = fn(n) { if (n == 0) { true } else { odd(n - 1) } }; let odd = fn(n) { if (n == 0) { false } else { even(n - 1) } }; even(101)",
+        "let f = fn() { }; f()",
+        "let x = 1;",
+        // A return inside an expression gives the expression a ReturnValue,
+        // which ends the function only once it is a statement's value.
+        "let g = fn() { let x = if (true) { return 5 }; x }; g()",
+        "let g = fn() { let x = if (true) { return 5 }; 10 }; g()",
+        "let g = fn() { 1 + if (true) { return 5 } }; g()",
+        "let g = fn() { -if (true) { return 5 } }; g()",
+        "let g = fn() { [if (true) { return 3 }, 4][0] }; g()",
+        "let g = fn() { while (true) { let x = if (true) { return 7 }; x } }; g()",
+        "let x = if (true) { return 4 }; x; 10",
+        "let x = if (true) { return 4 }; 10",
+        "",
+        // Errors end the program wherever they happen.
+        "5 + true; 5;",
+        "-true",
+        "if (10 > 1) { true + false; }",
+        "let f = fn() { foobar }; 1 + f()",
+        "[1, 2, 1 + \"a\", 4]",
+        "{\"name\": \"Monkey\"}[fn(x) { x }];",
+        "{[1]: 2}",
+        "{1: 2 - true}",
+        "[1][true + 1]",
+        "let x = 1; y = 2;",
+        "let f = fn() { 5(1) }; f()",
+        "len(1)",
+        "let i = 0; while (i < true) { i = i + 1; }",
+        "1 / 0",
+        "let f = fn(x) { x / (x - x) }; f(7)",
+        "(-9223372036854775807 - 1) / -1",
+    };
+
+    for (const auto& input : tests) {
+        expectResult(input, inspect(recursiveEval(input)), stackEval(input));
+    }
+}
+
+// Non-tail recursion far deeper than the Evaluator survives.
+void TestDeepRecursion() {
+    std::string sum = "let sum = fn(n) { if (n == 0) { 0 } else { n + sum(n - 1) } }; ";
+    expectResult("sum(50000)", "1250025000", stackEval(sum + "sum(50000)"));
+
+    std::string build = "let build = fn(n) { if (n == 0) { [] } else { push(build(n - 1), n) } }; ";
+    expectResult("len(build(30000))", "30000", stackEval(build + "len(build(30000))"));
+
+    // Returns unwind however deep they are made.
+    std::string find = "let find = fn(n) { if (n == 0) { return \"found\"; } let r = find(n - 1); return r; }; ";
+    expectResult("find(40000)", "found", stackEval(find + "find(40000)"));
+}
+
+void TestStackOverflow() {
+    std::string infinite = "let f = fn(n) { 1 + f(n + 1) }; f(0)";
+    expectResult(infinite, "ERROR: stack overflow at depth 100000", stackEval(infinite));
+
+    StackEvaluator small(100);
+    std::string depth = "let down = fn(n) { if (n == 0) { 0 } else { 1 + down(n - 1) } }; ";
+    expectResult("down(99) at 100", "99", evalWith(small, depth + "down(99)"));
+    expectResult("down(100) at 100", "ERROR: stack overflow at depth 100", evalWith(small, depth + "down(100)"));
+
+    // Nothing is left over from the failed run.
+    expectResult("after overflow", "5", evalWith(small, "2 + 3"));
+
+    // Calls in tail position replace the caller, so they never get deeper.
+    std::string count = "let count = fn(n) { if (n == 0) { \"done\" } else { count(n - 1) } }; count(100000)";
+    expectResult(count, "done", evalWith(small, count));
+    std::string ret = "let count = fn(n, acc) { if (n == 0) { return acc; } return count(n - 1, acc + 1); }; count(100000, 0)";
+    expectResult(ret, "100000", evalWith(small, ret));
+}
+
+void TestIntegerLimits() {
+    expectResult("1 / 0", "ERROR: division by zero", stackEval("1 / 0"));
+    expectResult("INT64_MIN / -1", "-9223372036854775808", stackEval("(-9223372036854775807 - 1) / -1"));
+    expectResult("INT64_MAX + 1", "-9223372036854775808", stackEval("9223372036854775807 + 1"));
+    expectResult("INT64_MIN - 1", "9223372036854775807", stackEval("-9223372036854775807 - 2"));
+    expectResult("2^62 * 2", "-9223372036854775808", stackEval("4611686018427387904 * 2"));
+    expectResult("-INT64_MIN", "-9223372036854775808", stackEval("-(-9223372036854775807 - 1)"));
+}
+
+void TestArgumentCount() {
+    expectResult("fn(a, b) { a }(1)", "ERROR: wrong number of arguments: want=2, got=1", stackEval("fn(a, b) { a }(1)"));
+    expectResult("fn(a) { a }(1, 2)", "ERROR: wrong number of arguments: want=1, got=2", stackEval("fn(a) { a }(1, 2)"));
+    expectResult("fn() { 1 }(1)", "ERROR: wrong number of arguments: want=0, got=1", stackEval("fn() { 1 }(1)"));
+    // Tail calls are checked too.
+    std::string tail = "let g = fn(x, y) { x }; let h = fn(n) { g(n) }; h(5)";
+    expectResult(tail, "ERROR: wrong number of arguments: want=2, got=1", stackEval(tail));
+}
+
+void TestExecutionLimits() {
+    ExecutionLimits steps;
+    steps.MaxSteps = 1000;
+    ExecutionLimits heap;
+    heap.MaxHeapBytes = 1 << 20;
+    ExecutionLimits time;
+    time.Timeout = std::chrono::milliseconds(20);
+
+    struct TestCase {
+        std::string input;
+        ExecutionLimits limits;
+        ErrorKind kind;
+    };
+    std::vector<TestCase> tests = {
+        {"while (true) { }", steps, ErrorKind::StepLimit},
+        {"let f = fn(n) { f(n + 1) }; f(0)", steps, ErrorKind::StepLimit},
+        {"let f = fn(n) { 1 + f(n + 1) }; f(0)", steps, ErrorKind::StepLimit},
+        {"let s = \"ab\"; while (true) { s = s + s; }", heap, ErrorKind::HeapLimit},
+        // Non-tail recursion grows the heap through its environments.
+        {"let f = fn(n) { 1 + f(n + 1) }; f(0)", heap, ErrorKind::HeapLimit},
+        {"let i = 0; while (true) { i = i + 1; }", time, ErrorKind::Timeout},
+    };
+    StackEvaluator evaluator;
+    for (const auto& tt : tests) {
+        Lexer l(tt.input);
+        Parser p(l);
+        auto err = std::dynamic_pointer_cast<Error>(evaluator.Eval(p.ParseProgram(), std::make_shared<Environment>(), tt.limits));
+        if (!err || err->Kind != tt.kind) {
+            std::cerr << "wrong limit error for " << tt.input << ": " << inspect(err) << std::endl;
+            exit(1);
+        }
+    }
+
+    auto overflow = std::dynamic_pointer_cast<Error>(stackEval("let f = fn(n) { 1 + f(n + 1) }; f(0)"));
+    if (!overflow || overflow->Kind != ErrorKind::StackOverflow) {
+        std::cerr << "stack overflow has the wrong kind" << std::endl;
+        exit(1);
+    }
+    expectResult("after limits", "5", evalWith(evaluator, "2 + 3"));
+}
+
+int main() {
+    TestSameResultsAsEvaluator();
+    TestDeepRecursion();
+    TestStackOverflow();
+    TestIntegerLimits();
+    TestArgumentCount();
+    TestExecutionLimits();
+    std::cout << "All stack_evaluator_test.cpp tests passed!" << std::endl;
+    return 0;
+}
@@ -1,6 +1,13 @@
 #include "lexer.hpp"
+#include <charconv>
+#include <limits>
+#include <stdexcept>
 
-Lexer::Lexer(const std::string& input) : input(input), position(0), readPosition(0), ch(0) {
+Lexer::Lexer(const std::string& input, const Scanner& scanner) : Lexer(std::make_shared<const std::string>(input), scanner) {}
+
+Lexer::Lexer(std::shared_ptr<const std::string> source, const Scanner& scanner)
+    : source(source), input(*source), position(0), readPosition(0), ch(0), scanner(&scanner),
+      names(&Interner::Current()) {
     readChar();
 }
 
@@ -14,6 +21,13 @@ void Lexer::readChar() {
     readPosition++;
 }
 
+// Moves n characters on at once, as n calls to readChar would.
+void Lexer::advance(std::string::size_type n) {
+    position += n;
+    readPosition = position + 1;
+    ch = position < input.size() ? input[position] : 0;
+}
+
 char Lexer::peekChar() const {
     if (readPosition >= input.size()) {
         return 0;
@@ -21,34 +35,30 @@ char Lexer::peekChar() const {
     return input[readPosition];
 }
 
-std::string Lexer::readIdentifier() {
-    int startPosition = position;
-    while (isLetter(ch)) {
-        readChar();
-    }
+// The read functions start on a character of their class, so position is
+// inside input, and leave ch on the first character past the run.
+std::string_view Lexer::readIdentifier() {
+    std::string::size_type startPosition = position;
+    advance(scanner->Letters(input.data() + position, input.size() - position));
     return input.substr(startPosition, position - startPosition);
 }
 
-std::string Lexer::readNumber() {
-    int startPosition = position;
-    while (isDigit(ch)) {
-        readChar();
-    }
+std::string_view Lexer::readNumber() {
+    std::string::size_type startPosition = position;
+    advance(scanner->Digits(input.data() + position, input.size() - position));
     return input.substr(startPosition, position - startPosition);
 }
 
-std::string Lexer::readString(){
-    int startPosition = position + 1;
-    do {
-        readChar();
-    }
-    while (ch != '"' && ch != 0);
+// Ends on the closing quote, or on the end of input if there is none.
+std::string_view Lexer::readString(){
+    std::string::size_type startPosition = position + 1;
+    advance(1 + scanner->StringBody(input.data() + startPosition, input.size() - startPosition));
     return input.substr(startPosition, position - startPosition);
 }
 
 void Lexer::skipWhitespace() {
-    while (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
-        readChar();
+    if (position < input.size()) {
+        advance(scanner->Whitespace(input.data() + position, input.size() - position));
     }
 }
 
@@ -60,8 +70,8 @@ bool Lexer::isDigit(char ch) {
     return '0' <= ch && ch <= '9';
 }
 
-Token Lexer::newToken(TokenType tokenType, char ch) {
-    return Token(tokenType, std::string(1, ch));
+Token Lexer::newToken(TokenType tokenType, std::string::size_type length) const {
+    return Token(tokenType, input.substr(position, length));
 }
 
 Token Lexer::NextToken() {
@@ -72,68 +82,64 @@ Token Lexer::NextToken() {
     switch (ch) {
         case '=':
             if (peekChar() == '=') {
-                char currCh = ch;
+                tok = newToken(TokenType::EQ, 2);
                 readChar();
-                std::string literal = std::string(1, currCh) + ch;
-                tok = Token(TokenType::EQ, literal);
             } else {
-                tok = newToken(TokenType::ASSIGN, ch);
+                tok = newToken(TokenType::ASSIGN);
             }
             break;
         case '+':
-            tok = newToken(TokenType::PLUS, ch);
+            tok = newToken(TokenType::PLUS);
             break;
         case '-':
-            tok = newToken(TokenType::MINUS, ch);
+            tok = newToken(TokenType::MINUS);
             break;
         case '!':
             if (peekChar() == '=') {
-                char currCh = ch;
+                tok = newToken(TokenType::NOT_EQ, 2);
                 readChar();
-                std::string literal = std::string(1, currCh) + ch;
-                tok = Token(TokenType::NOT_EQ, literal);
             } else {
-                tok = newToken(TokenType::BANG, ch); // (!true)
+                tok = newToken(TokenType::BANG); // (!true)
             }
             break;
         case '/':
-            tok = newToken(TokenType::SLASH, ch);
+            tok = newToken(TokenType::SLASH);
             break;
         case '*':
-            tok = newToken(TokenType::ASTERISK, ch);
+            tok = newToken(TokenType::ASTERISK);
             break;
         case '<':
-            tok = newToken(TokenType::LT, ch);
+            tok = newToken(TokenType::LT);
             break;
         case '>':
-            tok = newToken(TokenType::GT, ch);
+            tok = newToken(TokenType::GT);
             break;
         case ';':
-            tok = newToken(TokenType::SEMICOLON, ch);
+            tok = newToken(TokenType::SEMICOLON);
             break;
         case ':':
-            tok = newToken(TokenType::COLON, ch);
+            tok = newToken(TokenType::COLON);
             break;
         case ',':
-            tok = newToken(TokenType::COMMA, ch);
+            tok = newToken(TokenType::COMMA);
             break;
         case '{':
-            tok = newToken(TokenType::LBRACE, ch);
+            tok = newToken(TokenType::LBRACE);
             break;
         case '}':
-            tok = newToken(TokenType::RBRACE, ch);
+            tok = newToken(TokenType::RBRACE);
             break;
         case '(':
-            tok = newToken(TokenType::LPAREN, ch);
+            tok = newToken(TokenType::LPAREN);
             break;
         case ')':
-            tok = newToken(TokenType::RPAREN, ch);
+            tok = newToken(TokenType::RPAREN);
             break;
         case '[':
-            tok = newToken(TokenType::LBRACKET, ch);
+            tok = newToken(TokenType::LBRACKET);
             break;
         case ']':
-            tok = newToken(TokenType::RBRACKET, ch);
+            tok = newToken(TokenType::RBRACKET);
             break;
         case '"':
             tok.Type = TokenType::STRING;
@@ -144,15 +150,18 @@ Token Lexer::NextToken() {
             break;
         default:
             if (isLetter(ch)) {
-                std::string identifier = readIdentifier();
+                std::string_view identifier = readIdentifier();
                 tok = Token(LookupIdent(identifier), identifier);
+                if (tok.Type == TokenType::IDENT) {
+                    tok.Symbol = names->Intern(identifier);
+                }
                 return tok;  // Return here because readIdentifier advances the characters
             } else if (isDigit(ch)) {
-                std::string num = readNumber();
+                std::string_view num = readNumber();
                 tok = Token(TokenType::INT, num);
                 return tok;  // Return here because readNumber advances the characters
             } else {
-                tok = newToken(TokenType::ILLEGAL, ch);
+                tok = newToken(TokenType::ILLEGAL);
             }
             break;
     }
@@ -160,3 +169,43 @@ Token Lexer::NextToken() {
     readChar();
     return tok;
 }
+
+std::vector<Token> Lexer::Tokenize() {
+    std::vector<Token> tokens;
+    // Most tokens are at least two characters apart, counting whitespace.
+    tokens.reserve(input.size() / 2 + 1);
+    do {
+        tokens.push_back(NextToken());
+    } while (tokens.back().Type != TokenType::EOF_TOKEN);
+    return tokens;
+}
+
+TokenBuffer Lexer::TokenizeAll() {
+    if (input.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("source too large to tokenize into a TokenBuffer");
+    }
+    TokenBuffer buffer;
+    buffer.Source = source;
+    size_t expected = input.size() / 2 + 1;
+    buffer.Kinds.reserve(expected);
+    buffer.Offsets.reserve(expected);
+    buffer.Lengths.reserve(expected);
+    buffer.Values.reserve(expected);
+    Token tok;
+    do {
+        tok = NextToken();
+        int64_t value = 0;
+        if (tok.Type == TokenType::INT) {
+            std::from_chars(tok.Literal.data(), tok.Literal.data() + tok.Literal.size(), value);
+        } else if (tok.Type == TokenType::IDENT) {
+            value = tok.Symbol;
+        }
+        // The EOF literal is not in the source; it sits empty at the end.
+        uint32_t offset = tok.Type == TokenType::EOF_TOKEN ? input.size() : tok.Literal.data() - input.data();
+        buffer.Kinds.push_back(static_cast<uint8_t>(tok.Type));
+        buffer.Offsets.push_back(offset);
+        buffer.Lengths.push_back(tok.Literal.size());
+        buffer.Values.push_back(value);
+    } while (tok.Type != TokenType::EOF_TOKEN);
+    return buffer;
+}
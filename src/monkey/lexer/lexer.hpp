@@ -2,28 +2,49 @@
 #define LEXER_H
 
 #include <string>
+#include <string_view>
+#include <memory>
+#include <vector>
 #include "../token/token.hpp"
+#include "../token/token_buffer.hpp"
+#include "scan.hpp"
 
 class Lexer {
 private:
-    std::string input;
+    std::shared_ptr<const std::string> source; // owns the characters every Token views
+    std::string_view input;
     std::string::size_type position;         // current position in input (points to current char)
     std::string::size_type readPosition;     // current reading position in input (after current char)
     char ch;              // current char under examination
+    const Scanner* scanner; // finds where whitespace, identifiers, numbers and strings end
+    Interner* names;        // the Interner current when the Lexer was made
 
     void readChar();
+    void advance(std::string::size_type n);
     char peekChar() const;
-    std::string readIdentifier();
-    std::string readNumber();
-    std::string readString();
+    std::string_view readIdentifier();
+    std::string_view readNumber();
+    std::string_view readString();
     void skipWhitespace();
     static bool isLetter(char ch);
     static bool isDigit(char ch);
-    static Token newToken(TokenType tokenType, char ch);
+    Token newToken(TokenType tokenType, std::string::size_type length = 1) const;
 
 public:
-    Lexer(const std::string& input);
+    Lexer(const std::string& input, const Scanner& scanner = Scanner::Best());
+    Lexer(std::shared_ptr<const std::string> source, const Scanner& scanner = Scanner::Best());
     Token NextToken();
+    // Reads every token that is left, ending with the EOF, so a caller that
+    // wants to show the tokens and also parse them lexes the source once.
+    std::vector<Token> Tokenize();
+    // Reads every token that is left into a TokenBuffer, parsing INT
+    // literals on the way. Throws std::length_error for a source of 4 GiB
+    // or more, which its offsets cannot address.
+    TokenBuffer TokenizeAll();
+
+    // The buffer the token literals point into. Anything that outlives the
+    // Lexer and still holds tokens (Program, FunctionLiteral) keeps a copy.
+    std::shared_ptr<const std::string> Source() const { return source; }
 };
 
 #endif // LEXER_H
@@ -31,6 +31,7 @@ if (5 < 10) {
 "foo bar"
 [1, 2];
 {"foo": "bar"}
+while (five) { five = 0; }
 )";
 
     struct Test {
@@ -125,6 +126,16 @@ if (5 < 10) {
 		{TokenType::COLON, ":"},
 		{TokenType::STRING, "bar"},
 		{TokenType::RBRACE, "}"},
+        {TokenType::WHILE, "while"},
+        {TokenType::LPAREN, "("},
+        {TokenType::IDENT, "five"},
+        {TokenType::RPAREN, ")"},
+        {TokenType::LBRACE, "{"},
+        {TokenType::IDENT, "five"},
+        {TokenType::ASSIGN, "="},
+        {TokenType::INT, "0"},
+        {TokenType::SEMICOLON, ";"},
+        {TokenType::RBRACE, "}"},
         {TokenType::EOF_TOKEN, ""}
     };
 
@@ -148,6 +159,114 @@ if (5 < 10) {
         }
     }
 
+    // Literals are views into the lexer's source buffer, not copies.
+    Lexer views("let five = 5;");
+    Token let = views.NextToken();
+    Token five = views.NextToken();
+    if (let.Literal.data() != views.Source()->data() || five.Literal.data() != views.Source()->data() + 4) {
+        std::cerr << "Token literals do not point into the source buffer" << std::endl;
+        return 1;
+    }
+
+    // Tokenize reads the same tokens, ending with a single EOF.
+    Lexer all(input);
+    std::vector<Token> tokens = all.Tokenize();
+    if (tokens.size() != tests.size()) {
+        std::cerr << "Tokenize returned " << tokens.size() << " tokens, want " << tests.size() << std::endl;
+        return 1;
+    }
+    for (size_t i = 0; i < tests.size(); ++i) {
+        if (tokens[i].Type != tests[i].expectedType || tokens[i].Literal != tests[i].expectedLiteral) {
+            std::cerr << "Tokenize[" << i << "] wrong. got=" << tokens[i] << std::endl;
+            return 1;
+        }
+    }
+
+    // TokenizeAll reads them too, into parallel arrays over the same source.
+    Lexer buffered(input);
+    TokenBuffer buffer = buffered.TokenizeAll();
+    if (buffer.Size() != tests.size() || buffer.Source != buffered.Source() ||
+        buffer.Type(buffer.Size() - 1) != TokenType::EOF_TOKEN || buffer.Offsets.back() != input.size()) {
+        std::cerr << "TokenizeAll returned " << buffer.Size() << " tokens, want " << tests.size() << std::endl;
+        return 1;
+    }
+    for (size_t i = 0; i < tests.size(); ++i) {
+        Token tok = buffer.At(i);
+        if (tok.Type != tests[i].expectedType || tok.Literal != tests[i].expectedLiteral) {
+            std::cerr << "TokenizeAll[" << i << "] wrong. got=" << tok << std::endl;
+            return 1;
+        }
+        if (tok.Type == TokenType::INT && buffer.Values[i] != std::stoll(tests[i].expectedLiteral)) {
+            std::cerr << "TokenizeAll[" << i << "] value wrong. got=" << buffer.Values[i] << std::endl;
+            return 1;
+        }
+    }
+
+    // Identifiers carry their interned names, the same for the same name.
+    Lexer named("let five = five + ten; fn");
+    std::vector<Token> namedTokens = named.Tokenize();
+    if (namedTokens[1].Symbol != Interner::Current().Intern("five") || namedTokens[3].Symbol != namedTokens[1].Symbol ||
+        namedTokens[5].Symbol != Interner::Current().Intern("ten") || namedTokens[0].Symbol != Interner::None ||
+        namedTokens[7].Symbol != Interner::None) {
+        std::cerr << "Identifier tokens do not carry their symbols" << std::endl;
+        return 1;
+    }
+    Lexer namedAgain("let five = five + ten; fn");
+    TokenBuffer namedBuffer = namedAgain.TokenizeAll();
+    if (namedBuffer.At(3).Symbol != namedTokens[3].Symbol || namedBuffer.At(5).Symbol != namedTokens[5].Symbol) {
+        std::cerr << "TokenBuffer loses identifier symbols" << std::endl;
+        return 1;
+    }
+
+    // Every scanner this CPU runs finds the same runs as the scalar one,
+    // whether a run ends inside a 16 or 32 byte block, on its edge or at
+    // the end of input, and whatever the bytes around it.
+    std::vector<const Scanner*> scanners = Scanner::Available();
+    const Scanner& scalar = *scanners[0];
+    const std::string fillers[] = {" \t\r\n", "abzAZ_", "0189", "x = \\ 9", "\x80\xff\xe1{`@[/:"};
+    const char stops[] = {'a', ' ', '0', '"', '\0', '`', '{', '@', '[', '/', ':', '\x80', '\xfa'};
+    for (const Scanner* scanner : scanners) {
+        for (const std::string& filler : fillers) {
+            for (size_t length = 0; length <= 70; length++) {
+                for (char stop : stops) {
+                    std::string text;
+                    for (size_t i = 0; i < length; i++) text += filler[i % filler.size()];
+                    text += stop;
+                    for (size_t n : {length, text.size()}) {
+                        if (scanner->Whitespace(text.data(), n) != scalar.Whitespace(text.data(), n) ||
+                            scanner->Letters(text.data(), n) != scalar.Letters(text.data(), n) ||
+                            scanner->Digits(text.data(), n) != scalar.Digits(text.data(), n) ||
+                            scanner->StringBody(text.data(), n) != scalar.StringBody(text.data(), n)) {
+                            std::cerr << scanner->Name << " scanner disagrees with scalar on \"" << text << "\"" << std::endl;
+                            return 1;
+                        }
+                    }
+                }
+            }
+        }
+
+        Lexer scanned(input, *scanner);
+        for (size_t i = 0; i < tests.size(); ++i) {
+            Token tok = scanned.NextToken();
+            if (tok.Type != tests[i].expectedType || tok.Literal != tests[i].expectedLiteral) {
+                std::cerr << scanner->Name << " lexer[" << i << "] wrong. got=" << tok << std::endl;
+                return 1;
+            }
+        }
+
+        std::string longName(100, 'q');
+        std::string longNumber(40, '7');
+        std::string longText(50, 'z');
+        Lexer runs(std::string(37, ' ') + longName + "\n\t" + longNumber + std::string(33, '\n') + "\"" + longText + "\" \"" + longText, *scanner);
+        if (runs.NextToken().Literal != longName || runs.NextToken().Literal != longNumber ||
+            runs.NextToken().Literal != longText || runs.NextToken().Literal != longText ||
+            runs.NextToken().Type != TokenType::EOF_TOKEN) {
+            std::cerr << scanner->Name << " lexer misreads long runs" << std::endl;
+            return 1;
+        }
+        std::cout << scanner->Name << " scanner test passed!" << std::endl;
+    }
+
     std::cout << "All lexer_test.cpp tests passed!" << std::endl;
 
     return 0;
@@ -0,0 +1,134 @@
+#include "scan.hpp"
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+namespace {
+
+enum class Class { Whitespace, Letters, Digits, StringBody };
+
+template <Class C>
+inline bool inClass(char ch) {
+    if constexpr (C == Class::Whitespace) {
+        return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+    } else if constexpr (C == Class::Letters) {
+        return ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z') || ch == '_';
+    } else if constexpr (C == Class::Digits) {
+        return '0' <= ch && ch <= '9';
+    } else {
+        return ch != '"' && ch != 0;
+    }
+}
+
+template <Class C>
+size_t scalarRun(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n && inClass<C>(p[i])) {
+        i++;
+    }
+    return i;
+}
+
+#ifdef SCAN_X86
+
+// The vector paths test a range lo..lo+count-1 with one signed compare:
+// adding 0x80-lo moves the range to the bottom of the signed bytes.
+// Letters fold to lower case first by setting 0x20.
+
+template <Class C>
+inline unsigned sse2Mask(__m128i v) {
+    if constexpr (C == Class::Whitespace) {
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        return _mm_movemask_epi8(m);
+    } else if constexpr (C == Class::Letters) {
+        __m128i t = _mm_add_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8(0x80 - 'a'));
+        __m128i m = _mm_or_si128(_mm_cmplt_epi8(t, _mm_set1_epi8(-128 + 26)), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        return _mm_movemask_epi8(m);
+    } else if constexpr (C == Class::Digits) {
+        __m128i t = _mm_add_epi8(v, _mm_set1_epi8(0x80 - '0'));
+        return _mm_movemask_epi8(_mm_cmplt_epi8(t, _mm_set1_epi8(-128 + 10)));
+    } else {
+        __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+        return ~_mm_movemask_epi8(stop) & 0xFFFF;
+    }
+}
+
+template <Class C>
+size_t sse2Run(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        unsigned out = ~sse2Mask<C>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i))) & 0xFFFF;
+        if (out != 0) {
+            return i + __builtin_ctz(out);
+        }
+    }
+    return i + scalarRun<C>(p + i, n - i);
+}
+
+template <Class C>
+__attribute__((target("avx2"))) inline unsigned avx2Mask(__m256i v) {
+    if constexpr (C == Class::Whitespace) {
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        return _mm256_movemask_epi8(m);
+    } else if constexpr (C == Class::Letters) {
+        __m256i t = _mm256_add_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), _mm256_set1_epi8(0x80 - 'a'));
+        __m256i m = _mm256_or_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), t), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        return _mm256_movemask_epi8(m);
+    } else if constexpr (C == Class::Digits) {
+        __m256i t = _mm256_add_epi8(v, _mm256_set1_epi8(0x80 - '0'));
+        return _mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 10), t));
+    } else {
+        __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+        return ~static_cast<unsigned>(_mm256_movemask_epi8(stop));
+    }
+}
+
+template <Class C>
+__attribute__((target("avx2"))) size_t avx2Run(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        unsigned out = ~avx2Mask<C>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+        if (out != 0) {
+            return i + __builtin_ctz(out);
+        }
+    }
+    return i + sse2Run<C>(p + i, n - i);
+}
+
+#endif // SCAN_X86
+
+const Scanner scalarScanner = {
+    "scalar", scalarRun<Class::Whitespace>, scalarRun<Class::Letters>, scalarRun<Class::Digits>, scalarRun<Class::StringBody>
+};
+
+#ifdef SCAN_X86
+const Scanner sse2Scanner = {
+    "sse2", sse2Run<Class::Whitespace>, sse2Run<Class::Letters>, sse2Run<Class::Digits>, sse2Run<Class::StringBody>
+};
+
+const Scanner avx2Scanner = {
+    "avx2", avx2Run<Class::Whitespace>, avx2Run<Class::Letters>, avx2Run<Class::Digits>, avx2Run<Class::StringBody>
+};
+#endif
+
+} // namespace
+
+std::vector<const Scanner*> Scanner::Available() {
+    std::vector<const Scanner*> scanners = {&scalarScanner};
+#ifdef SCAN_X86
+    scanners.push_back(&sse2Scanner);
+    if (__builtin_cpu_supports("avx2")) {
+        scanners.push_back(&avx2Scanner);
+    }
+#endif
+    return scanners;
+}
+
+const Scanner& Scanner::Best() {
+    static const Scanner* best = Available().back();
+    return *best;
+}
@@ -0,0 +1,25 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <cstddef>
+#include <vector>
+
+// Scanner finds where a run of one character class ends, classifying 16
+// (SSE2) or 32 (AVX2) bytes at a time where the CPU allows. Each function
+// looks at the n bytes from p and returns how many of them, from the
+// start, belong to the run; the classes are the Lexer's own.
+struct Scanner {
+    const char* Name;
+    size_t (*Whitespace)(const char* p, size_t n); // ' ', '\t', '\n' and '\r'
+    size_t (*Letters)(const char* p, size_t n);    // a-z, A-Z and '_'
+    size_t (*Digits)(const char* p, size_t n);     // 0-9
+    size_t (*StringBody)(const char* p, size_t n); // anything up to '"' or '\0'
+
+    // The widest scanner this CPU runs, chosen once on first use.
+    static const Scanner& Best();
+    // Every scanner this CPU runs, scalar first, so tests and benchmarks
+    // can compare them.
+    static std::vector<const Scanner*> Available();
+};
+
+#endif // SCAN_H
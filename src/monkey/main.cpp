@@ -1,19 +1,90 @@
 #include "repl/repl.hpp"
+#include "server/server.hpp"
+#include <cstdint>
 #include <iostream>
+#include <string>
+
+static void usage(const char* prog) {
+    std::cerr << "usage: " << prog << " [--engine=eval|stack|vm] [--session | --server | --socket=PATH]"
+              << " [--max-steps=N] [--max-heap=BYTES] [--timeout-ms=N]" << std::endl;
+}
+
+// Reads the number after prefix in arg, as in --max-steps=1000. Returns
+// false if arg does not start with prefix or the rest is not a number.
+static bool numberFlag(const std::string& arg, const std::string& prefix, uint64_t& value) {
+    if (arg.rfind(prefix, 0) != 0 || arg.size() == prefix.size() ||
+        arg.find_first_not_of("0123456789", prefix.size()) != std::string::npos) {
+        return false;
+    }
+    try {
+        value = std::stoull(arg.substr(prefix.size()));
+    } catch (const std::out_of_range&) {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Engine engine = Engine::EVAL;
+    bool serve = false;
+    bool session = false;
+    std::string socketPath;
+    // Limits on every program run, so untrusted code cannot take the
+    // process down with it. 0 is no limit.
+    ExecutionLimits limits;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        uint64_t n = 0;
+        if (arg == "--engine=eval") {
+            engine = Engine::EVAL;
+        } else if (arg == "--engine=stack") {
+            engine = Engine::STACK;
+        } else if (arg == "--engine=vm") {
+            engine = Engine::VM;
+        } else if (arg == "--session") {
+            session = true;
+        } else if (arg == "--server") {
+            serve = true;
+        } else if (arg.rfind("--socket=", 0) == 0 && arg.size() > 9) {
+            socketPath = arg.substr(9);
+        } else if (numberFlag(arg, "--max-steps=", n)) {
+            limits.MaxSteps = n;
+        } else if (numberFlag(arg, "--max-heap=", n)) {
+            limits.MaxHeapBytes = n;
+        } else if (numberFlag(arg, "--timeout-ms=", n)) {
+            limits.Timeout = std::chrono::milliseconds(n);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Server mode: one JSON request per line, answered without restarting
+    // the process. See server/server.hpp for the protocol.
+    if (!socketPath.empty()) {
+        return Server(engine, limits).ServeSocket(socketPath);
+    }
+    if (serve) {
+        std::ios::sync_with_stdio(false);
+        Server(engine, limits).Serve(std::cin, std::cout);
+        return 0;
+    }
 
-int main() {
     std::cout << "This is the Monkey programming language!" << std::endl;
     std::cout << "Feel free to type in commands" << std::endl;
 
-    // Start the REPL using the standard input and output.
-    //REPL::Start(std::cin, std::cout);
-    REPL::StartSingle(std::cin, std::cout);
+    // Start the REPL using the standard input and output. With --session
+    // every line runs in the same Session, so definitions carry over.
+    if (session) {
+        REPL::Start(std::cin, std::cout, engine, limits);
+    } else {
+        REPL::StartSingle(std::cin, std::cout, engine, limits);
+    }
 
     return 0;
 }
-//g++ -std=c++17 -I. -o monkey_repl main.cpp repl/repl.cpp object/object.cpp object/environment.cpp lexer/lexer.cpp parser/parser.cpp evaluator/evaluator.cpp ast/ast.cpp token/token.cpp && ./monkey_repl
-
-//g++ -std=c++17 -I. -o monkey_repl src/monkey/main.cpp src/monkey/repl/repl.cpp src/monkey/object/object.cpp src/monkey/object/environment.cpp src/monkey/lexer/lexer.cpp src/monkey/parser/parser.cpp src/monkey/evaluator/evaluator.cpp src/monkey/ast/ast.cpp src/monkey/token/token.cpp && ./monkey_repl
+//make monkey_repl && ./monkey_repl --engine=vm
 
 /*
 Feel free to type in commands
@@ -0,0 +1,69 @@
+#include "server/service.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// monkey_server serves the monkey_repl --server protocol on a Unix domain
+// socket from a pool of worker threads. See server/service.hpp.
+
+static void usage(const char* prog) {
+    std::cerr << "usage: " << prog << " --socket=PATH [--workers=N] [--engine=eval|stack|vm]"
+              << " [--max-steps=N] [--max-heap=BYTES] [--timeout-ms=N]" << std::endl;
+}
+
+// Reads the number after prefix in arg, as in --workers=8. Returns false if
+// arg does not start with prefix or the rest is not a number.
+static bool numberFlag(const std::string& arg, const std::string& prefix, uint64_t& value) {
+    if (arg.rfind(prefix, 0) != 0 || arg.size() == prefix.size() ||
+        arg.find_first_not_of("0123456789", prefix.size()) != std::string::npos) {
+        return false;
+    }
+    try {
+        value = std::stoull(arg.substr(prefix.size()));
+    } catch (const std::out_of_range&) {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Engine engine = Engine::EVAL;
+    std::string socketPath;
+    uint64_t workers = 0;
+    ExecutionLimits limits;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        uint64_t n = 0;
+        if (arg == "--engine=eval") {
+            engine = Engine::EVAL;
+        } else if (arg == "--engine=stack") {
+            engine = Engine::STACK;
+        } else if (arg == "--engine=vm") {
+            engine = Engine::VM;
+        } else if (arg.rfind("--socket=", 0) == 0 && arg.size() > 9) {
+            socketPath = arg.substr(9);
+        } else if (numberFlag(arg, "--workers=", n) && n > 0 && n <= 1024) {
+            workers = n;
+        } else if (numberFlag(arg, "--max-steps=", n)) {
+            limits.MaxSteps = n;
+        } else if (numberFlag(arg, "--max-heap=", n)) {
+            limits.MaxHeapBytes = n;
+        } else if (numberFlag(arg, "--timeout-ms=", n)) {
+            limits.Timeout = std::chrono::milliseconds(n);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (socketPath.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Service service(workers, engine, limits);
+    std::cerr << "monkey_server: " << service.Workers() << " workers on " << socketPath << std::endl;
+    return service.ServeSocket(socketPath);
+}
@@ -0,0 +1,124 @@
+// builtins.cpp
+#include "builtins.hpp"
+#include <iostream>
+#include <cstdarg>
+#include <cstdio>
+#include <unordered_map>
+
+namespace YOXS_OBJECT {
+
+static std::shared_ptr<Error> newError(const std::string format, ...) {
+    char buffer[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format.c_str(), args);
+    va_end(args);
+    return std::make_shared<Error>(buffer);
+}
+
+static thread_local std::ostream* output = &std::cout;
+
+std::ostream& SetOutput(std::ostream& out) {
+    std::ostream& previous = *output;
+    output = &out;
+    return previous;
+}
+
+const std::vector<BuiltinDefinition> Builtins = {
+    {"len", std::make_shared<Builtin>([](const std::vector<Value>& args) -> Value {
+        if (args.size() != 1) {
+            return newError("wrong number of arguments. got=%zu, want=1", args.size());
+        }
+
+        auto argType = args[0].Type();
+        if (argType == ARRAY_OBJ) {
+            return Value::Int(args[0].As<ArrayObject>()->Elements.size());
+        } else if (argType == STRING_OBJ) {
+            return Value::Int(args[0].As<String>()->Value.size());
+        } else {
+            return newError("argument to `len` not supported, got %s", ObjectTypeToString(argType).c_str());
+        }
+    })},
+    {"puts", std::make_shared<Builtin>([](const std::vector<Value>& args) -> Value {
+        for (auto& arg : args) {
+            *output << arg.Inspect() << std::endl;
+        }
+        return Value::Null();
+    })},
+
+    {"first", std::make_shared<Builtin>([](const std::vector<Value>& args) -> Value {
+        if (args.size() != 1) {
+            return newError("wrong number of arguments. got=" + std::to_string(args.size()) + ", want=1");
+        }
+        if (args[0].Type() != ARRAY_OBJ) {
+            return newError("argument to `first` must be ARRAY, got " + ObjectTypeToString(args[0].Type()));
+        }
+        auto arr = args[0].As<ArrayObject>();
+        if (!arr->Elements.empty()) {
+            return arr->Elements.front();
+        }
+        return Value::Null();
+    })},
+
+    {"last", std::make_shared<Builtin>([](const std::vector<Value>& args) -> Value {
+        if (args.size() != 1) {
+            return newError("wrong number of arguments. got=" + std::to_string(args.size()) + ", want=1");
+        }
+        if (args[0].Type() != ARRAY_OBJ) {
+            return newError("argument to `last` must be ARRAY, got " + ObjectTypeToString(args[0].Type()));
+        }
+        auto arr = args[0].As<ArrayObject>();
+        if (!arr->Elements.empty()) {
+            return arr->Elements.back();
+        }
+        return Value::Null();
+    })},
+
+    {"rest", std::make_shared<Builtin>([](const std::vector<Value>& args) -> Value {
+        if (args.size() != 1) {
+            return newError("wrong number of arguments. got=" + std::to_string(args.size()) + ", want=1");
+        }
+        if (args[0].Type() != ARRAY_OBJ) {
+            return newError("argument to `rest` must be ARRAY, got " + ObjectTypeToString(args[0].Type()));
+        }
+        auto arr = args[0].As<ArrayObject>();
+        if (arr->Elements.size() > 1) {
+            return std::make_shared<ArrayObject>(arr->Elements.Rest());
+        }
+        return Value::Null();
+    })},
+
+    {"push", std::make_shared<Builtin>([](const std::vector<Value>& args) -> Value {
+        if (args.size() != 2) {
+            return newError("wrong number of arguments. got=" + std::to_string(args.size()) + ", want=2");
+        }
+        if (args[0].Type() != ARRAY_OBJ) {
+            return newError("argument to `push` must be ARRAY, got " + ObjectTypeToString(args[0].Type()));
+        }
+        auto arr = args[0].As<ArrayObject>();
+        return std::make_shared<ArrayObject>(arr->Elements.PushBack(args[1]));
+    })}
+};
+
+// The ids of the builtins' names in one Interner, rebuilt when a thread
+// moves on to another; that is once per Session run, not per lookup.
+struct BuiltinSymbols {
+    uint64_t serial = 0;
+    std::unordered_map<SymbolId, std::shared_ptr<Builtin>> byId;
+};
+
+std::shared_ptr<Builtin> GetBuiltinBySymbol(SymbolId name) {
+    thread_local BuiltinSymbols cache;
+    Interner& names = Interner::Current();
+    if (cache.serial != names.Serial()) {
+        cache.byId.clear();
+        for (const auto& def : Builtins) {
+            cache.byId.emplace(names.Intern(def.Name), def.builtin);
+        }
+        cache.serial = names.Serial();
+    }
+    auto it = cache.byId.find(name);
+    return it == cache.byId.end() ? nullptr : it->second;
+}
+
+} //namespace YOXS_OBJECT
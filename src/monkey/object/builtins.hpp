@@ -0,0 +1,34 @@
+// builtins.hpp
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include "object.hpp"
+#include "../token/symbol.hpp"
+
+namespace YOXS_OBJECT {
+
+struct BuiltinDefinition {
+    std::string Name;
+    std::shared_ptr<Builtin> builtin;
+};
+
+// The builtin functions shared by the Evaluator and the VM. The Compiler
+// refers to them by their index in this list, so new builtins go at the end.
+extern const std::vector<BuiltinDefinition> Builtins;
+
+// Returns the builtin called name, or nullptr if there is none. name is
+// an id in the Interner current on this thread.
+std::shared_ptr<Builtin> GetBuiltinBySymbol(SymbolId name);
+
+// Where puts writes on the calling thread, std::cout by default. The server
+// points this at a per-request buffer so program output ends up in the
+// response. Returns the previous stream.
+std::ostream& SetOutput(std::ostream& out);
+
+} //namespace YOXS_OBJECT
+
+#endif // BUILTINS_H
@@ -0,0 +1,35 @@
+// counters.hpp
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include "value.hpp"
+
+namespace YOXS_OBJECT {
+
+// RunCounters is what the engines did over a run, so a host can tell where
+// the work went and not only how long it took.
+struct RunCounters {
+    uint64_t Steps = 0;        // steps as ExecutionLimits::MaxSteps counts them
+    uint64_t Calls = 0;        // calls to functions and builtins, tail calls included
+    uint64_t Environments = 0; // environments created; a reused one counts once
+    uint32_t MaxEnvDepth = 0;  // the longest chain of environments, the outermost included
+    std::array<uint64_t, CLOSURE_OBJ + 1> Allocated{}; // objects created, by ObjectType
+};
+
+// Counters holds the RunCounters of each thread. The engines and objects
+// add to Current() as they go, at the cost of an increment; a host calls
+// Reset before a run and copies Current() after it.
+class Counters {
+public:
+    static RunCounters& Current() { return current; }
+    static void Reset() { current = RunCounters(); }
+
+private:
+    static inline thread_local RunCounters current;
+};
+
+} //namespace YOXS_OBJECT
+
+#endif // COUNTERS_H
@@ -3,21 +3,72 @@
 
 namespace YOXS_OBJECT {
 
-std::shared_ptr<Object> Environment::Get(const std::string& name) {
-    auto it = store.find(name);
-    if(it != store.end()) {
-        return it->second;
-    } else if(outer != nullptr) {
-        return outer->Get(name);
-    } else {
-        return nullptr;  // or throwing an exception
+Environment::Environment(std::shared_ptr<Environment> outer)
+    : outer(outer), ownScope(std::make_unique<YOXS_AST::Scope>()), scope(ownScope.get()) {
+    measure();
+    countDepth();
+    Counters::Current().Environments++;
+}
+
+Environment::Environment(std::shared_ptr<Environment> outer, YOXS_AST::Scope* scope)
+    : outer(outer), scope(scope), slots(scope->Size()) {
+    measure();
+    countDepth();
+    Counters::Current().Environments++;
+}
+
+void Environment::countDepth() {
+    depth = outer ? outer->depth + 1 : 1;
+    RunCounters& counters = Counters::Current();
+    counters.MaxEnvDepth = std::max(counters.MaxEnvDepth, depth);
+}
+
+// A slot that exists but has not been assigned yet does not hide the same
+// name further out, just like a map entry that was never inserted.
+Value Environment::Get(SymbolId name) {
+    for (Environment* env = this; env != nullptr; env = env->outer.get()) {
+        uint32_t slot = env->scope->Find(name);
+        if (slot != YOXS_AST::Scope::NotFound && slot < env->slots.size() && env->slots[slot]) {
+            return env->slots[slot];
+        }
     }
+    return Value();
 }
 
-std::shared_ptr<Object> Environment::Set(const std::string& name, std::shared_ptr<Object> val) {
-    store[name] = val;
+Value Environment::Set(SymbolId name, Value val) {
+    SetAt(scope->Declare(name), val);
     return val;
 }
 
+bool Environment::Assign(SymbolId name, Value val) {
+    for (Environment* env = this; env != nullptr; env = env->outer.get()) {
+        uint32_t slot = env->scope->Find(name);
+        if (slot != YOXS_AST::Scope::NotFound && slot < env->slots.size() && env->slots[slot]) {
+            env->slots[slot] = std::move(val);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Environment::Reset(std::shared_ptr<Environment> outer, YOXS_AST::Scope* scope) {
+    this->outer = std::move(outer);
+    ownScope.reset();
+    this->scope = scope;
+    slots.assign(scope->Size(), Value());
+    measure();
+    countDepth();
+}
+
+void Environment::Trace(std::vector<Traced*>& children) const {
+    if (outer) children.push_back(outer.get());
+    for (const auto& val : slots) TraceObject(val, children);
+}
+
+void Environment::ClearRefs() {
+    outer.reset();
+    slots.clear();
+}
+
 }//namespace YOXS_OBJECT
-//g++ -std=c++17 -Isrc -c src/monkey/object/environment.cpp -o environment.o
\ No newline at end of file
+//g++ -std=c++17 -Isrc -c src/monkey/object/environment.cpp -o environment.o
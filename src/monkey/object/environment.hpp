@@ -2,23 +2,97 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
-#include <unordered_map>
+#include <algorithm>
 #include <string>
+#include <vector>
 #include "object.hpp"
+#include "counters.hpp"
 #include <memory>
 
 namespace YOXS_OBJECT {
 
-class Environment {
+// Environment stores the values of one scope in a flat array of slots. The
+// Scope it is given says which name lives in which slot. An environment
+// created without one owns a Scope that grows as names are Set; that is how
+// top-level environments work. Environments are Traced because the
+// functions stored in them usually refer back to them.
+class Environment : public Traced {
 public:
     std::shared_ptr<Environment> outer;
-    std::unordered_map<std::string, std::shared_ptr<Object>> store;
 
-    Environment(std::shared_ptr<Environment> outer = nullptr) : outer(outer) {}
-    std::shared_ptr<Object> Get(const std::string& name);
-    std::shared_ptr<Object> Set(const std::string& name, std::shared_ptr<Object> val);
+    Environment(std::shared_ptr<Environment> outer = nullptr);
+    // The environment of one call to a function whose variables scope lists.
+    Environment(std::shared_ptr<Environment> outer, YOXS_AST::Scope* scope);
+
+    // Name based access, walking out through the enclosing environments.
+    Value Get(SymbolId name);
+    Value Set(SymbolId name, Value val);
+
+    // The value in slot of the environment depth levels out, or an empty
+    // Value if the slot has not been assigned yet.
+    Value GetAt(uint32_t depth, uint32_t slot) const {
+        const Environment* env = this;
+        while (depth-- > 0 && env) {
+            env = env->outer.get();
+        }
+        if (env && slot < env->slots.size()) {
+            return env->slots[slot];
+        }
+        return Value();
+    }
+
+    void SetAt(uint32_t slot, Value val) {
+        if (slot >= slots.size()) {
+            slots.resize(std::max<size_t>(slot + 1, scope->Size()));
+            measure();
+        }
+        slots[slot] = std::move(val);
+    }
+
+    // Replaces the value in slot of the environment depth levels out.
+    // Returns false, changing nothing, if that slot has not been assigned.
+    bool AssignAt(uint32_t depth, uint32_t slot, Value val) {
+        Environment* env = this;
+        while (depth-- > 0 && env) {
+            env = env->outer.get();
+        }
+        if (!env || slot >= env->slots.size() || !env->slots[slot]) {
+            return false;
+        }
+        env->slots[slot] = std::move(val);
+        return true;
+    }
+
+    // Replaces the value of the nearest binding of name. Returns false if
+    // no enclosing environment binds it.
+    bool Assign(SymbolId name, Value val);
+
+    // Turns this environment into a fresh one for a call to a function with
+    // the given outer environment and locals, keeping the slot storage.
+    void Reset(std::shared_ptr<Environment> outer, YOXS_AST::Scope* scope);
+
+    // The names this environment's slots belong to.
+    YOXS_AST::Scope& Names() { return *scope; }
+
+    // How many environments a lookup from here can walk through, this one
+    // and the outermost included.
+    uint32_t Depth() const { return depth; }
+
+    void Trace(std::vector<Traced*>& children) const override;
+    void ClearRefs() override;
+
+private:
+    std::unique_ptr<YOXS_AST::Scope> ownScope;
+    YOXS_AST::Scope* scope;
+    std::vector<Value> slots;
+    HeapBytes footprint;
+    uint32_t depth = 1;
+
+    void measure() { footprint.Set(sizeof(Environment) + slots.capacity() * sizeof(Value)); }
+    // Works out depth from outer and records it in RunCounters.
+    void countDepth();
 };
 
 } //namespace YOXS_OBJECT
 
-#endif // ENVIRONMENT_H
\ No newline at end of file
+#endif // ENVIRONMENT_H
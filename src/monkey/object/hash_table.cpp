@@ -0,0 +1,111 @@
+// hash_table.cpp
+#include "hash_table.hpp"
+#include "object.hpp"
+
+namespace YOXS_OBJECT {
+
+// Spreads the key hash over all 64 bits. Integer keys hash to themselves,
+// and without this keys with the same low bits would share a probe chain.
+static uint64_t mix(const HashKey& key) {
+    uint64_t h = static_cast<uint64_t>(key.Value) ^ (static_cast<uint64_t>(key.Type) << 58);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static bool sameKey(const Value& a, const Value& b) {
+    if (a == b) return true;
+    // Different string objects with the same characters are the same key.
+    return a.IsObject() && b.IsObject() && a.Type() == STRING_OBJ && b.Type() == STRING_OBJ &&
+           a.As<String>()->Value == b.As<String>()->Value;
+}
+
+// Returns the slot holding key, or the empty slot where it would go.
+size_t HashTable::probe(uint64_t h, const Value& key, bool& found) const {
+    size_t mask = control.size() - 1;
+    uint8_t tag = h & 0x7f;
+    for (size_t i = (h >> 7) & mask;; i = (i + 1) & mask) {
+        uint8_t c = control[i];
+        if (c == Empty) {
+            found = false;
+            return i;
+        }
+        if (c == tag) {
+            uint32_t index = slots[i];
+            if (hashes[index] == h && sameKey(pairs[index].Key, key)) {
+                found = true;
+                return i;
+            }
+        }
+    }
+}
+
+const HashPair* HashTable::Find(const HashKey& hash, const Value& key) const {
+    if (pairs.empty()) return nullptr;
+    bool found;
+    size_t i = probe(mix(hash), key, found);
+    return found ? &pairs[slots[i]] : nullptr;
+}
+
+void HashTable::Set(const HashKey& hash, HashPair pair) {
+    // Keep the load at 7/8 or below so every probe ends at an empty slot.
+    if ((pairs.size() + 1) * 8 > control.size() * 7) {
+        rehash(control.empty() ? 8 : control.size() * 2);
+    }
+    uint64_t h = mix(hash);
+    bool found;
+    size_t i = probe(h, pair.Key, found);
+    if (found) {
+        pairs[slots[i]].Value = std::move(pair.Value);
+        return;
+    }
+    control[i] = h & 0x7f;
+    slots[i] = static_cast<uint32_t>(pairs.size());
+    size_t capacity = pairs.capacity();
+    pairs.push_back(std::move(pair));
+    hashes.push_back(h);
+    if (pairs.capacity() != capacity) measure();
+}
+
+void HashTable::Reserve(size_t n) {
+    size_t capacity = 8;
+    while (n * 8 > capacity * 7) capacity *= 2;
+    if (capacity > control.size()) {
+        rehash(capacity);
+    }
+    pairs.reserve(n);
+    hashes.reserve(n);
+    measure();
+}
+
+void HashTable::Clear() {
+    pairs.clear();
+    hashes.clear();
+    control.clear();
+    slots.clear();
+    measure();
+}
+
+void HashTable::rehash(size_t capacity) {
+    control.assign(capacity, Empty);
+    slots.assign(capacity, 0);
+    size_t mask = capacity - 1;
+    for (size_t index = 0; index < hashes.size(); index++) {
+        uint64_t h = hashes[index];
+        size_t i = (h >> 7) & mask;
+        while (control[i] != Empty) i = (i + 1) & mask;
+        control[i] = h & 0x7f;
+        slots[i] = static_cast<uint32_t>(index);
+    }
+    measure();
+}
+
+void HashTable::measure() {
+    footprint.Set(pairs.capacity() * sizeof(HashPair) + hashes.capacity() * sizeof(uint64_t) +
+                  control.capacity() + slots.capacity() * sizeof(uint32_t));
+}
+
+} //namespace YOXS_OBJECT
@@ -0,0 +1,62 @@
+// hash_table.hpp
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "heap.hpp"
+#include "value.hpp"
+
+namespace YOXS_OBJECT {
+
+class HashKey;
+
+class HashPair {
+public:
+    YOXS_OBJECT::Value Key;
+    YOXS_OBJECT::Value Value;
+};
+
+// HashTable maps hashable values to values with open addressing, in the
+// style of a Swiss table: one control byte per slot holds 7 bits of the
+// key's hash, so a probe rarely touches an entry whose key does not match.
+// The pairs live in one vector in insertion order and the slots only hold
+// indexes into it. Two keys are the same only if their types, hashes and
+// values all match, so a hash collision never merges two keys.
+class HashTable {
+public:
+    using const_iterator = std::vector<HashPair>::const_iterator;
+
+    size_t size() const { return pairs.size(); }
+    bool empty() const { return pairs.empty(); }
+    const_iterator begin() const { return pairs.begin(); }
+    const_iterator end() const { return pairs.end(); }
+
+    // The pair whose key equals key, or nullptr. hash must be HashKeyOf(key).
+    const HashPair* Find(const HashKey& hash, const Value& key) const;
+    // Adds the pair, or replaces the value if its key is already there.
+    void Set(const HashKey& hash, HashPair pair);
+    // Makes room for n pairs without growing again.
+    void Reserve(size_t n);
+    void Clear();
+
+private:
+    static constexpr uint8_t Empty = 0x80;
+
+    std::vector<HashPair> pairs;
+    std::vector<uint64_t> hashes; // the mixed hash of each pair, so growing never rehashes a key
+    std::vector<uint8_t> control; // Empty, or the low 7 bits of the hash in that slot
+    std::vector<uint32_t> slots;  // index into pairs of the pair in each slot
+
+    HeapBytes footprint;
+
+    size_t probe(uint64_t h, const Value& key, bool& found) const;
+    void rehash(size_t capacity);
+    void measure();
+};
+
+} //namespace YOXS_OBJECT
+
+#endif // HASH_TABLE_H
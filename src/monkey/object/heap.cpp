@@ -0,0 +1,111 @@
+// heap.cpp
+#include "heap.hpp"
+#include "object.hpp"
+#include <algorithm>
+
+namespace YOXS_OBJECT {
+
+// One heap per thread. Trivial destructors, so values released during
+// static or thread destruction can still unlink themselves.
+static thread_local Traced* head = nullptr;
+static thread_local size_t sinceCollection = 0;
+static thread_local size_t survivors = 0;
+static thread_local HeapStats stats = {0, 0, 0, 0, 10000};
+thread_local size_t Heap::liveBytes = 0;
+
+Traced::Traced() { Heap::link(this); }
+Traced::Traced(const Traced&) : std::enable_shared_from_this<Traced>() { Heap::link(this); }
+Traced::~Traced() { Heap::unlink(this); }
+
+void Traced::TraceObject(const Value& v, std::vector<Traced*>& children) {
+    if (auto t = dynamic_cast<Traced*>(v.get())) {
+        children.push_back(t);
+    }
+}
+
+void Heap::link(Traced* t) {
+    t->next = head;
+    if (head) head->prev = t;
+    head = t;
+    stats.Live++;
+    stats.Allocated++;
+    sinceCollection++;
+}
+
+void Heap::unlink(Traced* t) {
+    if (t->prev) t->prev->next = t->next;
+    else head = t->next;
+    if (t->next) t->next->prev = t->prev;
+    stats.Live--;
+}
+
+size_t Heap::Collect() {
+    std::vector<Traced*> children;
+
+    // Start every value at its use count. A value that is not owned by a
+    // shared_ptr at all is held some other way, so it counts as a root.
+    for (Traced* t = head; t; t = t->next) {
+        long uses = t->weak_from_this().use_count();
+        t->gcRefs = uses > 0 ? uses : 1;
+    }
+    // Take away the references traced values hold on each other. What is
+    // left over comes from outside the graph.
+    for (Traced* t = head; t; t = t->next) {
+        children.clear();
+        t->Trace(children);
+        for (Traced* c : children) c->gcRefs--;
+    }
+
+    // Mark everything reachable from a root. gcRefs > 0 means root,
+    // 0 means not reached yet, and -1 means reached.
+    std::vector<Traced*> stack;
+    for (Traced* t = head; t; t = t->next) {
+        if (t->gcRefs > 0) stack.push_back(t);
+    }
+    while (!stack.empty()) {
+        Traced* t = stack.back();
+        stack.pop_back();
+        children.clear();
+        t->Trace(children);
+        for (Traced* c : children) {
+            if (c->gcRefs == 0) {
+                c->gcRefs = -1;
+                stack.push_back(c);
+            }
+        }
+    }
+
+    // Whatever is left is garbage. Hold it while the cycles are broken so
+    // nothing is freed out from under the loop, then let it all go.
+    std::vector<std::shared_ptr<Traced>> garbage;
+    for (Traced* t = head; t; t = t->next) {
+        if (t->gcRefs == 0) garbage.push_back(t->shared_from_this());
+    }
+    for (auto& g : garbage) g->ClearRefs();
+    size_t freed = garbage.size();
+    garbage.clear();
+
+    stats.Collections++;
+    stats.Freed += freed;
+    sinceCollection = 0;
+    survivors = stats.Live;
+    return freed;
+}
+
+void Heap::MaybeCollect() {
+    if (stats.Threshold > 0 && sinceCollection >= std::max(stats.Threshold, survivors)) {
+        Collect();
+    }
+}
+
+void Heap::SetThreshold(size_t threshold) {
+    stats.Threshold = threshold;
+}
+
+HeapStats Heap::Stats() {
+    HeapStats out = stats;
+    out.LiveBytes = liveBytes;
+    return out;
+}
+
+} //namespace YOXS_OBJECT
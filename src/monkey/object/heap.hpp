@@ -0,0 +1,121 @@
+// heap.hpp
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "value.hpp"
+
+namespace YOXS_OBJECT {
+
+// Traced is the base of every runtime value that holds references to other
+// values: environments, functions, arrays and hashes. Values are still
+// owned by shared_ptr, which frees everything except cycles, such as a
+// function bound in the environment it closes over. Every Traced value is
+// linked into the Heap so the collector can find those cycles.
+class Traced : public std::enable_shared_from_this<Traced> {
+public:
+    Traced();
+    Traced(const Traced&);
+    Traced& operator=(const Traced&) { return *this; }
+    virtual ~Traced();
+
+    // Appends the Traced values this one refers to.
+    virtual void Trace(std::vector<Traced*>& children) const = 0;
+    // Drops every reference this value holds. Used to break garbage cycles.
+    virtual void ClearRefs() = 0;
+
+    // Appends the object v holds to children if it is a Traced value.
+    static void TraceObject(const Value& v, std::vector<Traced*>& children);
+
+private:
+    friend class Heap;
+    Traced* prev = nullptr;
+    Traced* next = nullptr;
+    long gcRefs = 0;
+};
+
+struct HeapStats {
+    size_t Live = 0;        // Traced values currently alive
+    size_t Allocated = 0;   // Traced values ever created
+    size_t Collections = 0;
+    size_t Freed = 0;       // values released by the collector, over all collections
+    size_t Threshold = 0;
+    size_t LiveBytes = 0;   // bytes held by live values, as counted by HeapBytes
+};
+
+// Heap finds and frees garbage cycles among Traced values. A collection
+// works out which values are referenced from outside the traced graph, by
+// subtracting the references traced values hold on each other from their
+// shared_ptr use counts. Those values are the roots: the environments in
+// use, values on the evaluator's C++ stack and anything the host holds.
+// Everything reachable from a root survives; everything else can only be
+// kept alive by a cycle and has its references cleared.
+//
+// Every thread has a Heap of its own, so threads can run programs side by
+// side without locking. A value must stay on the thread that created it,
+// and every Heap function works on the calling thread's heap.
+class Heap {
+public:
+    // Runs a collection and returns the number of values it freed.
+    static size_t Collect();
+
+    // Collects if enough values were created since the last collection.
+    // Call it only where every value in use is held by a shared_ptr.
+    static void MaybeCollect();
+
+    // Collect automatically once threshold values have been created since
+    // the last collection, or as many as survived it if that is more, so
+    // the cost stays proportional to allocation. 0 turns it off.
+    static void SetThreshold(size_t threshold);
+
+    static HeapStats Stats();
+    static size_t LiveBytes() { return liveBytes; }
+
+private:
+    friend class Traced;
+    friend class HeapBytes;
+    static thread_local size_t liveBytes;
+    static void link(Traced* t);
+    static void unlink(Traced* t);
+};
+
+// HeapBytes counts the storage of the value it is a member of toward
+// Heap::LiveBytes for as long as that value lives. Only the storage a
+// program can grow is counted: string characters, array nodes, hash tables,
+// environments and closures. It is an estimate of what the program holds,
+// not of what the allocator handed out.
+class HeapBytes {
+public:
+    HeapBytes() = default;
+    explicit HeapBytes(size_t bytes) { Set(bytes); }
+    HeapBytes(const HeapBytes& other) { Set(other.bytes); }
+    HeapBytes(HeapBytes&& other) noexcept : bytes(other.bytes) { other.bytes = 0; }
+    HeapBytes& operator=(const HeapBytes& other) {
+        Set(other.bytes);
+        return *this;
+    }
+    HeapBytes& operator=(HeapBytes&& other) noexcept {
+        if (this != &other) {
+            Set(0);
+            bytes = other.bytes;
+            other.bytes = 0;
+        }
+        return *this;
+    }
+    ~HeapBytes() { Set(0); }
+
+    void Set(size_t n) {
+        Heap::liveBytes = Heap::liveBytes - bytes + n;
+        bytes = n;
+    }
+    size_t Get() const { return bytes; }
+
+private:
+    size_t bytes = 0;
+};
+
+} //namespace YOXS_OBJECT
+
+#endif // HEAP_H
@@ -0,0 +1,121 @@
+// limits.hpp
+#ifndef LIMITS_H
+#define LIMITS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include "object.hpp"
+
+namespace YOXS_OBJECT {
+
+// ExecutionLimits bounds one run of a program, so a host can run code it
+// does not trust in its own process and keep using the process afterwards.
+// A limit left at 0 is no limit.
+struct ExecutionLimits {
+    uint64_t MaxSteps = 0;               // nodes evaluated, or instructions the VM executes
+    size_t MaxHeapBytes = 0;             // how far Heap::LiveBytes may grow over the run
+    std::chrono::nanoseconds Timeout{0}; // wall-clock time from the start of the run
+
+    bool Unlimited() const { return MaxSteps == 0 && MaxHeapBytes == 0 && Timeout.count() == 0; }
+};
+
+// The stricter of a and b in each limit, so a request can ask for less than
+// its host allows but never more.
+inline ExecutionLimits Tighter(const ExecutionLimits& a, const ExecutionLimits& b) {
+    auto pick = [](auto x, auto y) { return x == decltype(x){} ? y : y == decltype(y){} ? x : std::min(x, y); };
+    ExecutionLimits out;
+    out.MaxSteps = pick(a.MaxSteps, b.MaxSteps);
+    out.MaxHeapBytes = pick(a.MaxHeapBytes, b.MaxHeapBytes);
+    out.Timeout = pick(a.Timeout, b.Timeout);
+    return out;
+}
+
+// LimitGuard enforces ExecutionLimits over one run. Engines call Step once
+// per node or instruction, which costs an increment and two compares; the
+// clock is only read every CheckInterval steps. A run can overshoot its
+// deadline by that many steps, and any limit by one long step, such as
+// concatenating two large strings.
+class LimitGuard {
+public:
+    static constexpr uint64_t CheckInterval = 1024;
+
+    explicit LimitGuard(const ExecutionLimits& limits) : limits(limits) {
+        size_t start = Heap::LiveBytes();
+        if (limits.MaxHeapBytes > 0) {
+            heapCeiling = limits.MaxHeapBytes > Max<size_t>() - start ? Max<size_t>() : start + limits.MaxHeapBytes;
+        }
+        if (limits.Timeout.count() > 0) {
+            deadline = Clock::now() + limits.Timeout;
+        }
+        schedule();
+    }
+
+    // Counts one step. Returns nullptr, or the error for the limit the run
+    // has hit; once one is hit, every later call returns the same error.
+    std::shared_ptr<Error> Step() {
+        if (++steps < nextCheck && Heap::LiveBytes() <= heapCeiling) {
+            return nullptr;
+        }
+        return check();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    template <class T> static constexpr T Max() { return std::numeric_limits<T>::max(); }
+
+    ExecutionLimits limits;
+    uint64_t steps = 0;
+    uint64_t nextCheck = 0;
+    size_t heapCeiling = Max<size_t>();
+    Clock::time_point deadline;
+    std::shared_ptr<Error> hit;
+
+    // The next step at which the step count or the clock needs a look.
+    void schedule() {
+        nextCheck = limits.Timeout.count() > 0 ? steps + CheckInterval : Max<uint64_t>();
+        if (limits.MaxSteps > 0 && limits.MaxSteps < nextCheck) {
+            nextCheck = limits.MaxSteps + 1;
+        }
+    }
+
+    std::shared_ptr<Error> fail(const std::string& message, ErrorKind kind) {
+        hit = std::make_shared<Error>(message, kind);
+        nextCheck = 0;
+        return hit;
+    }
+
+    std::shared_ptr<Error> check() {
+        if (hit) {
+            return hit;
+        }
+        if (limits.MaxSteps > 0 && steps > limits.MaxSteps) {
+            return fail("step limit of " + std::to_string(limits.MaxSteps) + " exceeded", ErrorKind::StepLimit);
+        }
+        if (Heap::LiveBytes() > heapCeiling) {
+            // Garbage cycles count until they are collected, so only what
+            // survives a collection counts against the limit.
+            Heap::Collect();
+            if (Heap::LiveBytes() > heapCeiling) {
+                return fail("heap limit of " + std::to_string(limits.MaxHeapBytes) + " bytes exceeded", ErrorKind::HeapLimit);
+            }
+        }
+        if (steps >= nextCheck) {
+            if (limits.Timeout.count() > 0 && Clock::now() >= deadline) {
+                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(limits.Timeout).count();
+                return fail("time limit of " + std::to_string(ms) + "ms exceeded", ErrorKind::Timeout);
+            }
+            schedule();
+        }
+        return nullptr;
+    }
+};
+
+} //namespace YOXS_OBJECT
+
+#endif // LIMITS_H
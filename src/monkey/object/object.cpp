@@ -5,6 +5,30 @@
 
 namespace YOXS_OBJECT {
 
+const std::shared_ptr<NullObject> ObjectConstants::NULL_OBJ = std::make_shared<NullObject>();
+const std::shared_ptr<BooleanObject> ObjectConstants::TRUE = std::make_shared<BooleanObject>(true);
+const std::shared_ptr<BooleanObject> ObjectConstants::FALSE = std::make_shared<BooleanObject>(false);
+
+std::string Value::Inspect() const {
+    switch (kind) {
+    case Kind::Null: return "null";
+    case Kind::Integer: return std::to_string(integer);
+    case Kind::Boolean: return boolean ? "true" : "false";
+    case Kind::Object: return object->Inspect();
+    default: return "";
+    }
+}
+
+std::shared_ptr<Object> Value::ToObject() const {
+    switch (kind) {
+    case Kind::Null: return ObjectConstants::NULL_OBJ;
+    case Kind::Integer: return std::make_shared<Integer>(integer);
+    case Kind::Boolean: return boolean ? ObjectConstants::TRUE : ObjectConstants::FALSE;
+    case Kind::Object: return object;
+    default: return nullptr;
+    }
+}
+
 std::string Function::Inspect() const {
     std::ostringstream out;
 
@@ -19,6 +43,22 @@ std::string Function::Inspect() const {
     return out.str();
 }
 
+void Function::Trace(std::vector<Traced*>& children) const {
+    if (Env) children.push_back(Env.get());
+}
+
+std::string CompiledFunction::Inspect() const {
+    std::ostringstream out;
+    out << "CompiledFunction[" << this << "]";
+    return out.str();
+}
+
+std::string Closure::Inspect() const {
+    std::ostringstream out;
+    out << "Closure[" << this << "]";
+    return out.str();
+}
+
 std::string ObjectTypeToString(ObjectType type) {
     switch (type) {
         case NULL_OBJ: return "NULL";
@@ -35,9 +75,23 @@ std::string ObjectTypeToString(ObjectType type) {
 
         case ARRAY_OBJ: return "ARRAY";
         case HASH_OBJ: return "HASH";
+
+        case COMPILED_FUNCTION_OBJ: return "COMPILED_FUNCTION";
+        case CLOSURE_OBJ: return "CLOSURE";
         
         default: return "UNKNOWN";
     }
 }
 
+std::string ErrorKindToString(ErrorKind kind) {
+    switch (kind) {
+        case ErrorKind::Runtime: return "runtime";
+        case ErrorKind::StepLimit: return "steps";
+        case ErrorKind::HeapLimit: return "heap";
+        case ErrorKind::Timeout: return "timeout";
+        case ErrorKind::StackOverflow: return "stack";
+        default: return "unknown";
+    }
+}
+
 } // namespace YOXS_OBJECT
\ No newline at end of file
@@ -7,34 +7,21 @@
 #include <vector>
 #include <sstream>
 #include <functional>
-#include <map>
+#include <optional>
 #include "../ast/ast.hpp"
+#include "../code/code.hpp"
+#include "value.hpp"
+#include "heap.hpp"
+#include "counters.hpp"
+#include "persistent_vector.hpp"
+#include "hash_table.hpp"
 
 namespace YOXS_OBJECT {
 
 class Environment;  // Forward declaration
 class Object;
 
-using BuiltinFunction = std::function<std::shared_ptr<Object>(const std::vector<std::shared_ptr<Object>>& args)>;
-
-enum ObjectType {
-    NULL_OBJ,
-    ERROR_OBJ,
-
-    INTEGER_OBJ,
-    BOOLEAN_OBJ,
-    STRING_OBJ,
-
-    RETURN_VALUE_OBJ,
-
-    FUNCTION_OBJ,
-    BUILTIN_OBJ,
-
-    ARRAY_OBJ,
-    HASH_OBJ
-};
-
-std::string ObjectTypeToString(ObjectType type);
+using BuiltinFunction = std::function<Value(const std::vector<Value>& args)>;
 
 class HashKey {
 public:
@@ -43,7 +30,7 @@ public:
     HashKey(const ObjectType& t, const int64_t& v) : Type(t), Value(v) {}
 
     bool operator ==(const HashKey& rhs) const {
-        return (ObjectTypeToString(this->Type) == ObjectTypeToString(rhs.Type)) && (this->Value == rhs.Value);
+        return this->Type == rhs.Type && this->Value == rhs.Value;
     }
 
     bool operator !=(const HashKey& rhs) const {
@@ -78,13 +65,17 @@ public:
     virtual ~Object() = default; // Virtual destructor
     virtual ObjectType Type() const = 0;
     virtual std::string Inspect() const = 0;
+
+protected:
+    // Every object counts itself in RunCounters::Allocated as type.
+    explicit Object(ObjectType type) { Counters::Current().Allocated[type]++; }
 };
 
 class Integer : public Object, public Hashable {
 public:
     int64_t Value;
 
-    Integer(int64_t value) : Value(value) {}
+    Integer(int64_t value) : Object(INTEGER_OBJ), Value(value) {}
     ObjectType Type() const override { return INTEGER_OBJ; }
     std::string Inspect() const override { return std::to_string(Value); }
     HashKey keyHash() const override {
@@ -96,7 +87,7 @@ class BooleanObject : public Object, public Hashable {
 public:
     bool Value;
 
-    BooleanObject(bool value) : Value(value) {}
+    BooleanObject(bool value) : Object(BOOLEAN_OBJ), Value(value) {}
     ObjectType Type() const override { return BOOLEAN_OBJ; }
     std::string Inspect() const override { return Value ? "true" : "false"; }
     HashKey keyHash() const override { return {this->Type(), Value ? 1 : 0}; }
@@ -104,104 +95,225 @@ public:
 
 class NullObject : public Object {
 public:
+    NullObject() : Object(NULL_OBJ) {}
     ObjectType Type() const override { return NULL_OBJ; }
     std::string Inspect() const override { return "null"; }
 };
 
 class ReturnValue : public Object {
 public:
-    std::shared_ptr<Object> Value;
+    YOXS_OBJECT::Value Value;
 
-    ReturnValue(std::shared_ptr<Object> value) : Value(value) {}
+    ReturnValue(YOXS_OBJECT::Value value) : Object(RETURN_VALUE_OBJ), Value(std::move(value)) {}
     ObjectType Type() const override { return RETURN_VALUE_OBJ; }
-    std::string Inspect() const override { return Value->Inspect(); }
+    std::string Inspect() const override { return Value.Inspect(); }
 };
 
+// Why a program stopped. Runtime errors are the program's own; the others
+// mean it ran into one of the ExecutionLimits it was run with, or its
+// engine's call depth limit, and not that it did anything wrong.
+enum class ErrorKind { Runtime, StepLimit, HeapLimit, Timeout, StackOverflow };
+
+// The name hosts report the kind by: "runtime", "steps", "heap", "timeout"
+// or "stack".
+std::string ErrorKindToString(ErrorKind kind);
+
 class Error : public Object {
 public:
     std::string Message;
+    ErrorKind Kind;
 
-    Error(const std::string& message) : Message(message) {}
+    Error(const std::string& message, ErrorKind kind = ErrorKind::Runtime) : Object(ERROR_OBJ), Message(message), Kind(kind) {}
     ObjectType Type() const override { return ERROR_OBJ; }
     std::string Inspect() const override { return "ERROR: " + Message; }
 };
 
-class Function : public Object {
+class Function : public Object, public Traced {
 public:
-    std::vector<std::shared_ptr<YOXS_AST::Identifier>> Parameters;
+    YOXS_AST::NodeList<YOXS_AST::Identifier*> Parameters;
     std::shared_ptr<Environment> Env;
-    std::shared_ptr<YOXS_AST::BlockStatement> Body;
+    YOXS_AST::BlockStatement* Body;
+    std::shared_ptr<YOXS_AST::Program> Owner; // owns the nodes Parameters and Body point to
+    YOXS_AST::Scope* Locals = nullptr; // slot layout of a call's environment, if the literal was resolved
 
-    Function(const std::vector<std::shared_ptr<YOXS_AST::Identifier>>& parameters, std::shared_ptr<Environment> env, std::shared_ptr<YOXS_AST::BlockStatement> body)
-        : Parameters(parameters), Env(env), Body(body) {}
+    Function(const YOXS_AST::NodeList<YOXS_AST::Identifier*>& parameters, std::shared_ptr<Environment> env, YOXS_AST::BlockStatement* body)
+        : Object(FUNCTION_OBJ), Parameters(parameters), Env(env), Body(body) {}
     ObjectType Type() const override { return FUNCTION_OBJ; }
     std::string Inspect() const override;
+    void Trace(std::vector<Traced*>& children) const override;
+    void ClearRefs() override { Env.reset(); }
+
+private:
+    HeapBytes footprint{sizeof(Function)};
 };
 
+// Strings are immutable, so the hash is computed the first time the string
+// is used as a key and cached for every lookup after that.
 class String : public Object, public Hashable {
 public:
     std::string Value;
-    String(const std::string& val) : Value(val) {}
+    String(const std::string& val) : Object(STRING_OBJ), Value(val), footprint(sizeof(String) + Value.capacity()) {}
     ObjectType Type() const override { return STRING_OBJ; }
     std::string Inspect() const override { return Value; }
     HashKey keyHash() const override {
-        std::hash<std::string> hasher;
-        return {STRING_OBJ, static_cast<int64_t>(hasher(Value))};
+        if (!hashed) {
+            hash = static_cast<int64_t>(std::hash<std::string>{}(Value));
+            hashed = true;
+        }
+        return {STRING_OBJ, hash};
     }
 
+private:
+    mutable int64_t hash = 0;
+    mutable bool hashed = false;
+    HeapBytes footprint;
 };
 
 class Builtin : public Object {
 public:
     BuiltinFunction function;
-    Builtin(BuiltinFunction fn) : function(fn) {}
+    Builtin(BuiltinFunction fn) : Object(BUILTIN_OBJ), function(fn) {}
 
     ObjectType Type() const override { return BUILTIN_OBJ; }
     std::string Inspect() const override { return "builtin function"; }
 };
 
-class ArrayObject : public Object {
+// Arrays are immutable, so push and rest build new arrays that share most
+// of their elements' storage with the original.
+class ArrayObject : public Object, public Traced {
 public: 
-    std::vector<std::shared_ptr<Object>> Elements;
-    ArrayObject(const std::vector<std::shared_ptr<Object>>& elms) : Elements(elms) {}
+    PersistentVector Elements;
+    ArrayObject(const std::vector<Value>& elms) : Object(ARRAY_OBJ), Elements(elms) {}
+    ArrayObject(const std::vector<std::shared_ptr<Object>>& elms) : Object(ARRAY_OBJ), Elements(std::vector<Value>(elms.begin(), elms.end())) {}
+    ArrayObject(const PersistentVector& elms) : Object(ARRAY_OBJ), Elements(elms) {}
     ObjectType Type() const override { return ARRAY_OBJ; }
     std::string Inspect() const override {
         std::ostringstream out;
 
         std::vector<std::string> elements; 
         for(const auto& e : Elements){
-            elements.push_back(e->Inspect());
+            elements.push_back(e.Inspect());
         }
  
         out << "[" << YOXS_AST::join(elements, ", ") << "]";
         return out.str();
     }
-};
+    void Trace(std::vector<Traced*>& children) const override {
+        Elements.Trace(children);
+    }
+    void ClearRefs() override { Elements = PersistentVector(); }
 
-class HashPair {
-public:
-    std::shared_ptr<Object> Key;
-    std::shared_ptr<Object> Value;
+private:
+    HeapBytes footprint{sizeof(ArrayObject)};
 };
 
-class Hash : public Object {
+class Hash : public Object, public Traced {
 public:
-    Hash(const std::map<HashKey, HashPair>& p) : Pairs(p) {}
-    std::map<HashKey, HashPair> Pairs;
+    Hash(HashTable p) : Object(HASH_OBJ), Pairs(std::move(p)) {}
+    HashTable Pairs;
     ObjectType Type() const override { return HASH_OBJ; }
     std::string Inspect() const override {
         std::ostringstream out; 
         
         std::vector<std::string> pairs; 
         for(const auto& pair : Pairs){
-            pairs.push_back(ObjectTypeToString(pair.first.Type) + ":" + pair.second.Value->Inspect());
+            pairs.push_back(ObjectTypeToString(pair.Key.Type()) + ":" + pair.Value.Inspect());
         }
 
         out << "{" << YOXS_AST::join(pairs, ", ") << "}";
         return out.str();
     }
+    void Trace(std::vector<Traced*>& children) const override {
+        for (const auto& pair : Pairs) {
+            TraceObject(pair.Key, children);
+            TraceObject(pair.Value, children);
+        }
+    }
+    void ClearRefs() override { Pairs.Clear(); }
+
+private:
+    HeapBytes footprint{sizeof(Hash)};
 };
 
+// A function compiled to bytecode by the Compiler. NumLocals is the number
+// of stack slots the VM reserves for its local bindings.
+class CompiledFunction : public Object {
+public:
+    YOXS_CODE::Instructions Instructions;
+    int NumLocals;
+    int NumParameters;
+
+    CompiledFunction(const YOXS_CODE::Instructions& ins, int numLocals = 0, int numParameters = 0)
+        : Object(COMPILED_FUNCTION_OBJ), Instructions(ins), NumLocals(numLocals), NumParameters(numParameters) {}
+    ObjectType Type() const override { return COMPILED_FUNCTION_OBJ; }
+    std::string Inspect() const override;
+};
+
+// A CompiledFunction together with the free variables it closed over.
+class Closure : public Object {
+public:
+    std::shared_ptr<CompiledFunction> Fn;
+    std::vector<std::shared_ptr<Object>> Free;
+
+    Closure(std::shared_ptr<CompiledFunction> fn, const std::vector<std::shared_ptr<Object>>& free = {})
+        : Object(CLOSURE_OBJ), Fn(fn), Free(free), footprint(sizeof(Closure) + Free.capacity() * sizeof(std::shared_ptr<Object>)) {}
+    ObjectType Type() const override { return CLOSURE_OBJ; }
+    std::string Inspect() const override;
+
+private:
+    HeapBytes footprint;
+};
+
+// Shared by every thread, so they never change.
+class ObjectConstants {
+public:
+    static const std::shared_ptr<NullObject> NULL_OBJ;
+    static const std::shared_ptr<BooleanObject> TRUE;
+    static const std::shared_ptr<BooleanObject> FALSE;
+};
+
+// The hash key of v, or nothing if v cannot be used as a hash key.
+inline std::optional<HashKey> HashKeyOf(const Value& v) {
+    switch (v.GetKind()) {
+    case Value::Kind::Integer: return HashKey(INTEGER_OBJ, v.AsInt());
+    case Value::Kind::Boolean: return HashKey(BOOLEAN_OBJ, v.AsBool() ? 1 : 0);
+    case Value::Kind::Object:
+        if (auto hashable = dynamic_cast<const Hashable*>(v.get())) {
+            return hashable->keyHash();
+        }
+        return std::nullopt;
+    default: return std::nullopt;
+    }
+}
+
+inline Value::Value(std::shared_ptr<Object> obj) : kind(Kind::Empty), integer(0) {
+    if (!obj) return;
+    switch (obj->Type()) {
+    case NULL_OBJ:
+        kind = Kind::Null;
+        break;
+    case INTEGER_OBJ:
+        kind = Kind::Integer;
+        integer = static_cast<Integer*>(obj.get())->Value;
+        break;
+    case BOOLEAN_OBJ:
+        kind = Kind::Boolean;
+        boolean = static_cast<BooleanObject*>(obj.get())->Value;
+        break;
+    default:
+        new (&object) std::shared_ptr<Object>(std::move(obj));
+        kind = Kind::Object;
+    }
+}
+
+inline ObjectType Value::Type() const {
+    switch (kind) {
+    case Kind::Integer: return INTEGER_OBJ;
+    case Kind::Boolean: return BOOLEAN_OBJ;
+    case Kind::Object: return object->Type();
+    default: return NULL_OBJ;
+    }
+}
 
 } //namespace of YOXS_OBJECT
 
@@ -64,9 +64,172 @@ void TestIntegerHashKey() {
 	}
 }
 
+int64_t valueAt(const YOXS_OBJECT::PersistentVector& v, size_t i) {
+    return v[i].AsInt();
+}
+
+// Grows a vector past one, two and three trie levels and checks that every
+// older version still holds exactly what it held before.
+void TestPersistentVector() {
+    const size_t n = 40000;
+    std::vector<YOXS_OBJECT::PersistentVector> versions;
+    YOXS_OBJECT::PersistentVector v;
+    for (size_t i = 0; i < n; i++) {
+        if (i == 31 || i == 32 || i == 33 || i == 1056 || i == 1057 || i == 33824 || i == 33825) {
+            versions.push_back(v);
+        }
+        v = v.PushBack(std::make_shared<YOXS_OBJECT::Integer>(i));
+    }
+    versions.push_back(v);
+
+    for (const auto& version : versions) {
+        for (size_t i = 0; i < version.size(); i++) {
+            if (valueAt(version, i) != int64_t(i)) {
+                std::cerr << "PersistentVector of size " << version.size() << " has " << valueAt(version, i) << " at " << i << "\n";
+                exit(1);
+            }
+        }
+    }
+
+    auto rest = v;
+    for (size_t i = 0; i < 1000; i++) rest = rest.Rest();
+    if (rest.size() != n - 1000 || valueAt(rest, 0) != 1000 || valueAt(rest, rest.size() - 1) != int64_t(n - 1) ||
+        valueAt(v, 0) != 0 || v.size() != n) {
+        std::cerr << "PersistentVector::Rest changed the wrong vector\n";
+        exit(1);
+    }
+    auto pushed = rest.PushBack(std::make_shared<YOXS_OBJECT::Integer>(-1));
+    if (valueAt(pushed, pushed.size() - 1) != -1 || rest.size() != n - 1000 || v.size() != n) {
+        std::cerr << "PersistentVector::PushBack after Rest went wrong\n";
+        exit(1);
+    }
+
+    std::vector<YOXS_OBJECT::Value> elements;
+    for (int i = 0; i < 100; i++) elements.push_back(YOXS_OBJECT::Value::Int(i));
+    YOXS_OBJECT::PersistentVector built(elements);
+    int64_t sum = 0;
+    for (const auto& e : built) sum += e.AsInt();
+    if (built.size() != 100 || sum != 4950) {
+        std::cerr << "PersistentVector built from a vector is wrong\n";
+        exit(1);
+    }
+}
+
+int64_t lookup(const YOXS_OBJECT::HashTable& table, const YOXS_OBJECT::Value& key) {
+    auto pair = table.Find(*YOXS_OBJECT::HashKeyOf(key), key);
+    return pair ? pair->Value.AsInt() : -1;
+}
+
+void set(YOXS_OBJECT::HashTable& table, const YOXS_OBJECT::Value& key, int64_t value) {
+    table.Set(*YOXS_OBJECT::HashKeyOf(key), {key, YOXS_OBJECT::Value::Int(value)});
+}
+
+// Fills a table through several resizes, then checks lookups, overwrites,
+// insertion order, and that keys whose hashes collide stay apart.
+void TestHashTable() {
+    using namespace YOXS_OBJECT;
+    const int64_t n = 10000;
+    HashTable table;
+    for (int64_t i = 0; i < n; i++) {
+        set(table, std::make_shared<Integer>(i * 1024), i);
+        set(table, std::make_shared<String>("key" + std::to_string(i)), n + i);
+    }
+    for (int64_t i = 0; i < n; i++) {
+        if (lookup(table, std::make_shared<Integer>(i * 1024)) != i ||
+            lookup(table, std::make_shared<String>("key" + std::to_string(i))) != n + i) {
+            std::cerr << "HashTable lost the pair for " << i << "\n";
+            exit(1);
+        }
+    }
+    if (table.size() != size_t(2 * n) || lookup(table, std::make_shared<Integer>(1)) != -1 ||
+        lookup(table, std::make_shared<String>("key")) != -1) {
+        std::cerr << "HashTable has the wrong pairs\n";
+        exit(1);
+    }
+
+    set(table, std::make_shared<String>("key7"), -7);
+    int64_t i = 0;
+    for (const auto& pair : table) {
+        int64_t want = i % 2 == 0 ? i / 2 : n + i / 2;
+        if (i == 15) want = -7;
+        if (pair.Value.AsInt() != want) {
+            std::cerr << "HashTable pairs are out of insertion order at " << i << "\n";
+            exit(1);
+        }
+        i++;
+    }
+    if (table.size() != size_t(2 * n)) {
+        std::cerr << "HashTable added a pair instead of replacing it\n";
+        exit(1);
+    }
+
+    // Same HashKey, different keys: both must be kept.
+    HashTable collide;
+    HashKey same(STRING_OBJ, 42);
+    auto a = std::make_shared<String>("a");
+    auto b = std::make_shared<String>("b");
+    collide.Set(same, {a, std::make_shared<Integer>(1)});
+    collide.Set(same, {b, std::make_shared<Integer>(2)});
+    auto foundA = collide.Find(same, std::make_shared<String>("a"));
+    auto foundB = collide.Find(same, std::make_shared<String>("b"));
+    if (collide.size() != 2 || !foundA || !foundB || foundA->Key != a || foundB->Key != b) {
+        std::cerr << "HashTable merged keys whose hashes collide\n";
+        exit(1);
+    }
+
+    HashTable mixed;
+    set(mixed, std::make_shared<Integer>(1), 1);
+    set(mixed, ObjectConstants::TRUE, 2);
+    if (mixed.size() != 2 || lookup(mixed, std::make_shared<Integer>(1)) != 1 || lookup(mixed, std::make_shared<BooleanObject>(true)) != 2) {
+        std::cerr << "HashTable mixed up keys of different types\n";
+        exit(1);
+    }
+}
+
+void TestHeapBytes() {
+    using namespace YOXS_OBJECT;
+    size_t base = Heap::LiveBytes();
+    {
+        auto big = std::make_shared<String>(std::string(100000, 'x'));
+        if (Heap::LiveBytes() < base + 100000) {
+            std::cerr << "a string's characters are not counted\n";
+            exit(1);
+        }
+
+        std::vector<Value> elements(1000, Value::Int(1));
+        auto array = std::make_shared<ArrayObject>(elements);
+        size_t withArray = Heap::LiveBytes();
+        auto pushed = std::make_shared<ArrayObject>(array->Elements.PushBack(Value::Int(2)));
+        // The new array shares all but its tail with the old one.
+        if (withArray - base < 1000 * sizeof(Value) || Heap::LiveBytes() - withArray > 2 * 32 * sizeof(Value) + 512) {
+            std::cerr << "array storage is counted wrong\n";
+            exit(1);
+        }
+
+        HashTable table;
+        for (int64_t i = 0; i < 1000; i++) {
+            set(table, Value::Int(i), i);
+        }
+        size_t withTable = Heap::LiveBytes();
+        HashTable copy = table;
+        HashTable moved = std::move(table);
+        if (Heap::LiveBytes() - withTable < 1000 * sizeof(HashPair) || Heap::LiveBytes() - withTable > 2 * (withTable - withArray)) {
+            std::cerr << "a copied or moved hash table is counted wrong\n";
+            exit(1);
+        }
+    }
+    if (Heap::LiveBytes() != base) {
+        std::cerr << "freed values are still counted: " << Heap::LiveBytes() - base << " bytes\n";
+        exit(1);
+    }
+}
+
 int main() {
     TestStringHashKey();
     TestIntegerHashKey();
     TestIntegerHashKey();
+    TestPersistentVector();
+    TestHashTable();
+    TestHeapBytes();
     std::cout << "object tests have finished!\n";
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+// persistent_vector.cpp
+#include "persistent_vector.hpp"
+#include "object.hpp"
+
+namespace YOXS_OBJECT {
+
+void VectorNode::Trace(std::vector<Traced*>& children) const {
+    for (const auto& c : Children) children.push_back(c.get());
+    for (const auto& v : Values) TraceObject(v, children);
+}
+
+void VectorNode::ClearRefs() {
+    Children.clear();
+    Values.clear();
+}
+
+PersistentVector::PersistentVector(const std::vector<Element>& elements) {
+    for (const auto& e : elements) {
+        append(e);
+    }
+}
+
+const PersistentVector::Element& PersistentVector::operator[](size_t i) const {
+    i += start;
+    if (i >= tailOffset()) {
+        return tail->Values[i & Mask];
+    }
+    const VectorNode* node = root.get();
+    for (unsigned level = shift; level > 0; level -= Bits) {
+        node = node->Children[(i >> level) & Mask].get();
+    }
+    return node->Values[i & Mask];
+}
+
+PersistentVector PersistentVector::PushBack(Element val) const {
+    PersistentVector v = *this;
+    v.append(std::move(val));
+    return v;
+}
+
+PersistentVector PersistentVector::Rest() const {
+    PersistentVector v = *this;
+    if (!v.empty()) v.start++;
+    return v;
+}
+
+void PersistentVector::Trace(std::vector<Traced*>& children) const {
+    if (root) children.push_back(root.get());
+    if (tail) children.push_back(tail.get());
+}
+
+// Appends in place. Nodes another vector may share are copied first; a tail
+// only this vector refers to, as while it is being built, is filled as is.
+void PersistentVector::append(Element val) {
+    if (count - tailOffset() < Width) {
+        if (!tail) {
+            tail = std::make_shared<VectorNode>();
+        } else if (tail.use_count() > 1) {
+            auto copy = std::make_shared<VectorNode>();
+            copy->Values.reserve(tail->Values.size() + 1);
+            copy->Values = tail->Values;
+            copy->Measure();
+            tail = copy;
+        }
+        size_t capacity = tail->Values.capacity();
+        tail->Values.push_back(std::move(val));
+        if (tail->Values.capacity() != capacity) tail->Measure();
+        count++;
+        return;
+    }
+
+    // The tail is full: move it into the trie and start a new one.
+    if (!root) {
+        root = std::make_shared<VectorNode>();
+        root->Children.push_back(tail);
+        root->Measure();
+        shift = Bits;
+    } else if ((count >> Bits) > (size_t(1) << shift)) {
+        auto newRoot = std::make_shared<VectorNode>();
+        newRoot->Children.push_back(root);
+        newRoot->Children.push_back(newPath(shift, tail));
+        newRoot->Measure();
+        root = newRoot;
+        shift += Bits;
+    } else {
+        root = pushTail(shift, root, tail);
+    }
+    tail = std::make_shared<VectorNode>();
+    tail->Values.push_back(std::move(val));
+    tail->Measure();
+    count++;
+}
+
+std::shared_ptr<VectorNode> PersistentVector::pushTail(unsigned level, const std::shared_ptr<VectorNode>& parent, std::shared_ptr<VectorNode> leaf) const {
+    auto node = std::make_shared<VectorNode>();
+    node->Children = parent->Children;
+    size_t index = ((count - 1) >> level) & Mask;
+
+    std::shared_ptr<VectorNode> child;
+    if (level == Bits) {
+        child = std::move(leaf);
+    } else if (index < parent->Children.size()) {
+        child = pushTail(level - Bits, parent->Children[index], std::move(leaf));
+    } else {
+        child = newPath(level - Bits, std::move(leaf));
+    }
+
+    if (index < node->Children.size()) {
+        node->Children[index] = child;
+    } else {
+        node->Children.push_back(child);
+    }
+    node->Measure();
+    return node;
+}
+
+std::shared_ptr<VectorNode> PersistentVector::newPath(unsigned level, std::shared_ptr<VectorNode> node) {
+    if (level == 0) {
+        return node;
+    }
+    auto branch = std::make_shared<VectorNode>();
+    branch->Children.push_back(newPath(level - Bits, std::move(node)));
+    branch->Measure();
+    return branch;
+}
+
+} //namespace YOXS_OBJECT
@@ -0,0 +1,103 @@
+// persistent_vector.hpp
+#ifndef PERSISTENT_VECTOR_H
+#define PERSISTENT_VECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "heap.hpp"
+#include "value.hpp"
+
+namespace YOXS_OBJECT {
+
+// VectorNode is one node of a PersistentVector's trie: a branch holds up to
+// 32 Children, a leaf up to 32 Values. Nodes are shared between the vectors
+// built from each other and never change once shared. They are Traced so
+// the collector counts a shared node's references once, not once per vector.
+class VectorNode : public Traced {
+public:
+    std::vector<std::shared_ptr<VectorNode>> Children;
+    std::vector<Value> Values;
+
+    void Trace(std::vector<Traced*>& children) const override;
+    void ClearRefs() override;
+
+    // Counts the node's storage toward Heap::LiveBytes. Call it after
+    // Children or Values grow.
+    void Measure() {
+        footprint.Set(sizeof(VectorNode) + Children.capacity() * sizeof(Children[0]) + Values.capacity() * sizeof(Value));
+    }
+
+private:
+    HeapBytes footprint;
+};
+
+// PersistentVector is an immutable vector of values with structural
+// sharing: a 32-way trie plus a tail leaf, as in Clojure. PushBack copies
+// at most one leaf and one path of the trie, so it is O(log32 n) instead of
+// O(n), and Rest is O(1) because it only moves the start offset (the
+// dropped element stays referenced until every vector sharing it is gone).
+class PersistentVector {
+public:
+    using Element = Value;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Element;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Element*;
+        using reference = const Element&;
+
+        Iterator(const PersistentVector* v, size_t i) : v(v), i(i) {}
+        reference operator*() const { return (*v)[i]; }
+        Iterator& operator++() { i++; return *this; }
+        bool operator==(const Iterator& rhs) const { return i == rhs.i; }
+        bool operator!=(const Iterator& rhs) const { return i != rhs.i; }
+
+    private:
+        const PersistentVector* v;
+        size_t i;
+    };
+
+    PersistentVector() = default;
+    PersistentVector(const std::vector<Element>& elements);
+
+    size_t size() const { return count - start; }
+    bool empty() const { return count == start; }
+    const Element& operator[](size_t i) const;
+    const Element& front() const { return (*this)[0]; }
+    const Element& back() const { return (*this)[size() - 1]; }
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, size()); }
+
+    // A vector with val appended. This one is unchanged.
+    PersistentVector PushBack(Element val) const;
+    // A vector without the first element. This one is unchanged.
+    PersistentVector Rest() const;
+
+    // The nodes this vector refers to, for the collector.
+    void Trace(std::vector<Traced*>& children) const;
+
+private:
+    static constexpr unsigned Bits = 5;
+    static constexpr size_t Width = size_t(1) << Bits;
+    static constexpr size_t Mask = Width - 1;
+
+    std::shared_ptr<VectorNode> root; // nullptr until the tail first fills up
+    std::shared_ptr<VectorNode> tail;
+    size_t count = 0;   // elements in root and tail, including the ones Rest dropped
+    size_t start = 0;   // elements dropped from the front by Rest
+    unsigned shift = Bits;
+
+    size_t tailOffset() const { return count < Width ? 0 : ((count - 1) >> Bits) << Bits; }
+    void append(Element val);
+    std::shared_ptr<VectorNode> pushTail(unsigned level, const std::shared_ptr<VectorNode>& parent, std::shared_ptr<VectorNode> leaf) const;
+    static std::shared_ptr<VectorNode> newPath(unsigned level, std::shared_ptr<VectorNode> node);
+};
+
+} //namespace YOXS_OBJECT
+
+#endif // PERSISTENT_VECTOR_H
@@ -0,0 +1,154 @@
+// value.hpp
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace YOXS_OBJECT {
+
+class Object;
+
+enum ObjectType {
+    NULL_OBJ,
+    ERROR_OBJ,
+
+    INTEGER_OBJ,
+    BOOLEAN_OBJ,
+    STRING_OBJ,
+
+    RETURN_VALUE_OBJ,
+
+    FUNCTION_OBJ,
+    BUILTIN_OBJ,
+
+    ARRAY_OBJ,
+    HASH_OBJ,
+
+    COMPILED_FUNCTION_OBJ,
+    CLOSURE_OBJ
+};
+
+std::string ObjectTypeToString(ObjectType type);
+
+// Value is what the evaluator, environments, arrays, hashes and builtins
+// pass around. Integers, booleans and null are stored inline, so arithmetic
+// and comparisons allocate nothing; every other value is a heap Object held
+// by shared_ptr. Constructing a Value from an Integer, BooleanObject or
+// NullObject unboxes it, so those kinds are never held as objects and two
+// equal integers are always equal Values.
+//
+// An empty Value is no value at all, what a let statement evaluates to and
+// what an unassigned slot holds. It is not the same as null.
+class Value {
+public:
+    enum class Kind : uint8_t { Empty, Null, Integer, Boolean, Object };
+
+    Value() noexcept : kind(Kind::Empty), integer(0) {}
+    Value(std::nullptr_t) noexcept : Value() {}
+    Value(std::shared_ptr<Object> obj); // defined in object.hpp
+    template <class T, class = std::enable_if_t<std::is_convertible<T*, Object*>::value>>
+    Value(std::shared_ptr<T> obj) : Value(std::shared_ptr<Object>(std::move(obj))) {}
+
+    static Value Int(int64_t v) noexcept { Value out; out.kind = Kind::Integer; out.integer = v; return out; }
+    static Value Bool(bool b) noexcept { Value out; out.kind = Kind::Boolean; out.boolean = b; return out; }
+    static Value Null() noexcept { Value out; out.kind = Kind::Null; return out; }
+
+    Value(const Value& other) : kind(Kind::Empty), integer(0) { copyFrom(other); }
+    Value(Value&& other) noexcept : kind(Kind::Empty), integer(0) { moveFrom(std::move(other)); }
+    Value& operator=(const Value& other) {
+        if (this != &other) {
+            reset();
+            copyFrom(other);
+        }
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(std::move(other));
+        }
+        return *this;
+    }
+    ~Value() { reset(); }
+
+    Kind GetKind() const { return kind; }
+    bool IsEmpty() const { return kind == Kind::Empty; }
+    bool IsNull() const { return kind == Kind::Null; }
+    bool IsInt() const { return kind == Kind::Integer; }
+    bool IsBool() const { return kind == Kind::Boolean; }
+    bool IsObject() const { return kind == Kind::Object; }
+    explicit operator bool() const { return kind != Kind::Empty; }
+
+    int64_t AsInt() const { return integer; }
+    bool AsBool() const { return boolean; }
+    // The heap object, or nullptr if the value is inline.
+    Object* get() const { return kind == Kind::Object ? object.get() : nullptr; }
+    // The heap object as a T, which the caller has checked with Type().
+    template <class T> T* As() const { return static_cast<T*>(object.get()); }
+    template <class T> std::shared_ptr<T> Share() const { return std::static_pointer_cast<T>(object); }
+
+    // An empty Value has type NULL_OBJ.
+    ObjectType Type() const; // defined in object.hpp
+    std::string Inspect() const;
+    // The value as an Object, allocating an Integer for inline integers.
+    // For hosts and the VM, which work with objects.
+    std::shared_ptr<Object> ToObject() const;
+
+    // Identity: equal inline values, or the same heap object.
+    bool operator==(const Value& rhs) const {
+        if (kind != rhs.kind) return false;
+        switch (kind) {
+        case Kind::Integer: return integer == rhs.integer;
+        case Kind::Boolean: return boolean == rhs.boolean;
+        case Kind::Object: return object == rhs.object;
+        default: return true;
+        }
+    }
+    bool operator!=(const Value& rhs) const { return !(*this == rhs); }
+
+private:
+    Kind kind;
+    union {
+        int64_t integer;
+        bool boolean;
+        std::shared_ptr<Object> object;
+    };
+
+    void reset() noexcept {
+        if (kind == Kind::Object) object.~shared_ptr<Object>();
+        kind = Kind::Empty;
+    }
+    void copyFrom(const Value& other) {
+        switch (other.kind) {
+        case Kind::Integer: integer = other.integer; break;
+        case Kind::Boolean: boolean = other.boolean; break;
+        case Kind::Object: new (&object) std::shared_ptr<Object>(other.object); break;
+        default: break;
+        }
+        kind = other.kind;
+    }
+    void moveFrom(Value&& other) noexcept {
+        switch (other.kind) {
+        case Kind::Integer: integer = other.integer; break;
+        case Kind::Boolean: boolean = other.boolean; break;
+        case Kind::Object: new (&object) std::shared_ptr<Object>(std::move(other.object)); break;
+        default: break;
+        }
+        kind = other.kind;
+        other.reset();
+    }
+};
+
+// A tag and a shared_ptr. Heap objects are owned by shared_ptr, which is
+// two words, so this cannot shrink to 16 bytes without intrusive counts.
+static_assert(sizeof(Value) == 24, "Value should be a tag and a shared_ptr");
+
+} //namespace YOXS_OBJECT
+
+#endif // VALUE_H
@@ -1,112 +1,73 @@
 #include "parser.hpp"
-
-std::unordered_map<TokenType, Precedence> precedences = {
-    { TokenType::EQ, EQUALS },
-    { TokenType::NOT_EQ, EQUALS },
-    { TokenType::LT, LESSGREATER },
-    { TokenType::GT, LESSGREATER},
-    { TokenType::PLUS, SUM},
-    { TokenType::MINUS, SUM},
-    { TokenType::SLASH, PRODUCT},
-    { TokenType::ASTERISK, PRODUCT},
-    { TokenType::LPAREN, CALL},
-    { TokenType::LBRACKET, INDEX}
-
-};
-
-Parser::Parser(Lexer& l) : lexer(&l) {
-    // Initialize errors
-    errors = std::vector<std::string>();
-
-
-    // Register prefix functions using lambda functions for explicit casting
-    registerPrefix(TokenType::IDENT, [this]() -> std::shared_ptr<Expression> {
-        return this->parseIdentifier();
-    });
-    registerPrefix(TokenType::INT, [this]() -> std::shared_ptr<Expression> {
-        return this->parseIntegerLiteral();
-    });
-    registerPrefix(TokenType::STRING, [this]() -> std::shared_ptr<Expression> {
-        return this->parseStringLiteral();
-    });
-    registerPrefix(TokenType::BANG, [this]() -> std::shared_ptr<Expression> {
-        return this->parsePrefixExpression();
-    });
-    registerPrefix(TokenType::MINUS, [this]() -> std::shared_ptr<Expression> {
-        return this->parsePrefixExpression();
-    });
-    registerPrefix(TokenType::TRUE, [this]() -> std::shared_ptr<Expression> {
-        return this->parseBoolean();
-    });
-    registerPrefix(TokenType::FALSE, [this]() -> std::shared_ptr<Expression> {
-        return this->parseBoolean();
-    });
-    registerPrefix(TokenType::LPAREN, [this]() -> std::shared_ptr<Expression> {
-        return this->parseGroupedExpression();
-    });
-    registerPrefix(TokenType::IF, [this]() -> std::shared_ptr<Expression> {
-        return this->parseIfExpression();
-    });
-    registerPrefix(TokenType::FUNCTION, [this]() -> std::shared_ptr<Expression> {
-        return this->parseFunctionLiteral();
-    });
-    registerPrefix(TokenType::LBRACKET, [this]() -> std::shared_ptr<Expression> {
-        return this->parseArrayLiteral();
-    });
-    registerPrefix(TokenType::LBRACE, [this]() -> std::shared_ptr<Expression> {
-        return this->parseHashLiteral();
-    });
-
-
-    // Register infix functions using lambda functions for explicit casting
-    registerInfix(TokenType::PLUS, [this](std::shared_ptr<Expression> left) -> std::shared_ptr<Expression> {
-        return this->parseInfixExpression(left);
-    });
-    registerInfix(TokenType::MINUS, [this](std::shared_ptr<Expression> left) -> std::shared_ptr<Expression> {
-        return this->parseInfixExpression(left);
-    });
-    registerInfix(TokenType::SLASH, [this](std::shared_ptr<Expression> left) {
-        return this->parseInfixExpression(left);
-    });
-    registerInfix(TokenType::ASTERISK, [this](std::shared_ptr<Expression> left) {
-        return this->parseInfixExpression(left);
-    });
-    registerInfix(TokenType::EQ, [this](std::shared_ptr<Expression> left) {
-        return this->parseInfixExpression(left);
-    });
-    registerInfix(TokenType::NOT_EQ, [this](std::shared_ptr<Expression> left) {
-        return this->parseInfixExpression(left);
-    });
-    registerInfix(TokenType::LT, [this](std::shared_ptr<Expression> left) {
-        return this->parseInfixExpression(left);
-    });
-    registerInfix(TokenType::GT, [this](std::shared_ptr<Expression> left) {
-        return this->parseInfixExpression(left);
-    });
-    registerInfix(TokenType::LPAREN, [this](std::shared_ptr<Expression> function) {
-        return this->parseCallExpression(function);
-    });
-    registerInfix(TokenType::LBRACKET, [this](std::shared_ptr<Expression> idx) {
-        return this->parseIndexExpression(idx);
-    });
-
+#include <charconv>
+
+// The parse rule of every token type, worked out by the compiler. A token
+// type with no prefix function cannot start an expression, and one with no
+// infix function does not continue one, so its precedence stays LOWEST.
+constexpr std::array<Parser::ParseRule, TokenTypeCount> Parser::makeRules() {
+    std::array<ParseRule, TokenTypeCount> rules{};
+    for (auto& rule : rules) {
+        rule.precedence = LOWEST;
+    }
+    auto prefix = [&rules](TokenType type, PrefixFn fn) { rules[static_cast<size_t>(type)].prefix = fn; };
+    auto infix = [&rules](TokenType type, InfixFn fn, Precedence precedence) {
+        rules[static_cast<size_t>(type)].infix = fn;
+        rules[static_cast<size_t>(type)].precedence = precedence;
+    };
+
+    prefix(TokenType::IDENT, &Parser::prefixRule<Identifier, &Parser::parseIdentifier>);
+    prefix(TokenType::INT, &Parser::prefixRule<IntegerLiteral, &Parser::parseIntegerLiteral>);
+    prefix(TokenType::STRING, &Parser::prefixRule<StringLiteral, &Parser::parseStringLiteral>);
+    prefix(TokenType::BANG, &Parser::prefixRule<PrefixExpression, &Parser::parsePrefixExpression>);
+    prefix(TokenType::MINUS, &Parser::prefixRule<PrefixExpression, &Parser::parsePrefixExpression>);
+    prefix(TokenType::TRUE, &Parser::prefixRule<YOXS_AST::Boolean, &Parser::parseBoolean>);
+    prefix(TokenType::FALSE, &Parser::prefixRule<YOXS_AST::Boolean, &Parser::parseBoolean>);
+    prefix(TokenType::LPAREN, &Parser::prefixRule<Expression, &Parser::parseGroupedExpression>);
+    prefix(TokenType::IF, &Parser::prefixRule<IfExpression, &Parser::parseIfExpression>);
+    prefix(TokenType::FUNCTION, &Parser::prefixRule<FunctionLiteral, &Parser::parseFunctionLiteral>);
+    prefix(TokenType::LBRACKET, &Parser::prefixRule<ArrayLiteral, &Parser::parseArrayLiteral>);
+    prefix(TokenType::LBRACE, &Parser::prefixRule<HashLiteral, &Parser::parseHashLiteral>);
+
+    infix(TokenType::EQ, &Parser::infixRule<InfixExpression, &Parser::parseInfixExpression>, EQUALS);
+    infix(TokenType::NOT_EQ, &Parser::infixRule<InfixExpression, &Parser::parseInfixExpression>, EQUALS);
+    infix(TokenType::LT, &Parser::infixRule<InfixExpression, &Parser::parseInfixExpression>, LESSGREATER);
+    infix(TokenType::GT, &Parser::infixRule<InfixExpression, &Parser::parseInfixExpression>, LESSGREATER);
+    infix(TokenType::PLUS, &Parser::infixRule<InfixExpression, &Parser::parseInfixExpression>, SUM);
+    infix(TokenType::MINUS, &Parser::infixRule<InfixExpression, &Parser::parseInfixExpression>, SUM);
+    infix(TokenType::SLASH, &Parser::infixRule<InfixExpression, &Parser::parseInfixExpression>, PRODUCT);
+    infix(TokenType::ASTERISK, &Parser::infixRule<InfixExpression, &Parser::parseInfixExpression>, PRODUCT);
+    infix(TokenType::LPAREN, &Parser::infixRule<CallExpression, &Parser::parseCallExpression>, CALL);
+    infix(TokenType::LBRACKET, &Parser::infixRule<IndexExpression, &Parser::parseIndexExpression>, INDEX);
+    return rules;
+}
+
+constexpr std::array<Parser::ParseRule, TokenTypeCount> Parser::rules = Parser::makeRules();
+
+Precedence PrecedenceOf(TokenType type) {
+    return Parser::rules[static_cast<size_t>(type)].precedence;
+}
+
+Parser::Parser(Lexer& l) : Parser(&l, nullptr, l.Source()) {}
+
+Parser::Parser(const TokenBuffer& tokens) : Parser(nullptr, &tokens, tokens.Source) {}
+
+Parser::Parser(Lexer* l, const TokenBuffer* tokens, std::shared_ptr<const std::string> source)
+    : lexer(l), tokens(tokens), source(std::move(source)), program(nullptr) {
     // Read two tokens, so curToken and peekToken are both set
     nextToken();
     nextToken();
 }
 
-
-void Parser::registerPrefix(TokenType type, prefixParseFn fn) {
-    prefixParseFns[type] = fn;
-}
-
-void Parser::registerInfix(TokenType type, infixParseFn fn) {
-    infixParseFns[type] = fn;
-}
-
 void Parser::nextToken() {
     curToken = peekToken;
-    peekToken = lexer->NextToken();
+    if (!tokens) {
+        peekToken = lexer->NextToken();
+    } else if (nextIndex < tokens->Size()) {
+        peekToken = tokens->At(nextIndex++);
+    } else {
+        // Like the Lexer, keep answering EOF once the input is exhausted.
+        peekToken = Token(TokenType::EOF_TOKEN, "");
+    }
 }
 
 bool Parser::curTokenIs(TokenType t) const {
@@ -141,37 +102,33 @@ void Parser::noPrefixParseFnError(TokenType t) {
 
 
 int Parser::peekPrecedence() const {
-    auto it = precedences.find(peekToken.Type);
-    if (it != precedences.end()) {
-        return it->second;
-    }
-    return Precedence::LOWEST;
+    return ruleFor(peekToken.Type).precedence;
 }
 
 int Parser::curPrecedence() const {
-    auto it = precedences.find(curToken.Type);
-    if (it != precedences.end()) {
-        return it->second;
-    }
-    return Precedence::LOWEST;
+    return ruleFor(curToken.Type).precedence;
 }
 
 // Parsing functions here...
 
 std::shared_ptr<Program> Parser::ParseProgram() {
-    auto program = std::make_shared<Program>();
-    program->Statements = std::vector<std::shared_ptr<Statement>>();
+    auto result = std::make_shared<Program>();
+    result->Source = source;
+    program = result.get();
 
+    std::vector<Statement*> statements;
     while(!curTokenIs(TokenType::EOF_TOKEN)) {
         auto stmt = parseStatement();
-        if(stmt) program->Statements.push_back(stmt);
+        if(stmt) statements.push_back(stmt);
         nextToken();
     }
+    program->Statements = program->List(statements);
 
-    return program;
+    program = nullptr;
+    return result;
 }
 
-std::shared_ptr<Statement> Parser::parseStatement(){
+Statement* Parser::parseStatement(){
     switch (curToken.Type)
     {
     case TokenType::LET:
@@ -181,6 +138,17 @@ std::shared_ptr<Statement> Parser::parseStatement(){
     case TokenType::RETURN:
         return parseReturnStatement();
         break;
+
+    case TokenType::WHILE:
+        return parseWhileStatement();
+        break;
+
+    case TokenType::IDENT:
+        if (peekTokenIs(TokenType::ASSIGN)) {
+            return parseAssignStatement();
+        }
+        return parseExpressionStatement();
+        break;
     
     default: //expression statement
         return parseExpressionStatement();
@@ -188,15 +156,15 @@ std::shared_ptr<Statement> Parser::parseStatement(){
     }
 }
 
-std::shared_ptr<LetStatement> Parser::parseLetStatement() {
-    auto stmt = std::make_shared<LetStatement>();
+LetStatement* Parser::parseLetStatement() {
+    auto stmt = program->New<LetStatement>();
     stmt->token = curToken;
 
     if (!expectPeek(TokenType::IDENT)) {
         return nullptr;
     }
 
-    stmt->Name = std::make_shared<Identifier> (curToken, curToken.Literal); 
+    stmt->Name = program->New<Identifier>(curToken, curToken.Literal); 
 
     if(!expectPeek(TokenType::ASSIGN)) {
         return nullptr;
@@ -205,6 +173,10 @@ std::shared_ptr<LetStatement> Parser::parseLetStatement() {
     nextToken();
     stmt->Value = parseExpression(Precedence::LOWEST);
 
+    if (stmt->Value && stmt->Value->Kind == NodeKind::FunctionLiteral) {
+        static_cast<FunctionLiteral*>(stmt->Value)->Name = stmt->Name->Value();
+    }
+
     if(peekTokenIs(TokenType::SEMICOLON)){
         nextToken();
     }
@@ -212,8 +184,8 @@ std::shared_ptr<LetStatement> Parser::parseLetStatement() {
     return stmt;
 }
 
-std::shared_ptr<ReturnStatement> Parser::parseReturnStatement() {
-    auto stmt = std::make_shared<ReturnStatement>();
+ReturnStatement* Parser::parseReturnStatement() {
+    auto stmt = program->New<ReturnStatement>();
     stmt->token = curToken;
 
     nextToken();
@@ -226,8 +198,52 @@ std::shared_ptr<ReturnStatement> Parser::parseReturnStatement() {
     return stmt;
 }
 
-std::shared_ptr<ExpressionStatement> Parser::parseExpressionStatement(){
-    auto stmt = std::make_shared<ExpressionStatement>();
+AssignStatement* Parser::parseAssignStatement() {
+    auto stmt = program->New<AssignStatement>();
+    stmt->Name = program->New<Identifier>(curToken, curToken.Literal);
+
+    nextToken();
+    stmt->token = curToken;
+
+    nextToken();
+    stmt->Value = parseExpression(Precedence::LOWEST);
+
+    if (peekTokenIs(TokenType::SEMICOLON)) {
+        nextToken();
+    }
+
+    return stmt;
+}
+
+WhileStatement* Parser::parseWhileStatement() {
+    auto stmt = program->New<WhileStatement>(curToken);
+
+    if (!expectPeek(TokenType::LPAREN)) {
+        return nullptr;
+    }
+
+    nextToken();
+    stmt->Condition = parseExpression(Precedence::LOWEST);
+
+    if (!expectPeek(TokenType::RPAREN)) {
+        return nullptr;
+    }
+
+    if (!expectPeek(TokenType::LBRACE)) {
+        return nullptr;
+    }
+
+    stmt->Body = parseBlockStatement();
+
+    if (peekTokenIs(TokenType::SEMICOLON)) {
+        nextToken();
+    }
+
+    return stmt;
+}
+
+ExpressionStatement* Parser::parseExpressionStatement(){
+    auto stmt = program->New<ExpressionStatement>();
     stmt->expr = parseExpression(Precedence::LOWEST); // check if valid
 
     if (peekTokenIs(TokenType::SEMICOLON)){
@@ -237,43 +253,50 @@ std::shared_ptr<ExpressionStatement> Parser::parseExpressionStatement(){
     return stmt;
 }
 
-std::shared_ptr<Expression> Parser::parseExpression(Precedence pVal){
-    auto prefixIt = prefixParseFns.find(curToken.Type);
-    if (prefixIt == prefixParseFns.end()) {
+Expression* Parser::parseExpression(Precedence pVal){
+    PrefixFn prefix = ruleFor(curToken.Type).prefix;
+    if (!prefix) {
         noPrefixParseFnError(curToken.Type);
         return nullptr;
     }
-    auto prefix = prefixIt->second;
-    std::shared_ptr<Expression> leftExp = (prefix)();
-    //here we are calling prefix like a function and the parentheses after prefix 
-    //are invoking the callable object. if prefix is a lambda or std::function
-    //wrapping a lambda it will invoke the lambdas code. 
-    //The result is stored in leftExp
+    Expression* leftExp = (this->*prefix)();
+    //here we are calling prefix through its member function pointer, on
+    //this parser. The result is stored in leftExp
 
     while(!peekTokenIs(TokenType::SEMICOLON) && pVal < peekPrecedence()) {
-        auto infixIt = infixParseFns.find(peekToken.Type);
-        if (infixIt == infixParseFns.end()) return leftExp;
+        InfixFn infix = ruleFor(peekToken.Type).infix;
+        if (!infix) return leftExp;
         nextToken();
 
-        auto infix = infixIt->second;
-        leftExp = (infix)(leftExp);    }
+        leftExp = (this->*infix)(leftExp);
+    }
 
     return leftExp;
 
 }
 
-std::shared_ptr<Identifier>  Parser::parseIdentifier(){
-    return std::make_shared<Identifier> (curToken, curToken.Literal);
+Identifier*  Parser::parseIdentifier(){
+    return program->New<Identifier>(curToken, curToken.Literal);
 }
 
-std::shared_ptr<IntegerLiteral>  Parser::parseIntegerLiteral(){
-    auto lit = std::make_shared<IntegerLiteral>(curToken);
+IntegerLiteral*  Parser::parseIntegerLiteral(){
+    auto lit = program->New<IntegerLiteral>(curToken);
+
+    // The buffer has the value already, unless the literal overflowed. Two
+    // tokens ahead, nextIndex is one past peekToken and two past curToken.
+    if (tokens && nextIndex >= 2) {
+        lit->Value = tokens->Values[nextIndex - 2];
+        if (lit->Value != 0 || curToken.Literal.find_first_not_of('0') == std::string_view::npos) {
+            return lit;
+        }
+    }
 
-    try {
-        //stoi can throw an exception if conversion fails
-        lit->Value = std::stoll(curToken.Literal);
-    } catch (const std::exception& e){
-        std::string msg = "could not parse \"" + curToken.Literal + "\" as integer";
+    // from_chars reads straight from the source view without building a string
+    const char* first = curToken.Literal.data();
+    const char* last = first + curToken.Literal.size();
+    auto result = std::from_chars(first, last, lit->Value);
+    if (result.ec != std::errc() || result.ptr != last) {
+        std::string msg = "could not parse \"" + std::string(curToken.Literal) + "\" as integer";
         errors.push_back(msg);
         return nullptr;
     }
@@ -281,12 +304,12 @@ std::shared_ptr<IntegerLiteral>  Parser::parseIntegerLiteral(){
     return lit;
 }
 
-std::shared_ptr<StringLiteral> Parser::parseStringLiteral() {
-    return std::make_shared<StringLiteral>(curToken, curToken.Literal);
+StringLiteral* Parser::parseStringLiteral() {
+    return program->New<StringLiteral>(curToken, curToken.Literal);
 }
 
-std::shared_ptr<PrefixExpression>  Parser::parsePrefixExpression(){
-    auto expression = std::make_shared<PrefixExpression>(curToken, curToken.Literal);
+PrefixExpression*  Parser::parsePrefixExpression(){
+    auto expression = program->New<PrefixExpression>(curToken, curToken.Literal);
 
     nextToken();
 
@@ -296,8 +319,8 @@ std::shared_ptr<PrefixExpression>  Parser::parsePrefixExpression(){
 
 }
 
-std::shared_ptr<InfixExpression> Parser::parseInfixExpression (std::shared_ptr<Expression> left){
-    auto expression = std::make_shared<InfixExpression>(curToken, curToken.Literal, left);
+InfixExpression* Parser::parseInfixExpression (Expression* left){
+    auto expression = program->New<InfixExpression>(curToken, curToken.Literal, left);
     auto precedence = curPrecedence();
 
     nextToken();
@@ -306,11 +329,11 @@ std::shared_ptr<InfixExpression> Parser::parseInfixExpression (std::shared_ptr<E
     return expression;
 }
 
-std::shared_ptr<YOXS_AST::Boolean> Parser::parseBoolean(){
-    return std::make_shared<YOXS_AST::Boolean> (curToken, curTokenIs(TokenType::TRUE));
+YOXS_AST::Boolean* Parser::parseBoolean(){
+    return program->New<YOXS_AST::Boolean>(curToken, curTokenIs(TokenType::TRUE));
 }
 
-std::shared_ptr<Expression> Parser::parseGroupedExpression(){
+Expression* Parser::parseGroupedExpression(){
     nextToken();
 
     auto exp = parseExpression(Precedence::LOWEST);
@@ -322,8 +345,8 @@ std::shared_ptr<Expression> Parser::parseGroupedExpression(){
     return exp;
 }
 
-std::shared_ptr<IfExpression>  Parser::parseIfExpression() {
-    auto expression = std::make_shared<IfExpression>(curToken);
+IfExpression*  Parser::parseIfExpression() {
+    auto expression = program->New<IfExpression>(curToken);
 
     if(!expectPeek(TokenType::LPAREN)) {
         return nullptr;
@@ -355,30 +378,33 @@ std::shared_ptr<IfExpression>  Parser::parseIfExpression() {
     return expression;
 }
 
-std::shared_ptr<BlockStatement> Parser::parseBlockStatement(){
-    auto block = std::make_shared<BlockStatement>(curToken);
+BlockStatement* Parser::parseBlockStatement(){
+    auto block = program->New<BlockStatement>(curToken);
 
     nextToken();
 
+    std::vector<Statement*> statements;
     while (!curTokenIs(TokenType::RBRACE) && !curTokenIs(TokenType::EOF_TOKEN)) {
         auto stmt = parseStatement();
         if (stmt) {
-            block->Statements.push_back(stmt);
+            statements.push_back(stmt);
         }
         nextToken();
     }
+    block->Statements = program->List(statements);
 
     return block;
 }
 
-std::shared_ptr<FunctionLiteral> Parser::parseFunctionLiteral(){
-    auto lit = std::make_shared<FunctionLiteral>(curToken);
+FunctionLiteral* Parser::parseFunctionLiteral(){
+    auto lit = program->New<FunctionLiteral>(curToken);
+    lit->Owner = program;
 
     if(!expectPeek(TokenType::LPAREN)) {
         return nullptr;
     }
 
-    lit->Parameters = parseFunctionParameters();
+    lit->Parameters = program->List(parseFunctionParameters());
 
     if(!expectPeek(TokenType::LBRACE)) {
         return nullptr;
@@ -388,8 +414,8 @@ std::shared_ptr<FunctionLiteral> Parser::parseFunctionLiteral(){
 
     return lit;
 }
-std::vector<std::shared_ptr<Identifier>>  Parser::parseFunctionParameters() {
-    std::vector<std::shared_ptr<Identifier>> identifiers;
+std::vector<Identifier*>  Parser::parseFunctionParameters() {
+    std::vector<Identifier*> identifiers;
 
     if(peekTokenIs(TokenType::RPAREN)) {
         nextToken();
@@ -398,13 +424,13 @@ std::vector<std::shared_ptr<Identifier>>  Parser::parseFunctionParameters() {
 
     nextToken();
 
-    auto ident = std::make_shared<Identifier>(curToken, curToken.Literal);
+    auto ident = program->New<Identifier>(curToken, curToken.Literal);
     identifiers.push_back(ident);
 
     while (peekTokenIs(TokenType::COMMA)){
         nextToken();  // Consume the COMMA
         nextToken();  // Move to the next token after the COMMA
-        ident = std::make_shared<Identifier>(curToken, curToken.Literal);
+        ident = program->New<Identifier>(curToken, curToken.Literal);
         identifiers.push_back(ident);
     }
 
@@ -420,14 +446,14 @@ std::vector<std::shared_ptr<Identifier>>  Parser::parseFunctionParameters() {
 
 }
 
-std::shared_ptr<CallExpression> Parser::parseCallExpression(std::shared_ptr<Expression> function){
-    auto exp = std::make_shared<CallExpression>(curToken, function);
-    exp->Arguments = parseExpressionList(TokenType::RPAREN);
+CallExpression* Parser::parseCallExpression(Expression* function){
+    auto exp = program->New<CallExpression>(curToken, function);
+    exp->Arguments = program->List(parseExpressionList(TokenType::RPAREN));
     return exp;
 }
 
-std::vector<std::shared_ptr<Expression>> Parser::parseExpressionList(const TokenType& end){
-    std::vector<std::shared_ptr<Expression>> list;
+std::vector<Expression*> Parser::parseExpressionList(const TokenType& end){
+    std::vector<Expression*> list;
     if(peekTokenIs(end)) {
         nextToken();
         return list;
@@ -449,16 +475,16 @@ std::vector<std::shared_ptr<Expression>> Parser::parseExpressionList(const Token
     return list;
 }
 
-std::shared_ptr<ArrayLiteral> Parser::parseArrayLiteral(){
-    auto array = std::make_shared<ArrayLiteral>(curToken);
+ArrayLiteral* Parser::parseArrayLiteral(){
+    auto array = program->New<ArrayLiteral>(curToken);
 
-    array->Elements = parseExpressionList(TokenType::RBRACKET);
+    array->Elements = program->List(parseExpressionList(TokenType::RBRACKET));
 
     return array;
 }
 
-std::shared_ptr<IndexExpression> Parser::parseIndexExpression(std::shared_ptr<Expression> left){
-    auto exp = std::make_shared<IndexExpression>(curToken, left);
+IndexExpression* Parser::parseIndexExpression(Expression* left){
+    auto exp = program->New<IndexExpression>(curToken, left);
     nextToken();
     exp->Index = parseExpression(Precedence::LOWEST);
 
@@ -467,8 +493,9 @@ std::shared_ptr<IndexExpression> Parser::parseIndexExpression(std::shared_ptr<Ex
     return exp;
 }
 
-std::shared_ptr<HashLiteral> Parser::parseHashLiteral(){
-    auto hash = std::make_shared<HashLiteral>(curToken);
+HashLiteral* Parser::parseHashLiteral(){
+    auto hash = program->New<HashLiteral>(curToken);
+    std::vector<HashLiteralPair> pairs;
     while(!peekTokenIs(TokenType::RBRACE)) {
         nextToken();
         auto key = parseExpression(Precedence::LOWEST);
@@ -477,13 +504,14 @@ std::shared_ptr<HashLiteral> Parser::parseHashLiteral(){
 
         nextToken();
         auto value = parseExpression(Precedence::LOWEST);
-        hash->Pairs[key] = value;
+        pairs.push_back({key, value});
 
         if(!peekTokenIs(TokenType::RBRACE) && !expectPeek(TokenType::COMMA)) return nullptr;
     }
 
     if(!expectPeek(TokenType::RBRACE)) return nullptr;
 
+    hash->Pairs = program->List(pairs);
     return hash;
 }
 
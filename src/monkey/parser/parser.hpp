@@ -3,9 +3,8 @@
 
 #include <string>
 #include <vector>
+#include <array>
 #include <memory>
-#include <functional>
-#include <unordered_map>
 #include <sstream>
 #include "../lexer/lexer.hpp"
 #include "../token/token.hpp"
@@ -24,17 +23,27 @@ enum Precedence {
     INDEX // array[index]
 };
 
-extern std::unordered_map<TokenType, Precedence> precedences;
+// The precedence of type as an infix operator, or LOWEST if it is not one.
+Precedence PrecedenceOf(TokenType type);
 
 class Parser {
 public:
     Parser(Lexer& l);
+    // Parses tokens a Lexer already produced, as TokenizeAll returns them,
+    // walking the buffer by index. tokens must outlive the Parser.
+    Parser(const TokenBuffer& tokens);
 
     std::vector<std::string> Errors() const; 
     std::shared_ptr<Program> ParseProgram();
 
 private:
-    Lexer* lexer;
+    Parser(Lexer* l, const TokenBuffer* tokens, std::shared_ptr<const std::string> source);
+
+    Lexer* lexer;                // where tokens come from, unless
+    const TokenBuffer* tokens;   // they were read ahead into here
+    size_t nextIndex = 0;        // the token in tokens peekToken takes next
+    std::shared_ptr<const std::string> source;
+    Program* program; // the Program being parsed; every node is allocated in its arena
     Token curToken;
     Token peekToken;
     //curToken and peekToken act exactly like the two “pointers” our 
@@ -46,14 +55,33 @@ private:
     //curToken doesn’t give us enough information.
     std::vector<std::string> errors;
 
-    using prefixParseFn = std::function<std::shared_ptr<Expression>(void)>;
-    using infixParseFn = std::function<std::shared_ptr<Expression>(std::shared_ptr<Expression>)>;
-
-    std::unordered_map<TokenType, prefixParseFn> prefixParseFns;
-    std::unordered_map<TokenType, infixParseFn> infixParseFns;
-
-    void registerPrefix(TokenType type, prefixParseFn fn);
-    void registerInfix(TokenType type, infixParseFn fn);
+    friend Precedence PrecedenceOf(TokenType type);
+
+    using PrefixFn = Expression* (Parser::*)();
+    using InfixFn = Expression* (Parser::*)(Expression*);
+
+    // What to do with a token type in an expression: the function that
+    // parses an expression starting with it, the one that parses an
+    // expression continued by it, and how tightly it binds as an operator.
+    // A missing function means the token cannot be used that way.
+    struct ParseRule {
+        PrefixFn prefix = nullptr;
+        InfixFn infix = nullptr;
+        Precedence precedence = LOWEST;
+    };
+
+    // Indexed by TokenType and filled in at compile time, so a Parser
+    // costs nothing to set up and each lookup is a single load.
+    static const std::array<ParseRule, TokenTypeCount> rules;
+    static constexpr std::array<ParseRule, TokenTypeCount> makeRules();
+    static const ParseRule& ruleFor(TokenType type) { return rules[static_cast<size_t>(type)]; }
+
+    // Adapt the parse functions, which return the node type they build, to
+    // the signatures of PrefixFn and InfixFn.
+    template <class T, T* (Parser::*Parse)()>
+    Expression* prefixRule() { return (this->*Parse)(); }
+    template <class T, T* (Parser::*Parse)(Expression*)>
+    Expression* infixRule(Expression* left) { return (this->*Parse)(left); }
 
     void nextToken();
     bool curTokenIs(TokenType t) const;
@@ -66,30 +94,32 @@ private:
 
     // Parsing functions here...
 
-    std::shared_ptr<Statement> parseStatement();
-    std::shared_ptr<LetStatement> parseLetStatement();
-    std::shared_ptr<ReturnStatement> parseReturnStatement();
-    std::shared_ptr<ExpressionStatement> parseExpressionStatement();
-
-    std::shared_ptr<Expression> parseExpression(Precedence pVal);
-
-    std::shared_ptr<Identifier> parseIdentifier();
-    std::shared_ptr<IntegerLiteral> parseIntegerLiteral();
-    std::shared_ptr<StringLiteral> parseStringLiteral();
-
-    std::shared_ptr<PrefixExpression> parsePrefixExpression();
-    std::shared_ptr<InfixExpression> parseInfixExpression(std::shared_ptr<Expression> left);
-    std::shared_ptr<YOXS_AST::Boolean> parseBoolean();
-    std::shared_ptr<Expression> parseGroupedExpression();
-    std::shared_ptr<IfExpression> parseIfExpression();
-    std::shared_ptr<BlockStatement> parseBlockStatement();
-    std::shared_ptr<FunctionLiteral> parseFunctionLiteral();
-    std::vector<std::shared_ptr<Identifier>> parseFunctionParameters();     
-    std::shared_ptr<CallExpression> parseCallExpression(std::shared_ptr<Expression> function);
-    std::vector<std::shared_ptr<Expression>> parseExpressionList(const TokenType& end);
-    std::shared_ptr<ArrayLiteral> parseArrayLiteral();
-    std::shared_ptr<IndexExpression> parseIndexExpression(std::shared_ptr<Expression> left);
-    std::shared_ptr<HashLiteral> parseHashLiteral();
+    Statement* parseStatement();
+    LetStatement* parseLetStatement();
+    ReturnStatement* parseReturnStatement();
+    AssignStatement* parseAssignStatement();
+    WhileStatement* parseWhileStatement();
+    ExpressionStatement* parseExpressionStatement();
+
+    Expression* parseExpression(Precedence pVal);
+
+    Identifier* parseIdentifier();
+    IntegerLiteral* parseIntegerLiteral();
+    StringLiteral* parseStringLiteral();
+
+    PrefixExpression* parsePrefixExpression();
+    InfixExpression* parseInfixExpression(Expression* left);
+    YOXS_AST::Boolean* parseBoolean();
+    Expression* parseGroupedExpression();
+    IfExpression* parseIfExpression();
+    BlockStatement* parseBlockStatement();
+    FunctionLiteral* parseFunctionLiteral();
+    std::vector<Identifier*> parseFunctionParameters();     
+    CallExpression* parseCallExpression(Expression* function);
+    std::vector<Expression*> parseExpressionList(const TokenType& end);
+    ArrayLiteral* parseArrayLiteral();
+    IndexExpression* parseIndexExpression(Expression* left);
+    HashLiteral* parseHashLiteral();
     
 
 };
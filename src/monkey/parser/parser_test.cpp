@@ -19,7 +19,7 @@ void TestFunctionLiteralParsing();
 void TestFunctionParameterParsing();
 void TestCallExpressionParsing();
 void TestCallExpressionParameterParsing();
-bool testLetStatement(const std::shared_ptr<Statement>& s, const std::string& name);
+bool testLetStatement(Statement* s, const std::string& name);
 bool testInfixExpression(const Expression& exp, const std::variant<int, bool, std::string>& left, const std::string& operator_, const std::variant<int, bool, std::string>& right);
 bool testLiteralExpression(const Expression& exp, const std::variant<int, bool, std::string>& expected);
 bool testIntegerLiteral(const Expression& il, int value);
@@ -57,9 +57,9 @@ void TestLetStatements() {
         }
 
         // Safely extract the value from the LetStatement
-        auto letStmtPtr = dynamic_cast<LetStatement*>(program->Statements[0].get());
+        auto letStmtPtr = dynamic_cast<LetStatement*>(program->Statements[0]);
         if (!letStmtPtr) {
-            std::cerr << "Statement is not a LetStatement. Got " << typeid(program->Statements[0].get()).name() << std::endl;
+            std::cerr << "Statement is not a LetStatement. Got " << typeid(program->Statements[0]).name() << std::endl;
             return;
         }
 
@@ -91,7 +91,7 @@ void TestReturnStatements() {
         assert(program->Statements.size() == 1);
 
         const auto& stmt = program->Statements[0];
-        auto returnStmt = dynamic_cast<ReturnStatement*>(stmt.get());
+        auto returnStmt = dynamic_cast<ReturnStatement*>(stmt);
         if (!returnStmt) {
             std::cerr << "stmt not a ReturnStatement. Got " << typeid(stmt).name() << std::endl;
             return;
@@ -116,18 +116,18 @@ void TestIdentifierExpression() {
 
     assert(program->Statements.size() == 1);
 
-    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
     if (!exprStmt) {
         std::cerr << "program.Statements[0] is not ExpressionStatement. Got "
-                  << typeid(program->Statements[0].get()).name() << std::endl;
+                  << typeid(program->Statements[0]).name() << std::endl;
 
         return;
     }
 
-    const auto* ident = dynamic_cast<Identifier*>(exprStmt->expr.get());
+    const auto* ident = dynamic_cast<Identifier*>(exprStmt->expr);
     if (!ident) {
         std::cerr << "exp not Identifier. Got "
-                  << typeid(exprStmt->expr.get()).name() << std::endl;
+                  << typeid(exprStmt->expr).name() << std::endl;
         return;
     }
 
@@ -145,19 +145,19 @@ void TestIntegerLiteralExpression() {
 
     assert(program->Statements.size() == 1);
 
-    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
     if (!exprStmt) {
 
         std::cerr << "program.Statements[0] is not ExpressionStatement. Got "
-                  << typeid(program->Statements[0].get()).name() << std::endl;
+                  << typeid(program->Statements[0]).name() << std::endl;
 
         return;
     }
 
-    const auto* literal = dynamic_cast<IntegerLiteral*>(exprStmt->expr.get());
+    const auto* literal = dynamic_cast<IntegerLiteral*>(exprStmt->expr);
     if (!literal) {
         std::cerr << "exp not IntegerLiteral. Got "
-                  << typeid(exprStmt->expr.get()).name() << std::endl;
+                  << typeid(exprStmt->expr).name() << std::endl;
         return;
     }
 
@@ -192,17 +192,17 @@ void TestParsingPrefixExpressions() {
 
         assert(program->Statements.size() == 1);
 
-        const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+        const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
         if (!exprStmt) {
             std::cerr << "program.Statements[0] is not ExpressionStatement. Got "
-                      << typeid(program->Statements[0].get()).name() << std::endl;
+                      << typeid(program->Statements[0]).name() << std::endl;
             return;
         }
 
-        const auto* exp = dynamic_cast<PrefixExpression*>(exprStmt->expr.get());
+        const auto* exp = dynamic_cast<PrefixExpression*>(exprStmt->expr);
         if (!exp) {
             std::cerr << "stmt is not PrefixExpression. Got "
-                      << typeid(exprStmt->expr.get()).name() << std::endl;
+                      << typeid(exprStmt->expr).name() << std::endl;
             return;
         }
 
@@ -254,10 +254,10 @@ void TestParsingInfixExpressions() {
 
         assert(program->Statements.size() == 1);
 
-        const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+        const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
         if (!exprStmt) {
             std::cerr << "program.Statements[0] is not ExpressionStatement. Got "
-                      << typeid(program->Statements[0].get()).name() << std::endl;
+                      << typeid(program->Statements[0]).name() << std::endl;
             return;
         }
 
@@ -420,18 +420,18 @@ void TestBooleanExpression() {
             return; // This was a fatal error in Go, so we just return here.
         }
 
-        auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+        auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
         if (!exprStmt) {
             std::cerr << "program.Statements[0] is not ExpressionStatement. Got "
-                      << typeid(program->Statements[0].get()).name() << std::endl;
+                      << typeid(program->Statements[0]).name() << std::endl;
 
             return;
         }
 
-        auto* boolean = dynamic_cast<Boolean*>(exprStmt->expr.get());
+        auto* boolean = dynamic_cast<Boolean*>(exprStmt->expr);
         if (!boolean) {
             std::cerr << "exp not Boolean. Got "
-                      << typeid(exprStmt->expr.get()).name() << std::endl;
+                      << typeid(exprStmt->expr).name() << std::endl;
             return;
         }
 
@@ -456,17 +456,17 @@ void TestIfExpression() {
         return;
     }
 
-    auto* stmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+    auto* stmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
     if (!stmt) {
         std::cerr << "program.Statements[0] is not ExpressionStatement. got=" 
-                  << typeid(program->Statements[0].get()).name() << std::endl;
+                  << typeid(program->Statements[0]).name() << std::endl;
         return;
     }
 
-    auto* exp = dynamic_cast<IfExpression*>(stmt->expr.get());
+    auto* exp = dynamic_cast<IfExpression*>(stmt->expr);
     if (!exp) {
         std::cerr << "stmt.Expression is not IfExpression. got=" 
-                  << typeid(stmt->expr.get()).name() << std::endl;
+                  << typeid(stmt->expr).name() << std::endl;
         return;
     }
 
@@ -480,10 +480,10 @@ void TestIfExpression() {
         return;
     }
 
-    auto* consequence = dynamic_cast<ExpressionStatement*>(exp->Consequence->Statements[0].get());
+    auto* consequence = dynamic_cast<ExpressionStatement*>(exp->Consequence->Statements[0]);
     if (!consequence) {
         std::cerr << "Statements[0] is not ExpressionStatement. got=" 
-                  << typeid(exp->Consequence->Statements[0].get()).name() << std::endl;
+                  << typeid(exp->Consequence->Statements[0]).name() << std::endl;
         return;
     }
 
@@ -511,17 +511,17 @@ void TestIfElseExpression() {
         return;
     }
 
-    auto* stmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+    auto* stmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
     if (!stmt) {
         std::cerr << "program.Statements[0] is not ExpressionStatement. got=" 
-                  << typeid(program->Statements[0].get()).name() << std::endl;
+                  << typeid(program->Statements[0]).name() << std::endl;
         return;
     }
 
-    auto* exp = dynamic_cast<IfExpression*>(stmt->expr.get());
+    auto* exp = dynamic_cast<IfExpression*>(stmt->expr);
     if (!exp) {
         std::cerr << "stmt.Expression is not IfExpression. got=" 
-                  << typeid(stmt->expr.get()).name() << std::endl;
+                  << typeid(stmt->expr).name() << std::endl;
         return;
     }
 
@@ -535,10 +535,10 @@ void TestIfElseExpression() {
         return;
     }
 
-    auto* consequence = dynamic_cast<ExpressionStatement*>(exp->Consequence->Statements[0].get());
+    auto* consequence = dynamic_cast<ExpressionStatement*>(exp->Consequence->Statements[0]);
     if (!consequence) {
         std::cerr << "Statements[0] is not ExpressionStatement. got=" 
-                  << typeid(exp->Consequence->Statements[0].get()).name() << std::endl;
+                  << typeid(exp->Consequence->Statements[0]).name() << std::endl;
         return;
     }
 
@@ -552,10 +552,10 @@ void TestIfElseExpression() {
         return;
     }
 
-    auto* alternative = dynamic_cast<ExpressionStatement*>(exp->Alternative->Statements[0].get());
+    auto* alternative = dynamic_cast<ExpressionStatement*>(exp->Alternative->Statements[0]);
     if(!alternative) {
         std::cerr << "Statements[0] is not ast.ExpressionStatement. got="
-                  << typeid(exp->Alternative->Statements[0].get()).name() << std::endl;
+                  << typeid(exp->Alternative->Statements[0]).name() << std::endl;
     }
 
     if (!testIdentifier(*alternative->expr, "y")) {
@@ -577,17 +577,17 @@ void TestFunctionLiteralParsing() {
         return;
     }
 
-    auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+    auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
     if (!exprStmt) {
         std::cerr << "program.Statements[0] is not ExpressionStatement. Got "
-                  << typeid(program->Statements[0].get()).name() << std::endl;
+                  << typeid(program->Statements[0]).name() << std::endl;
         return;
     }
 
-    auto* function = dynamic_cast<FunctionLiteral*>(exprStmt->expr.get());
+    auto* function = dynamic_cast<FunctionLiteral*>(exprStmt->expr);
     if (!function) {
         std::cerr << "stmt.Expression is not FunctionLiteral. Got "
-                  << typeid(exprStmt->expr.get()).name() << std::endl;
+                  << typeid(exprStmt->expr).name() << std::endl;
         return;
     }
 
@@ -597,8 +597,8 @@ void TestFunctionLiteralParsing() {
         return;
     }
 
-    testLiteralExpression(*function->Parameters[0].get(), "x");
-    testLiteralExpression(*function->Parameters[1].get(), "y");
+    testLiteralExpression(*function->Parameters[0], "x");
+    testLiteralExpression(*function->Parameters[1], "y");
 
     if (function->Body->Statements.size() != 1) {
         std::cerr << "function.Body.Statements has not 1 statements. got=" 
@@ -606,14 +606,14 @@ void TestFunctionLiteralParsing() {
         return;
     }
 
-    auto* bodyStmt = dynamic_cast<ExpressionStatement*>(function->Body->Statements[0].get());
+    auto* bodyStmt = dynamic_cast<ExpressionStatement*>(function->Body->Statements[0]);
     if (!bodyStmt) {
         std::cerr << "function body stmt is not ExpressionStatement. Got "
-                  << typeid(function->Body->Statements[0].get()).name() << std::endl;
+                  << typeid(function->Body->Statements[0]).name() << std::endl;
         return;
     }
 
-    testInfixExpression(*bodyStmt->expr.get(), "x", "+", "y");
+    testInfixExpression(*bodyStmt->expr, "x", "+", "y");
 }
 
 void TestFunctionParameterParsing() {
@@ -634,13 +634,13 @@ void TestFunctionParameterParsing() {
         std::shared_ptr<Program> program = p.ParseProgram();
         checkParserErrors(p); // Assuming this function is modified for C++
 
-        auto* stmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+        auto* stmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
         if (!stmt) {
             std::cerr << "Statement is not ExpressionStatement." << std::endl;
             return;
         }
 
-        auto* function = dynamic_cast<FunctionLiteral*>(stmt->expr.get());
+        auto* function = dynamic_cast<FunctionLiteral*>(stmt->expr);
         if (!function) {
             std::cerr << "Expression is not FunctionLiteral." << std::endl;
             return;
@@ -653,7 +653,7 @@ void TestFunctionParameterParsing() {
         }
 
         for (size_t i = 0; i < tt.expectedParams.size(); ++i) {
-            testLiteralExpression(*function->Parameters[i].get(), tt.expectedParams[i]);
+            testLiteralExpression(*function->Parameters[i], tt.expectedParams[i]);
         }
     }
 }
@@ -672,21 +672,21 @@ void TestCallExpressionParsing() {
         return;
     }
 
-    auto* stmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+    auto* stmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
     if (!stmt) {
         std::cerr << "stmt is not ExpressionStatement. got=" 
-                  << typeid(program->Statements[0].get()).name() << std::endl;
+                  << typeid(program->Statements[0]).name() << std::endl;
         return;
     }
 
-    auto* exp = dynamic_cast<CallExpression*>(stmt->expr.get());
+    auto* exp = dynamic_cast<CallExpression*>(stmt->expr);
     if (!exp) {
         std::cerr << "stmt.Expression is not CallExpression. got=" 
-                  << typeid(stmt->expr.get()).name() << std::endl;
+                  << typeid(stmt->expr).name() << std::endl;
         return;
     }
 
-    if (!testIdentifier(*exp->Function.get(), "add")) {
+    if (!testIdentifier(*exp->Function, "add")) {
         return;
     }
 
@@ -695,9 +695,9 @@ void TestCallExpressionParsing() {
         return;
     }
 
-    testLiteralExpression(*exp->Arguments[0].get(), 1);
-    testInfixExpression(*exp->Arguments[1].get(), 2, "*", 3);
-    testInfixExpression(*exp->Arguments[2].get(), 4, "+", 5);
+    testLiteralExpression(*exp->Arguments[0], 1);
+    testInfixExpression(*exp->Arguments[1], 2, "*", 3);
+    testInfixExpression(*exp->Arguments[2], 4, "+", 5);
 }
 
 void TestCallExpressionParameterParsing() {
@@ -719,21 +719,21 @@ void TestCallExpressionParameterParsing() {
         std::shared_ptr<Program> program = p.ParseProgram();
         checkParserErrors(p); // Assuming this function is adapted for C++
 
-        auto* stmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+        auto* stmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
         if (!stmt) {
             std::cerr << "First statement is not an ExpressionStatement. got=" 
-                      << typeid(program->Statements[0].get()).name() << std::endl;
+                      << typeid(program->Statements[0]).name() << std::endl;
             return;
         }
 
-        auto* exp = dynamic_cast<CallExpression*>(stmt->expr.get());
+        auto* exp = dynamic_cast<CallExpression*>(stmt->expr);
         if (!exp) {
             std::cerr << "stmt.Expression is not CallExpression. got=" 
-                      << typeid(stmt->expr.get()).name() << std::endl;
+                      << typeid(stmt->expr).name() << std::endl;
             return;
         }
 
-        if (!testIdentifier(*exp->Function.get(), tt.expectedIdent)) {
+        if (!testIdentifier(*exp->Function, tt.expectedIdent)) {
             return;
         }
 
@@ -762,10 +762,10 @@ void TestStringLiteralExpression() {
 
     assert(program->Statements.size() == 1);
 
-    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
     assert(exprStmt != nullptr);
 
-    const auto* literal = dynamic_cast<StringLiteral*>(exprStmt->expr.get());
+    const auto* literal = dynamic_cast<StringLiteral*>(exprStmt->expr);
     assert(literal != nullptr);
     std::cout << "got literal: " + literal->String() << std::endl;
     assert(literal->String() == "Hello World");
@@ -781,10 +781,10 @@ void TestArrayLiteralExpression() {
 
     assert(program->Statements.size() == 1);
 
-    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
     assert(exprStmt != nullptr);
 
-    const auto* array = dynamic_cast<ArrayLiteral*>(exprStmt->expr.get());
+    const auto* array = dynamic_cast<ArrayLiteral*>(exprStmt->expr);
     assert(array != nullptr);
     assert(array->Elements.size() == 2);
     testIntegerLiteral(*array->Elements[0], 1);
@@ -801,10 +801,10 @@ void TestIndexExpressions() {
 
     assert(program->Statements.size() == 1);
 
-    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
     assert(exprStmt != nullptr);
 
-    const auto* indexExp = dynamic_cast<IndexExpression*>(exprStmt->expr.get());
+    const auto* indexExp = dynamic_cast<IndexExpression*>(exprStmt->expr);
     assert(indexExp != nullptr);
 
     testIdentifier(*indexExp->Left, "myArray");
@@ -821,28 +821,119 @@ void TestHashLiteralExpression() {
 
     assert(program->Statements.size() == 1);
 
-    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0].get());
+    const auto* exprStmt = dynamic_cast<ExpressionStatement*>(program->Statements[0]);
     assert(exprStmt != nullptr);
 
-    const auto* hash = dynamic_cast<HashLiteral*>(exprStmt->expr.get());
+    const auto* hash = dynamic_cast<HashLiteral*>(exprStmt->expr);
     assert(hash != nullptr);
     assert(hash->Pairs.size() == 1);
 
-    const auto* key = dynamic_cast<StringLiteral*>(hash->Pairs.begin()->first.get());
-    const auto* value = dynamic_cast<StringLiteral*>(hash->Pairs.begin()->second.get());
+    const auto* key = dynamic_cast<StringLiteral*>(hash->Pairs.begin()->Key);
+    const auto* value = dynamic_cast<StringLiteral*>(hash->Pairs.begin()->Value);
     assert(key != nullptr && key->String() == "key");
     assert(value != nullptr && value->String() == "value");
 }
 
-bool testLetStatement(const std::shared_ptr<Statement>& s, const std::string& name) {
+void TestWhileStatement() {
+    std::string input = "while (i < 10) { i = i + 1; x }";
+
+    Lexer l(input);
+    Parser p(l);
+    auto program = p.ParseProgram();
+    checkParserErrors(p);
+
+    assert(program->Statements.size() == 1);
+
+    const auto* loop = dynamic_cast<WhileStatement*>(program->Statements[0]);
+    assert(loop != nullptr);
+    assert(testInfixExpression(*loop->Condition, "i", "<", 10));
+    assert(loop->Body->Statements.size() == 2);
+
+    const auto* assign = dynamic_cast<AssignStatement*>(loop->Body->Statements[0]);
+    assert(assign != nullptr);
+    assert(testIdentifier(*assign->Name, "i"));
+    assert(testInfixExpression(*assign->Value, "i", "+", 1));
+    assert(program->String() == "while(i < 10) i = (i + 1);x");
+
+    // Without a following '=' an identifier still starts an expression.
+    Lexer l2("x == 1;");
+    Parser p2(l2);
+    auto program2 = p2.ParseProgram();
+    checkParserErrors(p2);
+    assert(dynamic_cast<ExpressionStatement*>(program2->Statements[0]) != nullptr);
+}
+
+// A Parser over tokens read ahead with Tokenize builds the same tree as one
+// that pulls them from the Lexer.
+void TestParseTokens() {
+    std::string input = "let add = fn(a, b) { a + b }; add(1, [2, 3][0]);";
+
+    Lexer l(input);
+    auto tokens = l.TokenizeAll();
+    Parser p(tokens);
+    auto program = p.ParseProgram();
+    checkParserErrors(p);
+
+    Lexer l2(input);
+    Parser p2(l2);
+    assert(program->String() == p2.ParseProgram()->String());
+    assert(program->Source == l.Source());
+
+    // The same buffer can be parsed again.
+    Parser again(tokens);
+    assert(again.ParseProgram()->String() == program->String());
+
+    // Errors are reported the same way, including running out of tokens.
+    Lexer l3("let x");
+    auto tokens3 = l3.TokenizeAll();
+    Parser p3(tokens3);
+    p3.ParseProgram();
+    assert(p3.Errors().size() == 1);
+    assert(p3.Errors()[0] == "expected next token to be =, got EOF instead");
+
+    // Integers come from the values the lexer read, except one too large
+    // for them, which is still an error.
+    Lexer l4("0; 00; 9223372036854775807; 12;");
+    auto tokens4 = l4.TokenizeAll();
+    Parser p4(tokens4);
+    auto ints = p4.ParseProgram();
+    checkParserErrors(p4);
+    const int64_t want[] = {0, 0, 9223372036854775807, 12};
+    for (size_t i = 0; i < 4; i++) {
+        auto stmt = dynamic_cast<ExpressionStatement*>(ints->Statements[i]);
+        auto lit = dynamic_cast<IntegerLiteral*>(stmt->expr);
+        assert(lit && lit->Value == want[i]);
+    }
+    Lexer l5("9223372036854775808");
+    auto tokens5 = l5.TokenizeAll();
+    Parser p5(tokens5);
+    p5.ParseProgram();
+    assert(p5.Errors().size() == 1);
+    assert(p5.Errors()[0] == "could not parse \"9223372036854775808\" as integer");
+}
+
+void TestPrecedenceOf() {
+    assert(PrecedenceOf(TokenType::EQ) == EQUALS);
+    assert(PrecedenceOf(TokenType::GT) == LESSGREATER);
+    assert(PrecedenceOf(TokenType::MINUS) == SUM);
+    assert(PrecedenceOf(TokenType::ASTERISK) == PRODUCT);
+    assert(PrecedenceOf(TokenType::LPAREN) == CALL);
+    assert(PrecedenceOf(TokenType::LBRACKET) == INDEX);
+    // Tokens that are not infix operators never bind.
+    assert(PrecedenceOf(TokenType::BANG) == LOWEST);
+    assert(PrecedenceOf(TokenType::WHILE) == LOWEST);
+    assert(PrecedenceOf(TokenType::EOF_TOKEN) == LOWEST);
+}
+
+bool testLetStatement(Statement* s, const std::string& name) {
     if (s->TokenLiteral() != "let") {
         std::cerr << "s.TokenLiteral not 'let'. got=" << s->TokenLiteral() << std::endl;
         return false;
     }
 
-    const LetStatement* letStmt = dynamic_cast<LetStatement*>(s.get());
+    const LetStatement* letStmt = dynamic_cast<LetStatement*>(s);
     if (!letStmt) {
-        std::cerr << "s not LetStatement. got=" << typeid(s.get()).name() << std::endl;
+        std::cerr << "s not LetStatement. got=" << typeid(s).name() << std::endl;
         return false;
     }
 
@@ -987,6 +1078,9 @@ int main() {
     TestArrayLiteralExpression();
     TestIndexExpressions();
     TestHashLiteralExpression();
+    TestWhileStatement();
+    TestParseTokens();
+    TestPrecedenceOf();
     
     std::cout << "All parser_test.cpp tests passed!" << std::endl;
     return 0;
@@ -2,7 +2,7 @@
 #include <iostream>
 #include <string>
 
-int traceLevel = 0;
+thread_local int traceLevel = 0;
 const std::string traceIdentPlaceholder = "\t";
 
 std::string identLevel() {
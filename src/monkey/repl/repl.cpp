@@ -1,4 +1,7 @@
 #include "repl.hpp"
+#include <chrono>
+#include <sstream>
+#include "../ast/ast_json.hpp"
 
 const std::string PROMPT = ">> ";
 
@@ -11,6 +14,8 @@ void REPL::tokenStart(std::istream& in, std::ostream& out){
             return; // Exit if there's an error or EOF is encountered
         }
 
+        Interner names;
+        Interner::Use use(names);
         Lexer l(line);
         for (Token tok = l.NextToken(); tok.Type != TokenType::EOF_TOKEN; tok = l.NextToken()) {
             out << TokenTypeToString(tok.Type) << ": " << tok.Literal << "\n";
@@ -27,6 +32,8 @@ void REPL::parserStart(std::istream& in, std::ostream& out){
             return; // Exit if there's an error or EOF is encountered
         }
 
+        Interner names;
+        Interner::Use use(names);
         Lexer l(line);
         Parser p(l);
         
@@ -41,8 +48,54 @@ void REPL::parserStart(std::istream& in, std::ostream& out){
     }
 }   
 
-void REPL::Start(std::istream& in, std::ostream& out) {
+std::string EngineName(Engine engine) {
+    switch (engine) {
+    case Engine::STACK: return "stack";
+    case Engine::VM: return "vm";
+    default: return "eval";
+    }
+}
+
+Session::Session(Engine engine, const ExecutionLimits& limits)
+    : engine(engine), Limits(limits), Env(std::make_shared<Environment>()),
+      Names(std::make_shared<Interner>()) {
+    if (engine == Engine::VM) {
+        // The builtins are defined the same way Compiler() defines them.
+        Symbols = std::make_shared<SymbolTable>();
+        for (size_t i = 0; i < Builtins.size(); i++) {
+            Symbols->DefineBuiltin(static_cast<int>(i), Builtins[i].Name);
+        }
+        Globals.resize(GlobalsSize);
+    }
+}
+
+// Compiles program into session. If it fails, the symbol table is put back
+// so the session never holds names bound to globals that were never set.
+static bool compileInSession(std::shared_ptr<Program> program, Session& session, Bytecode& bytecode, std::vector<std::string>& errors) {
+    SymbolTable before = *session.Symbols;
+    Compiler compiler(session.Symbols, session.Constants);
+    if (!compiler.Compile(program)) {
+        *session.Symbols = before;
+        errors = compiler.Errors();
+        return false;
+    }
+    bytecode = compiler.GetBytecode();
+    session.Constants = bytecode.Constants;
+    return true;
+}
+
+// Evaluates program in the session's environment with the session's evaluator.
+static std::shared_ptr<Object> evalInSession(std::shared_ptr<Program> program, Session& session) {
+    if (session.engine == Engine::STACK) {
+        return StackEvaluator().Eval(program, session.Env, session.Limits);
+    }
+    return Evaluator::Eval(program, session.Env, session.Limits);
+}
+
+void REPL::Start(std::istream& in, std::ostream& out, Engine engine, const ExecutionLimits& limits) {
     std::string line;
+    Session session(engine, limits);
+    Interner::Use names(*session.Names);
 
     while (true) {
         out << PROMPT;
@@ -59,16 +112,33 @@ void REPL::Start(std::istream& in, std::ostream& out) {
             continue;
         }
 
-        auto env = std::make_shared<Environment>();
-        Evaluator evaluator;
-        auto evaluated = evaluator.Eval(program, env);
+        if (engine == Engine::VM) {
+            Bytecode bytecode;
+            std::vector<std::string> errors;
+            if (!compileInSession(program, session, bytecode, errors)) {
+                printCompilerErrors(out, errors);
+                continue;
+            }
+
+            VM machine(bytecode, session.Globals);
+            if (auto err = machine.Run(session.Limits)) {
+                out << err->Inspect() << "\n";
+                continue;
+            }
+            if (auto last = machine.LastPoppedStackElem()) {
+                out << last->Inspect() << "\n";
+            }
+            continue;
+        }
+
+        auto evaluated = evalInSession(program, session);
         if(evaluated) {
             out << evaluated->Inspect() << "\n";
         }
     }
 }
 
-void REPL::StartSingle(std::istream& in, std::ostream& out) {
+void REPL::StartSingle(std::istream& in, std::ostream& out, Engine engine, const ExecutionLimits& limits) {
     std::string line;
 
     out << PROMPT;
@@ -76,37 +146,118 @@ void REPL::StartSingle(std::istream& in, std::ostream& out) {
         return; // Exit if there's an error or EOF is encountered
     }
 
-    out << "Input: " << line << "\n";
+    RunSingle(line, out, engine, nullptr, limits);
+}
+
+// Nanoseconds elapsed since start.
+static int64_t since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The limit err reports running into, if it is not a runtime error.
+static std::string limitOf(const Error& err) {
+    return err.Kind == ErrorKind::Runtime ? "" : ErrorKindToString(err.Kind);
+}
+
+// Records what a successful run produced.
+static void setResult(RunReport& r, const std::shared_ptr<Object>& value) {
+    r.Result = value->Inspect();
+    r.ResultType = ObjectTypeToString(value->Type());
+}
+
+void REPL::RunSingle(const std::string& input, std::ostream& out, Engine engine, RunReport* report, const ExecutionLimits& limits) {
+    Session session(engine, limits);
+    RunSingle(input, out, session, report);
+}
+
+void REPL::RunSingle(const std::string& input, std::ostream& out, Session& session, RunReport* report) {
+    RunReport discarded;
+    RunReport& r = report ? *report : discarded;
+    Interner::Use names(*session.Names);
+
+    out << "Input: " << input << "\n";
 
     // Lexical Analysis
     out << "Starting Lexical Analysis...\n";
-    Lexer lPrint(line);
+    auto start = std::chrono::steady_clock::now();
+    Lexer l(input);
+    auto tokens = l.TokenizeAll();
+    r.LexNs = since(start);
+    r.Tokens = tokens.Size() - 1;
     out << "Tokens:\n";
-    for (Token tok = lPrint.NextToken(); tok.Type != TokenType::EOF_TOKEN; tok = lPrint.NextToken()) {
-        out << "  " << TokenTypeToString(tok.Type) << ": '" << tok.Literal << "'\n";
+    for (size_t i = 0; i + 1 < tokens.Size(); i++) {
+        out << "  " << TokenTypeToString(tokens.Type(i)) << ": '" << tokens.Literal(i) << "'\n";
         // Add more details here if needed, like line and character position
     }
 
     // Parsing
     out << "\nStarting Parsing...\n";
-    Lexer l(line);
-    Parser p(l);
+    start = std::chrono::steady_clock::now();
+    Parser p(tokens);
     auto program = p.ParseProgram();
+    r.ParseNs = since(start);
+    r.AstNodes = program->NodeArena.ObjectCount();
     if (!p.Errors().empty()) {
+        r.Errors = p.Errors();
         printParserErrors(out, p.Errors());
         return; // Stop further processing if there are parsing errors
     }
     out << "Parsed Program (AST):\n  " << program->String() << "\n";
 
+    if (session.engine == Engine::VM) {
+        // Compilation
+        out << "\nStarting Compilation...\n";
+        Counters::Reset();
+        start = std::chrono::steady_clock::now();
+        Bytecode bytecode;
+        bool compiled = compileInSession(program, session, bytecode, r.Errors);
+        r.CompileNs = since(start);
+        if (!compiled) {
+            printCompilerErrors(out, r.Errors);
+            return;
+        }
+        out << "Bytecode:\n" << InstructionsToString(bytecode.Instructions);
+
+        // Execution
+        out << "\nStarting Evaluation...\n";
+        start = std::chrono::steady_clock::now();
+        VM machine(bytecode, session.Globals);
+        auto err = machine.Run(session.Limits);
+        r.EvalNs = since(start);
+        r.Counts = Counters::Current();
+        if (err) {
+            r.Errors.push_back(err->Message);
+            r.Limit = limitOf(*err);
+            out << "Evaluated Result: " << err->Inspect() << "\n";
+            return;
+        }
+        if (auto last = machine.LastPoppedStackElem()) {
+            setResult(r, last);
+            out << "Evaluated Result: " << r.Result << "\n";
+        } else {
+            out << "No output from evaluation.\n";
+        }
+        return;
+    }
+
     // Evaluation
     out << "\nStarting Evaluation...\n";
-    auto env = std::make_shared<Environment>();
-    Evaluator evaluator;
-    auto evaluated = evaluator.Eval(program, env);
+    Counters::Reset();
+    start = std::chrono::steady_clock::now();
+    auto evaluated = evalInSession(program, session);
+    r.EvalNs = since(start);
+    r.Counts = Counters::Current();
 
     // Displaying the environment state could be added here
 
     if(evaluated) {
+        if (evaluated->Type() == ERROR_OBJ) {
+            auto err = std::static_pointer_cast<Error>(evaluated);
+            r.Errors.push_back(err->Message);
+            r.Limit = limitOf(*err);
+        } else {
+            setResult(r, evaluated);
+        }
         out << "Evaluated Result: " << evaluated->Inspect() << "\n";
     } else {
         out << "No output from evaluation.\n";
@@ -114,6 +265,155 @@ void REPL::StartSingle(std::istream& in, std::ostream& out) {
 
 }
 
+// Runs a parsed program in session and records its result or error in r.
+static void execute(std::shared_ptr<Program> program, Session& session, RunReport& r) {
+    Counters::Reset();
+    std::shared_ptr<Object> result;
+    if (session.engine == Engine::VM) {
+        auto start = std::chrono::steady_clock::now();
+        Bytecode bytecode;
+        bool compiled = compileInSession(program, session, bytecode, r.Errors);
+        r.CompileNs = since(start);
+        if (!compiled) {
+            r.Counts = Counters::Current();
+            return;
+        }
+        start = std::chrono::steady_clock::now();
+        VM machine(bytecode, session.Globals);
+        auto err = machine.Run(session.Limits);
+        r.EvalNs = since(start);
+        result = err ? std::shared_ptr<Object>(err) : machine.LastPoppedStackElem();
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        result = evalInSession(program, session);
+        r.EvalNs = since(start);
+    }
+    r.Counts = Counters::Current();
+
+    if (result && result->Type() == ERROR_OBJ) {
+        auto err = std::static_pointer_cast<Error>(result);
+        r.Errors.push_back(err->Message);
+        r.Limit = limitOf(*err);
+    } else if (result) {
+        setResult(r, result);
+    }
+}
+
+void REPL::Run(const std::string& input, Session& session, RunReport& r) {
+    Interner::Use names(*session.Names);
+    auto start = std::chrono::steady_clock::now();
+    Lexer l(input);
+    auto tokens = l.TokenizeAll();
+    r.LexNs = since(start);
+    r.Tokens = tokens.Size() - 1;
+
+    start = std::chrono::steady_clock::now();
+    Parser p(tokens);
+    auto program = p.ParseProgram();
+    r.ParseNs = since(start);
+    r.AstNodes = program->NodeArena.ObjectCount();
+    if (!p.Errors().empty()) {
+        r.Errors = p.Errors();
+        return;
+    }
+    execute(program, session, r);
+}
+
+// Appends `,"key":` and value as a JSON string, or null if isNull.
+static void appendMember(std::string& out, const char* key, const std::string& value, bool isNull = false) {
+    out += ",\"";
+    out += key;
+    out += "\":";
+    if (isNull) {
+        out += "null";
+    } else {
+        AppendJsonString(out, value);
+    }
+}
+
+std::string REPL::RunJson(const std::string& input, Session& session) {
+    Interner::Use names(*session.Names);
+    auto begin = std::chrono::steady_clock::now();
+    RunReport r;
+
+    auto start = begin;
+    Lexer l(input);
+    auto tokens = l.TokenizeAll();
+    r.LexNs = since(start);
+    r.Tokens = tokens.Size() - 1;
+
+    start = std::chrono::steady_clock::now();
+    Parser p(tokens);
+    auto program = p.ParseProgram();
+    r.ParseNs = since(start);
+    r.AstNodes = program->NodeArena.ObjectCount();
+
+    std::ostringstream output;
+    if (p.Errors().empty()) {
+        std::ostream& previous = SetOutput(output);
+        try {
+            execute(program, session, r);
+        } catch (...) {
+            SetOutput(previous);
+            throw;
+        }
+        SetOutput(previous);
+    } else {
+        r.Errors = p.Errors();
+    }
+
+    bool ok = r.Errors.empty();
+    std::string out = ok ? "{\"ok\":true" : "{\"ok\":false";
+    out += ",\"tokens\":[";
+    for (size_t i = 0; i + 1 < tokens.Size(); i++) {
+        if (i > 0) out += ',';
+        WriteTokenJson(tokens.At(i), tokens.Offsets[i], out);
+    }
+    out += "],\"ast\":";
+    if (p.Errors().empty()) {
+        WriteJson(program.get(), out);
+    } else {
+        out += "null";
+    }
+    appendMember(out, "result", r.Result, !ok);
+    appendMember(out, "type", r.ResultType, !ok);
+    appendMember(out, "output", output.str());
+    out += ",\"errors\":[";
+    for (size_t i = 0; i < r.Errors.size(); i++) {
+        if (i > 0) out += ',';
+        AppendJsonString(out, r.Errors[i]);
+    }
+    out += ']';
+    if (!r.Limit.empty()) {
+        appendMember(out, "limit", r.Limit);
+    }
+    out += ",\"timings_ns\":{\"lex\":" + std::to_string(r.LexNs);
+    out += ",\"parse\":" + std::to_string(r.ParseNs);
+    out += ",\"compile\":" + std::to_string(r.CompileNs);
+    out += ",\"eval\":" + std::to_string(r.EvalNs);
+    out += ",\"total\":" + std::to_string(since(begin)) + "}";
+    AppendCountersJson(out, r);
+    return out + "}";
+}
+
+void AppendCountersJson(std::string& out, const RunReport& r) {
+    const RunCounters& c = r.Counts;
+    out += ",\"counters\":{\"tokens\":" + std::to_string(r.Tokens);
+    out += ",\"ast_nodes\":" + std::to_string(r.AstNodes);
+    out += ",\"steps\":" + std::to_string(c.Steps);
+    out += ",\"calls\":" + std::to_string(c.Calls);
+    out += ",\"environments\":" + std::to_string(c.Environments);
+    out += ",\"max_env_depth\":" + std::to_string(c.MaxEnvDepth);
+    out += ",\"allocated\":{";
+    bool first = true;
+    for (size_t type = 0; type < c.Allocated.size(); type++) {
+        if (c.Allocated[type] == 0) continue;
+        if (!first) out += ',';
+        first = false;
+        out += "\"" + ObjectTypeToString(static_cast<ObjectType>(type)) + "\":" + std::to_string(c.Allocated[type]);
+    }
+    out += "}}";
+}
 
 void REPL::printParserErrors(std::ostream& out, const std::vector<std::string>& errors) {
     out << "Woops! We ran into an error:\n";
@@ -121,3 +421,10 @@ void REPL::printParserErrors(std::ostream& out, const std::vector<std::string>&
         out << "\t" << msg << "\n";
     }
 }
+
+void REPL::printCompilerErrors(std::ostream& out, const std::vector<std::string>& errors) {
+    out << "Woops! Compilation failed:\n";
+    for (const auto& msg : errors) {
+        out << "\t" << msg << "\n";
+    }
+}
@@ -1,21 +1,109 @@
 #ifndef REPL_H
 #define REPL_H
 
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <vector>
 #include "../lexer/lexer.hpp"
 #include "../token/token.hpp"
 #include "../parser/parser.hpp"
 #include "../ast/ast.hpp"
 #include "../evaluator/evaluator.hpp"
+#include "../evaluator/stack_evaluator.hpp"
+#include "../compiler/compiler.hpp"
+#include "../vm/vm.hpp"
+
+// Engine selects how a parsed program is executed: walking the AST with the
+// Evaluator, walking it with the StackEvaluator, which survives recursion
+// too deep for the C++ stack, or compiling it to bytecode and running it on
+// the VM.
+enum class Engine {
+    EVAL,
+    STACK,
+    VM
+};
+
+// "eval", "stack" or "vm", as the --engine flag and the server spell it.
+std::string EngineName(Engine engine);
+
+// RunReport collects what a single run produced besides its text output:
+// the error messages from whichever stage failed and the time spent in each
+// stage, in nanoseconds. Stages that did not run are left at zero. Limit
+// names the limit that stopped the program, as ErrorKindToString spells it,
+// and is empty if none did. Result is the Inspect of the value the program
+// produced, and ResultType its ObjectType; both are empty if it failed.
+// Tokens and AstNodes count what the lexer and parser produced, not
+// counting the EOF and the Program, and Counts what the engine did.
+struct RunReport {
+    std::vector<std::string> Errors;
+    std::string Limit;
+    std::string Result;
+    std::string ResultType;
+    int64_t LexNs = 0;
+    int64_t ParseNs = 0;
+    int64_t CompileNs = 0;
+    int64_t EvalNs = 0;
+    size_t Tokens = 0;
+    size_t AstNodes = 0;
+    RunCounters Counts;
+};
+
+// Appends the counts in report to out as a "counters" member:
+//   ,"counters":{"tokens":7,"ast_nodes":5,"steps":9,"calls":1,
+//    "environments":1,"max_env_depth":2,"allocated":{"STRING":1}}
+// where allocated leaves out the types of which none were created.
+void AppendCountersJson(std::string& out, const RunReport& report);
+
+// Session is the state one input leaves behind for the next: the
+// Environment the evaluator binds names in, or the VM's symbol table,
+// constant pool and globals. Each input is lexed, parsed and run on its own,
+// so it costs only its own code; the functions earlier inputs defined keep
+// their parsed bodies alive and are called as they are. A session sticks to
+// the engine it was created with, and runs every input with its Limits.
+class Session {
+public:
+    explicit Session(Engine engine = Engine::EVAL, const ExecutionLimits& limits = {});
+
+    Engine engine;
+    ExecutionLimits Limits;
+    std::shared_ptr<Environment> Env;
+    // The identifier names every input was lexed with, current while the
+    // session runs and freed with it.
+    std::shared_ptr<Interner> Names;
+    std::shared_ptr<SymbolTable> Symbols;
+    std::vector<std::shared_ptr<Object>> Constants;
+    std::vector<std::shared_ptr<Object>> Globals;
+};
 
 class REPL {
 public:
     static void tokenStart(std::istream& in, std::ostream& out);
     static void parserStart(std::istream& in, std::ostream& out);
-    static void Start(std::istream& in, std::ostream& out);
-    static void StartSingle(std::istream& in, std::ostream& out);
+    static void Start(std::istream& in, std::ostream& out, Engine engine = Engine::EVAL, const ExecutionLimits& limits = {});
+    static void StartSingle(std::istream& in, std::ostream& out, Engine engine = Engine::EVAL, const ExecutionLimits& limits = {});
+    static void RunSingle(const std::string& input, std::ostream& out, Engine engine = Engine::EVAL, RunReport* report = nullptr,
+                          const ExecutionLimits& limits = {});
+    // Like RunSingle, but runs input in session, so it sees everything the
+    // earlier inputs defined.
+    static void RunSingle(const std::string& input, std::ostream& out, Session& session, RunReport* report = nullptr);
+    // Runs input in session like RunSingle but prints nothing, so a host
+    // that wants the result pays for no trace.
+    static void Run(const std::string& input, Session& session, RunReport& report);
+    // Runs input in session and describes every stage in one JSON document:
+    //   {"ok":true,"tokens":[{"type":"INT","literal":"1","offset":0}],
+    //    "ast":{"type":"Program",...},"result":"1","type":"INTEGER",
+    //    "output":"","errors":[],
+    //    "timings_ns":{"lex":..,"parse":..,"compile":..,"eval":..,"total":..},
+    //    "counters":{...}}
+    // in the shapes ast/ast_json.hpp gives tokens and nodes. The source is
+    // lexed once and the parser reads the same tokens. output is what puts
+    // printed. ast is null if the input does not parse, and result and
+    // type are null if the run fails; a run stopped by a limit also has
+    // "limit", as in RunReport, and counters is as AppendCountersJson writes it.
+    static std::string RunJson(const std::string& input, Session& session);
     static void printParserErrors(std::ostream& out, const std::vector<std::string>& errors);
+    static void printCompilerErrors(std::ostream& out, const std::vector<std::string>& errors);
 };
 
 #endif // REPL_H
@@ -1,6 +1,7 @@
 #include "repl.hpp"
 #include <sstream>
 #include <cassert>
+#include <cstdlib>
 
 //REPL Test: This tests the REPL (Read-Eval-Print Loop) functionality, ensuring it can read inputs, evaluate them, and print results as expected.
 
@@ -11,11 +12,21 @@ void testSimpleExpression();
 void testFunctionDefinition();
 void testLetStatements();
 void testParsingErrors();
+void testSessionREPL();
+void testRunJson();
+void testCounters();
+void testInternerScope();
+void testSameResultsOnEveryEngine();
 
 int main() {
     // This stringstream will simulate the in put for the REPL.
     testTokenREPL();
     testParserREPL();
+    testSessionREPL();
+    testRunJson();
+    testCounters();
+    testInternerScope();
+    testSameResultsOnEveryEngine();
 
     std::cout << "All repl_test.cpp tests passed!" << std::endl;
     return 0;
@@ -111,4 +122,157 @@ void testParsingErrors() {
     std::cout << "Parsing error tests passed!" << std::endl;
 }
 
+// Start keeps one Session for all its lines, so a function defined on one
+// line can be called on the next, on either engine.
+void testSessionREPL() {
+    for (Engine engine : {Engine::EVAL, Engine::STACK, Engine::VM}) {
+        std::istringstream input("let add = fn(a, b) { a + b };\nlet x = add(1, 2);\nadd(x, 10)\n");
+        std::ostringstream output;
+        REPL::Start(input, output, engine);
+        assert(output.str().find(">> 13\n") != std::string::npos);
+    }
+
+    Session session;
+    std::ostringstream output;
+    REPL::RunSingle("let counter = fn(n) { if (n == 0) { 0 } else { 1 + counter(n - 1) } };", output, session);
+    RunReport report;
+    REPL::RunSingle("counter(50)", output, session, &report);
+    assert(report.Errors.empty());
+    assert(output.str().find("Evaluated Result: 50") != std::string::npos);
+
+    std::cout << "Session REPL tests passed!" << std::endl;
+}
+
+// RunJson puts every stage of a run in one document.
+void testRunJson() {
+    for (Engine engine : {Engine::EVAL, Engine::STACK, Engine::VM}) {
+        Session session(engine);
+        std::string json = REPL::RunJson("let x = 2; puts(x); x * 3", session);
+        assert(json.find(R"({"ok":true,"tokens":[{"type":"LET","literal":"let","offset":0},)") == 0);
+        assert(json.find(R"({"type":"INT","literal":"3","offset":24}],"ast":{"type":"Program",)") != std::string::npos);
+        assert(json.find(R"("result":"6","type":"INTEGER","output":"2\n","errors":[],"timings_ns":{"lex":)") != std::string::npos);
+
+        // The session keeps x for the next run.
+        json = REPL::RunJson("x + true", session);
+        assert(json.find(R"("result":null,"type":null,"output":"","errors":["type mismatch: INTEGER + BOOLEAN"])") != std::string::npos);
+
+        json = REPL::RunJson("let = 1", session);
+        assert(json.find(R"({"ok":false,"tokens":[)") == 0);
+        assert(json.find(R"("ast":null,"result":null)") != std::string::npos);
+    }
+
+    Session limited(Engine::EVAL, ExecutionLimits{100, 0, std::chrono::nanoseconds(0)});
+    assert(REPL::RunJson("while (true) { }", limited).find(R"("limit":"steps")") != std::string::npos);
+
+    std::cout << "RunJson tests passed!" << std::endl;
+}
+
+// A run reports how much work each stage did, on every engine.
+void testCounters() {
+    const std::string input = "let f = fn(n) { if (n == 0) { [] } else { push(f(n - 1), \"x\") } }; f(3)";
+    for (Engine engine : {Engine::EVAL, Engine::STACK, Engine::VM}) {
+        Session session(engine);
+        RunReport report;
+        REPL::Run(input, session, report);
+        assert(report.Errors.empty() && report.Result == "[x, x, x]");
+        assert(report.Tokens == 38);
+        assert(report.AstNodes > 10);
+        assert(report.Counts.Steps > 0);
+        // Four calls of f and three of push.
+        assert(report.Counts.Calls == 7);
+        assert(report.Counts.Allocated[ARRAY_OBJ] == 4);
+        if (engine == Engine::VM) {
+            assert(report.Counts.Environments == 0);
+        } else {
+            // Each call's environment encloses the global one.
+            assert(report.Counts.Environments == 4);
+            assert(report.Counts.MaxEnvDepth == 2);
+        }
+
+        std::string json;
+        AppendCountersJson(json, report);
+        assert(json.find(R"(,"counters":{"tokens":38,"ast_nodes":)") == 0);
+        assert(json.find(R"("calls":7,)") != std::string::npos);
+        assert(json.find(R"("ARRAY":4)") != std::string::npos);
+    }
+
+    // A later run counts only its own work.
+    Session session;
+    RunReport first, second;
+    REPL::Run("let a = [1, 2];", session, first);
+    REPL::Run("len(a)", session, second);
+    assert(first.Counts.Allocated[ARRAY_OBJ] == 1);
+    assert(second.Counts.Allocated[ARRAY_OBJ] == 0 && second.Counts.Calls == 1);
+
+    std::cout << "Counter tests passed!" << std::endl;
+}
+
+// Each Session interns names in its own Interner and frees them with it, so
+// a server running many programs with distinct names stays flat.
+void testInternerScope() {
+    size_t live = Interner::Live();
+    for (Engine engine : {Engine::EVAL, Engine::STACK, Engine::VM}) {
+        for (int i = 0; i < 1000; i++) {
+            std::string name = "name_";
+            for (int n = i; n > 0; n /= 26) name += char('a' + n % 26);
+            Session session(engine);
+            RunReport report;
+            REPL::Run("let " + name + " = fn(x) { x + 1 }; " + name + "(" + std::to_string(i) + ")", session, report);
+            assert(report.Errors.empty() && report.Result == std::to_string(i + 1));
+        }
+        assert(Interner::Live() == live);
+    }
+
+    // A session's names grow only with the names it has not seen.
+    Session session;
+    RunReport report;
+    REPL::Run("let a = 1; let b = a + 1;", session, report);
+    size_t names = session.Names->Count();
+    REPL::Run("let a = b; let b = a * 2; b", session, report);
+    assert(report.Result == "4" && session.Names->Count() == names);
+    REPL::Run("let c = b;", session, report);
+    assert(session.Names->Count() == names + 1);
+
+    std::cout << "Interner scope tests passed!" << std::endl;
+}
+
+// Each program gives the same result, or the same error, on every engine.
+void testSameResultsOnEveryEngine() {
+    const std::vector<std::string> programs = {
+        "let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } }; fib(12)",
+        "let f = fn() { let i = 0; while (true) { if (i == 5) { return i * 10; } i = i + 1; } }; f()",
+        // Returns nested in a let's value, an operand and a loop.
+        "let g = fn() { let x = if (true) { return 5 }; x }; g()",
+        "let f = fn(a) { a }; let h = fn(b) { f(b) }; "
+        "let g = fn(c) { let x = if (c) { return f(1) }; let y = h(2); x }; g(true)",
+        "let g = fn(n) { let x = if (n > 0) { return g(n - 1) }; x }; g(3)",
+        "let g = fn() { [if (true) { return 3 }, 4][0] }; g()",
+        "let g = fn() { while (true) { let x = if (true) { return 7 }; x } }; g()",
+        "let x = if (true) { return 4 }; x; 10",
+        "let x = 1; let x = x + 1; x",
+        "9223372036854775807 + 1",
+        "-(-9223372036854775807 - 1)",
+        "1 / 0",
+        "fn(a) { a }(1, 2)",
+    };
+    for (const auto& input : programs) {
+        RunReport want;
+        Session reference(Engine::EVAL);
+        REPL::Run(input, reference, want);
+        for (Engine engine : {Engine::STACK, Engine::VM}) {
+            Session session(engine);
+            RunReport got;
+            REPL::Run(input, session, got);
+            if (got.Result != want.Result || got.Errors != want.Errors) {
+                std::cerr << "different results on " << EngineName(engine) << " for " << input << ": want="
+                          << want.Result << (want.Errors.empty() ? "" : want.Errors[0]) << ", got="
+                          << got.Result << (got.Errors.empty() ? "" : got.Errors[0]) << std::endl;
+                exit(1);
+            }
+        }
+    }
+
+    std::cout << "Same results on every engine tests passed!" << std::endl;
+}
+
 //g++ -std=c++17 -Isrc -o repl_test src/monkey/repl/repl.cpp src/monkey/lexer/lexer.cpp src/monkey/token/token.cpp src/monkey/parser/parser.cpp src/monkey/ast/ast.cpp src/monkey/object/object.cpp src/monkey/evaluator/evaluator.cpp src/monkey/object/environment.cpp src/monkey/repl/repl_test.cpp && ./repl_test
\ No newline at end of file
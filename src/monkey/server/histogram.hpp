@@ -0,0 +1,75 @@
+// histogram.hpp
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// LatencyHistogram counts durations in power-of-two buckets of
+// microseconds: bucket 0 holds everything under 1us and bucket k the
+// durations from 2^(k-1) up to 2^k us. Recording is a few relaxed atomic
+// adds, so the thread serving requests records while another reads.
+class LatencyHistogram {
+public:
+    static constexpr size_t Buckets = 40;
+
+    void Record(std::chrono::nanoseconds d) {
+        uint64_t ns = d.count() > 0 ? static_cast<uint64_t>(d.count()) : 0;
+        counts[bucketOf(ns / 1000)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        uint64_t seen = maxNs.load(std::memory_order_relaxed);
+        while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Adds other's counts to this one.
+    void Merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < Buckets; i++) {
+            counts[i].fetch_add(other.Bucket(i), std::memory_order_relaxed);
+        }
+        count.fetch_add(other.Count(), std::memory_order_relaxed);
+        uint64_t theirs = other.MaxNs(), seen = maxNs.load(std::memory_order_relaxed);
+        while (theirs > seen && !maxNs.compare_exchange_weak(seen, theirs, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t Count() const { return count.load(std::memory_order_relaxed); }
+    uint64_t Bucket(size_t i) const { return counts[i].load(std::memory_order_relaxed); }
+    uint64_t MaxNs() const { return maxNs.load(std::memory_order_relaxed); }
+
+    // The upper bound, in microseconds, of the bucket holding the q-th
+    // quantile, but no more than the longest duration recorded; 0 if
+    // nothing was recorded.
+    uint64_t QuantileUs(double q) const {
+        uint64_t total = Count();
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * total);
+        if (rank >= total) rank = total - 1;
+        uint64_t maxUs = (MaxNs() + 999) / 1000;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < Buckets - 1; i++) {
+            seen += Bucket(i);
+            if (seen > rank) return std::min(uint64_t(1) << i, maxUs);
+        }
+        return maxUs;
+    }
+
+private:
+    std::atomic<uint64_t> counts[Buckets] = {};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> maxNs{0};
+
+    static size_t bucketOf(uint64_t us) {
+        size_t bucket = 0;
+        while (us > 0 && bucket < Buckets - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+};
+
+#endif // HISTOGRAM_H
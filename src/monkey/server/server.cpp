@@ -0,0 +1,440 @@
+#include "server.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// JsonReader is just enough of a JSON parser for request objects: a flat
+// object whose members are strings, numbers, booleans or null.
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& text) : text(text) {}
+
+    bool Fail(const std::string& msg) {
+        if (error.empty()) {
+            error = msg + " at offset " + std::to_string(pos);
+        }
+        return false;
+    }
+
+    void SkipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n')) {
+            pos++;
+        }
+    }
+
+    bool Consume(char c) {
+        SkipSpace();
+        if (pos < text.size() && text[pos] == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool AtEnd() {
+        SkipSpace();
+        return pos == text.size();
+    }
+
+    bool ReadString(std::string& out) {
+        if (!Consume('"')) return Fail("expected string");
+        while (pos < text.size()) {
+            char c = text[pos++];
+            if (c == '"') return true;
+            if (static_cast<unsigned char>(c) < 0x20) return Fail("control character in string");
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= text.size()) break;
+            switch (text[pos++]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!readHex4(cp)) return false;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low;
+                    if (pos + 1 >= text.size() || text[pos] != '\\' || text[pos + 1] != 'u') return Fail("unpaired surrogate");
+                    pos += 2;
+                    if (!readHex4(low)) return false;
+                    if (low < 0xDC00 || low > 0xDFFF) return Fail("unpaired surrogate");
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default:
+                return Fail("bad escape");
+            }
+        }
+        return Fail("unterminated string");
+    }
+
+    // Reads any scalar value and returns its raw JSON text.
+    bool ReadScalar(std::string& raw) {
+        SkipSpace();
+        size_t start = pos;
+        if (pos < text.size() && text[pos] == '"') {
+            std::string ignored;
+            if (!ReadString(ignored)) return false;
+        } else {
+            while (pos < text.size() && (isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '-' || text[pos] == '+' || text[pos] == '.')) {
+                pos++;
+            }
+            std::string word = text.substr(start, pos - start);
+            bool number = !word.empty() && (isdigit(static_cast<unsigned char>(word[0])) || word[0] == '-')
+                && word.find_first_not_of("0123456789.eE+-") == std::string::npos;
+            if (word != "true" && word != "false" && word != "null" && !number) {
+                return Fail("expected a string, number, boolean or null");
+            }
+        }
+        raw = text.substr(start, pos - start);
+        return true;
+    }
+
+    std::string error;
+
+private:
+    const std::string& text;
+    size_t pos = 0;
+
+    bool readHex4(uint32_t& out) {
+        if (pos + 4 > text.size()) return Fail("short \\u escape");
+        out = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = text[pos++];
+            out <<= 4;
+            if (c >= '0' && c <= '9') out |= c - '0';
+            else if (c >= 'a' && c <= 'f') out |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') out |= c - 'A' + 10;
+            else return Fail("bad \\u escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += char(cp);
+        } else if (cp < 0x800) {
+            out += char(0xC0 | (cp >> 6));
+            out += char(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += char(0xE0 | (cp >> 12));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+        } else {
+            out += char(0xF0 | (cp >> 18));
+            out += char(0x80 | ((cp >> 12) & 0x3F));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+        }
+    }
+};
+
+std::string response(const Request& req, const std::string& output, const RunReport& report, int64_t totalNs) {
+    std::string out = "{\"id\":" + req.Id;
+    if (!req.SessionId.empty()) {
+        out += ",\"session\":\"" + Server::Escape(req.SessionId) + "\"";
+    }
+    out += ",\"ok\":";
+    out += report.Errors.empty() ? "true" : "false";
+    out += ",\"output\":\"" + Server::Escape(output) + "\"";
+    out += ",\"errors\":[";
+    for (size_t i = 0; i < report.Errors.size(); i++) {
+        if (i > 0) out += ",";
+        out += "\"" + Server::Escape(report.Errors[i]) + "\"";
+    }
+    out += "]";
+    if (!report.Limit.empty()) {
+        out += ",\"limit\":\"" + report.Limit + "\"";
+    }
+    out += ",\"timings_ns\":{\"lex\":" + std::to_string(report.LexNs);
+    out += ",\"parse\":" + std::to_string(report.ParseNs);
+    out += ",\"compile\":" + std::to_string(report.CompileNs);
+    out += ",\"eval\":" + std::to_string(report.EvalNs);
+    out += ",\"total\":" + std::to_string(totalNs) + "}";
+    AppendCountersJson(out, report);
+    return out + "}";
+}
+
+// Reads a limit from a request, which must be a whole number.
+bool readLimit(const std::string& raw, uint64_t& value) {
+    if (raw.empty() || raw.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    try {
+        value = std::stoull(raw);
+    } catch (const std::out_of_range&) {
+        value = UINT64_MAX;
+    }
+    return true;
+}
+
+bool writeAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+} // namespace
+
+bool Server::ParseRequest(const std::string& line, Engine defaultEngine, Request& req, std::string& error) {
+    req = Request();
+    req.engine = defaultEngine;
+
+    JsonReader r(line);
+    bool haveCode = false;
+    if (!r.Consume('{')) {
+        r.Fail("expected object");
+    } else if (!r.Consume('}')) {
+        do {
+            std::string key;
+            if (!r.ReadString(key) || (!r.Consume(':') && !r.Fail("expected ':'"))) break;
+            if (key == "code" || key == "engine" || key == "session") {
+                std::string value;
+                if (!r.ReadString(value)) break;
+                if (key == "code") {
+                    req.Code = value;
+                    haveCode = true;
+                } else if (key == "session") {
+                    if (value.empty()) {
+                        r.Fail("empty session");
+                        break;
+                    }
+                    req.SessionId = value;
+                } else if (value == "eval") {
+                    req.engine = Engine::EVAL;
+                    req.EngineGiven = true;
+                } else if (value == "stack") {
+                    req.engine = Engine::STACK;
+                    req.EngineGiven = true;
+                } else if (value == "vm") {
+                    req.engine = Engine::VM;
+                    req.EngineGiven = true;
+                } else {
+                    r.Fail("unknown engine \"" + value + "\"");
+                    break;
+                }
+            } else {
+                std::string raw;
+                if (!r.ReadScalar(raw)) break;
+                if (key == "id") req.Id = raw;
+                if (key == "end_session") req.EndSession = raw == "true";
+                if (key == "stats") req.Stats = raw == "true";
+                if (key == "max_steps" || key == "max_heap" || key == "timeout_ms") {
+                    uint64_t n;
+                    if (!readLimit(raw, n)) {
+                        r.Fail("\"" + key + "\" must be a whole number");
+                        break;
+                    }
+                    if (key == "max_steps") {
+                        req.Limits.MaxSteps = n;
+                    } else if (key == "max_heap") {
+                        req.Limits.MaxHeapBytes = n;
+                    } else {
+                        // Anything near the range of nanoseconds is no limit in practice.
+                        req.Limits.Timeout = std::chrono::milliseconds(std::min<uint64_t>(n, uint64_t(1) << 40));
+                    }
+                }
+            }
+        } while (r.Consume(','));
+        if (r.error.empty() && !r.Consume('}')) r.Fail("expected '}'");
+    }
+    if (r.error.empty() && !r.AtEnd()) r.Fail("trailing characters");
+    if (r.error.empty() && !haveCode && !req.Stats) r.error = "missing \"code\"";
+
+    error = r.error;
+    return error.empty();
+}
+
+std::string Server::Escape(const std::string& s) {
+    static const char hex[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(s.size() + 16);
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += "\\u00";
+                out += hex[(c >> 4) & 0xF];
+                out += hex[c & 0xF];
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+Session* Server::sessionFor(const Request& req, std::string& error) {
+    auto it = sessions.find(req.SessionId);
+    if (it != sessions.end()) {
+        if (req.EngineGiven && req.engine != it->second->engine) {
+            error = "session \"" + req.SessionId + "\" runs on the " +
+                    EngineName(it->second->engine) + " engine";
+            return nullptr;
+        }
+        return it->second.get();
+    }
+    if (sessions.size() >= MaxSessions) {
+        error = "too many sessions";
+        return nullptr;
+    }
+    auto session = std::make_unique<Session>(req.engine, limits);
+    Session* s = session.get();
+    sessions.emplace(req.SessionId, std::move(session));
+    return s;
+}
+
+std::string Server::Handle(const std::string& line) {
+    auto start = std::chrono::steady_clock::now();
+    Request req;
+    std::string error;
+    RunReport report;
+    std::ostringstream output;
+
+    if (!ParseRequest(line, defaultEngine, req, error)) {
+        report.Errors.push_back("bad request: " + error);
+    } else if (req.Stats) {
+        return StatsResponse(req.Id, latency, 1);
+    } else {
+        ExecutionLimits runLimits = Tighter(limits, req.Limits);
+        Session* session = nullptr;
+        if (!req.SessionId.empty() && !(session = sessionFor(req, error))) {
+            report.Errors.push_back("bad request: " + error);
+        } else {
+            // puts writes into the response rather than onto the protocol stream.
+            std::ostream& previous = SetOutput(output);
+            if (session) {
+                session->Limits = runLimits;
+                REPL::RunSingle(req.Code, output, *session, &report);
+            } else {
+                REPL::RunSingle(req.Code, output, req.engine, &report, runLimits);
+            }
+            SetOutput(previous);
+        }
+        if (req.EndSession) {
+            sessions.erase(req.SessionId);
+        }
+    }
+
+    auto total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    latency.Record(total);
+    return response(req, output.str(), report, total.count());
+}
+
+std::string Server::StatsResponse(const std::string& id, const LatencyHistogram& latency, size_t workers) {
+    std::string out = "{\"id\":" + id + ",\"ok\":true,\"stats\":{\"requests\":" + std::to_string(latency.Count());
+    out += ",\"workers\":" + std::to_string(workers);
+    out += ",\"latency_us\":{\"p50\":" + std::to_string(latency.QuantileUs(0.5));
+    out += ",\"p90\":" + std::to_string(latency.QuantileUs(0.9));
+    out += ",\"p99\":" + std::to_string(latency.QuantileUs(0.99));
+    out += ",\"max\":" + std::to_string(latency.MaxNs() / 1000);
+    out += ",\"buckets\":[";
+    size_t used = LatencyHistogram::Buckets;
+    while (used > 0 && latency.Bucket(used - 1) == 0) used--;
+    for (size_t i = 0; i < used; i++) {
+        if (i > 0) out += ",";
+        out += std::to_string(latency.Bucket(i));
+    }
+    out += "]}}}";
+    return out;
+}
+
+void Server::Serve(std::istream& in, std::ostream& out) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        out << Handle(line) << std::endl;
+    }
+}
+
+int Server::Listen(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "socket path too long: " << path << std::endl;
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "socket: " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listener, 64) < 0) {
+        std::cerr << "bind " << path << ": " << std::strerror(errno) << std::endl;
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+void Server::ServeConnection(int fd, const std::function<std::string(const std::string&)>& handle) {
+    std::string pending;
+    char buf[64 * 1024];
+    while (true) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        pending.append(buf, n);
+
+        size_t lineStart = 0;
+        for (size_t nl; (nl = pending.find('\n', lineStart)) != std::string::npos; lineStart = nl + 1) {
+            std::string line = pending.substr(lineStart, nl - lineStart);
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            if (!writeAll(fd, handle(line) + "\n")) {
+                return;
+            }
+        }
+        pending.erase(0, lineStart);
+    }
+}
+
+int Server::ServeSocket(const std::string& path) {
+    int listener = Listen(path);
+    if (listener < 0) {
+        return 1;
+    }
+    while (true) {
+        int conn = accept(listener, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "accept: " << std::strerror(errno) << std::endl;
+            close(listener);
+            return 1;
+        }
+        ServeConnection(conn, [this](const std::string& line) { return Handle(line); });
+        close(conn);
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "../repl/repl.hpp"
+#include "histogram.hpp"
+
+// Request is one decoded line of the server protocol.
+struct Request {
+    std::string Id = "null"; // the raw JSON of the "id" member, echoed back unchanged
+    std::string Code;
+    Engine engine = Engine::EVAL;
+    bool EngineGiven = false;  // whether the request named an engine
+    std::string SessionId;     // empty for a one-off request
+    bool EndSession = false;
+    ExecutionLimits Limits;    // the request's own limits; they can only tighten the server's
+    bool Stats = false;        // a request for the server's statistics instead of a program
+};
+
+// Server keeps monkey_repl alive between programs. Each request is a single
+// line holding a JSON object such as
+//   {"id": 1, "code": "let x = 5; x * 2", "engine": "vm"}
+// and is answered with a single line
+//   {"id": 1, "ok": true, "output": "...", "errors": [],
+//    "timings_ns": {"lex": 0, "parse": 0, "compile": 0, "eval": 0, "total": 0},
+//    "counters": {"tokens": 9, "ast_nodes": 6, "steps": 8, ...}}
+// where output is what StartSingle would have printed for the code and
+// counters is as AppendCountersJson writes it. A
+// request runs against a fresh Environment, so nothing leaks between them,
+// unless it names a session:
+//   {"id": 2, "session": "s1", "code": "let add = fn(a, b) { a + b };"}
+//   {"id": 3, "session": "s1", "code": "add(1, 2)"}
+// Requests with the same session share one REPL Session, created by the
+// first of them with its engine, and the response echoes "session". Adding
+// "end_session": true drops the session once the request has run.
+//
+// Every program runs under the server's ExecutionLimits. One that hits a
+// limit fails like any other, and its response also carries
+//   "limit": "steps" | "heap" | "timeout" | "stack"
+// so a client can tell a runaway program from a broken one. The server
+// itself carries on with the next request. A request can lower the limits
+// for itself with "max_steps", "max_heap" (bytes) and "timeout_ms".
+//
+//   {"id": 4, "stats": true}
+// is answered with the number of programs run and their latency, as
+// StatsResponse describes.
+class Server {
+public:
+    // Sessions beyond this are refused until others are ended.
+    static constexpr size_t MaxSessions = 1024;
+
+    explicit Server(Engine engine = Engine::EVAL, const ExecutionLimits& limits = {}) : defaultEngine(engine), limits(limits) {}
+
+    // Answers one request line. The result has no trailing newline.
+    std::string Handle(const std::string& line);
+
+    // Answers requests read from in until EOF, flushing after each response.
+    void Serve(std::istream& in, std::ostream& out);
+
+    // Listens on a Unix domain socket at path and serves its connections one
+    // after another. Sessions outlive connections. Only returns if the
+    // socket cannot be set up.
+    int ServeSocket(const std::string& path);
+
+    size_t SessionCount() const { return sessions.size(); }
+    // The time each program took to handle, parsing the request included.
+    const LatencyHistogram& Latency() const { return latency; }
+
+    static bool ParseRequest(const std::string& line, Engine defaultEngine, Request& req, std::string& error);
+    static std::string Escape(const std::string& s);
+    // The answer to a stats request:
+    //   {"id": 4, "ok": true, "stats": {"requests": 10, "workers": 1,
+    //    "latency_us": {"p50": 64, "p90": 128, "p99": 1024, "max": 913, "buckets": [0, 0, 3, ...]}}}
+    // The quantiles are the upper bounds of LatencyHistogram buckets, and
+    // buckets holds its counts up to the last one in use.
+    static std::string StatsResponse(const std::string& id, const LatencyHistogram& latency, size_t workers);
+
+    // Binds and listens on a Unix domain socket at path, replacing any file
+    // there. Returns the listening descriptor, or -1 after reporting why.
+    static int Listen(const std::string& path);
+    // Reads request lines from fd until EOF and writes back handle's answer
+    // to each, in order. Blank lines are skipped.
+    static void ServeConnection(int fd, const std::function<std::string(const std::string&)>& handle);
+
+private:
+    Engine defaultEngine;
+    ExecutionLimits limits;
+    LatencyHistogram latency;
+    std::unordered_map<std::string, std::unique_ptr<Session>> sessions;
+
+    // The session req names, created if needed, or nullptr with error set.
+    Session* sessionFor(const Request& req, std::string& error);
+};
+
+#endif // SERVER_H
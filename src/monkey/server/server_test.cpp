@@ -0,0 +1,311 @@
+#include "server.hpp"
+#include <sstream>
+#include <string>
+#include <vector>
+
+//Server Test: This tests the request/response protocol of monkey_repl --server.
+
+bool contains(const std::string& haystack, const std::string& needle) {
+    return haystack.find(needle) != std::string::npos;
+}
+
+void TestParseRequest() {
+    struct TestCase {
+        std::string line;
+        bool ok;
+        std::string id;
+        std::string code;
+        Engine engine;
+    };
+    std::vector<TestCase> tests = {
+        {R"({"id": 7, "code": "1 + 2"})", true, "7", "1 + 2", Engine::EVAL},
+        {R"({"code":"x","id":"abc","engine":"vm"})", true, "\"abc\"", "x", Engine::VM},
+        {R"({"code": "x", "engine": "stack"})", true, "null", "x", Engine::STACK},
+        {R"( {"code": "a\nb\t\"c\"\\ é😀", "extra": null} )", true, "null", "a\nb\t\"c\"\\ \xc3\xa9\xf0\x9f\x98\x80", Engine::EVAL},
+        {R"({"id": 1})", false, "1", "", Engine::EVAL},
+        {R"({"code": "x", "engine": "jit"})", false, "null", "x", Engine::EVAL},
+        {R"({"code": "x")", false, "null", "x", Engine::EVAL},
+        {R"({"code": "x"} trailing)", false, "null", "x", Engine::EVAL},
+        {R"({"id": nope, "code": "x"})", false, "null", "", Engine::EVAL},
+        {"not json", false, "null", "", Engine::EVAL},
+    };
+
+    for (const auto& tt : tests) {
+        Request req;
+        std::string error;
+        bool ok = Server::ParseRequest(tt.line, Engine::EVAL, req, error);
+        if (ok != tt.ok) {
+            std::cerr << "ParseRequest(" << tt.line << ") ok=" << ok << ", want " << tt.ok << " (" << error << ")" << std::endl;
+            exit(1);
+        }
+        if (ok && (req.Id != tt.id || req.Code != tt.code || req.engine != tt.engine)) {
+            std::cerr << "ParseRequest(" << tt.line << ") got id=" << req.Id << " code=" << req.Code << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << "TestParseRequest passed!" << std::endl;
+}
+
+void TestEscape() {
+    std::string got = Server::Escape(std::string("a\"b\\c\nd\x01", 8));
+    std::string want = "a\\\"b\\\\c\\nd\\u0001";
+    if (got != want) {
+        std::cerr << "Escape: got " << got << ", want " << want << std::endl;
+        exit(1);
+    }
+    std::cout << "TestEscape passed!" << std::endl;
+}
+
+void TestHandle() {
+    Server server;
+
+    std::string resp = server.Handle(R"j({"id": 1, "code": "let x = 5; puts(x * 2); x"})j");
+    if (!contains(resp, R"("id":1,"ok":true)") || !contains(resp, "Starting Evaluation...\\n10\\n") ||
+        !contains(resp, "Evaluated Result: 5") || !contains(resp, R"("errors":[])") || !contains(resp, R"("timings_ns":{"lex":)") ||
+        !contains(resp, R"("counters":{"tokens":13,"ast_nodes":11,"steps":)") || !contains(resp, R"("calls":1,)")) {
+        std::cerr << "unexpected response: " << resp << std::endl;
+        exit(1);
+    }
+
+    // Each request gets a fresh Environment, so x from the last one is gone.
+    resp = server.Handle(R"({"id": 2, "code": "x"})");
+    if (!contains(resp, R"("ok":false)") || !contains(resp, R"("errors":["identifier not found: x"])")) {
+        std::cerr << "environment leaked between requests: " << resp << std::endl;
+        exit(1);
+    }
+
+    resp = server.Handle(R"({"id": 3, "code": "let", "engine": "vm"})");
+    if (!contains(resp, R"("ok":false)") || !contains(resp, "Woops! We ran into an error")) {
+        std::cerr << "parse error not reported: " << resp << std::endl;
+        exit(1);
+    }
+
+    resp = server.Handle(R"j({"id": 4, "code": "fn(a) { a * 3 }(4)", "engine": "vm"})j");
+    if (!contains(resp, R"("ok":true)") || !contains(resp, "Bytecode:") || !contains(resp, "Evaluated Result: 12")) {
+        std::cerr << "vm request failed: " << resp << std::endl;
+        exit(1);
+    }
+
+    // Programs that leave no value on the VM answer with no result rather
+    // than taking the server down.
+    for (const char* req : {R"({"id": 41, "code": "", "engine": "vm"})", R"({"id": 42, "code": "let x = 1;", "engine": "vm"})"}) {
+        resp = server.Handle(req);
+        if (!contains(resp, R"("ok":true)") || !contains(resp, "No output from evaluation.") || contains(resp, "Evaluated Result")) {
+            std::cerr << "vm request without a result failed: " << resp << std::endl;
+            exit(1);
+        }
+    }
+
+    // Recursion this deep would overflow the C++ stack in the Evaluator.
+    resp = server.Handle(R"j({"id": 5, "engine": "stack", "code": "let f = fn(n) { 1 + f(n + 1) }; f(0)"})j");
+    if (!contains(resp, R"("ok":false)") || !contains(resp, "stack overflow at depth 100000") || !contains(resp, R"("limit":"stack")")) {
+        std::cerr << "stack request failed: " << resp << std::endl;
+        exit(1);
+    }
+
+    resp = server.Handle("{");
+    if (!contains(resp, R"({"id":null,"ok":false,"output":"","errors":["bad request: )")) {
+        std::cerr << "bad request not rejected: " << resp << std::endl;
+        exit(1);
+    }
+    std::cout << "TestHandle passed!" << std::endl;
+}
+
+void TestServe() {
+    std::stringstream in;
+    in << R"({"id": "a", "code": "1 + 1"})" << "\n\n";
+    in << R"j({"id": "b", "code": "puts(\"hi\")"})j" << "\n";
+    std::stringstream out;
+
+    Server().Serve(in, out);
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(out, line)) {
+        lines.push_back(line);
+    }
+    if (lines.size() != 2 || !contains(lines[0], R"("id":"a")") || !contains(lines[0], "Evaluated Result: 2") ||
+        !contains(lines[1], R"("id":"b")") || !contains(lines[1], "Starting Evaluation...\\nhi\\n")) {
+        std::cerr << "unexpected Serve output: " << out.str() << std::endl;
+        exit(1);
+    }
+    std::cout << "TestServe passed!" << std::endl;
+}
+
+void TestSessions() {
+    Server server;
+
+    std::string resp = server.Handle(R"j({"id": 1, "session": "s1", "code": "let add = fn(a, b) { a + b }; let x = 40;"})j");
+    if (!contains(resp, R"({"id":1,"session":"s1","ok":true)")) {
+        std::cerr << "session request failed: " << resp << std::endl;
+        exit(1);
+    }
+
+    // The follow-up only carries the new code; add and x come from the session.
+    resp = server.Handle(R"j({"id": 2, "session": "s1", "code": "add(x, 2)"})j");
+    if (!contains(resp, R"("ok":true)") || !contains(resp, "Evaluated Result: 42") || contains(resp, "'let'")) {
+        std::cerr << "session state lost: " << resp << std::endl;
+        exit(1);
+    }
+
+    // Another session and one-off requests do not see it.
+    resp = server.Handle(R"j({"id": 3, "session": "s2", "code": "x"})j");
+    if (!contains(resp, R"("errors":["identifier not found: x"])")) {
+        std::cerr << "sessions not isolated: " << resp << std::endl;
+        exit(1);
+    }
+    resp = server.Handle(R"j({"id": 4, "code": "x"})j");
+    if (!contains(resp, R"("ok":false)")) {
+        std::cerr << "session leaked into a one-off request: " << resp << std::endl;
+        exit(1);
+    }
+
+    resp = server.Handle(R"j({"id": 5, "session": "v", "engine": "vm", "code": "let double = fn(a) { a * 2 };"})j");
+    resp = server.Handle(R"j({"id": 6, "session": "v", "code": "let y = double(21);"})j");
+    resp = server.Handle(R"j({"id": 7, "session": "v", "code": "y"})j");
+    if (!contains(resp, R"("ok":true)") || !contains(resp, "Evaluated Result: 42")) {
+        std::cerr << "vm session state lost: " << resp << std::endl;
+        exit(1);
+    }
+    resp = server.Handle(R"j({"id": 71, "session": "v", "code": ""})j");
+    if (!contains(resp, R"("ok":true)") || !contains(resp, "No output from evaluation.")) {
+        std::cerr << "empty vm session request failed: " << resp << std::endl;
+        exit(1);
+    }
+    // A compile error leaves the session as it was.
+    resp = server.Handle(R"j({"id": 8, "session": "v", "code": "let z = nope;"})j");
+    resp = server.Handle(R"j({"id": 9, "session": "v", "code": "z"})j");
+    if (!contains(resp, R"("errors":["identifier not found: z"])")) {
+        std::cerr << "failed compile left z defined: " << resp << std::endl;
+        exit(1);
+    }
+    resp = server.Handle(R"j({"id": 10, "session": "v", "engine": "eval", "code": "y"})j");
+    if (!contains(resp, R"("ok":false)") || !contains(resp, "runs on the vm engine")) {
+        std::cerr << "engine switch not rejected: " << resp << std::endl;
+        exit(1);
+    }
+
+    if (server.SessionCount() != 3) {
+        std::cerr << "SessionCount: got " << server.SessionCount() << ", want 3" << std::endl;
+        exit(1);
+    }
+    server.Handle(R"j({"id": 11, "session": "s1", "code": "1", "end_session": true})j");
+    resp = server.Handle(R"j({"id": 12, "session": "s1", "code": "x"})j");
+    if (server.SessionCount() != 3 || !contains(resp, R"("ok":false)")) {
+        std::cerr << "end_session did not drop the session: " << resp << std::endl;
+        exit(1);
+    }
+    std::cout << "TestSessions passed!" << std::endl;
+}
+
+void TestLimits() {
+    ExecutionLimits limits;
+    limits.MaxSteps = 100000;
+    limits.MaxHeapBytes = 1 << 20;
+    limits.Timeout = std::chrono::seconds(10);
+    Server server(Engine::EVAL, limits);
+
+    struct TestCase {
+        std::string line;
+        std::string limit;
+    };
+    std::vector<TestCase> tests = {
+        {R"({"id": 1, "code": "while (true) { }"})", "steps"},
+        {R"({"id": 2, "code": "while (true) { }", "engine": "stack"})", "steps"},
+        {R"({"id": 3, "code": "while (true) { }", "engine": "vm"})", "steps"},
+        {R"j({"id": 4, "code": "let s = \"ab\"; while (true) { s = s + s; }"})j", "heap"},
+        {R"j({"id": 5, "session": "s", "code": "let a = []; while (true) { a = push(a, a); }"})j", "heap"},
+    };
+    for (const auto& tt : tests) {
+        std::string resp = server.Handle(tt.line);
+        if (!contains(resp, R"("ok":false)") || !contains(resp, R"("limit":")" + tt.limit + "\"")) {
+            std::cerr << "limit not reported for " << tt.line << ": " << resp << std::endl;
+            exit(1);
+        }
+    }
+
+    // The session that hit a limit keeps working, and runtime errors carry no limit.
+    std::string resp = server.Handle(R"({"id": 6, "session": "s", "code": "len(a) > 0"})");
+    if (!contains(resp, R"("ok":true)") || !contains(resp, "Evaluated Result: true")) {
+        std::cerr << "session unusable after a limit: " << resp << std::endl;
+        exit(1);
+    }
+    resp = server.Handle(R"({"id": 7, "code": "1 + true"})");
+    if (!contains(resp, R"("ok":false)") || contains(resp, R"("limit")")) {
+        std::cerr << "runtime error reported as a limit: " << resp << std::endl;
+        exit(1);
+    }
+
+    // A request can tighten the server's limits but not loosen them.
+    resp = server.Handle(R"({"id": 8, "code": "let i = 0; while (i < 1000) { i = i + 1; }", "max_steps": 50})");
+    if (!contains(resp, R"("limit":"steps")") || !contains(resp, "step limit of 50 exceeded")) {
+        std::cerr << "request max_steps not applied: " << resp << std::endl;
+        exit(1);
+    }
+    resp = server.Handle(R"({"id": 9, "code": "while (true) { }", "max_steps": 99999999999})");
+    if (!contains(resp, "step limit of 100000 exceeded")) {
+        std::cerr << "request loosened the server's max_steps: " << resp << std::endl;
+        exit(1);
+    }
+    resp = server.Handle(R"({"id": 10, "session": "s", "code": "let n = 0; while (n < 1000) { n = n + 1; }", "max_steps": 50})");
+    if (!contains(resp, R"("limit":"steps")")) {
+        std::cerr << "request max_steps not applied to a session: " << resp << std::endl;
+        exit(1);
+    }
+    resp = server.Handle(R"({"id": 11, "session": "s", "code": "let m = 0; while (m < 1000) { m = m + 1; }; m"})");
+    if (!contains(resp, "Evaluated Result: 1000")) {
+        std::cerr << "request max_steps outlived its request: " << resp << std::endl;
+        exit(1);
+    }
+    std::cout << "TestLimits passed!" << std::endl;
+}
+
+void TestStats() {
+    Request req;
+    std::string error;
+    for (const char* bad : {R"({"code": "x", "max_steps": -1})", R"({"code": "x", "timeout_ms": 1.5})", R"({"code": "x", "max_heap": "1"})"}) {
+        if (Server::ParseRequest(bad, Engine::EVAL, req, error)) {
+            std::cerr << "ParseRequest(" << bad << ") accepted a bad limit" << std::endl;
+            exit(1);
+        }
+    }
+    if (!Server::ParseRequest(R"({"id": 1, "stats": true})", Engine::EVAL, req, error) || !req.Stats) {
+        std::cerr << "ParseRequest rejected a stats request: " << error << std::endl;
+        exit(1);
+    }
+
+    Server server;
+    server.Handle(R"({"id": 1, "code": "1 + 1"})");
+    server.Handle(R"({"id": 2, "code": "1 + true"})");
+    std::string resp = server.Handle(R"({"id": 3, "stats": true})");
+    for (const char* want : {R"({"id":3,"ok":true,"stats":{"requests":2,"workers":1,)", R"("p50":)", R"("p99":)", R"("buckets":[)"}) {
+        if (!contains(resp, want)) {
+            std::cerr << "stats response missing " << want << ": " << resp << std::endl;
+            exit(1);
+        }
+    }
+
+    LatencyHistogram h;
+    h.Record(std::chrono::nanoseconds(500));
+    h.Record(std::chrono::microseconds(3));
+    h.Record(std::chrono::microseconds(3));
+    h.Record(std::chrono::milliseconds(1));
+    if (h.Count() != 4 || h.Bucket(0) != 1 || h.Bucket(2) != 2 || h.QuantileUs(0.5) != 4 || h.QuantileUs(1) != 1000 ||
+        h.MaxNs() != 1000000) {
+        std::cerr << "LatencyHistogram: count=" << h.Count() << " p50=" << h.QuantileUs(0.5) << " p100=" << h.QuantileUs(1) << std::endl;
+        exit(1);
+    }
+    std::cout << "TestStats passed!" << std::endl;
+}
+
+int main() {
+    TestParseRequest();
+    TestEscape();
+    TestHandle();
+    TestSessions();
+    TestServe();
+    TestLimits();
+    TestStats();
+    std::cout << "All server_test.cpp tests passed!" << std::endl;
+    return 0;
+}
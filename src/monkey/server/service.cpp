@@ -0,0 +1,149 @@
+// service.cpp
+#include "service.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+Service::Service(size_t count, Engine engine, const ExecutionLimits& limits) : engine(engine), limits(limits) {
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < count; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (auto& w : workers) {
+        Worker* worker = w.get();
+        worker->thread = std::thread([this, worker] { run(*worker); });
+    }
+    // Stats read every worker's Server, so wait until they all have one.
+    std::unique_lock<std::mutex> lock(mu);
+    started.wait(lock, [this] {
+        return std::all_of(workers.begin(), workers.end(), [](const auto& w) { return w->server != nullptr; });
+    });
+}
+
+Service::~Service() {
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (auto& w : workers) {
+        w->thread.join();
+    }
+}
+
+std::string Service::Handle(const std::string& line) {
+    // Parsed here only to route it; the worker's Server parses it again and
+    // answers malformed requests itself.
+    Request req;
+    std::string error;
+    bool parsed = Server::ParseRequest(line, engine, req, error);
+    if (parsed && req.Stats) {
+        return stats(req.Id);
+    }
+
+    Job job{line, {}};
+    auto answer = job.answer.get_future();
+    bool pinned = parsed && !req.SessionId.empty();
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if (pinned) {
+            workers[std::hash<std::string>{}(req.SessionId) % workers.size()]->pinned.push_back(std::move(job));
+        } else {
+            shared.push_back(std::move(job));
+        }
+    }
+    // Any waiting worker can take a shared job, but only one can take a
+    // pinned job and there is no waking a particular one.
+    if (pinned) {
+        ready.notify_all();
+    } else {
+        ready.notify_one();
+    }
+    return answer.get();
+}
+
+void Service::run(Worker& worker) {
+    // Everything this worker runs lives in this Server, on this thread.
+    Server server(engine, limits);
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        worker.server = &server;
+    }
+    started.notify_all();
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            ready.wait(lock, [&] { return stopping || !worker.pinned.empty() || !shared.empty(); });
+            if (!worker.pinned.empty()) {
+                job = std::move(worker.pinned.front());
+                worker.pinned.pop_front();
+            } else if (!shared.empty()) {
+                job = std::move(shared.front());
+                shared.pop_front();
+            } else {
+                worker.server = nullptr;
+                return;
+            }
+        }
+        job.answer.set_value(server.Handle(job.line));
+    }
+}
+
+std::string Service::stats(const std::string& id) {
+    LatencyHistogram total;
+    for (const auto& w : workers) {
+        total.Merge(w->server->Latency());
+    }
+    return Server::StatsResponse(id, total, workers.size());
+}
+
+int Service::ServeSocket(const std::string& path) {
+    int listener = Server::Listen(path);
+    if (listener < 0) {
+        return 1;
+    }
+    while (true) {
+        int conn = accept(listener, nullptr, nullptr);
+        if (conn < 0) {
+            int err = errno;
+            if (err == EINTR || err == ECONNABORTED) continue;
+            std::cerr << "accept: " << std::strerror(err) << std::endl;
+            if (err == EMFILE || err == ENFILE) {
+                // Out of descriptors: wait for connections to close.
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            close(listener);
+            // The connections still open use this Service; let them finish.
+            std::unique_lock<std::mutex> lock(mu);
+            closed.wait(lock, [this] { return connections == 0; });
+            return 1;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            if (connections >= MaxConnections) {
+                close(conn);
+                continue;
+            }
+            connections++;
+        }
+        std::thread([this, conn] {
+            Server::ServeConnection(conn, [this](const std::string& line) { return Handle(line); });
+            close(conn);
+            // Notified under the lock, so ServeSocket cannot return and the
+            // Service go away before this thread is done with it.
+            std::lock_guard<std::mutex> lock(mu);
+            connections--;
+            closed.notify_all();
+        }).detach();
+    }
+}
@@ -0,0 +1,79 @@
+// service.hpp
+#ifndef SERVICE_H
+#define SERVICE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "server.hpp"
+
+// Service answers the Server protocol from a fixed pool of worker threads,
+// so one process can keep every core busy. Each worker owns a Server, and
+// with it the sessions, environments and Heap of everything it runs, so
+// workers never share interpreter state. A request that names a session
+// always goes to the worker that session hashes to, where its values live;
+// any idle worker takes the rest.
+//
+// A stats request is answered by the Service itself, with the latency of
+// every worker merged.
+class Service {
+public:
+    // Connections beyond this are closed as soon as they are accepted.
+    static constexpr size_t MaxConnections = 256;
+
+    // Starts workers threads, 0 meaning one per core.
+    explicit Service(size_t workers = 0, Engine engine = Engine::EVAL, const ExecutionLimits& limits = {});
+    // Finishes the requests already queued, then stops the workers.
+    ~Service();
+
+    Service(const Service&) = delete;
+    Service& operator=(const Service&) = delete;
+
+    // Answers one request line on a worker and waits for the answer. Safe to
+    // call from any number of threads.
+    std::string Handle(const std::string& line);
+
+    // Listens on a Unix domain socket at path and serves every connection
+    // on a thread of its own, so requests on different connections run in
+    // parallel and the answers on one connection come back in order. Only
+    // returns if the socket cannot be set up or accepting fails, once the
+    // open connections have closed.
+    int ServeSocket(const std::string& path);
+
+    size_t Workers() const { return workers.size(); }
+
+private:
+    struct Job {
+        std::string line;
+        std::promise<std::string> answer;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::deque<Job> pinned;           // requests for this worker's sessions
+        const Server* server = nullptr;   // set by the worker once it is running
+    };
+
+    Engine engine;
+    ExecutionLimits limits;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex mu;
+    std::condition_variable ready;       // a job was queued, or the service is stopping
+    std::condition_variable started;     // a worker has set its server
+    std::condition_variable closed;      // a connection has closed
+    std::deque<Job> shared;              // requests any worker can take
+    bool stopping = false;
+    size_t connections = 0;
+
+    void run(Worker& worker);
+    std::string stats(const std::string& id);
+};
+
+#endif // SERVICE_H
@@ -0,0 +1,174 @@
+#include "service.hpp"
+#include <atomic>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+//Service Test: This tests monkey_server's worker pool, which answers the
+//Server protocol from many threads at once.
+
+bool contains(const std::string& haystack, const std::string& needle) {
+    return haystack.find(needle) != std::string::npos;
+}
+
+// Runs body(t) on each of n threads and waits for them.
+template <class F> void parallel(int n, F body) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n; t++) {
+        threads.emplace_back(body, t);
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+}
+
+void TestConcurrentRequests() {
+    Service service(4);
+    std::atomic<int> failures{0};
+    parallel(8, [&](int t) {
+        for (int i = 0; i < 50; i++) {
+            // Each request allocates, collects and prints, all of which
+            // touch state that used to be process-wide.
+            std::string n = std::to_string(t * 1000 + i);
+            std::string code = "let f = fn(x) { let a = [x, x * 2]; puts(a[1]); a }; len(f(" + n + ")) + " + n;
+            std::string resp = service.Handle(R"({"id": )" + n + R"(, "code": ")" + code + R"(", "engine": ")" +
+                                              (i % 3 == 0 ? "eval" : i % 3 == 1 ? "stack" : "vm") + R"("})");
+            std::string want = "Evaluated Result: " + std::to_string(t * 1000 + i + 2);
+            std::string printed = "Starting Evaluation...\\n" + std::to_string((t * 1000 + i) * 2) + "\\n";
+            if (!contains(resp, R"({"id":)" + n + ",") || !contains(resp, want) || !contains(resp, printed)) {
+                if (failures++ == 0) {
+                    std::cerr << "thread " << t << " request " << i << ": " << resp << std::endl;
+                }
+            }
+        }
+    });
+    if (failures > 0) {
+        exit(1);
+    }
+    std::cout << "TestConcurrentRequests passed!" << std::endl;
+}
+
+void TestSessionsAcrossThreads() {
+    Service service(4);
+    parallel(6, [&](int t) {
+        std::string session = "s" + std::to_string(t);
+        service.Handle(R"({"session": ")" + session + R"(", "code": "let total = 0; let items = [];"})");
+        for (int i = 1; i <= 20; i++) {
+            service.Handle(R"({"session": ")" + session + R"(", "code": "total = total + )" + std::to_string(i) +
+                           R"(; items = push(items, total);"})");
+        }
+    });
+    for (int t = 0; t < 6; t++) {
+        std::string resp = service.Handle(R"({"session": "s)" + std::to_string(t) + R"(", "code": "[total, len(items)]"})");
+        if (!contains(resp, "Evaluated Result: [210, 20]")) {
+            std::cerr << "session s" << t << " lost state: " << resp << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << "TestSessionsAcrossThreads passed!" << std::endl;
+}
+
+void TestLimitsPerRequest() {
+    ExecutionLimits limits;
+    limits.Timeout = std::chrono::seconds(10);
+    Service service(2, Engine::EVAL, limits);
+    std::atomic<int> failures{0};
+    parallel(4, [&](int t) {
+        // A runaway request on one thread does not hold up the others.
+        std::string resp = t == 0 ? service.Handle(R"({"code": "while (true) { }", "max_steps": 100000})")
+                                  : service.Handle(R"({"code": "1 + 1"})");
+        if (!contains(resp, t == 0 ? R"("limit":"steps")" : "Evaluated Result: 2")) {
+            std::cerr << "thread " << t << ": " << resp << std::endl;
+            failures++;
+        }
+    });
+    if (failures > 0) {
+        exit(1);
+    }
+    std::cout << "TestLimitsPerRequest passed!" << std::endl;
+}
+
+void TestStats() {
+    Service service(3);
+    for (int i = 0; i < 10; i++) {
+        service.Handle(R"({"code": "1"})");
+    }
+    service.Handle("not json");
+    std::string resp = service.Handle(R"({"id": "q", "stats": true})");
+    if (!contains(resp, R"({"id":"q","ok":true,"stats":{"requests":11,"workers":3,)")) {
+        std::cerr << "stats: " << resp << std::endl;
+        exit(1);
+    }
+    std::cout << "TestStats passed!" << std::endl;
+}
+
+void TestServeSocket() {
+    std::string path = "/tmp/monkey_service_test_" + std::to_string(getpid()) + ".sock";
+    // ServeSocket only returns on an error, so the Service outlives the test.
+    static Service service(2);
+    std::thread([path] { service.ServeSocket(path); }).detach();
+
+    auto connect_ = [&path]() {
+        for (int attempt = 0; attempt < 200; attempt++) {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+            if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+                return fd;
+            }
+            close(fd);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::cerr << "cannot connect to " << path << std::endl;
+        exit(1);
+    };
+
+    std::atomic<int> failures{0};
+    parallel(4, [&](int t) {
+        int fd = connect_();
+        std::string requests;
+        for (int i = 0; i < 5; i++) {
+            requests += R"({"id": )" + std::to_string(i) + R"(, "code": ")" + std::to_string(t) + " + " + std::to_string(i) + "\"}\n";
+        }
+        if (write(fd, requests.data(), requests.size()) != static_cast<ssize_t>(requests.size())) {
+            failures++;
+        }
+        shutdown(fd, SHUT_WR);
+        std::string got;
+        char buf[4096];
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            got.append(buf, n);
+        }
+        close(fd);
+        // Answers on one connection come back in the order they were asked.
+        size_t at = 0;
+        for (int i = 0; i < 5; i++) {
+            at = got.find(R"({"id":)" + std::to_string(i) + ",", at);
+            if (at == std::string::npos || got.find("Evaluated Result: " + std::to_string(t + i), at) == std::string::npos) {
+                std::cerr << "connection " << t << " answer " << i << ": " << got << std::endl;
+                failures++;
+                break;
+            }
+        }
+    });
+    unlink(path.c_str());
+    if (failures > 0) {
+        exit(1);
+    }
+    std::cout << "TestServeSocket passed!" << std::endl;
+}
+
+int main() {
+    TestConcurrentRequests();
+    TestSessionsAcrossThreads();
+    TestLimitsPerRequest();
+    TestStats();
+    TestServeSocket();
+    std::cout << "All service_test.cpp tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "symbol.hpp"
+#include <atomic>
+
+namespace {
+
+std::atomic<uint64_t> nextSerial{1};
+std::atomic<size_t> liveNames{0};
+
+thread_local Interner* current = nullptr;
+
+} // namespace
+
+Interner::Interner() : serial(nextSerial++) {}
+
+Interner::~Interner() {
+    liveNames -= names.size();
+}
+
+SymbolId Interner::Intern(std::string_view name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    std::string_view stored = names.emplace_back(name);
+    liveNames++;
+    SymbolId id = static_cast<SymbolId>(names.size() - 1);
+    ids.emplace(stored, id);
+    return id;
+}
+
+std::string_view Interner::Name(SymbolId id) const {
+    return id < names.size() ? std::string_view(names[id]) : std::string_view();
+}
+
+Interner& Interner::Current() {
+    if (current) {
+        return *current;
+    }
+    thread_local Interner own;
+    return own;
+}
+
+size_t Interner::Live() {
+    return liveNames;
+}
+
+Interner::Use::Use(Interner& interner) : previous(current) {
+    current = &interner;
+}
+
+Interner::Use::~Use() {
+    current = previous;
+}
@@ -0,0 +1,62 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// SymbolId names an identifier by a small dense number, so scopes,
+// environments and the builtins can key on it instead of on the text.
+using SymbolId = uint32_t;
+
+// Interner gives each distinct name a SymbolId, counting up from 0. A
+// program is lexed and run with one Interner current on its thread, so the
+// ids in its AST, its environments and the builtins agree; a Session keeps
+// one for all its programs and frees it with the session. One Interner must
+// only be used by one thread at a time.
+class Interner {
+public:
+    static constexpr SymbolId None = UINT32_MAX;
+
+    Interner();
+    ~Interner();
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    SymbolId Intern(std::string_view name);
+    // The name id was interned from, valid as long as the Interner.
+    std::string_view Name(SymbolId id) const;
+    size_t Count() const { return names.size(); }
+    // Tells Interners apart for caches keyed by SymbolId; never reused.
+    uint64_t Serial() const { return serial; }
+
+    // The Interner the lexer uses on this thread: the one the innermost
+    // Use installed, or else one the thread owns, for code that lexes
+    // outside a Session such as tests.
+    static Interner& Current();
+    // The names held by every Interner alive in the process.
+    static size_t Live();
+
+    // Makes an Interner current on this thread while the Use is in scope.
+    class Use {
+    public:
+        explicit Use(Interner& interner);
+        ~Use();
+        Use(const Use&) = delete;
+        Use& operator=(const Use&) = delete;
+
+    private:
+        Interner* previous;
+    };
+
+private:
+    // The deque never moves the names, so ids can key on views into it.
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, SymbolId> ids;
+    uint64_t serial;
+};
+
+#endif // SYMBOL_H
@@ -1,23 +1,98 @@
 #include "token.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
 
-Token::Token(TokenType type, const std::string& literal) : Type(type), Literal(literal) {}
+Token::Token(TokenType type, std::string_view literal) : Type(type), Literal(literal) {}
 
-static std::unordered_map<std::string, TokenType> keywords = {
+namespace {
+
+struct Keyword {
+    std::string_view Word; // empty in a slot no keyword hashes to
+    TokenType Type = TokenType::IDENT;
+};
+
+// Every keyword of the language. LookupIdent finds them through a perfect
+// hash the compiler works out from this list, so adding a keyword here is
+// all it takes; the build fails if no perfect hash can be found.
+constexpr Keyword keywords[] = {
     {"fn", TokenType::FUNCTION},
     {"let", TokenType::LET},
     {"true", TokenType::TRUE},
     {"false", TokenType::FALSE},
     {"if", TokenType::IF},
     {"else", TokenType::ELSE},
-    {"return", TokenType::RETURN}
+    {"return", TokenType::RETURN},
+    {"while", TokenType::WHILE}
 };
 
-TokenType LookupIdent(const std::string& ident) {
-    auto it = keywords.find(ident);
-    if (it != keywords.end()) {
-        return it->second;
+constexpr size_t KeywordBits = 4;
+constexpr size_t KeywordSlots = size_t(1) << KeywordBits;
+static_assert(std::size(keywords) <= KeywordSlots, "more keywords than slots; raise KeywordBits");
+
+constexpr size_t minKeywordLength() {
+    size_t n = keywords[0].Word.size();
+    for (const auto& k : keywords) n = std::min(n, k.Word.size());
+    return n;
+}
+
+constexpr size_t maxKeywordLength() {
+    size_t n = 0;
+    for (const auto& k : keywords) n = std::max(n, k.Word.size());
+    return n;
+}
+
+// Mixes the length and the first and last characters of word, which must
+// not be empty, into a slot: a multiplicative hash that keeps the top bits.
+constexpr size_t keywordHash(std::string_view word, uint32_t seed) {
+    uint32_t key = static_cast<uint8_t>(word.front()) | static_cast<uint8_t>(word.back()) << 8 |
+                   static_cast<uint32_t>(word.size()) << 16;
+    return static_cast<uint32_t>(key * seed) >> (32 - KeywordBits);
+}
+
+// The first odd seed from the golden ratio up that sends every keyword to
+// a slot of its own, or 0. Small seeds would leave the top bits empty.
+constexpr uint32_t findSeed() {
+    for (uint32_t seed = 0x9E3779B1u; seed < 0x9E3779B1u + (1u << 16); seed += 2) {
+        bool used[KeywordSlots] = {};
+        bool perfect = true;
+        for (const auto& k : keywords) {
+            size_t slot = keywordHash(k.Word, seed);
+            if (used[slot]) {
+                perfect = false;
+                break;
+            }
+            used[slot] = true;
+        }
+        if (perfect) return seed;
+    }
+    return 0;
+}
+
+constexpr uint32_t KeywordSeed = findSeed();
+static_assert(KeywordSeed != 0, "no perfect hash for the keywords; change keywordHash or raise KeywordBits");
+
+constexpr std::array<Keyword, KeywordSlots> makeKeywordTable() {
+    std::array<Keyword, KeywordSlots> table{};
+    for (const auto& k : keywords) table[keywordHash(k.Word, KeywordSeed)] = k;
+    return table;
+}
+
+constexpr std::array<Keyword, KeywordSlots> keywordTable = makeKeywordTable();
+constexpr size_t MinKeywordLength = minKeywordLength();
+constexpr size_t MaxKeywordLength = maxKeywordLength();
+
+} // namespace
+
+// A keyword can only be the one word that hashes to its slot, so one
+// comparison settles it, and nothing is allocated or hashed in full.
+TokenType LookupIdent(std::string_view ident) {
+    if (ident.size() < MinKeywordLength || ident.size() > MaxKeywordLength) {
+        return TokenType::IDENT;
     }
-    return TokenType::IDENT;
+    const Keyword& k = keywordTable[keywordHash(ident, KeywordSeed)];
+    return k.Word == ident ? k.Type : TokenType::IDENT;
 }
 
 std::string TokenTypeToString(TokenType type) {
@@ -60,6 +135,7 @@ std::string TokenTypeToString(TokenType type) {
         case TokenType::IF:           return "IF";
         case TokenType::ELSE:         return "ELSE";
         case TokenType::RETURN:       return "RETURN";
+        case TokenType::WHILE:        return "WHILE";
         default:                      return "UNKNOWN";
     }
 }
@@ -1,8 +1,10 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <iostream>
+#include "symbol.hpp"
 
 enum class TokenType {
     ILLEGAL,
@@ -46,18 +48,25 @@ enum class TokenType {
     FALSE,
     IF,
     ELSE,
-    RETURN
+    RETURN,
+    WHILE // keep last, TokenTypeCount counts up to it
 };
 
+constexpr size_t TokenTypeCount = static_cast<size_t>(TokenType::WHILE) + 1;
+
+// Literal is a view into the source buffer the token was read from; it
+// does not own its characters, so copy it into a std::string before the
+// source goes away.
 class Token {
 public:
     TokenType Type;
-    std::string Literal;
+    SymbolId Symbol = Interner::None; // the interned Literal of an IDENT token
+    std::string_view Literal;
     Token() = default;
-    Token(TokenType type, const std::string& literal);
+    Token(TokenType type, std::string_view literal);
 };
 
-TokenType LookupIdent(const std::string& ident);
+TokenType LookupIdent(std::string_view ident);
 
 std::string TokenTypeToString(TokenType type);
 
@@ -0,0 +1,39 @@
+#ifndef TOKEN_BUFFER_H
+#define TOKEN_BUFFER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "token.hpp"
+
+static_assert(TokenTypeCount <= 256, "TokenBuffer keeps token types in a byte");
+
+// TokenBuffer is a whole token stream, as Lexer::TokenizeAll returns it, in
+// parallel arrays indexed by token: 17 bytes a token where a Token takes 24,
+// with the kinds packed together for a parser scanning ahead. It ends with
+// the EOF token and keeps the source alive, so it can be parsed, shown and
+// parsed again long after the Lexer is gone.
+class TokenBuffer {
+public:
+    std::shared_ptr<const std::string> Source;
+    std::vector<uint8_t> Kinds;    // TokenType
+    std::vector<uint32_t> Offsets; // where the literal starts in Source
+    std::vector<uint32_t> Lengths; // how long the literal is
+    // The value of each INT token, read once by the lexer, and the SymbolId
+    // of each IDENT. 0 for any other token, and for an INT too large for
+    // int64, which only a literal that is not all zeros can tell apart.
+    std::vector<int64_t> Values;
+
+    size_t Size() const { return Kinds.size(); }
+    TokenType Type(size_t i) const { return static_cast<TokenType>(Kinds[i]); }
+    std::string_view Literal(size_t i) const { return std::string_view(Source->data() + Offsets[i], Lengths[i]); }
+    Token At(size_t i) const {
+        Token tok(Type(i), Literal(i));
+        if (tok.Type == TokenType::IDENT) tok.Symbol = static_cast<SymbolId>(Values[i]);
+        return tok;
+    }
+};
+
+#endif // TOKEN_BUFFER_H
@@ -1,6 +1,7 @@
 #include "token.hpp"
 #include <iostream>
 #include <cassert>
+#include <string>
 
 //Token Test: This tests the token construction and the function that looks up identifiers to determine if they are keywords or general identifiers.
 
@@ -15,14 +16,57 @@ int main() {
     assert(LookupIdent("fn") == TokenType::FUNCTION);
     assert(LookupIdent("let") == TokenType::LET);
     assert(LookupIdent("true") == TokenType::TRUE);
+    assert(LookupIdent("while") == TokenType::WHILE);
+    assert(LookupIdent("false") == TokenType::FALSE);
+    assert(LookupIdent("if") == TokenType::IF);
+    assert(LookupIdent("else") == TokenType::ELSE);
+    assert(LookupIdent("return") == TokenType::RETURN);
     std::cout << "LookupIdent for keywords test passed!" << std::endl;
 
     // Test 3: LookupIdent for identifiers
     assert(LookupIdent("foobar") == TokenType::IDENT);
     assert(LookupIdent("x") == TokenType::IDENT);
+    // Words that share a keyword's length and first and last letters hash
+    // to its slot, and must still not match it.
+    assert(LookupIdent("fun") == TokenType::IDENT);
+    assert(LookupIdent("lot") == TokenType::IDENT);
+    assert(LookupIdent("tree") == TokenType::IDENT);
+    assert(LookupIdent("reborn") == TokenType::IDENT);
+    assert(LookupIdent("iF") == TokenType::IDENT);
+    assert(LookupIdent("whilee") == TokenType::IDENT);
+    assert(LookupIdent("") == TokenType::IDENT);
     std::cout << "LookupIdent for identifiers test passed!" << std::endl;
 
+    // Test 4: An Interner gives each distinct name one dense id
+    size_t live = Interner::Live();
+    {
+        Interner names;
+        std::string name = "counter";
+        SymbolId counter = names.Intern(name);
+        name[0] = 'C'; // the interner keeps its own copy
+        assert(counter == 0);
+        assert(names.Intern("counter") == counter);
+        assert(names.Intern("Counter") != counter);
+        assert(names.Name(counter) == "counter");
+        assert(names.Count() == 2);
+        assert(names.Name(Interner::None).empty());
+        assert(Interner::Live() == live + 2);
+
+        // Each Interner counts from 0 on its own, and Use makes one current.
+        Interner other;
+        assert(other.Intern("Counter") == 0);
+        assert(other.Serial() != names.Serial());
+        {
+            Interner::Use use(other);
+            assert(&Interner::Current() == &other);
+        }
+        assert(&Interner::Current() != &other);
+    }
+    // Dropping an Interner frees its names.
+    assert(Interner::Live() == live);
+    std::cout << "Interner test passed!" << std::endl;
+
     std::cout << "All token_test.cpp tests passed!" << std::endl;
     return 0;
 }
-//g++ -std=c++17 -Isrc -o token_test src/monkey/token/token_test.cpp src/monkey/token/token.cpp && ./token_test
+//g++ -std=c++17 -Isrc -o token_test src/monkey/token/token_test.cpp src/monkey/token/token.cpp src/monkey/token/symbol.cpp && ./token_test
@@ -0,0 +1,497 @@
+#include "vm.hpp"
+#include "../object/builtins.hpp"
+#include <cstdarg>
+#include <cstdio>
+
+//vm.cpp
+
+using namespace YOXS_CODE;
+
+static std::shared_ptr<Error> newError(const std::string format, ...) {
+    char buffer[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format.c_str(), args);
+    va_end(args);
+    return std::make_shared<Error>(buffer);
+}
+
+static std::shared_ptr<Error> stackOverflow() {
+    return std::make_shared<Error>("stack overflow", ErrorKind::StackOverflow);
+}
+
+static const char* operatorSymbol(Opcode op) {
+    switch (op) {
+        case OpAdd: return "+";
+        case OpSub: return "-";
+        case OpMul: return "*";
+        case OpDiv: return "/";
+        case OpEqual: return "==";
+        case OpNotEqual: return "!=";
+        case OpGreaterThan: return ">";
+        case OpLessThan: return "<";
+        default: return "?";
+    }
+}
+
+static std::shared_ptr<Object> nativeBoolToBooleanObject(bool input) {
+    return input ? ObjectConstants::TRUE : ObjectConstants::FALSE;
+}
+
+static bool isTruthy(const std::shared_ptr<Object>& obj) {
+    if (obj == ObjectConstants::NULL_OBJ) return false;
+    if (obj == ObjectConstants::FALSE) return false;
+    return true;
+}
+
+VM::VM(const Bytecode& bytecode)
+    : constants(bytecode.Constants), stack(StackSize), sp(0), ownGlobals(GlobalsSize), globals(ownGlobals), frames(MaxFrames), framesIndex(1) {
+    auto mainFn = std::make_shared<CompiledFunction>(bytecode.Instructions);
+    auto mainClosure = std::make_shared<Closure>(mainFn);
+    frames[0] = Frame(mainClosure, 0);
+}
+
+VM::VM(const Bytecode& bytecode, std::vector<std::shared_ptr<Object>>& globals)
+    : constants(bytecode.Constants), stack(StackSize), sp(0), globals(globals), frames(MaxFrames), framesIndex(1) {
+    if (globals.size() < GlobalsSize) {
+        globals.resize(GlobalsSize);
+    }
+    auto mainFn = std::make_shared<CompiledFunction>(bytecode.Instructions);
+    auto mainClosure = std::make_shared<Closure>(mainFn);
+    frames[0] = Frame(mainClosure, 0);
+}
+
+std::shared_ptr<Object> VM::StackTop() const {
+    if (sp == 0) {
+        return nullptr;
+    }
+    return stack[sp - 1];
+}
+
+std::shared_ptr<Object> VM::LastPoppedStackElem() const {
+    return lastPopped;
+}
+
+bool VM::pushFrame(const Frame& f) {
+    if (framesIndex >= MaxFrames) {
+        return false;
+    }
+    frames[framesIndex] = f;
+    framesIndex++;
+    return true;
+}
+
+Frame& VM::popFrame() {
+    framesIndex--;
+    return frames[framesIndex];
+}
+
+std::shared_ptr<Error> VM::push(std::shared_ptr<Object> obj) {
+    if (sp >= StackSize) {
+        return stackOverflow();
+    }
+    stack[sp] = std::move(obj);
+    sp++;
+    return nullptr;
+}
+
+std::shared_ptr<Object> VM::pop() {
+    sp--;
+    return stack[sp];
+}
+
+namespace {
+
+// Adds the instructions a run executed to RunCounters, however it ends.
+struct StepTally {
+    uint64_t steps = 0;
+    ~StepTally() { Counters::Current().Steps += steps; }
+};
+
+} // namespace
+
+std::shared_ptr<Error> VM::Run(const ExecutionLimits& limits) {
+    LimitGuard guard(limits);
+    const bool limited = !limits.Unlimited();
+    StepTally tally;
+    while (currentFrame().ip < static_cast<int>(currentFrame().Instructions().size()) - 1) {
+        tally.steps++;
+        if (limited) {
+            if (auto err = guard.Step()) {
+                return err;
+            }
+        }
+        Frame& frame = currentFrame();
+        frame.ip++;
+        int ip = frame.ip;
+        const YOXS_CODE::Instructions& ins = frame.Instructions();
+        Opcode op = static_cast<Opcode>(ins[ip]);
+
+        std::shared_ptr<Error> err;
+
+        switch (op) {
+            case OpConstant: {
+                int constIndex = ReadUint16(ins, ip + 1);
+                frame.ip += 2;
+                err = push(constants[constIndex]);
+                break;
+            }
+            case OpAdd:
+            case OpSub:
+            case OpMul:
+            case OpDiv:
+                err = executeBinaryOperation(op);
+                break;
+            case OpPop:
+                lastPopped = pop();
+                break;
+            case OpTrue:
+                err = push(ObjectConstants::TRUE);
+                break;
+            case OpFalse:
+                err = push(ObjectConstants::FALSE);
+                break;
+            case OpNull:
+                err = push(ObjectConstants::NULL_OBJ);
+                break;
+            case OpEqual:
+            case OpNotEqual:
+            case OpGreaterThan:
+            case OpLessThan:
+                err = executeComparison(op);
+                break;
+            case OpBang:
+                err = executeBangOperator();
+                break;
+            case OpMinus:
+                err = executeMinusOperator();
+                break;
+            case OpJump: {
+                int pos = ReadUint16(ins, ip + 1);
+                frame.ip = pos - 1;
+                break;
+            }
+            case OpJumpNotTruthy: {
+                int pos = ReadUint16(ins, ip + 1);
+                frame.ip += 2;
+                auto condition = pop();
+                if (!isTruthy(condition)) {
+                    frame.ip = pos - 1;
+                }
+                break;
+            }
+            case OpSetGlobal: {
+                int globalIndex = ReadUint16(ins, ip + 1);
+                frame.ip += 2;
+                globals[globalIndex] = pop();
+                // A let ends the program with no value, as it does in
+                // the Evaluator.
+                lastPopped = nullptr;
+                break;
+            }
+            case OpGetGlobal: {
+                int globalIndex = ReadUint16(ins, ip + 1);
+                frame.ip += 2;
+                if (!globals[globalIndex]) {
+                    // A let the program skipped, or one whose value failed.
+                    return newError("identifier not found: global %d", globalIndex);
+                }
+                err = push(globals[globalIndex]);
+                break;
+            }
+            case OpSetLocal: {
+                int localIndex = ReadUint8(ins, ip + 1);
+                frame.ip += 1;
+                stack[frame.basePointer + localIndex] = pop();
+                break;
+            }
+            case OpGetLocal: {
+                int localIndex = ReadUint8(ins, ip + 1);
+                frame.ip += 1;
+                if (!stack[frame.basePointer + localIndex]) {
+                    return newError("identifier not found: local %d", localIndex);
+                }
+                err = push(stack[frame.basePointer + localIndex]);
+                break;
+            }
+            case OpGetBuiltin: {
+                int builtinIndex = ReadUint8(ins, ip + 1);
+                frame.ip += 1;
+                err = push(Builtins[builtinIndex].builtin);
+                break;
+            }
+            case OpGetFree: {
+                int freeIndex = ReadUint8(ins, ip + 1);
+                frame.ip += 1;
+                err = push(frame.cl->Free[freeIndex]);
+                break;
+            }
+            case OpCurrentClosure:
+                err = push(frame.cl);
+                break;
+            case OpArray: {
+                int numElements = ReadUint16(ins, ip + 1);
+                frame.ip += 2;
+                auto array = buildArray(sp - numElements, sp);
+                sp = sp - numElements;
+                err = push(array);
+                break;
+            }
+            case OpHash: {
+                int numElements = ReadUint16(ins, ip + 1);
+                frame.ip += 2;
+                auto hash = buildHash(sp - numElements, sp);
+                sp = sp - numElements;
+                if (hash->Type() == ERROR_OBJ) {
+                    return std::static_pointer_cast<Error>(hash);
+                }
+                err = push(hash);
+                break;
+            }
+            case OpIndex: {
+                auto index = pop();
+                auto left = pop();
+                err = executeIndexExpression(left, index);
+                break;
+            }
+            case OpCall: {
+                int numArgs = ReadUint8(ins, ip + 1);
+                frame.ip += 1;
+                err = executeCall(numArgs);
+                break;
+            }
+            case OpReturnValue: {
+                auto returnValue = pop();
+                if (framesIndex == 1) {
+                    // A return at the top level ends the program with that value.
+                    lastPopped = std::move(returnValue);
+                    return nullptr;
+                }
+                Frame& returned = popFrame();
+                sp = returned.basePointer - 1;
+                err = push(returnValue);
+                break;
+            }
+            case OpReturn: {
+                Frame& returned = popFrame();
+                sp = returned.basePointer - 1;
+                err = push(ObjectConstants::NULL_OBJ);
+                break;
+            }
+            case OpClosure: {
+                int constIndex = ReadUint16(ins, ip + 1);
+                int numFree = ReadUint8(ins, ip + 3);
+                frame.ip += 3;
+                err = pushClosure(constIndex, numFree);
+                break;
+            }
+            default:
+                return newError("opcode %d undefined", static_cast<int>(op));
+        }
+
+        if (err) {
+            return err;
+        }
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<Error> VM::executeBinaryOperation(Opcode op) {
+    auto right = pop();
+    auto left = pop();
+
+    auto leftType = left->Type();
+    auto rightType = right->Type();
+
+    if (leftType != rightType) {
+        return newError("type mismatch: %s %s %s", ObjectTypeToString(leftType).c_str(), operatorSymbol(op), ObjectTypeToString(rightType).c_str());
+    }
+
+    if (leftType == INTEGER_OBJ) {
+        int64_t leftVal = std::static_pointer_cast<Integer>(left)->Value;
+        int64_t rightVal = std::static_pointer_cast<Integer>(right)->Value;
+        // Through uint64_t, where overflow wraps as in the evaluators.
+        uint64_t l = static_cast<uint64_t>(leftVal), r = static_cast<uint64_t>(rightVal);
+        int64_t result;
+
+        switch (op) {
+            case OpAdd: result = static_cast<int64_t>(l + r); break;
+            case OpSub: result = static_cast<int64_t>(l - r); break;
+            case OpMul: result = static_cast<int64_t>(l * r); break;
+            case OpDiv:
+                if (rightVal == 0) {
+                    return newError("division by zero");
+                }
+                // INT64_MIN / -1 traps too; it wraps like the evaluators'.
+                result = rightVal == -1 ? static_cast<int64_t>(0 - l) : leftVal / rightVal;
+                break;
+            default:
+                return newError("unknown integer operator: %d", static_cast<int>(op));
+        }
+        return push(std::make_shared<Integer>(result));
+    }
+
+    if (leftType == STRING_OBJ && op == OpAdd) {
+        const std::string& leftVal = std::static_pointer_cast<String>(left)->Value;
+        const std::string& rightVal = std::static_pointer_cast<String>(right)->Value;
+        return push(std::make_shared<String>(leftVal + rightVal));
+    }
+
+    return newError("unknown operator: %s %s %s", ObjectTypeToString(leftType).c_str(), operatorSymbol(op), ObjectTypeToString(rightType).c_str());
+}
+
+std::shared_ptr<Error> VM::executeComparison(Opcode op) {
+    auto right = pop();
+    auto left = pop();
+
+    auto leftType = left->Type();
+    auto rightType = right->Type();
+
+    if (leftType != rightType) {
+        return newError("type mismatch: %s %s %s", ObjectTypeToString(leftType).c_str(), operatorSymbol(op), ObjectTypeToString(rightType).c_str());
+    }
+
+    if (leftType == INTEGER_OBJ) {
+        int64_t leftVal = std::static_pointer_cast<Integer>(left)->Value;
+        int64_t rightVal = std::static_pointer_cast<Integer>(right)->Value;
+
+        switch (op) {
+            case OpEqual: return push(nativeBoolToBooleanObject(leftVal == rightVal));
+            case OpNotEqual: return push(nativeBoolToBooleanObject(leftVal != rightVal));
+            case OpGreaterThan: return push(nativeBoolToBooleanObject(leftVal > rightVal));
+            case OpLessThan: return push(nativeBoolToBooleanObject(leftVal < rightVal));
+            default: break;
+        }
+    } else if (leftType != STRING_OBJ) {
+        // Booleans and null are singletons, so identity is equality.
+        switch (op) {
+            case OpEqual: return push(nativeBoolToBooleanObject(left == right));
+            case OpNotEqual: return push(nativeBoolToBooleanObject(left != right));
+            default: break;
+        }
+    }
+
+    return newError("unknown operator: %s %s %s", ObjectTypeToString(leftType).c_str(), operatorSymbol(op), ObjectTypeToString(rightType).c_str());
+}
+
+std::shared_ptr<Error> VM::executeBangOperator() {
+    auto operand = pop();
+    return push(nativeBoolToBooleanObject(!isTruthy(operand)));
+}
+
+std::shared_ptr<Error> VM::executeMinusOperator() {
+    auto operand = pop();
+    if (operand->Type() != INTEGER_OBJ) {
+        return newError("unknown operator: -%s", ObjectTypeToString(operand->Type()).c_str());
+    }
+    uint64_t value = static_cast<uint64_t>(std::static_pointer_cast<Integer>(operand)->Value);
+    return push(std::make_shared<Integer>(static_cast<int64_t>(0 - value)));
+}
+
+std::shared_ptr<Error> VM::executeIndexExpression(std::shared_ptr<Object> left, std::shared_ptr<Object> index) {
+    if (left->Type() == ARRAY_OBJ && index->Type() == INTEGER_OBJ) {
+        auto array = std::static_pointer_cast<ArrayObject>(left);
+        int64_t i = std::static_pointer_cast<Integer>(index)->Value;
+        int64_t max = static_cast<int64_t>(array->Elements.size()) - 1;
+        if (i < 0 || i > max) {
+            return push(ObjectConstants::NULL_OBJ);
+        }
+        return push(array->Elements[i].ToObject());
+    } else if (left->Type() == HASH_OBJ) {
+        auto hash = std::static_pointer_cast<Hash>(left);
+        Value keyValue(index);
+        auto key = HashKeyOf(keyValue);
+        if (!key) {
+            return newError("unusable as hash key: %s", ObjectTypeToString(index->Type()).c_str());
+        }
+        auto pair = hash->Pairs.Find(*key, keyValue);
+        if (!pair) {
+            return push(ObjectConstants::NULL_OBJ);
+        }
+        return push(pair->Value.ToObject());
+    }
+
+    return newError("index operator not supported: %s", ObjectTypeToString(left->Type()).c_str());
+}
+
+std::shared_ptr<Error> VM::executeCall(int numArgs) {
+    auto callee = stack[sp - 1 - numArgs];
+    Counters::Current().Calls++;
+    switch (callee->Type()) {
+        case CLOSURE_OBJ:
+            return callClosure(std::static_pointer_cast<Closure>(callee), numArgs);
+        case BUILTIN_OBJ:
+            return callBuiltin(std::static_pointer_cast<Builtin>(callee), numArgs);
+        default:
+            return newError("not a function: %s", callee->Inspect().c_str());
+    }
+}
+
+std::shared_ptr<Error> VM::callClosure(std::shared_ptr<Closure> cl, int numArgs) {
+    if (numArgs != cl->Fn->NumParameters) {
+        return newError("wrong number of arguments: want=%d, got=%d", cl->Fn->NumParameters, numArgs);
+    }
+
+    int basePointer = sp - numArgs;
+    if (basePointer + cl->Fn->NumLocals >= StackSize || !pushFrame(Frame(cl, basePointer))) {
+        return stackOverflow();
+    }
+    // Unset the locals, which still hold what an earlier call left there.
+    for (int i = basePointer + numArgs; i < basePointer + cl->Fn->NumLocals; i++) {
+        stack[i] = nullptr;
+    }
+    sp = basePointer + cl->Fn->NumLocals;
+    return nullptr;
+}
+
+std::shared_ptr<Error> VM::callBuiltin(std::shared_ptr<Builtin> builtin, int numArgs) {
+    // Builtins work on Values, the evaluator's representation.
+    std::vector<Value> args(stack.begin() + (sp - numArgs), stack.begin() + sp);
+
+    auto result = builtin->function(args).ToObject();
+    sp = sp - numArgs - 1;
+
+    if (!result) {
+        return push(ObjectConstants::NULL_OBJ);
+    }
+    if (result->Type() == ERROR_OBJ) {
+        return std::static_pointer_cast<Error>(result);
+    }
+    return push(result);
+}
+
+std::shared_ptr<Error> VM::pushClosure(int constIndex, int numFree) {
+    auto constant = constants[constIndex];
+    if (constant->Type() != COMPILED_FUNCTION_OBJ) {
+        return newError("not a function: %s", constant->Inspect().c_str());
+    }
+
+    std::vector<std::shared_ptr<Object>> free(stack.begin() + (sp - numFree), stack.begin() + sp);
+    sp = sp - numFree;
+
+    return push(std::make_shared<Closure>(std::static_pointer_cast<CompiledFunction>(constant), free));
+}
+
+std::shared_ptr<Object> VM::buildArray(int startIndex, int endIndex) {
+    std::vector<Value> elements(stack.begin() + startIndex, stack.begin() + endIndex);
+    return std::make_shared<ArrayObject>(elements);
+}
+
+std::shared_ptr<Object> VM::buildHash(int startIndex, int endIndex) {
+    HashTable pairs;
+    pairs.Reserve((endIndex - startIndex) / 2);
+
+    for (int i = startIndex; i < endIndex; i += 2) {
+        Value key(stack[i]);
+        Value value(stack[i + 1]);
+
+        auto hashKey = HashKeyOf(key);
+        if (!hashKey) {
+            return newError("unusable as hash key: %s", ObjectTypeToString(key.Type()).c_str());
+        }
+        pairs.Set(*hashKey, HashPair{key, value});
+    }
+
+    return std::make_shared<Hash>(std::move(pairs));
+}
@@ -1,5 +1,10 @@
+#ifndef VM_H
+#define VM_H
+
 #include "../object/object.hpp"
 #include "../object/environment.hpp"
+#include "../object/limits.hpp"
+#include "../compiler/compiler.hpp"
 
 using namespace YOXS_OBJECT;
 using namespace YOXS_AST;
@@ -8,26 +13,67 @@ constexpr int StackSize = 2048;
 constexpr int GlobalsSize = 65536;
 constexpr int MaxFrames = 1024;
 
-class ObjectConstants {
+// Frame is the call frame of one closure invocation. basePointer is the
+// stack index where the callee's locals start.
+class Frame {
 public:
-    static std::shared_ptr<NullObject> NULL_OBJ;
-    static std::shared_ptr<BooleanObject> TRUE;
-    static std::shared_ptr<BooleanObject> FALSE;
-};
+    Frame() : ip(-1), basePointer(0) {}
+    Frame(std::shared_ptr<Closure> cl, int basePointer) : cl(cl), ip(-1), basePointer(basePointer) {}
+
+    std::shared_ptr<Closure> cl;
+    int ip;
+    int basePointer;
 
-std::shared_ptr<NullObject> ObjectConstants::NULL_OBJ = std::make_shared<NullObject>();
-std::shared_ptr<BooleanObject> ObjectConstants::TRUE = std::make_shared<BooleanObject>(true);
-std::shared_ptr<BooleanObject> ObjectConstants::FALSE = std::make_shared<BooleanObject>(false);
+    const YOXS_CODE::Instructions& Instructions() const { return cl->Fn->Instructions; }
+};
 
 class VM {
 public:
+    VM(const Bytecode& bytecode);
+    // Runs bytecode against an existing globals store, as a REPL session
+    // does, so the globals earlier programs set are still there. globals
+    // must outlive the VM and is grown to GlobalsSize if it is smaller.
+    VM(const Bytecode& bytecode, std::vector<std::shared_ptr<Object>>& globals);
+
+    // Executes the bytecode; returns nullptr on success or the runtime Error
+    // that stopped execution. Every instruction counts as one step against
+    // limits.
+    std::shared_ptr<Error> Run(const ExecutionLimits& limits = {});
+    std::shared_ptr<Object> StackTop() const;
+    // The value the last expression statement left, or nullptr if the
+    // program ended without one, as an empty program or a let does.
+    std::shared_ptr<Object> LastPoppedStackElem() const;
+
 private:
     std::vector<std::shared_ptr<Object>> constants;
     std::vector<std::shared_ptr<Object>> stack;
-    int sp; // stack pointer; always points to next value. 
+    int sp; // stack pointer; always points to next value.
     //top of stack is stack[sp-1]
+    std::shared_ptr<Object> lastPopped; // what the last OpPop took off
 
-    std::vector<std::shared_ptr<Object>> globals;
-    std::vector<int> frames;
+    std::vector<std::shared_ptr<Object>> ownGlobals;
+    std::vector<std::shared_ptr<Object>>& globals;
+    std::vector<Frame> frames;
     int framesIndex;
-};
\ No newline at end of file
+
+    Frame& currentFrame() { return frames[framesIndex - 1]; }
+    bool pushFrame(const Frame& f);
+    Frame& popFrame();
+
+    std::shared_ptr<Error> push(std::shared_ptr<Object> obj);
+    std::shared_ptr<Object> pop();
+
+    std::shared_ptr<Error> executeBinaryOperation(YOXS_CODE::Opcode op);
+    std::shared_ptr<Error> executeComparison(YOXS_CODE::Opcode op);
+    std::shared_ptr<Error> executeBangOperator();
+    std::shared_ptr<Error> executeMinusOperator();
+    std::shared_ptr<Error> executeIndexExpression(std::shared_ptr<Object> left, std::shared_ptr<Object> index);
+    std::shared_ptr<Error> executeCall(int numArgs);
+    std::shared_ptr<Error> callClosure(std::shared_ptr<Closure> cl, int numArgs);
+    std::shared_ptr<Error> callBuiltin(std::shared_ptr<Builtin> builtin, int numArgs);
+    std::shared_ptr<Error> pushClosure(int constIndex, int numFree);
+    std::shared_ptr<Object> buildArray(int startIndex, int endIndex);
+    std::shared_ptr<Object> buildHash(int startIndex, int endIndex);
+};
+
+#endif // VM_H
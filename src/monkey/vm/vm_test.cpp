@@ -0,0 +1,303 @@
+#include "vm.hpp"
+#include "../lexer/lexer.hpp"
+#include "../parser/parser.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <variant>
+#include <cstdint>
+#include <cstdlib>
+
+//VM Test: This tests that compiled programs produce the same results on the VM as they do in the evaluator.
+
+using Expected = std::variant<int64_t, bool, std::string, std::nullptr_t, std::vector<int64_t>>;
+
+struct VMTestCase {
+    std::string input;
+    Expected expected;
+};
+
+std::shared_ptr<Object> runVM(const std::string& input, std::shared_ptr<Error>& err, const ExecutionLimits& limits = {}) {
+    Lexer l(input);
+    Parser p(l);
+    auto program = p.ParseProgram();
+
+    Compiler compiler;
+    if (!compiler.Compile(program)) {
+        std::cerr << "compiler error: " << compiler.Errors()[0] << std::endl;
+        exit(1);
+    }
+
+    VM vm(compiler.GetBytecode());
+    err = vm.Run(limits);
+    return vm.LastPoppedStackElem();
+}
+
+bool testExpectedObject(const Expected& expected, const std::shared_ptr<Object>& actual) {
+    if (auto v = std::get_if<int64_t>(&expected)) {
+        auto integer = std::dynamic_pointer_cast<Integer>(actual);
+        if (!integer || integer->Value != *v) {
+            std::cerr << "object is not Integer " << *v << ". got=" << (actual ? actual->Inspect() : "nullptr") << std::endl;
+            return false;
+        }
+    } else if (auto v = std::get_if<bool>(&expected)) {
+        auto boolean = std::dynamic_pointer_cast<BooleanObject>(actual);
+        if (!boolean || boolean->Value != *v) {
+            std::cerr << "object is not Boolean " << *v << ". got=" << (actual ? actual->Inspect() : "nullptr") << std::endl;
+            return false;
+        }
+    } else if (auto v = std::get_if<std::string>(&expected)) {
+        auto str = std::dynamic_pointer_cast<String>(actual);
+        if (!str || str->Value != *v) {
+            std::cerr << "object is not String " << *v << ". got=" << (actual ? actual->Inspect() : "nullptr") << std::endl;
+            return false;
+        }
+    } else if (std::holds_alternative<std::nullptr_t>(expected)) {
+        if (actual != ObjectConstants::NULL_OBJ) {
+            std::cerr << "object is not NULL. got=" << (actual ? actual->Inspect() : "nullptr") << std::endl;
+            return false;
+        }
+    } else if (auto v = std::get_if<std::vector<int64_t>>(&expected)) {
+        auto array = std::dynamic_pointer_cast<ArrayObject>(actual);
+        if (!array || array->Elements.size() != v->size()) {
+            std::cerr << "object is not an Array of " << v->size() << " elements" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < v->size(); i++) {
+            if (!testExpectedObject((*v)[i], array->Elements[i].ToObject())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void runVMTests(const std::string& name, const std::vector<VMTestCase>& tests) {
+    for (const auto& tt : tests) {
+        std::shared_ptr<Error> err;
+        auto result = runVM(tt.input, err);
+        if (err) {
+            std::cerr << name << ": vm error: " << err->Message << " for input: " << tt.input << std::endl;
+            exit(1);
+        }
+        if (!testExpectedObject(tt.expected, result)) {
+            std::cerr << name << " failed for input: " << tt.input << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << name << " passed!" << std::endl;
+}
+
+void TestIntegerArithmetic() {
+    runVMTests("TestIntegerArithmetic", {
+        {"1 + 2", int64_t(3)},
+        {"50 / 2 * 2 + 10 - 5", int64_t(55)},
+        {"5 * (2 + 10)", int64_t(60)},
+        {"-50 + 100 + -50", int64_t(0)},
+        {"(5 + 10 * 2 + 15 / 3) * 2 + -10", int64_t(50)},
+        {"(-9223372036854775807 - 1) / -1", int64_t(INT64_MIN)},
+        {"9223372036854775807 + 1", int64_t(INT64_MIN)},
+        {"-9223372036854775807 - 2", int64_t(INT64_MAX)},
+        {"4611686018427387904 * 2", int64_t(INT64_MIN)},
+        {"-(-9223372036854775807 - 1)", int64_t(INT64_MIN)},
+    });
+}
+
+void TestBooleanExpressions() {
+    runVMTests("TestBooleanExpressions", {
+        {"1 < 2", true},
+        {"1 > 2", false},
+        {"(1 < 2) == true", true},
+        {"true != false", true},
+        {"!5", false},
+        {"!!true", true},
+        {"!(if (false) { 5; })", true},
+    });
+}
+
+void TestConditionals() {
+    runVMTests("TestConditionals", {
+        {"if (true) { 10 }", int64_t(10)},
+        {"if (1 > 2) { 10 } else { 20 }", int64_t(20)},
+        {"if (1 > 2) { 10 }", nullptr},
+        {"if ((if (false) { 10 })) { 10 } else { 20 }", int64_t(20)},
+        {"if (true) { }", nullptr},
+    });
+}
+
+void TestGlobalLetStatements() {
+    runVMTests("TestGlobalLetStatements", {
+        {"let one = 1; one", int64_t(1)},
+        {"let one = 1; let two = one + one; one + two", int64_t(3)},
+    });
+}
+
+// A let's value sees the earlier binding it shadows, as in the Evaluator.
+void TestLetShadowing() {
+    runVMTests("TestLetShadowing", {
+        {"let x = 1; let x = x + 1; x", int64_t(2)},
+        {"let f = fn(n) { let n = n + 1; n }; f(5)", int64_t(6)},
+        {"let f = fn() { let a = 2; let a = a * 3; a }; f()", int64_t(6)},
+        {"let x = 10; let f = fn() { let x = x + 1; x }; f() + x", int64_t(21)},
+    });
+}
+
+void TestCollections() {
+    runVMTests("TestCollections", {
+        {"\"mon\" + \"key\" + \"banana\"", std::string("monkeybanana")},
+        {"[1 + 2, 3 * 4, 5 + 6]", std::vector<int64_t>{3, 12, 11}},
+        {"[1, 2, 3][1]", int64_t(2)},
+        {"[1, 2, 3][99]", nullptr},
+        {"{1: 1, 2: 2}[2]", int64_t(2)},
+        {"{}[0]", nullptr},
+    });
+}
+
+void TestFunctions() {
+    runVMTests("TestFunctions", {
+        {"let fivePlusTen = fn() { 5 + 10; }; fivePlusTen();", int64_t(15)},
+        {"let earlyExit = fn() { return 99; 100; }; earlyExit();", int64_t(99)},
+        {"let noReturn = fn() { }; noReturn();", nullptr},
+        {"let sum = fn(a, b) { let c = a + b; c; }; sum(1, 2) + sum(3, 4);", int64_t(10)},
+        {"let globalNum = 10; let sum = fn(a, b) { let c = a + b; c + globalNum; }; sum(1, 2);", int64_t(13)},
+        {"return 10; 9;", int64_t(10)},
+    });
+}
+
+void TestBuiltins() {
+    runVMTests("TestBuiltins", {
+        {"len(\"four\")", int64_t(4)},
+        {"len([1, 2, 3])", int64_t(3)},
+        {"first([1, 2, 3])", int64_t(1)},
+        {"last([1, 2, 3])", int64_t(3)},
+        {"rest([1, 2, 3])", std::vector<int64_t>{2, 3}},
+        {"push([], 1)", std::vector<int64_t>{1}},
+    });
+}
+
+void TestClosuresAndRecursion() {
+    runVMTests("TestClosuresAndRecursion", {
+        {"let newAdder = fn(a, b) { fn(c) { a + b + c }; }; let adder = newAdder(1, 2); adder(8);", int64_t(11)},
+        {"let countDown = fn(x) { if (x == 0) { return 0; } else { countDown(x - 1); } }; countDown(1);", int64_t(0)},
+        {"let wrapper = fn() { let countDown = fn(x) { if (x == 0) { return 0; } else { countDown(x - 1); } }; countDown(1); }; wrapper();", int64_t(0)},
+        {"let factorial = fn(n) { if (n == 0) { return 1; } else { return n * factorial(n - 1); } }; factorial(10);", int64_t(3628800)},
+        {"let fibonacci = fn(x) { if (x == 0) { return 0; } else { if (x == 1) { return 1; } else { fibonacci(x - 1) + fibonacci(x - 2); } } }; fibonacci(15);", int64_t(610)},
+        {"let sum = fn(arr, i) { if (i == len(arr)) { return 0; } else { return arr[i] + sum(arr, i + 1); } }; sum([1, 2, 3, 4, 5], 0);", int64_t(15)},
+    });
+}
+
+void TestWhileLoops() {
+    runVMTests("TestWhileLoops", {
+        {"let i = 0; let sum = 0; while (i < 10) { sum = sum + i; i = i + 1; } sum", int64_t(45)},
+        {"let i = 0; let n = 0; while (i < 5) { let j = 0; while (j < 4) { n = n + 1; j = j + 1; } i = i + 1; } n", int64_t(20)},
+        {"let find = fn(limit) { let i = 0; while (true) { if (i * i > limit) { return i; } i = i + 1; } }; find(50)", int64_t(8)},
+        {"let f = fn(x) { x = x * 2; x }; f(21)", int64_t(42)},
+        {"let count = 0; let inc = fn() { count = count + 1; }; inc(); inc(); count", int64_t(2)},
+        {"let f = fn() { let i = 0; while (i < 3) { i = i + 1; } }; f()", nullptr},
+    });
+}
+
+// Programs that end without an expression statement leave no result, as
+// they do in the Evaluator, rather than whatever the stack last held.
+void TestNoResult() {
+    for (const std::string input : {"", " \n\t", "let x = 1;", "5; let x = 1;", "let f = fn() { 1 }; let y = f();"}) {
+        std::shared_ptr<Error> err;
+        auto result = runVM(input, err);
+        if (err || result) {
+            std::cerr << "want no result for input: \"" << input << "\". got="
+                      << (err ? err->Message : result->Inspect()) << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << "TestNoResult passed!" << std::endl;
+}
+
+void TestRuntimeErrors() {
+    struct TestCase {
+        std::string input;
+        std::string expectedMessage;
+    };
+    std::vector<TestCase> tests = {
+        {"5 + true;", "type mismatch: INTEGER + BOOLEAN"},
+        {"-true", "unknown operator: -BOOLEAN"},
+        {"true + false;", "unknown operator: BOOLEAN + BOOLEAN"},
+        {"fn() { 1; }(1);", "wrong number of arguments: want=0, got=1"},
+        {"len(1)", "argument to `len` not supported, got INTEGER"},
+        {"999[1]", "index operator not supported: INTEGER"},
+        {"1 / 0", "division by zero"},
+        {"let f = fn(x) { f(x + 1) }; f(0);", "stack overflow"},
+        // A let the program skipped leaves its name unset, however the
+        // stack was used before.
+        {"if (false) { let g = 1; } g + 1", "identifier not found: global 0"},
+        {"let g = fn(a) { let b = a * 2; b }; let h = fn(a) { if (false) { let c = 1; } c }; g(21); h(1)",
+         "identifier not found: local 1"},
+    };
+
+    for (const auto& tt : tests) {
+        std::shared_ptr<Error> err;
+        runVM(tt.input, err);
+        if (!err || err->Message != tt.expectedMessage) {
+            std::cerr << "wrong error for input: " << tt.input << ". want=" << tt.expectedMessage
+                      << ", got=" << (err ? err->Message : "no error") << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << "TestRuntimeErrors passed!" << std::endl;
+}
+
+void TestExecutionLimits() {
+    ExecutionLimits steps;
+    steps.MaxSteps = 1000;
+    ExecutionLimits heap;
+    heap.MaxHeapBytes = 1 << 20;
+    ExecutionLimits time;
+    time.Timeout = std::chrono::milliseconds(20);
+
+    struct TestCase {
+        std::string input;
+        ExecutionLimits limits;
+        ErrorKind kind;
+    };
+    std::vector<TestCase> tests = {
+        {"while (true) { }", steps, ErrorKind::StepLimit},
+        {"let f = fn(n) { 1 + f(n + 1) }; f(0)", steps, ErrorKind::StepLimit},
+        {"let s = \"ab\"; while (true) { s = s + s; }", heap, ErrorKind::HeapLimit},
+        {"let a = []; while (true) { a = push(a, a); }", heap, ErrorKind::HeapLimit},
+        {"let i = 0; while (true) { i = i + 1; }", time, ErrorKind::Timeout},
+        {"let f = fn(x) { f(x + 1) }; f(0);", {}, ErrorKind::StackOverflow},
+    };
+    for (const auto& tt : tests) {
+        std::shared_ptr<Error> err;
+        runVM(tt.input, err, tt.limits);
+        if (!err || err->Kind != tt.kind) {
+            std::cerr << "wrong limit error for input: " << tt.input << ", got=" << (err ? err->Message : "no error") << std::endl;
+            exit(1);
+        }
+    }
+
+    std::shared_ptr<Error> err;
+    auto result = runVM("let i = 0; while (i < 100) { i = i + 1; }; i", err, steps);
+    if (err || !testExpectedObject(int64_t(100), result)) {
+        std::cerr << "program within its limits did not finish" << std::endl;
+        exit(1);
+    }
+    std::cout << "TestExecutionLimits passed!" << std::endl;
+}
+
+int main() {
+    TestIntegerArithmetic();
+    TestBooleanExpressions();
+    TestConditionals();
+    TestGlobalLetStatements();
+    TestLetShadowing();
+    TestCollections();
+    TestFunctions();
+    TestBuiltins();
+    TestClosuresAndRecursion();
+    TestWhileLoops();
+    TestNoResult();
+    TestRuntimeErrors();
+    TestExecutionLimits();
+    std::cout << "All vm_test.cpp tests passed!" << std::endl;
+    return 0;
+}
@@ -2,8 +2,9 @@ from flask import Flask, render_template, request, redirect, url_for
 from flask_pymongo import PyMongo
 import logging
 import time
-import subprocess
 import os
+from monkey_client import get_client, MonkeyTimeout, MonkeyServerError
+import libmonkey
 from data.db_connect import get_mongo_uri
 
 app = Flask(__name__)
@@ -19,16 +20,18 @@ def run_custom_compiler(code):
     logging.info("Executing code")
     start_time = time.time()
 
-    command = ['./monkey_repl']
     try:
-        process = subprocess.Popen(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
-        output, error = process.communicate(input=code, timeout=10)  # Timeout added
-        process.wait()
-
-        if process.returncode != 0:
-            output = f"Error: {error}"
-    except subprocess.TimeoutExpired:
+        # libmonkey.so runs the code in this process; without it, a
+        # long-lived monkey_repl --server does. See libmonkey.py and
+        # monkey_client.py.
+        response = libmonkey.run(code)
+        if response is None:
+            response = get_client().run(code, timeout=10)
+        output = response['output']
+    except MonkeyTimeout:
         output = "Execution timed out"
+    except MonkeyServerError as e:
+        output = f"Error: {e}"
     except Exception as e:
         logging.error(f"Execution failed: {str(e)}")
         output = "An error occurred during execution"
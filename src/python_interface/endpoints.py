@@ -4,7 +4,8 @@ from flask_restx import Api, Resource, fields
 from flask_pymongo import PyMongo, ObjectId
 import logging
 import time
-import subprocess
+from monkey_client import get_client, MonkeyTimeout, MonkeyServerError
+import libmonkey
 from data.db_connect import get_mongo_uri, connect_db
 import os
 
@@ -42,7 +43,9 @@ compile_model = api.model('Compile', {
 
 compile_response_model = api.model('CompileResponse', {
     'output': fields.String(description='Output of the compiled code'),
-    'execution_time': fields.Float(description='Execution time in seconds')
+    'execution_time': fields.Float(description='Execution time in seconds'),
+    'timings_ns': fields.Raw(description='Nanoseconds the interpreter spent in each stage: lex, parse, compile, eval and total'),
+    'counters': fields.Raw(description='Work the interpreter did: tokens, ast_nodes, steps, calls, environments, max_env_depth and allocated objects by type')
 })
 HELLO_EP = '/hello'
 HELLO_RESP = 'hello'
@@ -228,15 +231,47 @@ class CompileCode(Resource):
             code: The source code to compile and execute.
 
         Responses:
-            200: Success - Returns the output of the compiled code and execution time.
+            200: Success - Returns the output of the compiled code, the execution time, and the interpreter's own timings_ns and counters.
             400: Bad Request - If no code is provided or compilation fails.
         """
         code = request.json.get('code')
         if not code:
             api.abort(400, "No code provided")
 
-        output, execution_time = run_custom_compiler(code)
-        return {'output': output, 'execution_time': execution_time}
+        output, execution_time, stats = run_custom_compiler(code)
+        return {'output': output, 'execution_time': execution_time, **stats}
+
+@ns.route('/pipeline')
+class PipelineCode(Resource):
+    """
+    PipelineCode Endpoint
+
+    This endpoint runs the provided code snippet and returns every stage of the run in one document.
+    """
+    @ns.doc('pipeline_code')
+    @ns.expect(compile_model)
+    def post(self):
+        """
+        Run Code and Return Every Stage
+
+        Lexes, parses and runs a provided code snippet in one pass, for the visualizer.
+
+        Request Body:
+            code: The source code to run.
+
+        Responses:
+            200: Success - Returns ok, tokens, ast, result, type, output, errors and timings_ns (lex, parse, compile, eval, total).
+            400: Bad Request - If no code is provided.
+            503: Service Unavailable - If libmonkey.so is not available.
+        """
+        code = request.json.get('code')
+        if not code:
+            api.abort(400, "No code provided")
+
+        response = libmonkey.pipeline(code)
+        if response is None:
+            api.abort(503, "libmonkey.so is not available")
+        return response
 
 #ENDPOINT #7: Get Total Number of Sample Programs
 
@@ -543,25 +578,34 @@ class ConfigManagement(Resource):
 
 # Helper function
 def run_custom_compiler(code):
+    """
+    Returns the output, the seconds the call took, and a dict with the
+    interpreter's timings_ns and counters, which is empty if the run failed
+    before the interpreter answered.
+    """
     logging.info("Executing code")
     start_time = time.time()
+    stats = {}
 
-    command = ['./monkey_repl']
     try:
-        process = subprocess.Popen(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
-        output, error = process.communicate(input=code, timeout=10)  # Timeout added
-        process.wait()
-
-        if process.returncode != 0:
-            output = f"Error: {error}"
-    except subprocess.TimeoutExpired:
+        # libmonkey.so runs the code in this process; without it, a
+        # long-lived monkey_repl --server does. See libmonkey.py and
+        # monkey_client.py.
+        response = libmonkey.run(code)
+        if response is None:
+            response = get_client().run(code, timeout=10)
+        output = response['output']
+        stats = {key: response[key] for key in ('timings_ns', 'counters') if key in response}
+    except MonkeyTimeout:
         output = "Execution timed out"
+    except MonkeyServerError as e:
+        output = f"Error: {e}"
     except Exception as e:
         logging.error(f"Execution failed: {str(e)}")
         output = "An error occurred during execution"
 
     execution_time = time.time() - start_time
-    return output, execution_time
+    return output, execution_time, stats
 
 if __name__ == '__main__':
     # Use the PORT environment variable from Heroku, default to 5000 if not found
@@ -0,0 +1,151 @@
+"""
+ctypes binding for libmonkey.so, the interpreter as a shared library.
+
+Programs run inside this process, so a request costs a function call
+instead of a round trip to a monkey_repl child. See capi/libmonkey.h for
+the C side.
+
+An interpreter must only be used on the thread that created it. Like the
+monkey_repl servers in monkey_client.py, interpreters run on the stack
+engine by default and stop any program after 5 seconds or 256 MiB of heap.
+"""
+import ctypes
+import json
+import logging
+import os
+import threading
+
+MONKEY_LIB = os.environ.get('MONKEY_LIB', './libmonkey.so')
+ABI_VERSION = 1
+
+
+class MonkeyLibraryError(Exception):
+    pass
+
+
+def load(path=MONKEY_LIB):
+    """Loads libmonkey and declares its functions. Raises OSError if it cannot."""
+    lib = ctypes.CDLL(path)
+    lib.monkey_abi_version.restype = ctypes.c_int
+    lib.monkey_abi_version.argtypes = []
+    if lib.monkey_abi_version() != ABI_VERSION:
+        raise OSError(f"{path} has ABI version {lib.monkey_abi_version()}, want {ABI_VERSION}")
+
+    lib.monkey_new.restype = ctypes.c_void_p
+    lib.monkey_new.argtypes = [ctypes.c_char_p]
+    lib.monkey_free.restype = None
+    lib.monkey_free.argtypes = [ctypes.c_void_p]
+    lib.monkey_set_limits.restype = None
+    lib.monkey_set_limits.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.c_uint64, ctypes.c_uint64]
+    # The strings are returned as raw pointers so they can be freed.
+    for name in ('monkey_eval', 'monkey_run', 'monkey_pipeline'):
+        fn = getattr(lib, name)
+        fn.restype = ctypes.c_void_p
+        fn.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+    for name in ('monkey_tokens', 'monkey_ast'):
+        fn = getattr(lib, name)
+        fn.restype = ctypes.c_void_p
+        fn.argtypes = [ctypes.c_char_p]
+    lib.monkey_string_free.restype = None
+    lib.monkey_string_free.argtypes = [ctypes.c_void_p]
+    return lib
+
+
+class Interpreter:
+    """
+    One libmonkey interpreter. Everything one run defines is visible to the
+    next. Use it only on the thread that created it.
+    """
+
+    def __init__(self, lib, engine='stack', max_steps=0, max_heap=256 << 20, timeout_ms=5000):
+        self.lib = lib
+        self.handle = lib.monkey_new(engine.encode())
+        if not self.handle:
+            raise MonkeyLibraryError(f"unknown engine {engine}")
+        lib.monkey_set_limits(self.handle, max_steps, max_heap, timeout_ms)
+
+    def close(self):
+        if self.handle:
+            self.lib.monkey_free(self.handle)
+            self.handle = None
+
+    def eval(self, code):
+        """
+        Runs code and returns a dict with 'ok', 'result', 'type', 'output'
+        (what puts printed), 'errors', 'timings_ns' and 'counters'.
+        """
+        return self._call(self.lib.monkey_eval, self.handle, code)
+
+    def run(self, code):
+        """
+        Runs code and answers as monkey_client.MonkeyClient.run does: 'output'
+        is the whole trace, tokens and AST included.
+        """
+        return self._call(self.lib.monkey_run, self.handle, code)
+
+    def pipeline(self, code):
+        """
+        Runs code and returns its tokens, AST, result, output and per-stage
+        timings in one dict, from a single pass; see REPL::RunJson.
+        """
+        return self._call(self.lib.monkey_pipeline, self.handle, code)
+
+    def tokens(self, code):
+        return self._call(self.lib.monkey_tokens, code)
+
+    def ast(self, code):
+        return self._call(self.lib.monkey_ast, code)
+
+    def _call(self, fn, *args):
+        args = [a.encode() if isinstance(a, str) else a for a in args]
+        ptr = fn(*args)
+        if not ptr:
+            raise MonkeyLibraryError("libmonkey is out of memory")
+        try:
+            return json.loads(ctypes.string_at(ptr).decode('utf-8', errors='replace'))
+        finally:
+            self.lib.monkey_string_free(ptr)
+
+
+_lib = None
+_lib_lock = threading.Lock()
+
+
+def get_library():
+    """Returns libmonkey, loading it on first use, or None if it cannot be loaded."""
+    global _lib
+    with _lib_lock:
+        if _lib is None:
+            try:
+                _lib = load()
+                logging.info("Running programs in-process with %s", MONKEY_LIB)
+            except OSError as e:
+                logging.info("Cannot load %s, using monkey_repl servers: %s", MONKEY_LIB, e)
+                _lib = False
+        return _lib or None
+
+
+def run(code):
+    """
+    Runs code in a fresh interpreter, so it sees nothing earlier requests
+    defined, and returns what Interpreter.run does. Returns None if
+    libmonkey.so cannot be loaded, in which case callers fall back to
+    monkey_client.
+    """
+    return _run_fresh(lambda interp: interp.run(code))
+
+
+def pipeline(code):
+    """Like run, but returns what Interpreter.pipeline does."""
+    return _run_fresh(lambda interp: interp.pipeline(code))
+
+
+def _run_fresh(fn):
+    lib = get_library()
+    if lib is None:
+        return None
+    interp = Interpreter(lib)
+    try:
+        return fn(interp)
+    finally:
+        interp.close()
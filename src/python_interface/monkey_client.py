@@ -0,0 +1,202 @@
+"""
+Client for `monkey_repl --server`.
+
+Instead of starting a new monkey_repl for every program, we keep a small
+pool of long-lived server processes and send each program to one of them
+as a line of JSON. A server that hangs past the timeout or dies is killed
+and replaced on the next request. The servers evaluate with the stack
+engine by default, so deeply recursive programs fail with an error instead
+of taking their process down. By default they also stop any program after
+5 seconds or 256 MiB of heap, well inside the client's own timeout, so a
+runaway program costs an error response and not a restarted process.
+
+Runs that pass a session share state on the server: the first run of a
+session pins it to one process, and later runs with the same session go
+to that process and see what the earlier ones defined.
+"""
+import json
+import logging
+import os
+import queue
+import select
+import subprocess
+import itertools
+import threading
+import time
+
+MONKEY_REPL = os.environ.get('MONKEY_REPL', './monkey_repl')
+POOL_SIZE = int(os.environ.get('MONKEY_SERVER_PROCS', '2'))
+
+
+class MonkeyTimeout(Exception):
+    pass
+
+
+class MonkeyServerError(Exception):
+    pass
+
+
+class MonkeySessionLost(MonkeyServerError):
+    """The process holding a session was restarted, so its state is gone."""
+
+
+class MonkeyProcess:
+    """One `monkey_repl --server` child, used by a single caller at a time."""
+
+    def __init__(self, command):
+        self.command = command
+        self.process = None
+        self.buffer = b''
+        self.next_id = 0
+        self.generation = 0
+        self.lock = threading.Lock()
+
+    def start(self):
+        self.process = subprocess.Popen(self.command, stdin=subprocess.PIPE, stdout=subprocess.PIPE, bufsize=0)
+        self.buffer = b''
+        self.generation += 1
+
+    def close(self):
+        if self.process is not None:
+            self.process.kill()
+            self.process.wait()
+            self.process = None
+
+    def request(self, code, timeout, engine=None, session=None, end_session=False):
+        if self.process is None or self.process.poll() is not None:
+            self.start()
+
+        self.next_id += 1
+        message = {'id': self.next_id, 'code': code}
+        if engine:
+            message['engine'] = engine
+        if session:
+            message['session'] = session
+            if end_session:
+                message['end_session'] = True
+        try:
+            self.process.stdin.write(json.dumps(message).encode() + b'\n')
+        except (BrokenPipeError, OSError) as e:
+            self.close()
+            raise MonkeyServerError(f"monkey_repl exited: {e}")
+
+        line = self._read_line(time.monotonic() + timeout)
+        response = json.loads(line)
+        if response.get('id') != self.next_id:
+            self.close()
+            raise MonkeyServerError("monkey_repl answered out of order")
+        return response
+
+    def _read_line(self, deadline):
+        fd = self.process.stdout.fileno()
+        while b'\n' not in self.buffer:
+            remaining = deadline - time.monotonic()
+            ready, _, _ = select.select([fd], [], [], max(remaining, 0))
+            if not ready:
+                self.close()
+                raise MonkeyTimeout()
+            chunk = os.read(fd, 65536)
+            if not chunk:
+                code = self.process.wait()
+                self.process = None
+                raise MonkeyServerError(f"monkey_repl exited with status {code}")
+            self.buffer += chunk
+        line, self.buffer = self.buffer.split(b'\n', 1)
+        return line.decode('utf-8', errors='replace')
+
+
+class MonkeyClient:
+    """A thread-safe pool of monkey_repl servers, started lazily."""
+
+    def __init__(self, command=None, size=POOL_SIZE):
+        self.command = command or [MONKEY_REPL, '--server', '--engine=stack',
+                                   '--timeout-ms=5000', '--max-heap=268435456']
+        self.idle = queue.LifoQueue()
+        self.size = size
+        self.slots = threading.Semaphore(size)
+        self.lock = threading.Lock()
+        self.all = []
+        self.sessions = {}  # session -> (process, generation it was started in)
+        self.session_ids = itertools.count(1)
+
+    def run(self, code, timeout=10, engine=None, session=None):
+        """
+        Runs code and returns the server's response: a dict with 'output',
+        'errors', 'ok', 'timings_ns' (lex, parse, compile, eval, total) and
+        'counters' (tokens, ast_nodes, steps, calls, environments,
+        max_env_depth and allocated objects by type).
+        With a session from new_session(), the code runs in that session.
+        Raises MonkeyTimeout or MonkeyServerError, or MonkeySessionLost if
+        the session's process had to be restarted.
+        """
+        if session:
+            return self._run_in_session(code, timeout, engine, session)
+        with self.slots:
+            try:
+                proc = self.idle.get_nowait()
+            except queue.Empty:
+                proc = MonkeyProcess(self.command)
+                with self.lock:
+                    self.all.append(proc)
+            try:
+                with proc.lock:
+                    return proc.request(code, timeout, engine)
+            finally:
+                self.idle.put(proc)
+
+    def new_session(self):
+        """Returns a fresh session id to pass to run()."""
+        return f"s{next(self.session_ids)}"
+
+    def end_session(self, session):
+        """Drops the session's state on its server."""
+        with self.lock:
+            pinned = self.sessions.pop(session, None)
+        if pinned is None:
+            return
+        proc, generation = pinned
+        with proc.lock:
+            if proc.generation == generation and proc.process is not None:
+                proc.request('null', 10, session=session, end_session=True)
+
+    def _run_in_session(self, code, timeout, engine, session):
+        with self.lock:
+            pinned = self.sessions.get(session)
+            if pinned is None:
+                # Spread sessions over the processes, starting new ones up to the pool size.
+                if len(self.all) < self.size:
+                    proc = MonkeyProcess(self.command)
+                    self.all.append(proc)
+                    self.idle.put(proc)
+                else:
+                    proc = min(self.all, key=lambda p: sum(1 for q, _ in self.sessions.values() if q is p))
+                pinned = (proc, None)
+        proc, generation = pinned
+        with proc.lock:
+            if generation is not None and proc.generation != generation:
+                with self.lock:
+                    self.sessions.pop(session, None)
+                raise MonkeySessionLost(f"monkey_repl restarted, session {session} is gone")
+            if proc.process is None or proc.process.poll() is not None:
+                proc.start()
+            with self.lock:
+                self.sessions[session] = (proc, proc.generation)
+            return proc.request(code, timeout, engine, session=session)
+
+    def close(self):
+        with self.lock:
+            for proc in self.all:
+                proc.close()
+
+
+_client = None
+_client_lock = threading.Lock()
+
+
+def get_client():
+    global _client
+    with _client_lock:
+        if _client is None:
+            _client = MonkeyClient()
+            logging.info("Using up to %d monkey_repl servers", POOL_SIZE)
+        return _client